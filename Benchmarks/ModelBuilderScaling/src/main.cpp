@@ -0,0 +1,143 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKbench
+ *  @file main.cpp
+ *  @brief Benchmark for thread parallel Model assembly
+ *
+ *  Measures the time it takes to add the HoppingAmplitudes of a cubic lattice
+ *  with two spins per site, construct the Hilbert space, and sort the
+ *  HoppingAmplitudes. The serial Model::addHA() path is compared to the
+ *  ModelBuilder for 1 up to omp_get_max_threads() threads, and the resulting
+ *  Hamiltonians are checked to be identical to the serial one.
+ *
+ *  Takes the linear size of the lattice as optional first argument (default
+ *  64, resulting in a 64x64x64 lattice).
+ *
+ *  @author agent
+ */
+
+#include "Model.h"
+#include "ModelBuilder.h"
+#include "Streams.h"
+
+#include <chrono>
+#include <complex>
+#include <cstdlib>
+
+#include <omp.h>
+
+using namespace std;
+using namespace TBTK;
+
+//Time since the given time point in seconds.
+double getElapsedTime(chrono::high_resolution_clock::time_point start){
+	return chrono::duration<double>(
+		chrono::high_resolution_clock::now() - start
+	).count();
+}
+
+//Add the HoppingAmplitudes for the sites with given x-coordinate to a Model
+//or ModelBuilder.
+template<typename Builder>
+void addSlice(Builder &builder, int x, int size){
+	complex<double> mu = -1.;
+	complex<double> t = 1.;
+
+	for(int y = 0; y < size; y++){
+		for(int z = 0; z < size; z++){
+			for(int s = 0; s < 2; s++){
+				builder.addHA(HoppingAmplitude(-mu,	{x, y, z, s},	{x, y, z, s}));
+				builder.addHAAndHC(HoppingAmplitude(-t,	{(x+1)%size, y, z, s},	{x, y, z, s}));
+				builder.addHAAndHC(HoppingAmplitude(-t,	{x, (y+1)%size, z, s},	{x, y, z, s}));
+				builder.addHAAndHC(HoppingAmplitude(-t,	{x, y, (z+1)%size, s},	{x, y, z, s}));
+			}
+		}
+	}
+}
+
+//Check that two Models have identical Hamiltonians on COO format.
+bool isEqual(Model &model0, Model &model1){
+	model0.constructCOO();
+	model1.constructCOO();
+	AmplitudeSet *as0 = model0.getAmplitudeSet();
+	AmplitudeSet *as1 = model1.getAmplitudeSet();
+
+	bool equal = (as0->getNumMatrixElements() == as1->getNumMatrixElements());
+	for(int n = 0; equal && n < as0->getNumMatrixElements(); n++){
+		if(
+			as0->getCOORowIndices()[n] != as1->getCOORowIndices()[n]
+			|| as0->getCOOColIndices()[n] != as1->getCOOColIndices()[n]
+			|| as0->getCOOValues()[n] != as1->getCOOValues()[n]
+		){
+			equal = false;
+		}
+	}
+
+	model0.destructCOO();
+	model1.destructCOO();
+
+	return equal;
+}
+
+int main(int argc, char **argv){
+	int size = 64;
+	if(argc > 1)
+		size = atoi(argv[1]);
+
+	int maxThreads = omp_get_max_threads();
+
+	Streams::out << "Lattice size: " << size << "x" << size << "x" << size << "\n";
+
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	Model serialModel;
+	serialModel.setTalkative(false);
+	for(int x = 0; x < size; x++)
+		addSlice(serialModel, x, size);
+	serialModel.construct();
+	serialModel.getAmplitudeSet()->sort();
+	double serialTime = getElapsedTime(start);
+
+	Streams::out << "Basis size: " << serialModel.getBasisSize() << "\n";
+	Streams::out << "Model::addHA():\t" << serialTime << "s\n";
+
+	for(int numThreads = 1; numThreads <= maxThreads; numThreads++){
+		omp_set_num_threads(numThreads);
+
+		start = chrono::high_resolution_clock::now();
+		Model model;
+		model.setTalkative(false);
+		ModelBuilder modelBuilder;
+		#pragma omp parallel for schedule(static)
+		for(int x = 0; x < size; x++)
+			addSlice(modelBuilder, x, size);
+		double addTime = getElapsedTime(start);
+		modelBuilder.build(model);
+		double time = getElapsedTime(start);
+
+		Streams::out << "ModelBuilder, " << numThreads << " threads:\t"
+			<< time << "s (add " << addTime << "s, build "
+			<< time - addTime << "s), speedup "
+			<< serialTime/time << "\n";
+
+		if(!isEqual(serialModel, model)){
+			Streams::err << "Error: ModelBuilder result differs from"
+				<< " Model::addHA().\n";
+			exit(1);
+		}
+	}
+
+	return 0;
+}
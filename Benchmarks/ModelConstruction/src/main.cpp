@@ -0,0 +1,82 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKbench
+ *  @file main.cpp
+ *  @brief Benchmark for Model construction
+ *
+ *  Measures the time it takes to build a square lattice using
+ *  ModelFactory::createSquareLattice, to construct its Hilbert space, and to
+ *  set up the Hamiltonian on COO format, as well as the peak memory usage
+ *  (resident set size) of the process.
+ *
+ *  Takes the linear size of the lattice as optional first argument (default
+ *  1000, resulting in a 1000x1000 lattice with two spins per site).
+ *
+ *  @author agent
+ */
+
+#include "Model.h"
+#include "ModelFactory.h"
+#include "Streams.h"
+#include "Timer.h"
+
+#include <cstdlib>
+#include <sys/resource.h>
+
+using namespace std;
+using namespace TBTK;
+
+//Peak resident set size in MB.
+double getPeakRSS(){
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	return usage.ru_maxrss/1024.;
+}
+
+int main(int argc, char **argv){
+	int size = 1000;
+	if(argc > 1)
+		size = atoi(argv[1]);
+
+	Streams::out << "Lattice size: " << size << "x" << size << "\n";
+
+	Timer::tick("Total");
+	Timer::tick("ModelFactory::createSquareLattice()");
+	Model *model = ModelFactory::createSquareLattice(
+		{size, size},
+		{true, true},
+		1.
+	);
+	Timer::tock();
+
+	Timer::tick("Model::construct()");
+	model->setTalkative(false);
+	model->construct();
+	Timer::tock();
+
+	Timer::tick("Model::constructCOO()");
+	model->constructCOO();
+	Timer::tock();
+	Timer::tock();
+
+	Streams::out << "Basis size: " << model->getBasisSize() << "\n";
+	Streams::out << "Peak RSS: " << getPeakRSS() << "MB\n";
+
+	delete model;
+
+	return 0;
+}
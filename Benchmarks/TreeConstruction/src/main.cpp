@@ -0,0 +1,183 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKbench
+ *  @file main.cpp
+ *  @brief Benchmark for building the tree that stores HoppingAmplitudes
+ *
+ *  Builds the models of the WireOnSuperconductor and CarbonNanotube templates
+ *  scaled up to 100 times as many sites, and measures the time it takes to
+ *  add the HoppingAmplitudes and construct the Hilbert space, as well as the
+ *  peak memory usage (resident set size) of the process.
+ *
+ *  Takes the name of the model as first argument: "wire", "nanotube", or
+ *  "sparse". The "sparse" model is the wire model with the subsystem label
+ *  of the magnetic wire offset to 1000 and the site indices of the wire
+ *  offset by 1000000, together with a chain of 100000 sites that only uses
+ *  every tenth site index, which results in a sparse index space.
+ *
+ *  @author agent
+ */
+
+#include "Model.h"
+#include "Streams.h"
+#include "Timer.h"
+
+#include <complex>
+#include <cstdlib>
+#include <string>
+#include <sys/resource.h>
+
+using namespace std;
+using namespace TBTK;
+
+//Peak resident set size in MB.
+double getPeakRSS(){
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	return usage.ru_maxrss/1024.;
+}
+
+//WireOnSuperconductor with 10 times the linear size of the template.
+void addWire(Model &model, int wireLabel, int wireOffset){
+	const int SIZE_X = 10*4*7;
+	const int SIZE_Y = 10*(2*7+1);
+
+	complex<double> mu = -4.;
+	complex<double> t_ss = 1.;
+	complex<double> t_mm = 1.;
+	complex<double> t_sm = 0.5;
+	complex<double> V_z = 0.5;
+	complex<double> D = 0.3;
+
+	for(int x = 0; x < SIZE_X; x++){
+		for(int y = 0; y < SIZE_Y; y++){
+			for(int s = 0; s < 2; s++){
+				model.addHA(HoppingAmplitude(-mu,	{0, x, y, s},	{0, x, y, s}));
+				model.addHA(HoppingAmplitude(mu,	{0, x, y, s+2},	{0, x, y, s+2}));
+
+				if(x+1 < SIZE_X){
+					model.addHAAndHC(HoppingAmplitude(-t_ss,	{0, x+1, y, s},		{0, x, y, s}));
+					model.addHAAndHC(HoppingAmplitude(t_ss,		{0, x+1, y, s+2},	{0, x, y, s+2}));
+				}
+				if(y+1 < SIZE_Y){
+					model.addHAAndHC(HoppingAmplitude(-t_ss,	{0, x, y+1, s},		{0, x, y, s}));
+					model.addHAAndHC(HoppingAmplitude(t_ss,		{0, x, y+1, s+2},	{0, x, y, s+2}));
+				}
+				model.addHAAndHC(HoppingAmplitude(D,	{0, x, y, 3-s},	{0, x, y, s}));
+			}
+		}
+	}
+
+	for(int x = 0; x < SIZE_X/2; x++){
+		int xw = x + wireOffset;
+		for(int s = 0; s < 2; s++){
+			model.addHA(HoppingAmplitude(-2.*V_z*(s-1/2.),	{wireLabel, xw, s},	{wireLabel, xw, s}));
+			model.addHA(HoppingAmplitude(2.*V_z*(s-1/2.),	{wireLabel, xw, s+2},	{wireLabel, xw, s+2}));
+
+			if(x+1 < SIZE_X/2){
+				model.addHAAndHC(HoppingAmplitude(-t_mm,	{wireLabel, xw+1, s},	{wireLabel, xw, s}));
+				model.addHAAndHC(HoppingAmplitude(t_mm,		{wireLabel, xw+1, s+2},	{wireLabel, xw, s+2}));
+			}
+
+			model.addHAAndHC(HoppingAmplitude(-t_sm,	{0, x+SIZE_X/4, SIZE_Y/2, s},	{wireLabel, xw, s}));
+			model.addHAAndHC(HoppingAmplitude(t_sm,		{0, x+SIZE_X/4, SIZE_Y/2, s+2},	{wireLabel, xw, s+2}));
+		}
+	}
+}
+
+//Chain with the given number of sites, where only every stride:th site index
+//is used.
+void addSparseChain(Model &model, int label, int numSites, int stride){
+	complex<double> t = 1.;
+
+	for(int x = 0; x < numSites; x++){
+		for(int s = 0; s < 2; s++){
+			model.addHA(HoppingAmplitude(0.,	{label, stride*x, s},	{label, stride*x, s}));
+
+			if(x+1 < numSites)
+				model.addHAAndHC(HoppingAmplitude(-t,	{label, stride*(x+1), s},	{label, stride*x, s}));
+		}
+	}
+}
+
+//CarbonNanotube with 10 times the circumference and length of the template.
+void addNanotube(Model &model){
+	const int SIZE_X = 10*2;
+	const int SIZE_Y = 10*20;
+
+	complex<double> mu = 0;
+	complex<double> t = 1.0;
+
+	for(int x = 0; x < SIZE_X; x++){
+		for(int y = 0; y < SIZE_Y; y++){
+			for(int s = 0; s < 2; s++){
+				for(int n = 0; n < 4; n++)
+					model.addHA(HoppingAmplitude(-mu,	{x, y, n, s},	{x, y, n, s}));
+
+				model.addHAAndHC(HoppingAmplitude(-t,	{x, y, 1, s},	{x, y, 0, s}));
+				model.addHAAndHC(HoppingAmplitude(-t,	{x, y, 2, s},	{x, y, 1, s}));
+				model.addHAAndHC(HoppingAmplitude(-t,	{x, y, 3, s},	{x, y, 2, s}));
+				model.addHAAndHC(HoppingAmplitude(-t,	{(x+1)%SIZE_X, y, 0, s},	{x, y, 3, s}));
+				if(y+1 < SIZE_Y){
+					model.addHAAndHC(HoppingAmplitude(-t,	{x, y+1, 0, s},	{x, y, 1, s}));
+					model.addHAAndHC(HoppingAmplitude(-t,	{x, y+1, 3, s},	{x, y, 2, s}));
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char **argv){
+	string name = "wire";
+	if(argc > 1)
+		name = argv[1];
+
+	Streams::out << "Model: " << name << "\n";
+
+	Model *model = new Model();
+	model->setTalkative(false);
+
+	Timer::tick("Total");
+	Timer::tick("Add HoppingAmplitudes");
+	if(name.compare("wire") == 0){
+		addWire(*model, 1, 0);
+	}
+	else if(name.compare("nanotube") == 0){
+		addNanotube(*model);
+	}
+	else if(name.compare("sparse") == 0){
+		addWire(*model, 1000, 1000000);
+		addSparseChain(*model, 2000, 100000, 10);
+	}
+	else{
+		Streams::err << "Unknown model '" << name << "'.\n";
+		exit(1);
+	}
+	Timer::tock();
+
+	Timer::tick("Model::construct()");
+	model->construct();
+	Timer::tock();
+	Timer::tock();
+
+	Streams::out << "Basis size: " << model->getBasisSize() << "\n";
+	Streams::out << "Peak RSS: " << getPeakRSS() << "MB\n";
+
+	delete model;
+
+	return 0;
+}
@@ -0,0 +1,424 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file AmplitudeArray.h
+ *  @brief Contiguous storage of @link HoppingAmplitude HoppingAmplitudes
+ *  @endlink
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_AMPLITUDE_ARRAY
+#define COM_DAFER45_TBTK_AMPLITUDE_ARRAY
+
+#include "HoppingAmplitude.h"
+#include "IndexHashTable.h"
+#include "PhysicalIndexTable.h"
+#include "TreeNode.h"
+
+#include <complex>
+#include <unordered_map>
+#include <vector>
+
+namespace TBTK{
+
+/** Struct-of-arrays storage of the @link HoppingAmplitude HoppingAmplitudes
+ *  @endlink in a tree, built once the basis indices have been generated. The
+ *  amplitudes are stored as four arrays containing the 'from'-basis index,
+ *  the 'to'-basis index, the value, and the callback id of each amplitude.
+ *  The amplitudes are ordered by 'from'-basis index, and amplitudes with the
+ *  same 'from'-basis index are ordered by 'to'-basis index.
+ *
+ *  Amplitudes that are given by a callback function have a callback id that
+ *  refers to a callback group, while other amplitudes have callback id -1.
+ *  A callback group consists of all amplitudes with the same callback, or
+ *  with the same batch callback and context. The values of callback
+ *  amplitudes are evaluated by evaluateCallbacks(), which calls batch
+ *  callbacks once per group.
+ *
+ *  If dirty tracking is enabled, evaluateCallbacks() only evaluates the
+ *  callback groups that have been marked as dirty since the last
+ *  evaluation. Otherwise all callback groups are evaluated every time. Each
+ *  group also has a version that is increased every time it is evaluated.
+ *  Code that keeps its own copy of the values, such as the COO format of
+ *  the AmplitudeSet, records the versions it has copied and compares them
+ *  to the current versions after calling evaluateCallbacks(). The dirty
+ *  flags can therefore be shared by any number of such consumers.
+ *
+ *  With Hermitian storage, the Hamiltonian is assumed to be Hermitian and
+ *  the tree to only contain one of each amplitude and its Hermitian
+ *  conjugate. The amplitudes are stored such that the 'to'-basis index is
+ *  smaller than or equal to the 'from'-basis index, which means that the
+ *  Hermitian conjugate is stored for amplitudes that are stored the other
+ *  way round in the tree. Each stored off-diagonal amplitude then also
+ *  represents its Hermitian conjugate, which halves the memory needed for
+ *  the arrays and the memory traffic of algorithms that loop over them.
+ *
+ *  The arrays can be accessed directly, or through a Range that can be split
+ *  into parts for parallel processing. Ranges are split at boundaries between
+ *  different 'from'-basis indices, which means that different parts never
+ *  contain amplitudes with the same 'from'-basis index. */
+class AmplitudeArray{
+public:
+	/** Constructor. */
+	AmplitudeArray();
+
+	/** Destructor. */
+	~AmplitudeArray();
+
+	/** Build the arrays from a tree for which the basis indices have been
+	 *  generated.
+	 *
+	 *  @param tree Root node of the tree to build the arrays from.
+	 *  @param indexHashTable Table used to resolve the 'to'-indices of the
+	 *  amplitudes to basis indices.
+	 *  @param physicalIndexTable Table used to obtain the physical indices
+	 *  that are passed to callbacks. Has to remain valid for as long as
+	 *  the AmplitudeArray is used.
+	 *  @param hermitianStorage If true, the tree is assumed to contain
+	 *  one triangle of a Hermitian Hamiltonian, and the amplitudes are
+	 *  stored with 'to'-basis index smaller than or equal to the
+	 *  'from'-basis index. */
+	void construct(
+		const TreeNode &tree,
+		const IndexHashTable &indexHashTable,
+		const PhysicalIndexTable &physicalIndexTable,
+		bool hermitianStorage = false
+	);
+
+	/** Free all memory used by the arrays. */
+	void clear();
+
+	/** Returns true if the arrays have been constructed. */
+	bool getIsConstructed() const;
+
+	/** Get number of amplitudes. */
+	int getSize() const;
+
+	/** Get the bandwidth of the Hamiltonian. That is, the largest
+	 *  difference between the 'from'- and 'to'-basis index of any
+	 *  amplitude. */
+	int getBandwidth() const;
+
+	/** Returns true if only one triangle of the Hamiltonian is stored.
+	 *  The off-diagonal amplitudes then have to be applied together with
+	 *  their Hermitian conjugates. */
+	bool getHermitianStorage() const;
+
+	/** Get 'from'-basis indices. */
+	const int* getFromBasisIndices() const;
+
+	/** Get 'to'-basis indices. */
+	const int* getToBasisIndices() const;
+
+	/** Get amplitude values. For callback amplitudes the values are those
+	 *  obtained at the last call to evaluateCallbacks(), or zero if it
+	 *  has not been called. */
+	const std::complex<double>* getValues() const;
+
+	/** Get callback ids. */
+	const int* getCallbackIds() const;
+
+	/** Get number of callback groups. */
+	int getNumCallbacks() const;
+
+	/** Get positions of the amplitudes in the given callback group, in
+	 *  increasing order.
+	 *
+	 *  @param callbackId Callback id of the group. */
+	const std::vector<int>& getCallbackGroupPositions(int callbackId) const;
+
+	/** Get number of amplitudes that are given by callbacks. */
+	int getNumCallbackAmplitudes() const;
+
+	/** Get positions of the amplitudes that are given by callbacks, in
+	 *  increasing order. */
+	const std::vector<int>& getCallbackPositions() const;
+
+	/** Evaluate callback amplitudes and store the result in the value
+	 *  array. Evaluates every callback group, or only the dirty ones if
+	 *  dirty tracking is enabled, and marks them as clean. The callbacks
+	 *  are evaluated serially, since user supplied callbacks are not
+	 *  required to be thread safe. */
+	void evaluateCallbacks();
+
+	/** Enable or disable dirty tracking. Disabled by default. */
+	void setCallbackDirtyTracking(bool callbackDirtyTracking);
+
+	/** Returns true if dirty tracking is enabled. */
+	bool getCallbackDirtyTracking() const;
+
+	/** Returns true if the given callback group will be evaluated by the
+	 *  next call to evaluateCallbacks(). */
+	bool getIsCallbackDirty(int callbackId) const;
+
+	/** Get the version of the values of the given callback group. The
+	 *  version is increased every time the group is evaluated by
+	 *  evaluateCallbacks(). */
+	unsigned int getCallbackVersion(int callbackId) const;
+
+	/** Mark the callback group for the given callback as dirty. */
+	void markCallbackDirty(
+		std::complex<double> (*amplitudeCallback)(Index, Index)
+	);
+
+	/** Mark the callback group for the given batch callback and context
+	 *  as dirty. */
+	void markCallbackDirty(
+		HoppingAmplitude::BatchCallback batchCallback,
+		void *callbackContext
+	);
+
+	/** Mark all callback groups as dirty. */
+	void markAllCallbacksDirty();
+
+	/** Range [begin, end) of positions in the arrays. */
+	class Range{
+	public:
+		/** First position in the range. */
+		int begin;
+
+		/** One past the last position in the range. */
+		int end;
+
+		/** Constructor. */
+		Range(int begin, int end);
+	};
+
+	/** Get Range covering all amplitudes. */
+	Range getRange() const;
+
+	/** Split the full range into numParts parts and return the part with
+	 *  number part. The parts are split at boundaries between different
+	 *  'from'-basis indices, which allows the parts to be processed in
+	 *  parallel without two parts writing to the same column.
+	 *
+	 *  @param numParts Number of parts to split the range into.
+	 *  @param part Part to return, in the range [0, numParts). */
+	Range getRange(int numParts, int part) const;
+private:
+	/** Number of amplitudes. */
+	int size;
+
+	/** Flag indicating whether only one triangle is stored. */
+	bool hermitianStorage;
+
+	/** 'From'-basis indices. */
+	int *fromBasisIndices;
+
+	/** 'To'-basis indices. */
+	int *toBasisIndices;
+
+	/** Amplitude values. */
+	std::complex<double> *values;
+
+	/** Callback ids. -1 for amplitudes that are not given by callbacks. */
+	int *callbackIds;
+
+	/** Group of amplitudes given by the same callback. */
+	class CallbackGroup{
+	public:
+		/** Callback, or NULL for batch callback groups. */
+		std::complex<double> (*amplitudeCallback)(Index, Index);
+
+		/** Batch callback, or NULL for callback groups. */
+		HoppingAmplitude::BatchCallback batchCallback;
+
+		/** Context passed to the batch callback. */
+		void *callbackContext;
+
+		/** Positions of the amplitudes in the group. */
+		std::vector<int> positions;
+
+		/** 'To'-basis indices of the amplitudes in the group. Only
+		 *  used for batch callbacks. */
+		std::vector<int> toBasisIndices;
+
+		/** 'From'-basis indices of the amplitudes in the group. Only
+		 *  used for batch callbacks. */
+		std::vector<int> fromBasisIndices;
+
+		/** Buffer for values returned by the batch callback. */
+		std::vector<std::complex<double>> values;
+
+		/** Flag indicating whether the group needs to be evaluated. */
+		bool isDirty;
+
+		/** Number of times the group has been evaluated. */
+		unsigned int version;
+	};
+
+	/** Callback groups. */
+	std::vector<CallbackGroup> callbackGroups;
+
+	/** Ids of the callback groups, indexed by callback and context. Used
+	 *  to find the group of an amplitude during construction. */
+	std::unordered_map<
+		std::complex<double> (*)(Index, Index),
+		std::unordered_map<void*, unsigned int>
+	> amplitudeCallbackGroupIds;
+
+	/** Ids of the batch callback groups, indexed by batch callback and
+	 *  context. */
+	std::unordered_map<
+		HoppingAmplitude::BatchCallback,
+		std::unordered_map<void*, unsigned int>
+	> batchCallbackGroupIds;
+
+	/** Flag indicating whether dirty tracking is enabled. */
+	bool callbackDirtyTracking;
+
+	/** Positions of the amplitudes that are given by callbacks. */
+	std::vector<int> callbackPositions;
+
+	/** Table used to obtain physical indices to pass to callbacks. */
+	const PhysicalIndexTable *physicalIndexTable;
+
+	/** Count the amplitudes in the tree. Called recursively. */
+	static int countAmplitudes(const TreeNode &treeNode);
+
+	/** Collect the leaves of the tree, indexed by basis index. Called
+	 *  recursively. */
+	static void collectLeaves(
+		const TreeNode &treeNode,
+		const TreeNode **leaves
+	);
+
+	/** Store the amplitudes on a leaf.
+	 *
+	 *  @param amplitudeToBasisIndices 'To'-basis indices of the
+	 *  amplitudes on the leaf. */
+	void storeAmplitudes(
+		const TreeNode &treeNode,
+		const int *amplitudeToBasisIndices,
+		int *position
+	);
+
+	/** Store the amplitudes on all leaves with Hermitian storage, using
+	 *  the Hermitian conjugate of amplitudes with a 'to'-basis index
+	 *  larger than the 'from'-basis index.
+	 *
+	 *  @param amplitudeToBasisIndices 'To'-basis indices of all
+	 *  amplitudes, with the leaves visited in basis order. */
+	void storeHermitianAmplitudes(
+		const TreeNode *const *leaves,
+		int basisSize,
+		const int *amplitudeToBasisIndices
+	);
+
+	/** Store a single amplitude at the given position.
+	 *
+	 *  @param isConjugated If true, the Hermitian conjugate of the
+	 *  amplitude is stored. The basis indices are those of the stored
+	 *  amplitude. */
+	void storeAmplitude(
+		int position,
+		const HoppingAmplitude &ha,
+		int fromBasisIndex,
+		int toBasisIndex,
+		bool isConjugated
+	);
+
+	/** Get position of the first amplitude with a 'from'-basis index
+	 *  larger than the one at the given position. */
+	int getNextColumnStart(int position) const;
+
+	/** Copying is not allowed since the arrays are owned by the object. */
+	AmplitudeArray(const AmplitudeArray &amplitudeArray);
+
+	/** Assignment is not allowed since the arrays are owned by the
+	 *  object. */
+	AmplitudeArray& operator=(const AmplitudeArray &rhs);
+};
+
+inline bool AmplitudeArray::getIsConstructed() const{
+	return fromBasisIndices != NULL;
+}
+
+inline int AmplitudeArray::getSize() const{
+	return size;
+}
+
+inline bool AmplitudeArray::getHermitianStorage() const{
+	return hermitianStorage;
+}
+
+inline const int* AmplitudeArray::getFromBasisIndices() const{
+	return fromBasisIndices;
+}
+
+inline const int* AmplitudeArray::getToBasisIndices() const{
+	return toBasisIndices;
+}
+
+inline const std::complex<double>* AmplitudeArray::getValues() const{
+	return values;
+}
+
+inline const int* AmplitudeArray::getCallbackIds() const{
+	return callbackIds;
+}
+
+inline int AmplitudeArray::getNumCallbacks() const{
+	return callbackGroups.size();
+}
+
+inline const std::vector<int>& AmplitudeArray::getCallbackGroupPositions(
+	int callbackId
+) const{
+	return callbackGroups.at(callbackId).positions;
+}
+
+inline void AmplitudeArray::setCallbackDirtyTracking(
+	bool callbackDirtyTracking
+){
+	this->callbackDirtyTracking = callbackDirtyTracking;
+}
+
+inline bool AmplitudeArray::getCallbackDirtyTracking() const{
+	return callbackDirtyTracking;
+}
+
+inline bool AmplitudeArray::getIsCallbackDirty(int callbackId) const{
+	return !callbackDirtyTracking || callbackGroups.at(callbackId).isDirty;
+}
+
+inline unsigned int AmplitudeArray::getCallbackVersion(
+	int callbackId
+) const{
+	return callbackGroups.at(callbackId).version;
+}
+
+inline int AmplitudeArray::getNumCallbackAmplitudes() const{
+	return callbackPositions.size();
+}
+
+inline const std::vector<int>& AmplitudeArray::getCallbackPositions() const{
+	return callbackPositions;
+}
+
+inline AmplitudeArray::Range::Range(int begin, int end){
+	this->begin = begin;
+	this->end = end;
+}
+
+inline AmplitudeArray::Range AmplitudeArray::getRange() const{
+	return Range(0, size);
+}
+
+};	//End of namespace TBTK
+
+#endif
@@ -25,11 +25,17 @@
 
 #include "HoppingAmplitude.h"
 #include "TreeNode.h"
+#include "IndexHashTable.h"
+#include "PhysicalIndexTable.h"
+#include "AmplitudeArray.h"
+#include "BlockStructure.h"
+#include "BasisReordering.h"
 #include "Streams.h"
 #include "TBTKMacros.h"
 
 #include <vector>
 #include <complex>
+#include <mutex>
 
 namespace TBTK{
 
@@ -41,6 +47,12 @@ namespace TBTK{
  *  AmplitudeSet, the construct method has to be called in order to construct
  *  an appropriate Hilbert space. The AmplitudeSet is most importantly used by
  *  the Model to store the Hamiltonian.
+ *
+ *  The lookup tables, the AmplitudeArray, and the BlockStructure are built
+ *  the first time they are needed rather than by construct(), so that
+ *  models only pay for the structures that are used by the solvers and
+ *  property extractors they are used with. The construction is thread safe,
+ *  which allows the first lookup to happen in a parallel region.
  */
 class AmplitudeSet{
 public:
@@ -64,17 +76,101 @@ public:
 	 *  @param HoppingAmplitude to add. */
 	void addHAAndHC(HoppingAmplitude ha);
 
+	/** Add the @link HoppingAmplitude HoppingAmplitudes @endlink in
+	 *  several lists in parallel. Gives the same result as adding them one
+	 *  by one in the order of the lists.
+	 *
+	 *  @param haLists Lists of HoppingAmplitudes to add. */
+	void addHAs(const std::vector<std::vector<HoppingAmplitude>*> &haLists);
+
 	/** Get all @link HoppingAmplitude HoppingAmplitudes @endlink with
-	 * given 'from'-index.
+	 * given 'from'-index. With Hermitian storage, only the stored
+	 * HoppingAmplitudes are returned. That is, those with a 'to'-index
+	 * smaller than or equal to the 'from'-index.
 	 *
 	 *  @param index 'From'-index to get HoppingAmplitudes for. */
-	const std::vector<HoppingAmplitude>* getHAs(Index index) const;
+	const std::vector<HoppingAmplitude>* getHAs(const Index &index) const;
 
 	/** Get Hilbert space index corresponding to given 'from'-index.
 	 *
 	 *  @param index 'From'-index to get Hilbert space index for. */
 	int getBasisIndex(const Index &index) const;
 
+	/** Get Hilbert space indices for an array of 'from'-indices. Resolves
+	 *  all indices in one call using the IndexHashTable, which is built
+	 *  the first time it is needed.
+	 *
+	 *  @param indices Array of 'from'-indices.
+	 *  @param numIndices Number of indices in the array.
+	 *  @param basisIndices Array able to hold numIndices basis indices.
+	 *  Will contain the Hilbert space index for each of the indices. */
+	void getBasisIndices(
+		const Index *indices,
+		int numIndices,
+		int *basisIndices
+	) const;
+
+	/** Get Hilbert space indices for a vector of 'from'-indices.
+	 *
+	 *  @param indices 'From'-indices to get Hilbert space indices for.
+	 *  @param basisIndices Array able to hold indices.size() basis
+	 *  indices. */
+	void getBasisIndices(
+		const std::vector<Index> &indices,
+		int *basisIndices
+	) const;
+
+	/** Get the amplitude value of a HoppingAmplitude in the
+	 *  AmplitudeSet. Unlike HoppingAmplitude::getAmplitude(), this also
+	 *  works for amplitudes given by batch callbacks, which are evaluated
+	 *  one by one at the basis indices of the HoppingAmplitude. The
+	 *  AmplitudeSet has to be constructed for such amplitudes. Solvers
+	 *  should use the AmplitudeArray instead, which evaluates each batch
+	 *  callback once for all of its amplitudes.
+	 *
+	 *  @param ha HoppingAmplitude to get the amplitude value for. */
+	std::complex<double> getAmplitude(const HoppingAmplitude &ha) const;
+
+	/** Get physical index corresponding to given Hilbert space index.
+	 *  Uses the PhysicalIndexTable, which is built the first time it is
+	 *  needed.
+	 *
+	 *  @param basisIndex Hilbert space index to get the physical index
+	 *  for. */
+	Index getPhysicalIndex(int basisIndex) const;
+
+	/** Get the reverse lookup table, building it if necessary. Gives
+	 *  direct access to the packed subindices of every basis state, which
+	 *  is useful when iterating over the whole basis. */
+	const PhysicalIndexTable& getPhysicalIndexTable() const;
+
+	/** Enable or disable callback dirty tracking. When enabled, callback
+	 *  amplitudes are only reevaluated if their callback has been marked
+	 *  as dirty. See AmplitudeArray. */
+	void setCallbackDirtyTracking(bool callbackDirtyTracking);
+
+	/** Mark amplitudes given by the callback as dirty. */
+	void markCallbackDirty(
+		std::complex<double> (*amplitudeCallback)(Index, Index)
+	);
+
+	/** Mark amplitudes given by the batch callback and context as
+	 *  dirty. */
+	void markCallbackDirty(
+		HoppingAmplitude::BatchCallback batchCallback,
+		void *callbackContext
+	);
+
+	/** Mark all callback amplitudes as dirty. */
+	void markAllCallbacksDirty();
+
+	/** Get the contiguous amplitude storage, building it if necessary.
+	 *  The amplitudes are ordered by 'from'-basis index, and by 'to'-basis
+	 *  index within each 'from'-basis index. Use
+	 *  AmplitudeArray::evaluateCallbacks() to update the values of
+	 *  callback amplitudes before reading the values. */
+	AmplitudeArray& getAmplitudeArray();
+
 	/** Get size of Hilbert space. */
 	int getBasisSize() const;
 
@@ -83,20 +179,60 @@ public:
 	 *  to other indices with the same initial subspace indices. */
 	bool isProperSubspace(const Index &subspace);
 
+	/** Get the decomposition of the Hilbert space into blocks that are
+	 *  not connected to each other by any HoppingAmplitude, building it if
+	 *  necessary. */
+	const BlockStructure& getBlockStructure() const;
+
 	/** Construct Hilbert space. No more @link HoppingAmplitude
-	 *  HoppingAmplitudes @endlink should be added after this call. */
+	 *  HoppingAmplitudes @endlink should be added after this call. The
+	 *  lookup tables used to map between physical indices and Hilbert
+	 *  space indices, the contiguous amplitude storage, and the block
+	 *  structure are built later, the first time they are needed. */
 	void construct();
 
 	/** Returns true if the Hilbert space basis has been constructed. */
 	bool getIsConstructed() const;
 
+	/** Enable or disable Hermitian storage. Has to be set before any
+	 *  HoppingAmplitude is added. With Hermitian storage the Hamiltonian
+	 *  is assumed to be Hermitian, and only the HoppingAmplitudes with a
+	 *  'to'-index smaller than or equal to the 'from'-index are added to
+	 *  the tree. The remaining HoppingAmplitudes are assumed to be the
+	 *  Hermitian conjugates of these and are dropped. The AmplitudeArray
+	 *  and the COO format contain the same triangle, ordered such that
+	 *  the 'to'-basis index is smaller than or equal to the 'from'-basis
+	 *  index, and the CSR and SELL formats are built from this triangle.
+	 *  The Iterator expands the stored triangle to the full matrix.
+	 *  Disabled by default. */
+	void setHermitianStorage(bool hermitianStorage);
+
+	/** Returns true if Hermitian storage is enabled. */
+	bool getHermitianStorage() const;
+
+	/** Enable or disable basis reordering. Has to be set before
+	 *  construct() is called. When enabled, the basis indices are
+	 *  permuted using the reverse Cuthill-McKee ordering to reduce the
+	 *  bandwidth of the Hamiltonian. The permutation is transparent to
+	 *  code that maps between physical indices and basis indices through
+	 *  the AmplitudeSet. Disabled by default. */
+	void setBasisReordering(bool basisReordering);
+
+	/** Returns true if basis reordering is enabled. */
+	bool getBasisReordering() const;
+
 	/** Sort HoppingAmplitudes. */
 	void sort();
 
-	/** Construct Hamiltonian on COO format. */
+	/** Construct Hamiltonian on COO format. With Hermitian storage, only
+	 *  the matrix elements with column index smaller than or equal to
+	 *  the row index are stored. Each off-diagonal element then also
+	 *  represents its Hermitian conjugate. */
 	void constructCOO();
 
-	/** Destruct Hamiltonian on COO format. */
+	/** Destruct Hamiltonian on COO format. Also destructs the CSR and
+	 *  SELL formats, since these are built from and updated through the
+	 *  COO format. */
 	void destructCOO();
 
 	/** Reconstruct Hamiltonian on COO format. Only has any effect if a
@@ -104,11 +240,21 @@ public:
 	 *  reflect changes in the Hamiltonain due to changes in values
 	 *  returned by HoppingAmplitude-callback functions. The function is
 	 *  intended to be called by the Model whenever it is notified of
-	 *  possible changes in values returned by the callback-functions. */
+	 *  possible changes in values returned by the callback-functions.
+	 *
+	 *  The sparsity pattern is kept from the first construction, and only
+	 *  the matrix elements that contain callback amplitudes are
+	 *  reevaluated and updated in place. Only the matrix elements of
+	 *  callback groups that have been evaluated since the COO format was
+	 *  last updated are updated, also if the evaluation was triggered by
+	 *  someone else, such as a solver that reads the AmplitudeArray
+	 *  directly. */
 	void reconstructCOO();
 
 	/** Get number of matrix elements in the Hamiltonian corresponding to
-	 *  the AmplitudeSet. */
+	 *  the AmplitudeSet. That is, the number of matrix elements on COO
+	 *  format, which only contains one triangle with Hermitian
+	 *  storage. */
 	int getNumMatrixElements() const;
 
 	/** Get row indices on COO format. */
@@ -120,8 +266,77 @@ public:
 	/** Get row indices on COO format. */
 	const std::complex<double>* getCOOValues() const;
 
+	/** Construct Hamiltonian on CSR format. The CSR format shares column
+	 *  indices and values with the COO format, which is constructed first
+	 *  if it does not already exist. The matrix elements are stored in
+	 *  row major order, and the elements of row n are stored at positions
+	 *  csrRowPointers[n] to csrRowPointers[n+1]-1. Values updated by
+	 *  reconstructCOO() are therefore also updated on CSR format. With
+	 *  Hermitian storage, row n only contains the matrix elements with
+	 *  column index smaller than or equal to n. */
+	void constructCSR();
+
+	/** Destruct Hamiltonian on CSR format. */
+	void destructCSR();
+
+	/** Get row pointers on CSR format. Contains basisSize+1 elements. */
+	const int* getCSRRowPointers() const;
+
+	/** Get col indices on CSR format. */
+	const int* getCSRColIndices() const;
+
+	/** Get values on CSR format. */
+	const std::complex<double>* getCSRValues() const;
+
+	/** Construct Hamiltonian on sliced ELLPACK (SELL-C-sigma) format. The
+	 *  rows are sorted by decreasing number of matrix elements within
+	 *  windows of sortingScope rows, and are then grouped into chunks of
+	 *  chunkSize rows. Each chunk is padded to the length of its longest
+	 *  row and stored column major, so that the rows of a chunk can be
+	 *  processed in SIMD lanes. Element m of the row in slot r of chunk c
+	 *  is stored at position sellChunkPointers[c] + m*chunkSize + r.
+	 *  Padding elements have value zero. The CSR format is constructed
+	 *  first if it does not already exist, and values updated by
+	 *  reconstructCOO() are also updated on SELL format.
+	 *
+	 *  @param chunkSize Number of rows per chunk (C).
+	 *  @param sortingScope Number of rows within which rows are sorted by
+	 *  length (sigma). Should be a multiple of chunkSize. */
+	void constructSELL(int chunkSize = 8, int sortingScope = 256);
+
+	/** Destruct Hamiltonian on SELL format. */
+	void destructSELL();
+
+	/** Get chunk size on SELL format. */
+	int getSELLChunkSize() const;
+
+	/** Get number of chunks on SELL format. */
+	int getSELLNumChunks() const;
+
+	/** Get chunk pointers on SELL format. Contains numChunks+1
+	 *  elements. */
+	const int* getSELLChunkPointers() const;
+
+	/** Get chunk lengths on SELL format. That is, the number of elements
+	 *  in the longest row of each chunk. */
+	const int* getSELLChunkLengths() const;
+
+	/** Get row permutation on SELL format. Contains numChunks*chunkSize
+	 *  elements, where element n is the row stored in slot n, or -1 for
+	 *  padding slots past the last row. */
+	const int* getSELLRowPermutation() const;
+
+	/** Get col indices on SELL format. */
+	const int* getSELLColIndices() const;
+
+	/** Get values on SELL format. */
+	const std::complex<double>* getSELLValues() const;
+
 	/** Iterator for iterating through @link HoppingAmplitude
-	 *  HoppingAmplitudes @endlink. */
+	 *  HoppingAmplitudes @endlink. With Hermitian storage, each stored
+	 *  off-diagonal HoppingAmplitude is followed by its Hermitian
+	 *  conjugate, which means that the iterator visits the full
+	 *  matrix. */
 	class Iterator{
 	public:
 		/** Destructor. */
@@ -140,11 +355,44 @@ public:
 		friend class AmplitudeSet;
 
 		/** Private constructor. Limits the ability to construct the
-		 *  iterator to the AmplitudeSet. */
-		Iterator(const TreeNode *tree);
+		 *  iterator to the AmplitudeSet.
+		 *
+		 *  @param tree Tree to iterate over.
+		 *  @param hermitianStorage Flag indicating whether the
+		 *  Hermitian conjugates of the stored HoppingAmplitudes should
+		 *  be visited too.
+		 *  @param subspace If not NULL, only the Hermitian conjugates
+		 *  with a 'from'-index that starts with the given subspace are
+		 *  visited. */
+		Iterator(
+			const TreeNode *tree,
+			bool hermitianStorage,
+			const Index *subspace = NULL
+		);
 
 		/** TreeNode iterator. Implements the actual iteration. */
 		TreeNode::Iterator* it;
+
+		/** Flag indicating whether the Hermitian conjugates of the
+		 *  stored HoppingAmplitudes are visited. */
+		bool hermitianStorage;
+
+		/** Subspace that the 'from'-index of the visited Hermitian
+		 *  conjugates has to start with, or NULL if all Hermitian
+		 *  conjugates are visited. */
+		Index *subspace;
+
+		/** Hermitian conjugate of the stored HoppingAmplitude that the
+		 *  TreeNode iterator points at. Only valid if atConjugate is
+		 *  true. */
+		HoppingAmplitude conjugate;
+
+		/** Flag indicating whether the current HoppingAmplitude is
+		 *  the Hermitian conjugate. */
+		bool atConjugate;
+
+		/** Returns true if the Index starts with the subspace. */
+		bool isInSubspace(const Index &index) const;
 	};
 
 	/** Returns an iterator for iterating through @link HoppingAmplitude
@@ -154,7 +402,12 @@ public:
 	/** Returns an iterator for iterating through @link HoppingAmplitude
 	 *  HoppingAmplitudes @endlink. The iterator is restricted to the
 	 *  subspace for which the 'from'-index starts with the indices in
-	 *  the argument 'subspace'. */
+	 *  the argument 'subspace'. Only the subtree of the subspace is
+	 *  traversed. With Hermitian storage, the Hermitian conjugates of
+	 *  the HoppingAmplitudes in the subtree are therefore only visited if
+	 *  their 'from'-index also is in the subspace, while
+	 *  HoppingAmplitudes whose Hermitian conjugate is stored outside of
+	 *  the subspace are not visited. */
 	AmplitudeSet::Iterator getIterator(const Index &subspace) const;
 
 	/** Print tree structure. Mainly for debuging. */
@@ -194,9 +447,53 @@ private:
 	/** Flag indicating whether the AmplitudeSet have been constructed. */
 	bool isConstructed;
 
+	/** Flag indicating whether Hermitian storage is enabled. */
+	bool hermitianStorage;
+
+	/** Flag indicating whether basis reordering is enabled. */
+	bool basisReordering;
+
 	/** Flag indicating whether the AmplitudeSet have been sorted. */
 	bool isSorted;
 
+	/** Lookup table for mapping physical indices to Hilbert space
+	 *  indices. Used instead of walking the tree. Built by
+	 *  constructIndexHashTable(). */
+	mutable IndexHashTable indexHashTable;
+
+	/** Lookup table for mapping Hilbert space indices to physical
+	 *  indices. Built by constructPhysicalIndexTable(). */
+	mutable PhysicalIndexTable physicalIndexTable;
+
+	/** Contiguous storage of the HoppingAmplitudes. Built by
+	 *  constructAmplitudeArray(). */
+	mutable AmplitudeArray amplitudeArray;
+
+	/** Decomposition of the Hilbert space into independent blocks. Built
+	 *  by constructBlockStructure(). */
+	mutable BlockStructure blockStructure;
+
+	/** Flags ensuring that each of the structures above is built once. */
+	mutable std::once_flag indexHashTableFlag;
+	mutable std::once_flag physicalIndexTableFlag;
+	mutable std::once_flag amplitudeArrayFlag;
+	mutable std::once_flag blockStructureFlag;
+
+	/** Build the IndexHashTable unless it already has been built. */
+	void constructIndexHashTable() const;
+
+	/** Build the PhysicalIndexTable unless it already has been built. */
+	void constructPhysicalIndexTable() const;
+
+	/** Build the AmplitudeArray unless it already has been built. Also
+	 *  builds the PhysicalIndexTable, which is used to evaluate
+	 *  callbacks. */
+	void constructAmplitudeArray() const;
+
+	/** Build the BlockStructure unless it already has been built. Also
+	 *  builds the AmplitudeArray. */
+	void constructBlockStructure() const;
+
 	/** Number of matrix elements in AmplitudeSet. */
 	int numMatrixElements;
 
@@ -208,25 +505,166 @@ private:
 
 	/** COO format values. */
 	std::complex<double> *cooValues;
+
+	/** Position in the AmplitudeArray of the first amplitude that
+	 *  contributes to each COO matrix element. Contains
+	 *  numMatrixElements+1 elements, with the last being the number of
+	 *  amplitudes. */
+	int *cooElementStarts;
+
+	/** COO matrix elements that have contributions from callback
+	 *  amplitudes. */
+	int *cooCallbackElements;
+
+	/** Number of elements in cooCallbackElements. */
+	int numCOOCallbackElements;
+
+	/** COO matrix elements that have contributions from each callback
+	 *  group. */
+	std::vector<std::vector<int>> cooCallbackGroupElements;
+
+	/** Version of each callback group at the last update of the COO
+	 *  values. See AmplitudeArray::getCallbackVersion(). */
+	std::vector<unsigned int> cooCallbackVersions;
+
+	/** Get the COO matrix elements that the given amplitudes contribute
+	 *  to, in increasing order and without duplicates.
+	 *
+	 *  @param positions Positions of the amplitudes in the
+	 *  AmplitudeArray, in increasing order. */
+	std::vector<int> getCOOElements(const std::vector<int> &positions) const;
+
+	/** CSR format row pointers. */
+	int *csrRowPointers;
+
+	/** SELL format chunk size. */
+	int sellChunkSize;
+
+	/** SELL format number of chunks. */
+	int sellNumChunks;
+
+	/** SELL format chunk pointers. */
+	int *sellChunkPointers;
+
+	/** SELL format chunk lengths. */
+	int *sellChunkLengths;
+
+	/** SELL format row permutation. */
+	int *sellRowPermutation;
+
+	/** SELL format column indices. */
+	int *sellColIndices;
+
+	/** SELL format values. */
+	std::complex<double> *sellValues;
+
+	/** Position on SELL format of each COO matrix element. */
+	int *sellPositions;
+
+	/** Calculate the value of a COO matrix element from the amplitudes
+	 *  in the AmplitudeArray. Also updates the values on SELL format if
+	 *  it is constructed. */
+	void updateCOOValue(int element);
+
+	/** Returns true if the HoppingAmplitude is to be added to the tree.
+	 *  That is, unless Hermitian storage is enabled and the 'to'-index is
+	 *  larger than the 'from'-index. */
+	bool isStored(const HoppingAmplitude &ha) const;
 };
 
 inline void AmplitudeSet::addHA(HoppingAmplitude ha){
-	tree.add(ha);
+	if(isStored(ha))
+		tree.add(ha);
 }
 
 inline void AmplitudeSet::addHAAndHC(HoppingAmplitude ha){
-	tree.add(ha);
-	tree.add(ha.getHermitianConjugate());
+	if(isStored(ha))
+		tree.add(ha);
+	HoppingAmplitude hc = ha.getHermitianConjugate();
+	if(isStored(hc))
+		tree.add(hc);
 }
 
-inline const std::vector<HoppingAmplitude>* AmplitudeSet::getHAs(Index index) const{
+inline bool AmplitudeSet::isStored(const HoppingAmplitude &ha) const{
+	return !hermitianStorage
+		|| ha.toIndex.equals(ha.fromIndex)
+		|| ha.toIndex < ha.fromIndex;
+}
+
+inline const std::vector<HoppingAmplitude>* AmplitudeSet::getHAs(const Index &index) const{
 	return tree.getHAs(index);
 }
 
 inline int AmplitudeSet::getBasisIndex(const Index &index) const{
+	if(isConstructed){
+		constructIndexHashTable();
+		int basisIndex = indexHashTable.getBasisIndex(index);
+		if(basisIndex != -1)
+			return basisIndex;
+	}
+
+	//Not a basis state (or not yet constructed). Let the tree resolve the
+	//index, which also takes care of reporting invalid indices.
 	return tree.getBasisIndex(index);
 }
 
+inline Index AmplitudeSet::getPhysicalIndex(int basisIndex) const{
+	TBTKAssert(
+		isConstructed,
+		"AmplitudeSet::getPhysicalIndex()",
+		"AmplitudeSet has to be constructed first.",
+		""
+	);
+
+	constructPhysicalIndexTable();
+	return physicalIndexTable.getPhysicalIndex(basisIndex);
+}
+
+inline const PhysicalIndexTable& AmplitudeSet::getPhysicalIndexTable() const{
+	TBTKAssert(
+		isConstructed,
+		"AmplitudeSet::getPhysicalIndexTable()",
+		"AmplitudeSet has to be constructed first.",
+		""
+	);
+
+	constructPhysicalIndexTable();
+	return physicalIndexTable;
+}
+
+inline AmplitudeArray& AmplitudeSet::getAmplitudeArray(){
+	TBTKAssert(
+		isConstructed,
+		"AmplitudeSet::getAmplitudeArray()",
+		"AmplitudeSet has to be constructed first.",
+		""
+	);
+
+	constructAmplitudeArray();
+	return amplitudeArray;
+}
+
+inline void AmplitudeSet::setCallbackDirtyTracking(bool callbackDirtyTracking){
+	amplitudeArray.setCallbackDirtyTracking(callbackDirtyTracking);
+}
+
+inline void AmplitudeSet::markCallbackDirty(
+	std::complex<double> (*amplitudeCallback)(Index, Index)
+){
+	amplitudeArray.markCallbackDirty(amplitudeCallback);
+}
+
+inline void AmplitudeSet::markCallbackDirty(
+	HoppingAmplitude::BatchCallback batchCallback,
+	void *callbackContext
+){
+	amplitudeArray.markCallbackDirty(batchCallback, callbackContext);
+}
+
+inline void AmplitudeSet::markAllCallbacksDirty(){
+	amplitudeArray.markAllCallbacksDirty();
+}
+
 inline int AmplitudeSet::getBasisSize() const{
 	return tree.basisSize;
 }
@@ -235,6 +673,18 @@ inline bool AmplitudeSet::isProperSubspace(const Index &subspace){
 	return tree.isProperSubspace(subspace);
 }
 
+inline const BlockStructure& AmplitudeSet::getBlockStructure() const{
+	TBTKAssert(
+		isConstructed,
+		"AmplitudeSet::getBlockStructure()",
+		"AmplitudeSet has to be constructed first.",
+		""
+	);
+
+	constructBlockStructure();
+	return blockStructure;
+}
+
 inline void AmplitudeSet::construct(){
 	TBTKAssert(
 		!isConstructed,
@@ -243,7 +693,18 @@ inline void AmplitudeSet::construct(){
 		""
 	);
 
+	if(hermitianStorage)
+		tree.addMissingToIndices();
 	tree.generateBasisIndices();
+	if(basisReordering){
+		int *permutation = new int[tree.basisSize];
+		BasisReordering::calculateReverseCuthillMcKee(
+			tree,
+			permutation
+		);
+		tree.permuteBasisIndices(permutation);
+		delete [] permutation;
+	}
 	isConstructed = true;
 }
 
@@ -251,6 +712,38 @@ inline bool AmplitudeSet::getIsConstructed() const{
 	return isConstructed;
 }
 
+inline void AmplitudeSet::setHermitianStorage(bool hermitianStorage){
+	TBTKAssert(
+		tree.getNumChildren() == 0
+		&& tree.hoppingAmplitudes.size() == 0,
+		"AmplitudeSet::setHermitianStorage()",
+		"HoppingAmplitudes have already been added.",
+		"Hermitian storage has to be set before any HoppingAmplitude"
+		<< " is added."
+	);
+
+	this->hermitianStorage = hermitianStorage;
+}
+
+inline bool AmplitudeSet::getHermitianStorage() const{
+	return hermitianStorage;
+}
+
+inline void AmplitudeSet::setBasisReordering(bool basisReordering){
+	TBTKAssert(
+		!isConstructed,
+		"AmplitudeSet::setBasisReordering()",
+		"AmplitudeSet is already constructed.",
+		"Basis reordering has to be set before construct() is called."
+	);
+
+	this->basisReordering = basisReordering;
+}
+
+inline bool AmplitudeSet::getBasisReordering() const{
+	return basisReordering;
+}
+
 inline void AmplitudeSet::sort(){
 	TBTKAssert(
 		isConstructed,
@@ -277,6 +770,69 @@ inline const std::complex<double>* AmplitudeSet::getCOOValues() const{
 	return cooValues;
 }
 
+inline const int* AmplitudeSet::getCSRRowPointers() const{
+	return csrRowPointers;
+}
+
+inline const int* AmplitudeSet::getCSRColIndices() const{
+	if(csrRowPointers == NULL)
+		return NULL;
+	else
+		return cooColIndices;
+}
+
+inline const std::complex<double>* AmplitudeSet::getCSRValues() const{
+	if(csrRowPointers == NULL)
+		return NULL;
+	else
+		return cooValues;
+}
+
+inline int AmplitudeSet::getSELLChunkSize() const{
+	return sellChunkSize;
+}
+
+inline int AmplitudeSet::getSELLNumChunks() const{
+	return sellNumChunks;
+}
+
+inline const int* AmplitudeSet::getSELLChunkPointers() const{
+	return sellChunkPointers;
+}
+
+inline const int* AmplitudeSet::getSELLChunkLengths() const{
+	return sellChunkLengths;
+}
+
+inline const int* AmplitudeSet::getSELLRowPermutation() const{
+	return sellRowPermutation;
+}
+
+inline const int* AmplitudeSet::getSELLColIndices() const{
+	return sellColIndices;
+}
+
+inline const std::complex<double>* AmplitudeSet::getSELLValues() const{
+	return sellValues;
+}
+
+inline void AmplitudeSet::updateCOOValue(int element){
+	const std::complex<double> *values = amplitudeArray.getValues();
+	int start = cooElementStarts[element];
+	int end = cooElementStarts[element+1];
+
+	//Note: The sorted AmplitudeSet is in ordered column major order, while
+	//the COO format is in row major order. The Hermitian conjugat eis
+	//therefore taken here.
+	std::complex<double> value = conj(values[start]);
+	for(int n = start+1; n < end; n++)
+		value += conj(values[n]);
+
+	cooValues[element] = value;
+	if(sellPositions != NULL)
+		sellValues[sellPositions[element]] = value;
+}
+
 };	//End of namespace TBTK
 
 #endif
@@ -0,0 +1,80 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file BasisReordering.h
+ *  @brief Bandwidth minimizing reordering of the Hilbert space basis
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_BASIS_REORDERING
+#define COM_DAFER45_TBTK_BASIS_REORDERING
+
+#include "TreeNode.h"
+
+#include <vector>
+
+namespace TBTK{
+
+/** Calculates permutations of the Hilbert space basis that reduce the
+ *  bandwidth of the Hamiltonian. The basis indices generated by
+ *  TreeNode::generateBasisIndices() follow the lexicographic order of the
+ *  physical indices, which for example gives a bandwidth proportional to the
+ *  width of a ribbon if the first subindex runs along the ribbon. A smaller
+ *  bandwidth improves the memory locality of sparse matrix-vector
+ *  multiplication and allows banded eigensolvers to be used. */
+class BasisReordering{
+public:
+	/** Calculate the reverse Cuthill-McKee ordering of the basis states in
+	 *  a tree for which the basis indices have been generated. Each
+	 *  connected component of the Hamiltonian is traversed breadth first
+	 *  starting from a pseudo-peripheral state, visiting neighbors in
+	 *  order of increasing degree, and the resulting order is reversed.
+	 *
+	 *  @param tree Root node of the tree.
+	 *  @param permutation Array able to hold tree.basisSize elements. Will
+	 *  contain the new basis index of each basis state, suitable for
+	 *  TreeNode::permuteBasisIndices(). */
+	static void calculateReverseCuthillMcKee(
+		const TreeNode &tree,
+		int *permutation
+	);
+private:
+	/** Add the connections of the basis states in the tree to the
+	 *  adjacency lists. Called recursively. */
+	static void addConnections(
+		const TreeNode &treeNode,
+		const TreeNode &tree,
+		std::vector<std::vector<int>> &adjacency
+	);
+
+	/** Traverse the connected component of the given state breadth
+	 *  first, visiting neighbors in order of increasing degree. The
+	 *  states are appended to order, and their distance from the start
+	 *  state is stored in levels.
+	 *
+	 *  @return The number of levels in the traversal. */
+	static int traverse(
+		int start,
+		const std::vector<std::vector<int>> &adjacency,
+		std::vector<int> &levels,
+		std::vector<int> &order
+	);
+};
+
+};	//End of namespace TBTK
+
+#endif
@@ -0,0 +1,172 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file BlockStructure.h
+ *  @brief Decomposition of the Hilbert space into independent blocks
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_BLOCK_STRUCTURE
+#define COM_DAFER45_TBTK_BLOCK_STRUCTURE
+
+#include "AmplitudeArray.h"
+#include "TBTKMacros.h"
+
+namespace TBTK{
+
+/** Decomposition of the Hilbert space into blocks that are not connected to
+ *  each other by any HoppingAmplitude. The blocks are the connected
+ *  components of the graph formed by the basis states and the amplitudes in
+ *  an AmplitudeArray. This finds every proper subspace found by
+ *  TreeNode::isProperSubspace(), such as spin sectors, but also decoupled
+ *  subsystems that are not separated by the first subindices.
+ *
+ *  The blocks are numbered in order of their smallest basis index, and the
+ *  basis indices of block k are stored in increasing order at
+ *  basisIndices[blockStarts[k]] to basisIndices[blockStarts[k+1]-1]. Since
+ *  the order within a block is kept, a matrix element (from, to) with
+ *  from >= to also has intra block indices with from >= to. */
+class BlockStructure{
+public:
+	/** Constructor. */
+	BlockStructure();
+
+	/** Destructor. */
+	~BlockStructure();
+
+	/** Build the block structure from an AmplitudeArray.
+	 *
+	 *  @param amplitudeArray Amplitudes that connect the basis states.
+	 *  @param basisSize Number of basis states. */
+	void construct(const AmplitudeArray &amplitudeArray, int basisSize);
+
+	/** Free all memory used by the block structure. */
+	void clear();
+
+	/** Returns true if the block structure has been constructed. */
+	bool getIsConstructed() const;
+
+	/** Get number of blocks. */
+	int getNumBlocks() const;
+
+	/** Get number of basis states in the given block.
+	 *
+	 *  @param block Block number. */
+	int getBlockSize(int block) const;
+
+	/** Get the basis indices of the given block, in increasing order. The
+	 *  array contains getBlockSize(block) elements.
+	 *
+	 *  @param block Block number. */
+	const int* getBasisIndices(int block) const;
+
+	/** Get the block that the given basis index belongs to.
+	 *
+	 *  @param basisIndex Basis index. */
+	int getBlock(int basisIndex) const;
+
+	/** Get the position of the given basis index within its block.
+	 *
+	 *  @param basisIndex Basis index. */
+	int getIntraBlockIndex(int basisIndex) const;
+private:
+	/** Number of basis states. */
+	int basisSize;
+
+	/** Number of blocks. */
+	int numBlocks;
+
+	/** Offsets into basisIndices for each block, numBlocks+1 elements. */
+	int *blockStarts;
+
+	/** Basis indices grouped by block. */
+	int *basisIndices;
+
+	/** Block of each basis index. */
+	int *blocks;
+
+	/** Position of each basis index within its block. */
+	int *intraBlockIndices;
+
+	/** Find the root of the set that the element belongs to, while
+	 *  compressing the path to it. */
+	static int findRoot(int *parents, int element);
+
+	/** Copying is not allowed since the block structure owns its
+	 *  memory. */
+	BlockStructure(const BlockStructure &blockStructure);
+
+	/** Assignment is not allowed since the block structure owns its
+	 *  memory. */
+	BlockStructure& operator=(const BlockStructure &rhs);
+};
+
+inline bool BlockStructure::getIsConstructed() const{
+	return blockStarts != NULL;
+}
+
+inline int BlockStructure::getNumBlocks() const{
+	return numBlocks;
+}
+
+inline int BlockStructure::getBlockSize(int block) const{
+	TBTKAssert(
+		block >= 0 && block < numBlocks,
+		"BlockStructure::getBlockSize()",
+		"Block out of bound.",
+		""
+	);
+
+	return blockStarts[block+1] - blockStarts[block];
+}
+
+inline const int* BlockStructure::getBasisIndices(int block) const{
+	TBTKAssert(
+		block >= 0 && block < numBlocks,
+		"BlockStructure::getBasisIndices()",
+		"Block out of bound.",
+		""
+	);
+
+	return &basisIndices[blockStarts[block]];
+}
+
+inline int BlockStructure::getBlock(int basisIndex) const{
+	TBTKAssert(
+		basisIndex >= 0 && basisIndex < basisSize,
+		"BlockStructure::getBlock()",
+		"Hilbert space index out of bound.",
+		""
+	);
+
+	return blocks[basisIndex];
+}
+
+inline int BlockStructure::getIntraBlockIndex(int basisIndex) const{
+	TBTKAssert(
+		basisIndex >= 0 && basisIndex < basisSize,
+		"BlockStructure::getIntraBlockIndex()",
+		"Hilbert space index out of bound.",
+		""
+	);
+
+	return intraBlockIndices[basisIndex];
+}
+
+};	//End of namespace TBTK
+
+#endif
@@ -24,6 +24,7 @@
 #define COM_DAFER45_TBTK_HOPPING_AMPLITUDE
 
 #include "Index.h"
+#include "TBTKMacros.h"
 
 #include <complex>
 #include <initializer_list>
@@ -41,6 +42,29 @@ namespace TBTK{
  */
 class HoppingAmplitude{
 public:
+	/** Callback that evaluates a batch of amplitudes in one call. The
+	 *  callback is passed the 'to'- and 'from'-basis indices of
+	 *  numAmplitudes amplitudes, and should write the corresponding
+	 *  values to amplitudes. The context pointer is the one passed to the
+	 *  HoppingAmplitude constructor and can be used to carry user state.
+	 *  The Hermitian conjugate of a batch callback amplitude uses the same
+	 *  callback and context, with 'to'- and 'from'-indices interchanged.
+	 *  Physical indices can be obtained from the basis indices through
+	 *  Model::getPhysicalIndex().
+	 *
+	 *  Amplitudes with batch callbacks are evaluated through the
+	 *  AmplitudeArray of a constructed AmplitudeSet, or one by one
+	 *  through AmplitudeSet::getAmplitude(). getAmplitude() can not be
+	 *  used for them, since the basis indices are not known to the
+	 *  HoppingAmplitude. */
+	typedef void (*BatchCallback)(
+		const int *toBasisIndices,
+		const int *fromBasisIndices,
+		int numAmplitudes,
+		std::complex<double> *amplitudes,
+		void *context
+	);
+
 	/** Index to jump from (annihilate). */
 	Index fromIndex;
 
@@ -100,6 +124,26 @@ public:
 		Index toUnitCell
 	);
 
+	/** Constructor. Takes a batch callback and a context pointer rather
+	 *  than a parameter value. All amplitudes with the same batch
+	 *  callback and context are evaluated in one call to the callback. */
+	HoppingAmplitude(
+		Index fromIndex,
+		Index toIndex,
+		BatchCallback batchCallback,
+		void *callbackContext
+	);
+
+	/** Constructor. Takes a batch callback and a context pointer rather
+	 *  than a parameter value. All amplitudes with the same batch
+	 *  callback and context are evaluated in one call to the callback. */
+	HoppingAmplitude(
+		BatchCallback batchCallback,
+		void *callbackContext,
+		Index toIndex,
+		Index fromIndex
+	);
+
 	/** Copy constructor. */
 	HoppingAmplitude(const HoppingAmplitude &ha);
 
@@ -112,6 +156,14 @@ public:
 	/** Get the amplitude value \f$a_{ij}\f$. */
 	std::complex<double> getAmplitude() const;
 private:
+	/** AmplitudeArray reads the amplitude and callback directly when
+	 *  storing amplitudes in contiguous arrays. */
+	friend class AmplitudeArray;
+
+	/** AmplitudeSet evaluates batch callbacks at the basis indices of
+	 *  the HoppingAmplitude. See AmplitudeSet::getAmplitude(). */
+	friend class AmplitudeSet;
+
 	/** Amplitude \f$a_{ij}\f$. Will be used if amplitudeCallback is NULL. */
 	std::complex<double> amplitude;
 
@@ -121,13 +173,29 @@ private:
 		Index toIndex,
 		Index fromIndex
 	);
+
+	/** Batch callback for runtime evaluation of amplitudes. Used instead
+	 *  of amplitude if not NULL. */
+	BatchCallback batchCallback;
+
+	/** Context pointer passed to the batch callback. */
+	void *callbackContext;
 };
 
 inline std::complex<double> HoppingAmplitude::getAmplitude() const{
 	if(amplitudeCallback)
 		return amplitudeCallback(toIndex, fromIndex);
-	else
-		return amplitude;
+	TBTKAssert(
+		batchCallback == NULL,
+		"HoppingAmplitude::getAmplitude()",
+		"Amplitudes given by batch callbacks can not be evaluated"
+		<< " individually.",
+		"Use AmplitudeSet::getAmplitude() or"
+		<< " AmplitudeSet::getAmplitudeArray() to evaluate the"
+		<< " amplitudes."
+	);
+
+	return amplitude;
 }
 
 };	//End of namespace TBTK
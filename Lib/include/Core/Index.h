@@ -25,6 +25,9 @@
 
 #include "Streams.h"
 
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace TBTK{
@@ -40,22 +43,38 @@ enum {
 /** Flexible physical index for indexing arbitrary models. Each index can
  *  contain an arbitrary number of subindices. For example {x, y, spin},
  *  {x, y, z, orbital, spin}, and {subsystem, x, y, z, orbital, spin}.
- */
+ *
+ *  Indices with up to INLINE_CAPACITY subindices are stored inside the Index
+ *  itself, and only longer indices allocate memory on the heap. Since
+ *  models typically contain millions of indices with only a few subindices
+ *  each, this avoids one heap allocation per Index. */
 class Index{
 public:
 	/** Constructor. */
-	Index(std::initializer_list<int> i) : indices(i){};
+	Index(std::initializer_list<int> i);
 
 	/** Constructor. */
-	Index(std::vector<int> i) : indices(i){};
+	Index(const std::vector<int> &i);
 
 	/** Copy constructor. */
-	Index(const Index &index) : indices(index.indices){};
+	Index(const Index &index);
+
+	/** Move constructor. */
+	Index(Index &&index);
 
 	/** Constructor. Concatenates two indices into one total index of the
 	 *  form {head, tail}. */
 	Index(const Index &head, const Index &tail);
 
+	/** Destructor. */
+	~Index();
+
+	/** Assignment operator. */
+	Index& operator=(const Index &rhs);
+
+	/** Move assignment operator. */
+	Index& operator=(Index &&rhs);
+
 	/** Compare this index with another index. Returns true if the indices
 	 * have the same number of subindices and all subindices are equal.
 	 * @param index Index to compare with.
@@ -101,27 +120,156 @@ public:
 	/** Comparison operator. Returns false if the TreeNode structure would
 	 *  generate a larger Hilbert space index for i1 than for i2. */
 	friend bool operator>(const Index &i1, const Index &i2);
+
+	/** IndexHashTable reads the subindices directly when hashing. */
+	friend class IndexHashTable;
+
+	/** Maximum number of subindices stored without heap allocation. */
+	static const unsigned int INLINE_CAPACITY = 8;
 private:
-	/** Subindex container. */
-	std::vector<int> indices;
+	/** Number of subindices. */
+	unsigned int numSubindices;
+
+	/** Number of subindices that fit in the current storage. Equal to
+	 *  INLINE_CAPACITY as long as the subindices are stored inline. */
+	unsigned int capacity;
+
+	/** Subindex container. The inline array is used as long as capacity
+	 *  equals INLINE_CAPACITY, otherwise heapSubindices points to heap
+	 *  allocated memory. */
+	union{
+		int inlineSubindices[INLINE_CAPACITY];
+		int *heapSubindices;
+	};
+
+	/** Returns true if the subindices are stored inline. */
+	bool isInline() const;
+
+	/** Get pointer to the first subindex. */
+	int* getData();
+
+	/** Get pointer to the first subindex. Constant version. */
+	const int* getData() const;
+
+	/** Ensure that there is room for at least newCapacity subindices. */
+	void reserve(unsigned int newCapacity);
+
+	/** Initialize the Index with a copy of the given subindices. */
+	void initialize(const int *subindices, unsigned int numSubindices);
 };
 
-inline void Index::print() const{
-	Streams::out << "{";
-	for(unsigned int n = 0; n < indices.size(); n++){
-		if(n != 0)
-			Streams::out << ", ";
-		Streams::out << indices.at(n);
+inline Index::Index(std::initializer_list<int> i){
+	initialize(i.begin(), i.size());
+}
+
+inline Index::Index(const std::vector<int> &i){
+	initialize(i.data(), i.size());
+}
+
+inline Index::Index(const Index &index){
+	initialize(index.getData(), index.numSubindices);
+}
+
+inline Index::Index(Index &&index){
+	numSubindices = index.numSubindices;
+	capacity = index.capacity;
+	if(index.isInline()){
+		for(unsigned int n = 0; n < numSubindices; n++)
+			inlineSubindices[n] = index.inlineSubindices[n];
 	}
-	Streams::out << "}\n";
+	else{
+		heapSubindices = index.heapSubindices;
+		index.capacity = INLINE_CAPACITY;
+		index.numSubindices = 0;
+	}
+}
+
+inline Index::~Index(){
+	if(!isInline())
+		delete [] heapSubindices;
+}
+
+inline Index& Index::operator=(const Index &rhs){
+	if(this != &rhs){
+		numSubindices = 0;
+		reserve(rhs.numSubindices);
+		const int *source = rhs.getData();
+		int *destination = getData();
+		for(unsigned int n = 0; n < rhs.numSubindices; n++)
+			destination[n] = source[n];
+		numSubindices = rhs.numSubindices;
+	}
+
+	return *this;
+}
+
+inline Index& Index::operator=(Index &&rhs){
+	if(this != &rhs){
+		if(rhs.isInline()){
+			*this = static_cast<const Index&>(rhs);
+		}
+		else{
+			if(!isInline())
+				delete [] heapSubindices;
+			numSubindices = rhs.numSubindices;
+			capacity = rhs.capacity;
+			heapSubindices = rhs.heapSubindices;
+			rhs.capacity = INLINE_CAPACITY;
+			rhs.numSubindices = 0;
+		}
+	}
+
+	return *this;
+}
+
+inline bool Index::isInline() const{
+	return capacity == INLINE_CAPACITY;
+}
+
+inline int* Index::getData(){
+	if(isInline())
+		return inlineSubindices;
+	else
+		return heapSubindices;
+}
+
+inline const int* Index::getData() const{
+	if(isInline())
+		return inlineSubindices;
+	else
+		return heapSubindices;
+}
+
+inline void Index::initialize(
+	const int *subindices,
+	unsigned int numSubindices
+){
+	this->numSubindices = numSubindices;
+	int *destination;
+	if(numSubindices <= INLINE_CAPACITY){
+		capacity = INLINE_CAPACITY;
+		destination = inlineSubindices;
+	}
+	else{
+		capacity = numSubindices;
+		heapSubindices = new int[capacity];
+		destination = heapSubindices;
+	}
+	for(unsigned int n = 0; n < numSubindices; n++)
+		destination[n] = subindices[n];
+}
+
+inline void Index::print() const{
+	Streams::out << toString() << "\n";
 }
 
 inline std::string Index::toString() const{
+	const int *subindices = getData();
 	std::string str = "{";
-	for(unsigned int n = 0; n < indices.size(); n++){
+	for(unsigned int n = 0; n < numSubindices; n++){
 		if(n != 0)
 			str += ", ";
-		str += std::to_string(indices.at(n));
+		str += std::to_string(subindices[n]);
 	}
 	str += "}";
 
@@ -129,56 +277,68 @@ inline std::string Index::toString() const{
 }
 
 inline bool Index::equals(const Index &index, bool allowWildcard) const{
-	if(indices.size() == index.indices.size()){
-		for(unsigned int n = 0; n < indices.size(); n++){
-			if(indices.at(n) != index.indices.at(n)){
-				if(!allowWildcard)
+	if(numSubindices != index.numSubindices)
+		return false;
+
+	const int *subindices0 = getData();
+	const int *subindices1 = index.getData();
+	for(unsigned int n = 0; n < numSubindices; n++){
+		if(subindices0[n] != subindices1[n]){
+			if(!allowWildcard)
+				return false;
+			else{
+				if(
+					subindices0[n] == IDX_ALL ||
+					subindices1[n] == IDX_ALL
+				)
+					continue;
+				else
 					return false;
-				else{
-					if(
-						indices.at(n) == IDX_ALL ||
-						index.indices.at(n) == IDX_ALL
-					)
-						continue;
-					else
-						return false;
-				}
 			}
 		}
 	}
-	else{
-		return false;
-	}
 
 	return true;
 }
 
 inline int& Index::at(unsigned int n){
-	return indices.at(n);
+	if(n >= numSubindices)
+		throw std::out_of_range("Index::at()");
+
+	return getData()[n];
 }
 
 inline const int& Index::at(unsigned int n) const{
-	return indices.at(n);
+	if(n >= numSubindices)
+		throw std::out_of_range("Index::at()");
+
+	return getData()[n];
 }
 
 inline unsigned int Index::size() const{
-	return indices.size();
+	return numSubindices;
 }
 
 inline void Index::push_back(int subindex){
-	indices.push_back(subindex);
+	if(numSubindices == capacity)
+		reserve(2*capacity);
+
+	getData()[numSubindices++] = subindex;
 }
 
 inline int Index::popFront(){
-	int first = indices.at(0);
-	indices.erase(indices.begin());
+	int *subindices = getData();
+	int first = at(0);
+	for(unsigned int n = 1; n < numSubindices; n++)
+		subindices[n-1] = subindices[n];
+	numSubindices--;
 
 	return first;
 }
 
 inline int Index::popBack(){
-	int last = indices.back();
-	indices.pop_back();
+	int last = getData()[numSubindices-1];
+	numSubindices--;
 
 	return last;
 }
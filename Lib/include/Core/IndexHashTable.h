@@ -0,0 +1,207 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file IndexHashTable.h
+ *  @brief Flat lookup table mapping physical indices to basis indices
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_INDEX_HASH_TABLE
+#define COM_DAFER45_TBTK_INDEX_HASH_TABLE
+
+#include "Index.h"
+#include "TreeNode.h"
+
+namespace TBTK{
+
+/** Open addressing hash table that maps physical indices to Hilbert space
+ *  basis indices. The table is built from a TreeNode for which the basis
+ *  indices already have been generated, and provides the same result as
+ *  TreeNode::getBasisIndex() for every Index that corresponds to a basis
+ *  state. In contrast to the tree, which is walked one subindex at a time,
+ *  the table resolves an Index with a single hash computation followed by a
+ *  short linear probe into contiguous memory.
+ *
+ *  Each slot is stored as slotSize consecutive integers of the form
+ *  [basisIndex] [number of subindices] [subindex 0] [subindex 1] ..., padded
+ *  to the largest number of subindices in the tree. The key is therefore
+ *  compared directly in the slot, and a lookup usually touches a single
+ *  cache line. Empty slots have basisIndex -1. */
+class IndexHashTable{
+public:
+	/** Constructor. */
+	IndexHashTable();
+
+	/** Destructor. */
+	~IndexHashTable();
+
+	/** Build the table from a tree for which the basis indices have been
+	 *  generated.
+	 *
+	 *  @param tree Root node of the tree to build the table from. */
+	void construct(const TreeNode &tree);
+
+	/** Free all memory used by the table. */
+	void clear();
+
+	/** Returns true if the table has been constructed. */
+	bool getIsConstructed() const;
+
+	/** Get basis index for the given physical index.
+	 *
+	 *  @param index Physical index to get basis index for.
+	 *
+	 *  @return The basis index, or -1 if the Index does not correspond to
+	 *  any basis state. */
+	int getBasisIndex(const Index &index) const;
+
+	/** Get basis indices for an array of physical indices.
+	 *
+	 *  @param indices Array of physical indices.
+	 *  @param numIndices Number of indices in the array.
+	 *  @param basisIndices Array able to hold numIndices basis indices.
+	 *  Will contain the basis index for each of the indices, or -1 for
+	 *  indices that does not correspond to any basis state. */
+	void getBasisIndices(
+		const Index *indices,
+		int numIndices,
+		int *basisIndices
+	) const;
+
+	/** Get basis indices for an array of pointers to physical indices.
+	 *  Allows for indices stored inside other objects to be resolved
+	 *  without first copying them to a contiguous array.
+	 *
+	 *  @param indices Array of pointers to physical indices.
+	 *  @param numIndices Number of indices in the array.
+	 *  @param basisIndices Array able to hold numIndices basis indices.
+	 *  Will contain the basis index for each of the indices, or -1 for
+	 *  indices that does not correspond to any basis state. */
+	void getBasisIndices(
+		const Index *const *indices,
+		int numIndices,
+		int *basisIndices
+	) const;
+private:
+	/** Number of slots in the table. Always a power of two. */
+	unsigned int numSlots;
+
+	/** Number of integers per slot. */
+	unsigned int slotSize;
+
+	/** Largest number of subindices of any basis state. */
+	unsigned int maxKeySize;
+
+	/** Slots, numSlots*slotSize integers. */
+	int *slots;
+
+	/** Number of indices that are hashed and prefetched together in the
+	 *  batch lookups, allowing the cache misses of the lookups in a block
+	 *  to overlap. */
+	static const int BATCH_BLOCK_SIZE = 32;
+
+	/** Calculate hash for an Index. */
+	static unsigned int hash(const Index &index);
+
+	/** Get the basis index for the given physical index, starting the
+	 *  probe sequence at the given slot. */
+	int probe(const Index &index, unsigned int firstSlot) const;
+
+	/** Get basis indices for a range of physical indices. Shared
+	 *  implementation of the batch lookups.
+	 *
+	 *  @param getIndex Function returning the nth physical index. */
+	template<typename IndexAccessor>
+	void resolveBasisIndices(
+		IndexAccessor getIndex,
+		int numIndices,
+		int *basisIndices
+	) const;
+
+	/** Insert all basis states in the tree into the table. Called
+	 *  recursively.
+	 *
+	 *  @param treeNode Node to insert basis states for.
+	 *  @param key Subindices leading to the current node. */
+	void insert(const TreeNode &treeNode, Index &key);
+
+	/** Get the largest number of subindices of any basis state in the
+	 *  tree. Called recursively. */
+	static unsigned int getMaxKeySize(
+		const TreeNode &treeNode,
+		unsigned int depth
+	);
+
+	/** Copying is not allowed since the table owns its memory. */
+	IndexHashTable(const IndexHashTable &indexHashTable);
+
+	/** Assignment is not allowed since the table owns its memory. */
+	IndexHashTable& operator=(const IndexHashTable &rhs);
+};
+
+inline bool IndexHashTable::getIsConstructed() const{
+	return slots != NULL;
+}
+
+inline unsigned int IndexHashTable::hash(const Index &index){
+	//FNV-1a over the subindices, followed by a final avalanche step to
+	//spread consecutive subindices over the whole table.
+	const int *subindices = index.getData();
+	unsigned long long h = 14695981039346656037ull;
+	for(unsigned int n = 0; n < index.numSubindices; n++){
+		h ^= (unsigned int)subindices[n];
+		h *= 1099511628211ull;
+	}
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+
+	return (unsigned int)h;
+}
+
+inline int IndexHashTable::getBasisIndex(const Index &index) const{
+	return probe(index, hash(index) & (numSlots - 1));
+}
+
+inline int IndexHashTable::probe(
+	const Index &index,
+	unsigned int firstSlot
+) const{
+	unsigned int size = index.numSubindices;
+	if(size > maxKeySize)
+		return -1;
+
+	const int *subindices = index.getData();
+	unsigned int mask = numSlots - 1;
+	for(unsigned int s = firstSlot; ; s = (s + 1) & mask){
+		const int *slot = &slots[s*slotSize];
+		if(slot[0] == -1)
+			return -1;
+		if((unsigned int)slot[1] != size)
+			continue;
+
+		unsigned int n = 0;
+		while(n < size && slot[2+n] == subindices[n])
+			n++;
+		if(n == size)
+			return slot[0];
+	}
+}
+
+};	//End of namespace TBTK
+
+#endif
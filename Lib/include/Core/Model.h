@@ -53,11 +53,29 @@ public:
 
 	/** Get Hilbert space index corresponding to given 'from'-index.
 	 *  @param index 'From'-index to get Hilbert space index for. */
-	int getBasisIndex(Index index);
+	int getBasisIndex(const Index &index);
+
+	/** Get Hilbert space indices for a vector of 'from'-indices.
+	 *  @param indices 'From'-indices to get Hilbert space indices for.
+	 *  @param basisIndices Array able to hold indices.size() basis
+	 *  indices. */
+	void getBasisIndices(
+		const std::vector<Index> &indices,
+		int *basisIndices
+	);
+
+	/** Get physical index corresponding to given Hilbert space index.
+	 *  @param basisIndex Hilbert space index to get physical index for. */
+	Index getPhysicalIndex(int basisIndex);
 
 	/** Get size of Hilbert space. */
 	int getBasisSize();
 
+	/** Get the decomposition of the Hilbert space into blocks that are
+	 *  not connected to each other by any HoppingAmplitude, such as spin
+	 *  sectors or decoupled subsystems. Available after construct(). */
+	const BlockStructure& getBlockStructure();
+
 	/** Construct Hilbert space. No more @link HoppingAmplitude
 	 *  HoppingAmplitudes @endlink should be added after this call. */
 	void construct();
@@ -71,12 +89,70 @@ public:
 	/** Destruct Hamiltonian on COO format. */
 	void destructCOO();
 
+	/** Construct Hamiltonian on CSR format. The CSR format shares column
+	 *  indices and values with the COO format. */
+	void constructCSR();
+
+	/** Destruct Hamiltonian on CSR format. */
+	void destructCSR();
+
+	/** Construct Hamiltonian on SELL-C-sigma format. See
+	 *  AmplitudeSet::constructSELL().
+	 *
+	 *  @param chunkSize Number of rows per chunk (C).
+	 *  @param sortingScope Number of rows within which rows are sorted by
+	 *  length (sigma). */
+	void constructSELL(int chunkSize = 8, int sortingScope = 256);
+
+	/** Destruct Hamiltonian on SELL-C-sigma format. */
+	void destructSELL();
+
 	/** To be called when HoppingAmplitudes need to be reevaluated. This is
 	 *  required if the AmplitudeSet in addition to its standard storage
 	 *  format also utilizes a more effective format such as COO format and
 	 *  some HoppingAmplitudes are evaluated through the use of callbacks. */
 	void reconstructCOO();
 
+	/** Enable or disable Hermitian storage. Has to be called before any
+	 *  HoppingAmplitude is added. The Hamiltonian is then assumed to be
+	 *  Hermitian, and only one triangle of it is stored in the tree, the
+	 *  amplitude arrays, and on COO, CSR, and SELL format. See
+	 *  AmplitudeSet::setHermitianStorage(). */
+	void setHermitianStorage(bool hermitianStorage);
+
+	/** Returns true if Hermitian storage is enabled. */
+	bool getHermitianStorage() const;
+
+	/** Enable or disable bandwidth minimizing basis reordering. Has to be
+	 *  called before construct(). See AmplitudeSet::setBasisReordering().
+	 */
+	void setBasisReordering(bool basisReordering);
+
+	/** Returns true if basis reordering is enabled. */
+	bool getBasisReordering() const;
+
+	/** Enable or disable callback dirty tracking. When enabled, amplitudes
+	 *  given by callbacks are only reevaluated by reconstructCOO() and
+	 *  solvers if their callback has been marked as dirty since the last
+	 *  evaluation. Disabled by default, in which case all callback
+	 *  amplitudes are reevaluated every time. */
+	void setCallbackDirtyTracking(bool callbackDirtyTracking);
+
+	/** Mark amplitudes given by the callback as dirty. */
+	void markCallbackDirty(
+		std::complex<double> (*amplitudeCallback)(Index, Index)
+	);
+
+	/** Mark amplitudes given by the batch callback and context as
+	 *  dirty. */
+	void markCallbackDirty(
+		HoppingAmplitude::BatchCallback batchCallback,
+		void *callbackContext
+	);
+
+	/** Mark all callback amplitudes as dirty. */
+	void markAllCallbacksDirty();
+
 	/** Set temperature. */
 	void setTemperature(double temperature);
 
@@ -147,10 +223,25 @@ inline int Model::getBasisSize(){
 	return amplitudeSet->getBasisSize();
 }
 
-inline int Model::getBasisIndex(Index index){
+inline const BlockStructure& Model::getBlockStructure(){
+	return amplitudeSet->getBlockStructure();
+}
+
+inline int Model::getBasisIndex(const Index &index){
 	return amplitudeSet->getBasisIndex(index);
 }
 
+inline void Model::getBasisIndices(
+	const std::vector<Index> &indices,
+	int *basisIndices
+){
+	amplitudeSet->getBasisIndices(indices, basisIndices);
+}
+
+inline Index Model::getPhysicalIndex(int basisIndex){
+	return amplitudeSet->getPhysicalIndex(basisIndex);
+}
+
 inline bool Model::getIsConstructed(){
 	return amplitudeSet->getIsConstructed();
 }
@@ -164,10 +255,65 @@ inline void Model::destructCOO(){
 	amplitudeSet->destructCOO();
 }
 
+inline void Model::constructCSR(){
+	amplitudeSet->sort();
+	amplitudeSet->constructCSR();
+}
+
+inline void Model::destructCSR(){
+	amplitudeSet->destructCSR();
+}
+
+inline void Model::constructSELL(int chunkSize, int sortingScope){
+	amplitudeSet->sort();
+	amplitudeSet->constructSELL(chunkSize, sortingScope);
+}
+
+inline void Model::destructSELL(){
+	amplitudeSet->destructSELL();
+}
+
 inline void Model::reconstructCOO(){
 	amplitudeSet->reconstructCOO();
 }
 
+inline void Model::setHermitianStorage(bool hermitianStorage){
+	amplitudeSet->setHermitianStorage(hermitianStorage);
+}
+
+inline bool Model::getHermitianStorage() const{
+	return amplitudeSet->getHermitianStorage();
+}
+
+inline void Model::setBasisReordering(bool basisReordering){
+	amplitudeSet->setBasisReordering(basisReordering);
+}
+
+inline bool Model::getBasisReordering() const{
+	return amplitudeSet->getBasisReordering();
+}
+
+inline void Model::setCallbackDirtyTracking(bool callbackDirtyTracking){
+	amplitudeSet->setCallbackDirtyTracking(callbackDirtyTracking);
+}
+
+inline void Model::markCallbackDirty(
+	std::complex<double> (*amplitudeCallback)(Index, Index)
+){
+	amplitudeSet->markCallbackDirty(amplitudeCallback);
+}
+
+inline void Model::markCallbackDirty(
+	HoppingAmplitude::BatchCallback batchCallback,
+	void *callbackContext
+){
+	amplitudeSet->markCallbackDirty(batchCallback, callbackContext);
+}
+
+inline void Model::markAllCallbacksDirty(){
+	amplitudeSet->markAllCallbacksDirty();
+}
+
 inline void Model::setTemperature(double temperature){
 	this->temperature = temperature;
 }
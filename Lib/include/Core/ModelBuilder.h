@@ -0,0 +1,121 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file ModelBuilder.h
+ *  @brief Thread parallel assembly of Model Hamiltonians
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_MODEL_BUILDER
+#define COM_DAFER45_TBTK_MODEL_BUILDER
+
+#include "HoppingAmplitude.h"
+#include "Model.h"
+#include "TBTKMacros.h"
+
+#include <vector>
+
+#include <omp.h>
+
+namespace TBTK{
+
+/** The ModelBuilder allows the @link HoppingAmplitude HoppingAmplitudes
+ *  @endlink of a Model to be added from several OpenMP threads at once. Each
+ *  thread appends to a private buffer, and ModelBuilder::build() merges the
+ *  buffers into the Model in parallel and constructs the Hilbert space.
+ *
+ *  The buffers are merged in the order of the thread numbers, and the result
+ *  is the same as if the HoppingAmplitudes were added with Model::addHA() in
+ *  that order. In particular, a loop of the form
+ *
+ *  #pragma omp parallel for schedule(static)
+ *  for(int x = 0; x < SIZE_X; x++)
+ *      builder.addHA(...);
+ *
+ *  gives the same Model as the corresponding serial loop. */
+class ModelBuilder{
+public:
+	/** Constructor. Creates one buffer for each of the threads that
+	 *  omp_get_max_threads() reports. */
+	ModelBuilder();
+
+	/** Destructor. */
+	~ModelBuilder();
+
+	/** Add a HoppingAmplitude to the buffer of the calling thread. */
+	void addHA(HoppingAmplitude ha);
+
+	/** Add a HoppingAmplitude and its Hermitian conjugate to the buffer
+	 *  of the calling thread. */
+	void addHAAndHC(HoppingAmplitude ha);
+
+	/** Get the number of HoppingAmplitudes in the buffers. */
+	unsigned int getNumHAs() const;
+
+	/** Merge the buffers into the Model, construct the Hilbert space, and
+	 *  sort the HoppingAmplitudes. The Model can already contain
+	 *  HoppingAmplitudes added through Model::addHA(), in which case these
+	 *  come before the buffered HoppingAmplitudes, but must not be
+	 *  constructed. The buffers are emptied.
+	 *
+	 *  @param model Model to add the HoppingAmplitudes to. */
+	void build(Model &model);
+private:
+	/** Number of buffers. */
+	int numBuffers;
+
+	/** One buffer per thread. Allocated separately to keep the buffers of
+	 *  different threads on separate cache lines. */
+	std::vector<HoppingAmplitude> **buffers;
+
+	/** Copying is not allowed. */
+	ModelBuilder(const ModelBuilder &modelBuilder);
+
+	/** Assignment is not allowed. */
+	ModelBuilder& operator=(const ModelBuilder &rhs);
+
+	/** Get buffer for the calling thread. */
+	std::vector<HoppingAmplitude>* getBuffer();
+};
+
+inline void ModelBuilder::addHA(HoppingAmplitude ha){
+	getBuffer()->push_back(ha);
+}
+
+inline void ModelBuilder::addHAAndHC(HoppingAmplitude ha){
+	std::vector<HoppingAmplitude> *buffer = getBuffer();
+	buffer->push_back(ha);
+	buffer->push_back(ha.getHermitianConjugate());
+}
+
+inline std::vector<HoppingAmplitude>* ModelBuilder::getBuffer(){
+	int thread = omp_get_thread_num();
+	TBTKAssert(
+		thread < numBuffers,
+		"ModelBuilder::addHA()",
+		"Thread number '" << thread << "' is larger than the number of"
+		<< " buffers '" << numBuffers << "'.",
+		"The number of threads cannot be increased after the"
+		<< " ModelBuilder has been created."
+	);
+
+	return buffers[thread];
+}
+
+};	//End of namespace TBTK
+
+#endif
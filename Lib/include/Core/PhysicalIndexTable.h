@@ -0,0 +1,130 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file PhysicalIndexTable.h
+ *  @brief Flat lookup table mapping basis indices to physical indices
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_PHYSICAL_INDEX_TABLE
+#define COM_DAFER45_TBTK_PHYSICAL_INDEX_TABLE
+
+#include "Index.h"
+#include "TreeNode.h"
+#include "TBTKMacros.h"
+
+namespace TBTK{
+
+/** Reverse lookup table that maps Hilbert space basis indices to physical
+ *  indices. The table is built from a TreeNode for which the basis indices
+ *  already have been generated, and provides the same result as
+ *  TreeNode::getPhysicalIndex(), which searches the whole tree. The
+ *  subindices of all basis states are packed into a single array in basis
+ *  order, and the subindices of basis state b are stored at
+ *  keys[keyOffsets[b]] to keys[keyOffsets[b+1]-1]. Lookups are therefore
+ *  O(1), and the whole basis can be iterated over by stepping through the
+ *  array. */
+class PhysicalIndexTable{
+public:
+	/** Constructor. */
+	PhysicalIndexTable();
+
+	/** Destructor. */
+	~PhysicalIndexTable();
+
+	/** Build the table from a tree for which the basis indices have been
+	 *  generated.
+	 *
+	 *  @param tree Root node of the tree to build the table from. */
+	void construct(const TreeNode &tree);
+
+	/** Free all memory used by the table. */
+	void clear();
+
+	/** Returns true if the table has been constructed. */
+	bool getIsConstructed() const;
+
+	/** Get physical index for given basis index.
+	 *
+	 *  @param basisIndex Basis index to get the physical index for. */
+	Index getPhysicalIndex(int basisIndex) const;
+
+	/** Get number of subindices of the physical index corresponding to
+	 *  the given basis index.
+	 *
+	 *  @param basisIndex Basis index. */
+	int getNumSubindices(int basisIndex) const;
+
+	/** Get pointer to the packed subindices of the physical index
+	 *  corresponding to the given basis index. The array contains
+	 *  getNumSubindices(basisIndex) elements.
+	 *
+	 *  @param basisIndex Basis index. */
+	const int* getSubindices(int basisIndex) const;
+private:
+	/** Number of basis states in the table. */
+	int basisSize;
+
+	/** Offsets into keys for each basis state, basisSize+1 elements. */
+	int *keyOffsets;
+
+	/** Packed subindices for all basis states, in basis order. */
+	int *keys;
+
+	/** Count the number of subindices of each basis state. Called
+	 *  recursively. */
+	void countSubindices(const TreeNode &treeNode, int depth);
+
+	/** Store the subindices of each basis state. Called recursively. */
+	void storeSubindices(const TreeNode &treeNode, Index &key);
+
+	/** Copying is not allowed since the table owns its memory. */
+	PhysicalIndexTable(const PhysicalIndexTable &physicalIndexTable);
+
+	/** Assignment is not allowed since the table owns its memory. */
+	PhysicalIndexTable& operator=(const PhysicalIndexTable &rhs);
+};
+
+inline bool PhysicalIndexTable::getIsConstructed() const{
+	return keyOffsets != NULL;
+}
+
+inline int PhysicalIndexTable::getNumSubindices(int basisIndex) const{
+	TBTKAssert(
+		basisIndex >= 0 && basisIndex < basisSize,
+		"PhysicalIndexTable::getNumSubindices()",
+		"Hilbert space index out of bound.",
+		""
+	);
+
+	return keyOffsets[basisIndex+1] - keyOffsets[basisIndex];
+}
+
+inline const int* PhysicalIndexTable::getSubindices(int basisIndex) const{
+	TBTKAssert(
+		basisIndex >= 0 && basisIndex < basisSize,
+		"PhysicalIndexTable::getSubindices()",
+		"Hilbert space index out of bound.",
+		""
+	);
+
+	return &keys[keyOffsets[basisIndex]];
+}
+
+};	//End of namespace TBTK
+
+#endif
@@ -29,7 +29,15 @@
 namespace TBTK{
 
 /** TreeNode structure used to build a tree for stroing @link HoppingAmplitude
- *   HoppingAmplitudes @endlink. Used by AmplitudeSet.*/
+ *   HoppingAmplitudes @endlink. Used by AmplitudeSet.
+ *
+ *  The child nodes are allocated from an arena owned by the root node, and
+ *  are referred to through an array of pointers. The child array is dense,
+ *  with entry n corresponding to subindex n, as long as the subindices are
+ *  (close to) contiguous. Otherwise the child array is sparse and kept sorted
+ *  with the subindex of each child stored in a separate array. In both cases
+ *  the children are ordered by subindex, and no empty dummy nodes are created
+ *  for subindices that are never used. */
 class TreeNode{
 public:
 	/** Basis index for the Hamiltonian. */
@@ -43,16 +51,40 @@ public:
 	 *   subindex index. */
 	std::vector<HoppingAmplitude> hoppingAmplitudes;
 
-	/** Child nodes. Never non-empty at the same time as hoppingAmplitudes
-	*/
-	std::vector<TreeNode> children;
-
 	/** Constructor. */
 	TreeNode();
 
+	/** Destructor. */
+	~TreeNode();
+
 	/** Add a HoppingAmplitude. */
 	void add(HoppingAmplitude ha);
 
+	/** Add the @link HoppingAmplitude HoppingAmplitudes @endlink in
+	 *  several lists in parallel. The result is the same as if the
+	 *  HoppingAmplitudes in the lists were added one by one in the order
+	 *  of the lists. The HoppingAmplitudes are partitioned on the
+	 *  subindices and the resulting subtrees are filled in parallel, each
+	 *  allocating its nodes from its own arena.
+	 *
+	 *  @param haLists Lists of HoppingAmplitudes to add. */
+	void add(const std::vector<std::vector<HoppingAmplitude>*> &haLists);
+
+	/** Get number of child slots. In dense mode some of the slots can be
+	 *  empty, in which case getChild() returns NULL. */
+	unsigned int getNumChildren() const;
+
+	/** Get child in given slot, or NULL if the slot is empty. Slots are
+	 *  ordered by subindex.
+	 *
+	 *  @param n Slot number in the range [0, getNumChildren()). */
+	const TreeNode* getChild(unsigned int n) const;
+
+	/** Get the subindex that the child in the given slot corresponds to.
+	 *
+	 *  @param n Slot number in the range [0, getNumChildren()). */
+	int getChildSubindex(unsigned int n) const;
+
 	/** Get sub tree. */
 	const TreeNode* getSubTree(const Index &subspace) const;
 
@@ -63,19 +95,43 @@ public:
 
 	/** Get all @link HoppingAmplitude HoppingAmplitudes @endlink with
 	 *  given 'from'-index. */
-	const std::vector<HoppingAmplitude>* getHAs(Index index) const;
+	const std::vector<HoppingAmplitude>* getHAs(const Index &index) const;
 
 	/** Get Hilbert space basis index for given physical index. */
 	int getBasisIndex(const Index &index) const;
 
-	/** Get physical index for given Hilbert space absis index. */
+	/** Get physical index for given Hilbert space absis index. Since the
+	 *  basis indices may have been permuted, subtrees do not necessarily
+	 *  cover contiguous ranges of basis indices and the tree is searched
+	 *  depth first. Each call is therefore O(N) in the number of basis
+	 *  states. Use AmplitudeSet::getPhysicalIndex(), which uses a
+	 *  PhysicalIndexTable with O(1) lookups, when looking up more than a
+	 *  few indices. */
 	Index getPhysicalIndex(int basisIndex) const;
 
+	/** Add an empty leaf for every 'to'-index that is not the 'from'-index
+	 *  of any HoppingAmplitude. Used when only one of each
+	 *  HoppingAmplitude and its Hermitian conjugate is stored, in which
+	 *  case an index may only appear as 'to'-index. Has to be called
+	 *  before generateBasisIndices() to give such indices a basis
+	 *  index. */
+	void addMissingToIndices();
+
 	/** Generate Hilbert space indices. No more @link HoppingAmplitude
-	 *   HoppingAmplitudes @endlink should be added after this call. */
+	 *   HoppingAmplitudes @endlink should be added after this call. Every
+	 *  leaf, including the empty leaves added by addMissingToIndices(), is
+	 *  given a basis index. */
 	void generateBasisIndices();
 
-	/** Sort HoppingAmplitudes in row order. */
+	/** Permute the Hilbert space indices generated by
+	 *  generateBasisIndices().
+	 *
+	 *  @param permutation Array with basisSize elements, where element n
+	 *  is the new basis index of the state with basis index n. */
+	void permuteBasisIndices(const int *permutation);
+
+	/** Sort HoppingAmplitudes in row order. The subtrees of the root
+	 *  node are sorted in parallel. */
 	void sort(TreeNode *rootNode);
 
 	/** Print @link HoppingAmplitude HoppingAmplitudes @endlink. Mainly for
@@ -89,7 +145,7 @@ public:
 		/** Root node to iterate from. */
 		const TreeNode* tree;
 
-		/** Current index at which the iterator points at. */
+		/** Current child slots at which the iterator points at. */
 		std::vector<int> currentIndex;
 
 		/** Current HoppingAmplitude that the iterator points at at the
@@ -108,6 +164,10 @@ public:
 		/** Get HoppingAmplitude currently pointed at. */
 		const HoppingAmplitude* getHA() const;
 	private:
+		/** Leaf node that the iterator currently points at. Avoids
+		 *  walking the tree from the root in getHA(). */
+		const TreeNode *currentLeaf;
+
 		/** Search after next HoppingAmplitude. Is used by
 		 *  TreeNode::Iterator::searchNext and called recursively. */
 		bool searchNext(const TreeNode *treeNode, unsigned int subindex);
@@ -116,6 +176,65 @@ public:
 	/** Returns Iterator initialized to point at first HoppingAmplitude. */
 	Iterator begin();
 private:
+	/** Arena from which the nodes of a tree are allocated. Nodes are
+	 *  placed in blocks of increasing size and are destroyed together
+	 *  with the arena. */
+	class Arena{
+	public:
+		/** Constructor. */
+		Arena();
+
+		/** Destructor. Destroys all nodes allocated from the arena. */
+		~Arena();
+
+		/** Allocate and construct a new node. */
+		TreeNode* allocate();
+	private:
+		/** Blocks of memory holding the nodes. */
+		std::vector<TreeNode*> blocks;
+
+		/** Number of nodes constructed in each block. */
+		std::vector<unsigned int> blockSizes;
+
+		/** Number of nodes that fit in the last block. */
+		unsigned int blockCapacity;
+
+		/** Size of the first block. */
+		static const unsigned int MIN_BLOCK_CAPACITY = 16;
+
+		/** Largest block size. */
+		static const unsigned int MAX_BLOCK_CAPACITY = 4096;
+
+		/** Copying is not allowed since the arena owns its memory. */
+		Arena(const Arena &arena);
+
+		/** Assignment is not allowed since the arena owns its memory. */
+		Arena& operator=(const Arena &rhs);
+	};
+
+	/** Child nodes, ordered by subindex. Never non-empty at the same time
+	 *  as hoppingAmplitudes. The capacity of the array is the smallest
+	 *  power of two that is larger than or equal to numChildSlots. */
+	TreeNode **children;
+
+	/** Subindices of the children in sparse mode. NULL in dense mode, in
+	 *  which case the child in slot n corresponds to subindex n. */
+	int *childSubindices;
+
+	/** Number of child slots. */
+	unsigned int numChildSlots;
+
+	/** Number of children. Smaller than numChildSlots if some slots are
+	 *  empty in dense mode. */
+	unsigned int numChildren;
+
+	/** Arena used to allocate child nodes. */
+	Arena *arena;
+
+	/** Flag indicating whether the node owns the arena. Only true for the
+	 *  root node. */
+	bool isArenaOwner;
+
 	/** Flag indicating whether all HoppingAmplitudes passed to this nodes
 	 *  child nodes have the same 'to' and 'from' subindex in the position
 	 *  corresponding this node level. Is set to true when the node is
@@ -134,10 +253,62 @@ private:
 	 *  For leaf nodes the value is irrelevant. */
 	bool isPotentialBlockSeparator;
 
+	/** Constructor used by the Arena. */
+	TreeNode(Arena *arena);
+
+	/** Copying is not allowed since the tree owns its nodes. */
+	TreeNode(const TreeNode &treeNode);
+
+	/** Assignment is not allowed since the tree owns its nodes. */
+	TreeNode& operator=(const TreeNode &rhs);
+
+	/** Initialize members. Used by the constructors. */
+	void initialize(Arena *arena);
+
+	/** Get child corresponding to the given subindex, or NULL if no such
+	 *  child exists. */
+	TreeNode* findChild(int subindex) const;
+
+	/** Get the slot of the child corresponding to the given subindex. The
+	 *  child is assumed to exist. */
+	unsigned int getChildSlot(int subindex) const;
+
+	/** Get child corresponding to the given subindex. Creates the child
+	 *  if it does not already exist. */
+	TreeNode* getOrCreateChild(int subindex);
+
+	/** Get the largest subindex of any child, or -1 if the node has no
+	 *  children. */
+	int getMaxChildSubindex() const;
+
+	/** Ensure the child arrays can hold the given number of slots. */
+	void reserveChildren(unsigned int size);
+
+	/** Convert the child arrays from dense to sparse mode. */
+	void convertChildrenToSparse();
+
+	/** Convert the child arrays from sparse to dense mode. */
+	void convertChildrenToDense();
+
+	/** Get child to use when looking up the given subindex. Returns a
+	 *  pointer to an empty node if the subindex is within the range of
+	 *  the children but no child exists for it, and NULL if the subindex
+	 *  is out of range. */
+	const TreeNode* getChildForLookup(int subindex) const;
+
+	/** Get capacity of the child arrays for given number of slots. */
+	static unsigned int getChildCapacity(unsigned int size);
+
 	/** Add HoppingAmplitude. Is called by the public TreeNode::add and is
 	 *  called recursively. */
 	void add(HoppingAmplitude &ha, unsigned int subindex);
 
+	/** Add HoppingAmplitudes in parallel. Is called by the public
+	 *  TreeNode::add for lists of HoppingAmplitudes and is called
+	 *  recursively until a node level with enough children to keep all
+	 *  threads busy is reached. */
+	void add(std::vector<HoppingAmplitude*> &has, unsigned int subindex);
+
 	/** Get sub tree. Is called by TreeNode::getSubTree and is called
 	 *  recursively. */
 	const TreeNode* getSubTree(
@@ -152,7 +323,7 @@ private:
 	/** Get HoppingAmpilitudes. Is called by the public TreeNode::getHAs
 	 *  and is called recursively. */
 	const std::vector<HoppingAmplitude>* getHAs(
-		Index index,
+		const Index &index,
 		unsigned int subindex
 	) const;
 
@@ -161,14 +332,27 @@ private:
 	int getBasisIndex(const Index &index, unsigned int subindex) const;
 
 	/** Get physical index for given Hilbert space index. Is called by the
-	 *  public TreeNode::getPhysicalIndex and is called recursively. */
-	void getPhysicalIndex(int basisIndex, std::vector<int> *indices) const;
+	 *  public TreeNode::getPhysicalIndex and is called recursively.
+	 *  Returns true if the basis index is found in the subtree. The
+	 *  subtree has to be searched since the basis indices are not
+	 *  necessarily ordered if they have been permuted. */
+	bool getPhysicalIndex(int basisIndex, std::vector<int> *indices) const;
+
+	/** Collect the 'to'-indices that do not have a leaf in the tree. Is
+	 *  called by TreeNode::addMissingToIndices and is called
+	 *  recursively. */
+	void collectMissingToIndices(
+		const TreeNode &rootNode,
+		std::vector<Index> &missingIndices
+	) const;
 
-	/** Get minimum index on TreeNode. */
-	int getMinIndex() const;
+	/** Returns true if the tree has a leaf for the given index. Exits
+	 *  with an error if the index is incompatible with the tree
+	 *  structure. */
+	bool hasLeaf(const Index &index) const;
 
-	/** Get max index on TreeNode. */
-	int getMaxIndex() const;
+	/** Add an empty leaf for the given index unless it already exists. */
+	void addLeaf(const Index &index);
 
 	/** Generate Hilbert space indices. Is called by the public
 	 *  TreeNode::generateBasisIndices and is called recursively. */
@@ -183,6 +367,70 @@ private:
 	HoppingAmplitude getFirstHA() const;
 };
 
+inline unsigned int TreeNode::getNumChildren() const{
+	return numChildSlots;
+}
+
+inline const TreeNode* TreeNode::getChild(unsigned int n) const{
+	return children[n];
+}
+
+inline int TreeNode::getChildSubindex(unsigned int n) const{
+	if(childSubindices == NULL)
+		return n;
+	else
+		return childSubindices[n];
+}
+
+inline TreeNode* TreeNode::findChild(int subindex) const{
+	if(childSubindices == NULL){
+		if(subindex < 0 || (unsigned int)subindex >= numChildSlots)
+			return NULL;
+		else
+			return children[subindex];
+	}
+
+	//Binary search in the sorted sparse child array.
+	unsigned int first = 0;
+	unsigned int last = numChildSlots;
+	while(first < last){
+		unsigned int middle = (first + last)/2;
+		if(childSubindices[middle] < subindex)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	if(first < numChildSlots && childSubindices[first] == subindex)
+		return children[first];
+	else
+		return NULL;
+}
+
+inline unsigned int TreeNode::getChildSlot(int subindex) const{
+	if(childSubindices == NULL)
+		return subindex;
+
+	unsigned int first = 0;
+	unsigned int last = numChildSlots;
+	while(first < last){
+		unsigned int middle = (first + last)/2;
+		if(childSubindices[middle] < subindex)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	return first;
+}
+
+inline int TreeNode::getMaxChildSubindex() const{
+	if(numChildSlots == 0)
+		return -1;
+	else
+		return getChildSubindex(numChildSlots-1);
+}
+
 };	//End of namespace TBTK
 
 #endif
@@ -25,11 +25,13 @@
 
 #include "ChebyshevSolver.h"
 #include "Density.h"
+#include "DOS.h"
 #include "Magnetization.h"
 #include "LDOS.h"
 #include "SpinPolarizedLDOS.h"
 
 #include <iostream>
+#include <random>
 
 namespace TBTK{
 
@@ -51,6 +53,19 @@ public:
 	/** Destructor. */
 	~CPropertyExtractor();
 
+	/** Set the number of random vectors used to estimate sums over
+	 *  IDX_SUM_ALL subindices in calculateDensity() and calculateLDOS().
+	 *  A sum with more terms than the number of random vectors is then
+	 *  estimated from the expansions for random vectors with random
+	 *  phases on the summed indices, rather than from one expansion per
+	 *  term. The statistical error falls off as one over the square root
+	 *  of the number of random vectors. The random vectors are always
+	 *  propagated on CPU. Zero (default) disables the estimation. */
+	void setNumRandomVectors(int numRandomVectors);
+
+	/** Get the number of random vectors. */
+	int getNumRandomVectors();
+
 	/** Calculate Green's function. */
 	std::complex<double>* calculateGreensFunction(
 		Index to,
@@ -65,6 +80,32 @@ public:
 		ChebyshevSolver::GreensFunctionType type = ChebyshevSolver::GreensFunctionType::Retarded
 	);
 
+	/** Estimate the density of states (DOS) from the trace of the
+	 *  Green's function, using the expansions for random vectors with
+	 *  random phases on every basis state. Each random vector gives an
+	 *  unbiased estimate of the DOS, and the estimate is the average over
+	 *  the random vectors.
+	 *
+	 *  @param numRandomVectors Number of random vectors.
+	 *  @param standardError If not NULL, *standardError is set to a newly
+	 *  allocated DOS containing the standard error of the estimate, which
+	 *  requires at least two random vectors.
+	 *
+	 *  @return The DOS, summed over all basis states. */
+	Property::DOS* calculateDOS(
+		int numRandomVectors,
+		Property::DOS **standardError = NULL
+	);
+
+	/** Estimate the DOS restricted to the basis states with indices that
+	 *  match the pattern, where IDX_ALL matches any subindex. Otherwise
+	 *  the same as calculateDOS(int, Property::DOS**). */
+	Property::DOS* calculateDOS(
+		const Index &pattern,
+		int numRandomVectors,
+		Property::DOS **standardError = NULL
+	);
+
 	/** Calculate expectation value. */
 	std::complex<double> calculateExpectationValue(Index to, Index from);
 
@@ -89,6 +130,9 @@ public:
 	 *  {SIZE_X, 1, 1, NUM_SPINS} and {SIZE_X, 1, SIZE_Z, NUM_SPINS},
 	 *  respectively.
 	 *
+	 *  Sums over IDX_SUM_ALL subindices are estimated with random
+	 *  vectors if enabled with setNumRandomVectors().
+	 *
 	 *  @return A density array with size equal to the number of points
 	 *  included by specified patter-range combination.
 	 */
@@ -155,6 +199,9 @@ public:
 	 *  {SIZE_X, 1, 1, NUM_SPINS} and {SIZE_X, 1, SIZE_Z, NUM_SPINS},
 	 *  respectively.
 	 *
+	 *  Sums over IDX_SUM_ALL subindices are estimated with random
+	 *  vectors if enabled with setNumRandomVectors().
+	 *
 	 *  @return A density array with size equal to the number of points
 	 *  included by specified patter-range combination.
 	 */
@@ -235,16 +282,86 @@ private:
 	 *  functions. */
 	bool useGPUToGenerateGreensFunctions;
 
+	/** Number of random vectors used to estimate sums over IDX_SUM_ALL
+	 *  subindices. */
+	int numRandomVectors;
+
+	/** Random number generator for the phases of the random vectors. A
+	 *  fixed seed is used to make the calculations reproducible. */
+	std::mt19937 randomGenerator;
+
+	/** Calculate Chebyshev coefficients for all pairs of 'to'- and
+	 *  'from'-indices, stored as by
+	 *  ChebyshevSolver::calculateCoefficients(). */
+	std::complex<double>* calculateCoefficients(
+		std::vector<Index> &to,
+		std::vector<Index> &from
+	);
+
+	/** Calculate Chebyshev coefficients for numStates random vectors with
+	 *  random phases on the basis states in basisIndices and zero
+	 *  elsewhere, stored as by
+	 *  ChebyshevSolver::calculateStateCoefficients(). The average of the
+	 *  coefficients estimates the coefficients for the sum of the
+	 *  diagonal Green's functions of the basis states. */
+	std::complex<double>* calculateRandomStateCoefficients(
+		const std::vector<int> &basisIndices,
+		int numStates
+	);
+
+	/** Estimate the DOS for the basis states in basisIndices. Used by
+	 *  calculateDOS(). */
+	Property::DOS* calculateDOS(
+		const std::vector<int> &basisIndices,
+		int numRandomVectors,
+		Property::DOS **standardError
+	);
+
+	/** Generate Green's function from the coefficients for one pair of
+	 *  indices. */
+	std::complex<double>* generateGreensFunction(
+		std::complex<double> *coefficients,
+		ChebyshevSolver::GreensFunctionType type
+	);
+
 	/** Loops over range indices and calls the appropriate callback
-	 *  function to calculate the correct quantity. */
+	 *  function to calculate the correct quantity. The indices are passed
+	 *  to the callback in blocks of ChebyshevSolver::getBlockSize()
+	 *  indices, which are calculated in parallel when running on CPU. The
+	 *  callback stores the results for the n-th index of the block at
+	 *  n*resultSize doubles into the memory it is passed, and the results
+	 *  are then added to memory at the offsets of the indices.
+	 *
+	 *  If traceCallback is not NULL and the number of random vectors is
+	 *  larger than zero, sums over IDX_SUM_ALL subindices with more terms
+	 *  than the number of random vectors are instead estimated with
+	 *  random vectors. traceCallback is then passed the estimated
+	 *  coefficients for the sum, and stores resultSize doubles into the
+	 *  memory it is passed.
+	 *
+	 *  @param resultSize Number of doubles stored per index. */
 	void calculate(
 		void (*callback)(
 			CPropertyExtractor *cb_this,
 			void *memory,
-			const Index &index,
-			int offset
+			std::vector<Index> &indices
+		),
+		void (*traceCallback)(
+			CPropertyExtractor *cb_this,
+			std::complex<double> *coefficients,
+			double *memory
 		),
 		void *memory,
+		int resultSize,
+		Index pattern,
+		const Index &ranges
+	);
+
+	/** Appends the indices matching the pattern and the offsets at which
+	 *  to store the results for them to indices and offsets. */
+	void getIndices(
+		std::vector<Index> &indices,
+		std::vector<int> &offsets,
 		Index pattern,
 		const Index &ranges,
 		int currentOffset,
@@ -256,8 +373,17 @@ private:
 	static void calculateDensityCallback(
 		CPropertyExtractor *cb_this,
 		void *density,
-		const Index &index,
-		int offset
+		std::vector<Index> &indices
+	);
+
+	/** Calculates the density from the coefficients for a diagonal
+	 *  Green's function, or for a sum of diagonal Green's functions, and
+	 *  adds it to density. Used by calculateDensityCallback and as trace
+	 *  callback by calculateDensity. */
+	static void calculateDensityFromCoefficients(
+		CPropertyExtractor *cb_this,
+		std::complex<double> *coefficients,
+		double *density
 	);
 
 	/** !!!Not tested!!! Callback for calculating magnetization.
@@ -265,8 +391,7 @@ private:
 	static void calculateMAGCallback(
 		CPropertyExtractor *cb_this,
 		void *density,
-		const Index &index,
-		int offset
+		std::vector<Index> &indices
 	);
 
 	/** !!!Not tested!!! Callback for calculating local density of states.
@@ -274,8 +399,18 @@ private:
 	static void calculateLDOSCallback(
 		CPropertyExtractor *cb_this,
 		void *ldos,
-		const Index &index,
-		int offset
+		std::vector<Index> &indices
+	);
+
+	/** Calculates the LDOS from the coefficients for a diagonal Green's
+	 *  function, or for a sum of diagonal Green's functions, and adds it
+	 *  to the energyResolution elements of ldos. Used by
+	 *  calculateLDOSCallback, calculateDOS, and as trace callback by
+	 *  calculateLDOS. */
+	static void calculateLDOSFromCoefficients(
+		CPropertyExtractor *cb_this,
+		std::complex<double> *coefficients,
+		double *ldos
 	);
 
 	/** !!!Not tested!!! Callback for calculating spin-polarized local
@@ -283,8 +418,7 @@ private:
 	static void calculateSP_LDOSCallback(
 		CPropertyExtractor *cb_this,
 		void *sp_ldos,
-		const Index &index,
-		int offset
+		std::vector<Index> &indices
 	);
 
 	/** Hint used to pass information between calculate[Property] and
@@ -304,6 +438,21 @@ private:
 	);
 };
 
+inline void CPropertyExtractor::setNumRandomVectors(int numRandomVectors){
+	TBTKAssert(
+		numRandomVectors >= 0,
+		"CPropertyExtractor::setNumRandomVectors()",
+		"numRandomVectors cannot be negative.",
+		""
+	);
+
+	this->numRandomVectors = numRandomVectors;
+}
+
+inline int CPropertyExtractor::getNumRandomVectors(){
+	return numRandomVectors;
+}
+
 };	//End of namespace TBTK
 
 #endif
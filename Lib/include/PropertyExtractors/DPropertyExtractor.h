@@ -24,6 +24,9 @@
 #define COM_DAFER45_TBTK_D_PROPERTY_EXTRACTOR
 
 #include "DiagonalizationSolver.h"
+#include "BlockDiagonalizationSolver.h"
+#include "ChebyshevFilterSolver.h"
+#include "DistributedDiagonalizationSolver.h"
 #include "EigenValues.h"
 #include "DOS.h"
 #include "Density.h"
@@ -32,17 +35,34 @@
 #include "SpinPolarizedLDOS.h"
 
 #include <complex>
+#include <vector>
 
 namespace TBTK{
 
 /** The DPropertyExtractor extracts common physical properties such as DOS,
- *  Density, LDOS, etc. from a DiagonalizationSolver. These can then be written
- *  to file using the FileWriter.*/
+ *  Density, LDOS, etc. from a DiagonalizationSolver, a
+ *  BlockDiagonalizationSolver, a ChebyshevFilterSolver, or a
+ *  DistributedDiagonalizationSolver. These can then be written to file using
+ *  the FileWriter. For the ChebyshevFilterSolver, only the eigenstates in its
+ *  energy window contribute to the properties. For the
+ *  DistributedDiagonalizationSolver, each process calculates the
+ *  contribution from its own eigenstates, which are summed over the
+ *  processes. The calculate functions therefore have to be called on all
+ *  processes, and return the complete property on every process.*/
 class DPropertyExtractor{
 public:
 	/** Constructor. */
 	DPropertyExtractor(DiagonalizationSolver *dSolver);
 
+	/** Constructor. */
+	DPropertyExtractor(BlockDiagonalizationSolver *bSolver);
+
+	/** Constructor. */
+	DPropertyExtractor(ChebyshevFilterSolver *cfSolver);
+
+	/** Constructor. */
+	DPropertyExtractor(DistributedDiagonalizationSolver *ddSolver);
+
 	/** Destructor. */
 	~DPropertyExtractor();
 
@@ -261,46 +281,122 @@ private:
 		int offsetMultiplier
 	);
 
-	/** Callback for calculating density. Used by calculateDensity. */
-	static void calculateDensityCallback(
+	/** Basis indices of the indices visited by calculate(), together with
+	 *  the offsets into the property data. Resolved once per property so
+	 *  that the amplitudes can be accessed without tree lookups. The
+	 *  indices are grouped by offset. */
+	struct ResolvedIndices{
+		/** Subindex that is set to 0 and 1 to obtain the spin up and
+		 *  down indices, or -1 if the property is not spin resolved. */
+		int spinIndex;
+
+		/** Offsets into the property data. */
+		std::vector<int> offsets;
+
+		/** Position of the spin up (or only) and spin down indices in
+		 *  the eigenvectors returned by getEigenVector(). */
+		std::vector<int> vectorIndices[2];
+
+		/** Blocks of the spin up (or only) and spin down indices. */
+		std::vector<int> blocks[2];
+	};
+
+	/** Callback for resolving indices. Used by resolveIndices. */
+	static void resolveIndexCallback(
 		DPropertyExtractor *cb_this,
-		void *density,
+		void *resolvedIndices,
 		const Index &index,
 		int offset
 	);
 
-	/** Callback for calculating magnetization. Used by calculateMAG. */
-	static void calculateMAGCallback(
-		DPropertyExtractor *cb_this,
-		void *mag,
-		const Index &index,
-		int offset
+	/** Resolve all indices included by the pattern-range combination.
+	 *
+	 *  @param spinIndex Subindex to resolve for both spin up and down, or
+	 *  -1 for no spin resolution. */
+	void resolveIndices(
+		const Index &pattern,
+		const Index &ranges,
+		int spinIndex,
+		ResolvedIndices &resolvedIndices
 	);
 
-	/** Calback for callculating local density of states. Used by
-	 *  calculateLDOS. */
-	static void calculateLDOSCallback(
-		DPropertyExtractor *cb_this,
-		void *ldos,
-		const Index &index,
-		int offset
+	/** Resolve a physical index to its position in the eigenvectors
+	 *  returned by getEigenVector() and the block it belongs to. */
+	void resolveIndex(const Index &index, int &vectorIndex, int &block);
+
+	/** Get the range of resolved indices to be processed by the given
+	 *  thread. The ranges never split indices with the same offset. */
+	void getIndexRange(
+		const ResolvedIndices &resolvedIndices,
+		int numThreads,
+		int thread,
+		int &begin,
+		int &end
 	);
 
-	/** Callback for calculating spin-polarized local density of states.
-	 *  Used by calculateSP_LDOS. */
-	static void calculateSP_LDOSCallback(
-		DPropertyExtractor *cb_this,
-		void *sp_ldos,
-		const Index &index,
-		int offset
+	/** Calculate the occupation of each eigenstate. */
+	void calculateOccupations(std::vector<double> &occupations);
+
+	/** Calculate the energy index of each eigenstate for an energy
+	 *  resolved property, or -1 for eigenstates outside of the range. */
+	void calculateEnergyIndices(
+		double lowerBound,
+		double upperBound,
+		int resolution,
+		std::vector<int> &energyIndices
 	);
 
-	/** DiagonalizationSolver to work on. */
+	/** DiagonalizationSolver to work on. NULL if another solver is used.
+	 */
 	DiagonalizationSolver *dSolver;
 
-	/** Hint used to pass information between calculate[Property] and
-	 *  calculate[Property]Callback. */
-	void *hint;
+	/** BlockDiagonalizationSolver to work on. NULL if another solver is
+	 *  used. */
+	BlockDiagonalizationSolver *bSolver;
+
+	/** ChebyshevFilterSolver to work on. NULL if another solver is used.
+	 */
+	ChebyshevFilterSolver *cfSolver;
+
+	/** DistributedDiagonalizationSolver to work on. NULL if another solver
+	 *  is used. */
+	DistributedDiagonalizationSolver *ddSolver;
+
+	/** Get the model of the solver. */
+	Model* getModel();
+
+	/** Get the eigenvalues of the solver. */
+	const double* getSolverEigenValues();
+
+	/** Get the number of eigenstates calculated by the solver. */
+	int getNumStates();
+
+	/** Get the eigenvector of the given state. For the
+	 *  BlockDiagonalizationSolver, the eigenvector only contains the
+	 *  block of the state. For the DistributedDiagonalizationSolver, NULL
+	 *  is returned if the state is not owned by this process. */
+	const std::complex<double>* getEigenVector(int state);
+
+	/** Get the block of the given state. Always zero except for the
+	 *  BlockDiagonalizationSolver. */
+	int getStateBlock(int state);
+
+	/** Get the number of eigenstates to process at a time. Smaller than
+	 *  the number of eigenstates if a DiagonalizationSolver stores the
+	 *  eigenvectors in a file. */
+	int getEigenVectorPanelSize();
+
+	/** Make the eigenvectors of the states firstState to lastState
+	 *  resident before they are processed. */
+	void loadEigenVectorPanels(int firstState, int lastState);
+
+	/** Sum the contributions to a property over the processes when a
+	 *  DistributedDiagonalizationSolver is used. */
+	void sumOverProcesses(double *data, int size);
+
+	/** Sum the contributions to a property over the processes when a
+	 *  DistributedDiagonalizationSolver is used. */
+	void sumOverProcesses(std::complex<double> *data, int size);
 
 	/** Ensure that range indices are on compliant format. (Set range to
 	 *  one for indices with non-negative pattern value.) */
@@ -316,14 +412,109 @@ private:
 };
 
 inline double DPropertyExtractor::getEigenValue(int state){
-	return dSolver->getEigenValue(state);
+	if(dSolver != NULL)
+		return dSolver->getEigenValue(state);
+	else if(bSolver != NULL)
+		return bSolver->getEigenValue(state);
+	else if(ddSolver != NULL)
+		return ddSolver->getEigenValue(state);
+	else
+		return cfSolver->getEigenValue(state);
 }
 
 inline const std::complex<double> DPropertyExtractor::getAmplitude(
 	int state,
 	const Index &index
 ){
-	return dSolver->getAmplitude(state, index);
+	if(dSolver != NULL)
+		return dSolver->getAmplitude(state, index);
+	else if(bSolver != NULL)
+		return bSolver->getAmplitude(state, index);
+	else if(ddSolver != NULL)
+		return ddSolver->getAmplitude(state, index);
+	else
+		return cfSolver->getAmplitude(state, index);
+}
+
+inline Model* DPropertyExtractor::getModel(){
+	if(dSolver != NULL)
+		return dSolver->getModel();
+	else if(bSolver != NULL)
+		return bSolver->getModel();
+	else if(ddSolver != NULL)
+		return ddSolver->getModel();
+	else
+		return cfSolver->getModel();
+}
+
+inline int DPropertyExtractor::getNumStates(){
+	if(dSolver != NULL)
+		return dSolver->getNumStates();
+	else if(bSolver != NULL)
+		return bSolver->getModel()->getBasisSize();
+	else if(ddSolver != NULL)
+		return ddSolver->getNumStates();
+	else
+		return cfSolver->getNumStates();
+}
+
+inline const std::complex<double>* DPropertyExtractor::getEigenVector(
+	int state
+){
+	if(dSolver != NULL)
+		return &dSolver->getEigenVectors()[(size_t)getModel()->getBasisSize()*state];
+	else if(bSolver != NULL)
+		return bSolver->getBlockEigenVector(state);
+	else if(ddSolver != NULL)
+		return ddSolver->getEigenVector(state);
+	else
+		return &cfSolver->getEigenVectors()[(size_t)getModel()->getBasisSize()*state];
+}
+
+inline int DPropertyExtractor::getStateBlock(int state){
+	if(bSolver != NULL)
+		return bSolver->getBlock(state);
+	else
+		return 0;
+}
+
+inline int DPropertyExtractor::getEigenVectorPanelSize(){
+	if(dSolver != NULL)
+		return dSolver->getEigenVectorPanelSize();
+	else
+		return std::max(getNumStates(), 1);
+}
+
+inline void DPropertyExtractor::loadEigenVectorPanels(
+	int firstState,
+	int lastState
+){
+	if(dSolver != NULL)
+		dSolver->loadEigenVectorPanels(firstState, lastState);
+}
+
+inline const double* DPropertyExtractor::getSolverEigenValues(){
+	if(dSolver != NULL)
+		return dSolver->getEigenValues();
+	else if(bSolver != NULL)
+		return bSolver->getEigenValues();
+	else if(ddSolver != NULL)
+		return ddSolver->getEigenValues();
+	else
+		return cfSolver->getEigenValues();
+}
+
+inline void DPropertyExtractor::sumOverProcesses(double *data, int size){
+	if(ddSolver != NULL)
+		ddSolver->sumOverProcesses(data, size);
+}
+
+inline void DPropertyExtractor::sumOverProcesses(
+	std::complex<double> *data,
+	int size
+){
+	if(ddSolver != NULL)
+		ddSolver->sumOverProcesses(data, size);
 }
 
 };	//End of namespace TBTK
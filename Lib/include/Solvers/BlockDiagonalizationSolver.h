@@ -0,0 +1,212 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file BlockDiagonalizationSolver.h
+ *  @brief Solves a Model using block-wise diagonalization
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_BLOCK_DIAGONALIZATION_SOLVER
+#define COM_DAFER45_TBTK_BLOCK_DIAGONALIZATION_SOLVER
+
+#include "Model.h"
+#include "BlockStructure.h"
+#include <complex>
+
+namespace TBTK{
+
+/** Solves a given model by diagonalizing each independent block of the
+ *  Hamiltonian separately. The blocks are given by the Model's
+ *  BlockStructure, and are diagonalized in parallel. Scales as
+ *  \f$O(\sum_k n_k^3)\f$, where \f$n_k\f$ is the dimension of block \f$k\f$.
+ *  The eigenstates are numbered in order of increasing eigenvalue across all
+ *  blocks, and the interface is the same as for the DiagonalizationSolver
+ *  except that the eigenvectors are only stored within their own block.
+ *  Use getAmplitude() to access them. */
+class BlockDiagonalizationSolver{
+public:
+	/** Constructor */
+	BlockDiagonalizationSolver();
+
+	/** Destructor. */
+	~BlockDiagonalizationSolver();
+
+	/** Set model to work on. */
+	void setModel(Model *model);
+
+	/** Set self-consistency callback. If set to NULL or never called, the
+	 *  self-consistency loop will not be run. */
+	void setSCCallback(
+		bool (*scCallback)(
+			BlockDiagonalizationSolver *blockDiagonalizationSolver
+		)
+	);
+
+	/** Set maximum number of iterations for the self-consistency loop. */
+	void setMaxIterations(int maxIterations);
+
+	/** Run calculations. Diagonalizes ones if no self-consistency callback
+	 *  have been set, or otherwise multiple times until self-consistencey
+	 *  or maximum number of iterations has been reached. */
+	void run();
+
+	/** Get eigenvalues, in increasing order. */
+	const double* getEigenValues();
+
+	/** Get eigenvalues. Same as getEigenValues(), but with write access.
+	 *  Use with causion. */
+	double* getEigenValuesRW();
+
+	/** Get eigenvalue. */
+	const double getEigenValue(int state);
+
+	/** Get amplitude for given eigenvector \f$n\f$ and physical index
+	 * \f$x\f$: \f$\Psi_{n}(x)\f$.
+	 *  @param state Eigenstate number \f$n\f$.
+	 *  @param index Physical index \f$x\f$.
+	 */
+	const std::complex<double> getAmplitude(int state, const Index &index);
+
+	/** Get the block that the given eigenstate belongs to.
+	 *  @param state Eigenstate number. */
+	int getBlock(int state);
+
+	/** Get the eigenvector of the given eigenstate. Contains the
+	 *  components within the block of the eigenstate, ordered by intra
+	 *  block index.
+	 *  @param state Eigenstate number. */
+	const std::complex<double>* getBlockEigenVector(int state);
+
+	/** Get model. */
+	Model *getModel();
+private:
+	/** Model to work on. */
+	Model *model;
+
+	/** Block structure of the model. */
+	const BlockStructure *blockStructure;
+
+	/** Pointer to array containing the Hamiltonian of each block on
+	 *  packed upper triangular format. */
+	std::complex<double> *hamiltonian;
+
+	/** Offsets into hamiltonian for each block. */
+	int *hamiltonianOffsets;
+
+	/** Pointer to array containing the eigenvalues of each block. The
+	 *  eigenvalues of block k start at the same offset as the basis
+	 *  indices of block k in the BlockStructure. */
+	double *blockEigenValues;
+
+	/** Pointer to array containing the eigenvectors of each block. */
+	std::complex<double> *eigenVectors;
+
+	/** Offsets into eigenVectors for each block. */
+	int *eigenVectorOffsets;
+
+	/** Pointer to array containing the eigenvalues of all blocks, in
+	 *  increasing order. */
+	double *eigenValues;
+
+	/** Block of each eigenstate. */
+	int *stateBlocks;
+
+	/** Offset into eigenVectors of each eigenstate. */
+	int *stateOffsets;
+
+	/** Maximum number of iterations in the self-consistency loop. */
+	int maxIterations;
+
+	/** Callback function to call each time a diagonalization has been
+	 *  completed. */
+	bool (*scCallback)(
+		BlockDiagonalizationSolver *blockDiagonalizationSolver
+	);
+
+	/** Allocates space for Hamiltonian etc. */
+	void init();
+
+	/** Updates Hamiltonian. */
+	void update();
+
+	/** Diagonalizes the Hamiltonian of each block and orders the
+	 *  eigenstates by eigenvalue. */
+	void solve();
+
+	/** Free all memory. */
+	void clear();
+};
+
+inline void BlockDiagonalizationSolver::setModel(Model *model){
+	this->model = model;
+}
+
+inline void BlockDiagonalizationSolver::setSCCallback(
+	bool (*scCallback)(
+		BlockDiagonalizationSolver *blockDiagonalizationSolver
+	)
+){
+	this->scCallback = scCallback;
+}
+
+inline void BlockDiagonalizationSolver::setMaxIterations(int maxIterations){
+	this->maxIterations = maxIterations;
+}
+
+inline const double* BlockDiagonalizationSolver::getEigenValues(){
+	return eigenValues;
+}
+
+inline double* BlockDiagonalizationSolver::getEigenValuesRW(){
+	return eigenValues;
+}
+
+inline const double BlockDiagonalizationSolver::getEigenValue(int state){
+	return eigenValues[state];
+}
+
+inline const std::complex<double> BlockDiagonalizationSolver::getAmplitude(
+	int state,
+	const Index &index
+){
+	int basisIndex = model->getBasisIndex(index);
+	if(blockStructure->getBlock(basisIndex) != stateBlocks[state])
+		return 0.;
+
+	return eigenVectors[
+		stateOffsets[state]
+		+ blockStructure->getIntraBlockIndex(basisIndex)
+	];
+}
+
+inline int BlockDiagonalizationSolver::getBlock(int state){
+	return stateBlocks[state];
+}
+
+inline const std::complex<double>* BlockDiagonalizationSolver::getBlockEigenVector(
+	int state
+){
+	return &eigenVectors[stateOffsets[state]];
+}
+
+inline Model* BlockDiagonalizationSolver::getModel(){
+	return model;
+}
+
+};	//End of namespace TBTK
+
+#endif
@@ -0,0 +1,245 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file ChebyshevFilterSolver.h
+ *  @brief Solves a Model for the eigenstates in an energy window using
+ *  Chebyshev filtered subspace iteration
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_CHEBYSHEV_FILTER_SOLVER
+#define COM_DAFER45_TBTK_CHEBYSHEV_FILTER_SOLVER
+
+#include "Model.h"
+#include "ChebyshevSolver.h"
+#include <complex>
+
+namespace TBTK{
+
+/** Calculates the eigenstates with eigenvalues inside an energy window using
+ *  Chebyshev filtered subspace iteration. A block of vectors is repeatedly
+ *  multiplied by a Chebyshev expansion of the indicator function of the
+ *  window, which suppresses the components outside of the window, after
+ *  which the eigenstates are extracted from the filtered subspace using the
+ *  Rayleigh-Ritz procedure. Only sparse matrix-vector multiplications are
+ *  needed, which are performed by a ChebyshevSolver, and the scale factor
+ *  has the same meaning as for the ChebyshevSolver. Scales as \f$O(n)\f$
+ *  with the number of hopping amplitudes, the number of coefficients, and
+ *  the subspace size, plus \f$O(Nm^2)\f$ for the Rayleigh-Ritz procedure,
+ *  where \f$N\f$ is the basis size and \f$m\f$ is the subspace size.
+ *
+ *  The subspace size has to be larger than the number of eigenstates in the
+ *  window. The eigenstates are numbered in order of increasing eigenvalue,
+ *  and the interface for accessing them is the same as for the
+ *  DiagonalizationSolver, which allows the DPropertyExtractor to be used. */
+class ChebyshevFilterSolver{
+public:
+	/** Constructor */
+	ChebyshevFilterSolver();
+
+	/** Destructor. */
+	~ChebyshevFilterSolver();
+
+	/** Set model to work on. */
+	void setModel(Model *model);
+
+	/** Get model. */
+	Model* getModel();
+
+	/** Set scale factor. The spectrum of the Hamiltonian has to be
+	 *  contained in [energyShift - scaleFactor,
+	 *  energyShift + scaleFactor]. */
+	void setScaleFactor(double scaleFactor);
+
+	/** Get scale factor. */
+	double getScaleFactor();
+
+	/** Set energy shift. The spectrum is centered around the energy shift
+	 *  before it is scaled by the scale factor. */
+	void setEnergyShift(double energyShift);
+
+	/** Get energy shift. */
+	double getEnergyShift();
+
+	/** Set the energy window to calculate eigenstates in. Has to be
+	 *  contained in [energyShift - scaleFactor,
+	 *  energyShift + scaleFactor]. */
+	void setEnergyWindow(double lowerBound, double upperBound);
+
+	/** Set the number of vectors in the filtered subspace. Has to be
+	 *  larger than the number of eigenstates in the energy window, and
+	 *  convergence is faster with a margin of about 20%. */
+	void setSubspaceSize(int subspaceSize);
+
+	/** Set the number of Chebyshev coefficients used for the filter. The
+	 *  filter resolves energies on the scale
+	 *  \f$\pi\textrm{scaleFactor}/\textrm{numCoefficients}\f$, which
+	 *  should be small compared to the width of the window. */
+	void setNumCoefficients(int numCoefficients);
+
+	/** Set the tolerance for the residual norm
+	 *  \f$|H\Psi_n - E_n\Psi_n|\f$ of the eigenstates. */
+	void setTolerance(double tolerance);
+
+	/** Set the maximum number of filter iterations. */
+	void setMaxIterations(int maxIterations);
+
+	/** Run calculations. */
+	void run();
+
+	/** Get the number of eigenstates found in the energy window. */
+	int getNumStates();
+
+	/** Get eigenvalues, in increasing order. */
+	const double* getEigenValues();
+
+	/** Get eigenvalue. */
+	const double getEigenValue(int state);
+
+	/** Get eigenvectors. The eigenvector for state n starts at
+	 *  n*basisSize. */
+	const std::complex<double>* getEigenVectors();
+
+	/** Get amplitude for given eigenvector \f$n\f$ and physical index
+	 * \f$x\f$: \f$\Psi_{n}(x)\f$.
+	 *  @param state Eigenstate number \f$n\f$.
+	 *  @param index Physical index \f$x\f$.
+	 */
+	const std::complex<double> getAmplitude(int state, const Index &index);
+private:
+	/** Model to work on. */
+	Model *model;
+
+	/** ChebyshevSolver used for the matrix-vector multiplications. */
+	ChebyshevSolver chebyshevSolver;
+
+	/** Lower bound of the energy window. */
+	double lowerBound;
+
+	/** Upper bound of the energy window. */
+	double upperBound;
+
+	/** Number of vectors in the filtered subspace. */
+	int subspaceSize;
+
+	/** Number of Chebyshev coefficients used for the filter. */
+	int numCoefficients;
+
+	/** Tolerance for the residual norm. */
+	double tolerance;
+
+	/** Maximum number of filter iterations. */
+	int maxIterations;
+
+	/** Number of eigenstates found in the energy window. */
+	int numStates;
+
+	/** Pointer to array containing the eigenvalues. */
+	double *eigenValues;
+
+	/** Pointer to array containing the eigenvectors. */
+	std::complex<double> *eigenVectors;
+
+	/** Apply the Chebyshev expansion of the window indicator function to
+	 *  a block of vectors. */
+	void filter(
+		std::complex<double> *x,
+		int numVectors,
+		const double *coefficients
+	);
+
+	/** Free all memory. */
+	void clear();
+};
+
+inline void ChebyshevFilterSolver::setModel(Model *model){
+	this->model = model;
+	chebyshevSolver.setModel(model);
+}
+
+inline Model* ChebyshevFilterSolver::getModel(){
+	return model;
+}
+
+inline void ChebyshevFilterSolver::setScaleFactor(double scaleFactor){
+	chebyshevSolver.setScaleFactor(scaleFactor);
+}
+
+inline double ChebyshevFilterSolver::getScaleFactor(){
+	return chebyshevSolver.getScaleFactor();
+}
+
+inline void ChebyshevFilterSolver::setEnergyShift(double energyShift){
+	chebyshevSolver.setEnergyShift(energyShift);
+}
+
+inline double ChebyshevFilterSolver::getEnergyShift(){
+	return chebyshevSolver.getEnergyShift();
+}
+
+inline void ChebyshevFilterSolver::setEnergyWindow(
+	double lowerBound,
+	double upperBound
+){
+	this->lowerBound = lowerBound;
+	this->upperBound = upperBound;
+}
+
+inline void ChebyshevFilterSolver::setSubspaceSize(int subspaceSize){
+	this->subspaceSize = subspaceSize;
+}
+
+inline void ChebyshevFilterSolver::setNumCoefficients(int numCoefficients){
+	this->numCoefficients = numCoefficients;
+}
+
+inline void ChebyshevFilterSolver::setTolerance(double tolerance){
+	this->tolerance = tolerance;
+}
+
+inline void ChebyshevFilterSolver::setMaxIterations(int maxIterations){
+	this->maxIterations = maxIterations;
+}
+
+inline int ChebyshevFilterSolver::getNumStates(){
+	return numStates;
+}
+
+inline const double* ChebyshevFilterSolver::getEigenValues(){
+	return eigenValues;
+}
+
+inline const double ChebyshevFilterSolver::getEigenValue(int state){
+	return eigenValues[state];
+}
+
+inline const std::complex<double>* ChebyshevFilterSolver::getEigenVectors(){
+	return eigenVectors;
+}
+
+inline const std::complex<double> ChebyshevFilterSolver::getAmplitude(
+	int state,
+	const Index &index
+){
+	return eigenVectors[
+		model->getBasisSize()*state + model->getBasisIndex(index)
+	];
+}
+
+};	//End of namespace TBTK
+
+#endif
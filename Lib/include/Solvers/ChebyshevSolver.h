@@ -26,6 +26,8 @@
 #define COM_DAFER45_TBTK_CHEBYSHEV_SOLVER
 
 #include "Model.h"
+#include "TBTKMacros.h"
+
 #include <complex>
 #include <omp.h>
 
@@ -39,6 +41,38 @@ namespace TBTK{
  *  coefficients. The generation of Green's functions scales as \f$O(n)\f$ with
  *  the following: Number of coefficients, energy resolution, and the number of
  *  Green's functions.
+ *
+ *  On CPU, the coefficients are calculated on the SELL-C-sigma format of
+ *  the AmplitudeSet, which is constructed the first time coefficients are
+ *  calculated unless it already exists. The rows of the Hamiltonian are
+ *  divided between the OpenMP threads, and the rows of each chunk are
+ *  processed in SIMD lanes. Expansions for several 'from'-indices are
+ *  calculated together in blocks, which multiplies the Hamiltonian with a
+ *  block of vectors and thereby reuses each matrix element for all vectors
+ *  in the block. With Hermitian storage, all multiplications are instead
+ *  performed on the stored triangle on CSR format, where each off-diagonal
+ *  matrix element is also applied as its Hermitian conjugate.
+ *
+ *  The CPU calculation of coefficients is reentrant, which allows
+ *  coefficients to be calculated from several threads at once. Each call
+ *  then runs on the calling thread with its own Chebyshev vectors. The
+ *  Hamiltonian is not updated inside parallel regions, and
+ *  updateHamiltonian() therefore has to be called before the parallel
+ *  region.
+ *
+ *  The expansion is carried out for (H - energyShift)/scaleFactor, whose
+ *  spectrum has to lie inside [-1, 1]. Green's functions can then be
+ *  evaluated in the interval [energyShift - scaleFactor, energyShift +
+ *  scaleFactor]. The number of coefficients needed for a given energy
+ *  resolution grows with the scale factor, and estimateScaleFactor() can
+ *  be used to choose the scale factor and energy shift from estimated
+ *  bounds of the spectrum.
+ *
+ *  For quantities such as the DOS and LDOS, single precision is often
+ *  accurate enough. With setSinglePrecision(), the Chebyshev vectors,
+ *  hopping amplitudes, and lookup table are stored in single precision,
+ *  which halves the memory traffic, while the coefficients are returned and
+ *  the Green's functions are accumulated in double precision.
  */
 class ChebyshevSolver{
 public:
@@ -60,6 +94,75 @@ public:
 	/** Get scale factor. */
 	double getScaleFactor();
 
+	/** Set energy shift. The Chebyshev expansion is carried out for
+	 *  (H - energyShift)/scaleFactor, which centers spectra that are not
+	 *  symmetric around zero. Default is 0. */
+	void setEnergyShift(double energyShift);
+
+	/** Get energy shift. */
+	double getEnergyShift();
+
+	/** Estimate lower and upper bounds for the spectrum of the
+	 *  Hamiltonian. The bounds are obtained from the extreme Ritz values
+	 *  of a Lanczos iteration from a random state, widened by the
+	 *  residual norms of the corresponding Ritz vectors, and limited to
+	 *  the Gershgorin bounds of the Hamiltonian on COO format. The
+	 *  Gershgorin bounds are used alone if numLanczosSteps is zero. Too
+	 *  few steps can give bounds that lie inside the spectrum of models
+	 *  with few distinct eigenvalues.
+	 *  @param lowerBound Set to the lower bound.
+	 *  @param upperBound Set to the upper bound.
+	 *  @param numLanczosSteps Number of Lanczos steps, each of which
+	 *  multiplies the Hamiltonian by one vector. */
+	void estimateSpectralBounds(
+		double &lowerBound,
+		double &upperBound,
+		int numLanczosSteps = 50
+	);
+
+	/** Set the scale factor and energy shift from the bounds estimated by
+	 *  estimateSpectralBounds(), such that the spectrum fits inside the
+	 *  expansion interval with a margin.
+	 *  @param numLanczosSteps Number of Lanczos steps used to estimate
+	 *  the bounds.
+	 *  @param safetyMargin Relative amount by which the interval is made
+	 *  larger than the estimated bounds.
+	 *  @param centerSpectrum If true, the energy shift is set to the
+	 *  center of the spectrum, otherwise it is set to zero and the
+	 *  interval is symmetric around zero. */
+	void estimateScaleFactor(
+		int numLanczosSteps = 50,
+		double safetyMargin = 0.01,
+		bool centerSpectrum = true
+	);
+
+	/** Set whether the coefficients should be calculated and the lookup
+	 *  table be stored in single precision on CPU. The relative error of
+	 *  the coefficients is then of the order 1e-6 times the square root of
+	 *  the number of coefficients. False by default. */
+	void setSinglePrecision(bool singlePrecision);
+
+	/** Get whether single precision is used. */
+	bool getSinglePrecision();
+
+	/** Set the maximum number of 'from'-indices that are propagated
+	 *  together when coefficients are calculated for several
+	 *  'from'-indices. Each matrix element is then loaded once per
+	 *  block rather than once per 'from'-index, at the cost of storing
+	 *  three Chebyshev vectors per 'from'-index in the block. Block sizes
+	 *  4, 8, and 16 have specialized kernels. Default is 8. */
+	void setBlockSize(int blockSize);
+
+	/** Get block size. */
+	int getBlockSize();
+
+	/** Constructs the Hamiltonian on the SELL and CSR formats used on CPU
+	 *  if they do not exist, and otherwise brings them up to date with the
+	 *  callbacks of the Model. With Hermitian storage, only the CSR format
+	 *  is constructed. Called by calculateCoefficients() unless it
+	 *  is called from inside an OpenMP parallel region. */
+	void updateHamiltonian();
+
 	/** Calculates the Chebyshev coefficients for \f$ G_{ij}(E)\f$, where
 	 *  \f$i = \textrm{to}\f$ is a set of indices and \f$j =
 	 *  \textrm{from}\f$. Runs on CPU.
@@ -97,6 +200,58 @@ public:
 		double broadening = 0.0001
 	);
 
+	/** Calculates the Chebyshev coefficients for \f$ G_{ij}(E)\f$, where
+	 *  \f$i = \textrm{to}\f$ and \f$j = \textrm{from}\f$ both are sets
+	 *  of indices. The expansions for the 'from'-indices are calculated
+	 *  together in blocks of at most blockSize indices, see
+	 *  setBlockSize(). Runs on CPU.
+	 *  @param to vector of 'to'-indeces, or \f$i\f$'s.
+	 *  @param from vector of 'from'-indices, or \f$j\f$'s.
+	 *  @param coefficients Pointer to array able to hold
+	 *  numCoefficients\f$\times\f$to.size()\f$\times\f$from.size()
+	 *  coefficients. The coefficients for to[t] and from[f] start at
+	 *  (f*to.size() + t)*numCoefficients.
+	 *  @param numCoefficients Number of coefficients to calculate for each
+	 *  pair of 'to'- and 'from'-indices.
+	 *  @param broadening Broadening to use in convolusion of coefficients
+	 *  to remedy Gibb's osciallations.
+	 */
+	void calculateCoefficients(
+		std::vector<Index> &to,
+		std::vector<Index> &from,
+		std::complex<double> *coefficients,
+		int numCoefficients,
+		double broadening = 0.0001
+	);
+
+	/** Calculates the Chebyshev coefficients for
+	 *  \f$\langle\psi|G(E)|\psi\rangle\f$ for a set of states
+	 *  \f$|\psi\rangle\f$. The states are propagated together in blocks
+	 *  of at most blockSize states, see setBlockSize(), and two
+	 *  coefficients are obtained per multiplication by the Hamiltonian,
+	 *  which requires the Hamiltonian to be Hermitian and damping not to
+	 *  be set. For random states, the average of the coefficients is a
+	 *  stochastic estimate of the coefficients for the trace of
+	 *  \f$G(E)\f$. Runs on CPU.
+	 *  @param states Pointer to numStates states, stored one after
+	 *  another with basisSize components each.
+	 *  @param numStates Number of states.
+	 *  @param coefficients Pointer to array able to hold
+	 *  numCoefficients\f$\times\f$numStates coefficients. The
+	 *  coefficients for the k-th state start at k*numCoefficients.
+	 *  @param numCoefficients Number of coefficients to calculate for each
+	 *  state.
+	 *  @param broadening Broadening to use in convolusion of coefficients
+	 *  to remedy Gibb's osciallations.
+	 */
+	void calculateStateCoefficients(
+		const std::complex<double> *states,
+		int numStates,
+		std::complex<double> *coefficients,
+		int numCoefficients,
+		double broadening = 0.0001
+	);
+
 	/** Calculates the Chebyshev coefficients for \f$ G_{ij}(E)\f$, where
 	 *  \f$i = \textrm{to}\f$ is a set of indices and \f$j =
 	 *  \textrm{from}\f$. Runs on GPU.
@@ -144,13 +299,33 @@ public:
 		double broadening = 0.0001
 	);
 
+	/** Multiply a block of vectors by the scaled Hamiltonian,
+	 *  \f$y = (H - c)x/s\f$, where \f$c\f$ is the energy shift and
+	 *  \f$s\f$ is the scale factor. This is the operator that the
+	 *  Chebyshev expansions are performed in. The vectors are multiplied
+	 *  blockSize at a time on CSR format. The Hamiltonian is constructed
+	 *  if necessary, but is otherwise used as it is, so
+	 *  updateHamiltonian() has to be called after the callbacks have
+	 *  changed. Runs on CPU.
+	 *  @param x Input vectors, stored one after another with basisSize
+	 *  elements each.
+	 *  @param y Output vectors, on the same format as x.
+	 *  @param numVectors Number of vectors in x and y. */
+	void multiplyScaledHamiltonian(
+		const std::complex<double> *x,
+		std::complex<double> *y,
+		int numVectors
+	);
+
 	/** Generate lokup table for quicker generation of multiple Green's
 	 *  functions. Required if evaluation is to be performed on GPU.
 	 *  @param numCoefficeints Number of coefficients used in Chebyshev
 	 *  @param lowerBound Lower bound, has to be larger or equal to
-	 *  -scaleFactor set by setScaleFactor (default value 1).
+	 *  energyShift - scaleFactor set by setEnergyShift and
+	 *  setScaleFactor (default value -1).
 	 *  @param upperBound Upper bound, has to be smaller or equal to
-	 *  scaleFactor setBy setScaleFactor (default value 1).
+	 *  energyShift + scaleFactor set by setEnergyShift and
+	 *  setScaleFactor (default value 1).
 	 *  expansion.*/
 	void generateLookupTable(
 		int numCoefficeints,
@@ -184,9 +359,11 @@ public:
 	 *  @param numCoefficeints Number of coefficients in coefficients.
 	 *  @param energyResolution Number of elements in greensFunction.
 	 *  @param lowerBound Lower bound, has to be larger or equal to
-	 *  -scaleFactor set by setScaleFactor (default value 1).
+	 *  energyShift - scaleFactor set by setEnergyShift and
+	 *  setScaleFactor (default value -1).
 	 *  @param upperBound Upper bound, has to be smaller or equal to
-	 *  scaleFactor setBy setScaleFactor (default value 1).
+	 *  energyShift + scaleFactor set by setEnergyShift and
+	 *  setScaleFactor (default value 1).
 	 */
 	void generateGreensFunction(
 		std::complex<double> *greensFunction,
@@ -262,13 +439,27 @@ private:
 	/** Scale factor. */
 	double scaleFactor;
 
+	/** Energy shift. */
+	double energyShift;
+
 	/** Damping mask. */
 	std::complex<double> *damping;
 
+	/** Flag indicating whether single precision is used on CPU. */
+	bool singlePrecision;
+
+	/** Maximum number of 'from'-indices propagated together. */
+	int blockSize;
+
 	/** Pointer to lookup table used to speed up evaluation of multiple
 	 *  Green's functions. */
 	std::complex<double> **generatingFunctionLookupTable;
 
+	/** Pointer to lookup table stored in single precision. Used instead of
+	 *  generatingFunctionLookupTable if the lookup table was generated
+	 *  with single precision enabled. */
+	std::complex<float> **generatingFunctionLookupTableSingle;
+
 	/** Pointer to lookup table on GPU. */
 	std::complex<double> ***generatingFunctionLookupTable_device;
 
@@ -284,6 +475,80 @@ private:
 	 *  not. */
 	bool isTalkative;
 
+	/** Calculates the Chebyshev vectors \f$|j_n\rangle\f$ starting from
+	 *  the basis state fromBasisIndex on CPU, and stores the components
+	 *  \f$\langle i|j_n\rangle\f$ for the basis states \f$i\f$ in
+	 *  toBasisIndices in coefficients. The vectors are stored using the
+	 *  scalar type T, while the coefficients are stored in double
+	 *  precision. Each vector is calculated in a single pass over the
+	 *  Hamiltonian on SELL format, which also applies the damping and
+	 *  extracts the coefficients. With Hermitian storage, the calculation
+	 *  is instead performed by calculateCoefficientsBlockCPU() with a
+	 *  single vector. */
+	template<typename T>
+	void calculateCoefficientsCPU(
+		const std::vector<int> &toBasisIndices,
+		int fromBasisIndex,
+		std::complex<double> *coefficients,
+		int numCoefficients
+	);
+
+	/** Calculates the Chebyshev vectors for a block of numFromIndices
+	 *  'from'-indices on CPU, and stores the coefficients for each pair of
+	 *  'from'- and 'to'-index as described for calculateCoefficients().
+	 *  The block of vectors is multiplied by the Hamiltonian on CSR
+	 *  format, with the components of all vectors for a given basis state
+	 *  stored contiguously. */
+	template<typename T>
+	void calculateCoefficientsBlockCPU(
+		const std::vector<int> &toBasisIndices,
+		const int *fromBasisIndices,
+		int numFromIndices,
+		std::complex<double> *coefficients,
+		int numCoefficients
+	);
+
+	/** Calculates the Chebyshev vectors for a block of numStates states on
+	 *  CPU, and stores the coefficients for each state as described for
+	 *  calculateStateCoefficients(). The block of vectors is multiplied by
+	 *  the Hamiltonian on CSR format, like in
+	 *  calculateCoefficientsBlockCPU(). */
+	template<typename T>
+	void calculateStateCoefficientsBlockCPU(
+		const std::complex<double> *states,
+		int numStates,
+		std::complex<double> *coefficients,
+		int numCoefficients
+	);
+
+	/** Returns true if the formats used by the CPU kernels are
+	 *  constructed. That is, the CSR format with Hermitian storage, and
+	 *  the SELL format otherwise. */
+	bool hamiltonianIsConstructed() const;
+
+	/** Delete the lookup tables. */
+	void deleteLookupTable();
+
+	/** Get energy point e of energyResolution points in the interval
+	 *  [lowerBound, upperBound), shifted and scaled to the interval
+	 *  [-1, 1] of the expansion. */
+	double getScaledEnergy(
+		double lowerBound,
+		double upperBound,
+		int e,
+		int energyResolution
+	) const;
+
+	/** Genererate Green's function using the given lookup table, with
+	 *  accumulation in double precision. */
+	template<typename T>
+	void generateGreensFunction(
+		std::complex<double> *greensFunction,
+		std::complex<double> *coefficients,
+		std::complex<T> **lookupTable,
+		GreensFunctionType type
+	);
+
 	/** Number of ChebyshevSolvers created. Needed for resource management.
 	 */
 //	static int numChebyshevSolvers;
@@ -329,6 +594,37 @@ inline double ChebyshevSolver::getScaleFactor(){
 	return scaleFactor;
 }
 
+inline void ChebyshevSolver::setEnergyShift(double energyShift){
+	this->energyShift = energyShift;
+}
+
+inline double ChebyshevSolver::getEnergyShift(){
+	return energyShift;
+}
+
+inline void ChebyshevSolver::setSinglePrecision(bool singlePrecision){
+	this->singlePrecision = singlePrecision;
+}
+
+inline bool ChebyshevSolver::getSinglePrecision(){
+	return singlePrecision;
+}
+
+inline void ChebyshevSolver::setBlockSize(int blockSize){
+	TBTKAssert(
+		blockSize > 0,
+		"ChebyshevSolver::setBlockSize()",
+		"blockSize has to be larger than 0.",
+		""
+	);
+
+	this->blockSize = blockSize;
+}
+
+inline int ChebyshevSolver::getBlockSize(){
+	return blockSize;
+}
+
 inline void ChebyshevSolver::setDamping(std::complex<double> *damping){
 	this->damping = damping;
 }
@@ -337,6 +633,23 @@ inline void ChebyshevSolver::setTalkative(bool isTalkative){
 	this->isTalkative = isTalkative;
 }
 
+inline double ChebyshevSolver::getScaledEnergy(
+	double lowerBound,
+	double upperBound,
+	int e,
+	int energyResolution
+) const{
+	double E = (lowerBound + (upperBound - lowerBound)*e/(double)energyResolution - energyShift)/scaleFactor;
+
+	//With a non-zero energy shift, a lower bound equal to
+	//energyShift - scaleFactor can end up marginally below -1 due to
+	//rounding, where acos() is not defined.
+	if(E < -1.)
+		E = -1.;
+
+	return E;
+}
+
 };	//End of namespace TBTK
 
 #endif
@@ -23,8 +23,14 @@
 #ifndef COM_DAFER45_TBTK_DIAGONALIZATION_SOLVER
 #define COM_DAFER45_TBTK_DIAGONALIZATION_SOLVER
 
+#include "ChebyshevSolver.h"
 #include "Model.h"
+#include "TBTKMacros.h"
+
+#include <algorithm>
 #include <complex>
+#include <list>
+#include <string>
 
 namespace TBTK{
 
@@ -32,9 +38,55 @@ namespace TBTK{
  *  eigenvectors can then either be directly extracted and used to calculate
  *  custom physical quantities, or the PropertyExtractor can be used to extract
  *  common properties. Scales as \f$O(n^3)\f$ with the dimension of the Hilbert
- *  space. */
+ *  space. If banded storage is enabled using setBandedStorage() and the
+ *  bandwidth \f$k\f$ of the Hamiltonian is small compared to the dimension
+ *  of the Hilbert space, the Hamiltonian is stored on banded format and
+ *  diagonalized using a banded eigensolver, which requires \f$O(nk)\f$
+ *  rather than \f$O(n^2)\f$ memory for the Hamiltonian.
+ *
+ *  The LAPACK routine used for the diagonalization can be selected using
+ *  setAlgorithm(). The MRRR algorithm can also be restricted to a window of
+ *  states or energies, in which case only the eigenstates in the window are
+ *  calculated and numbered from zero in order of increasing energy.
+ *
+ *  In self-consistency loops, setIterativeNumStates() can be used to only
+ *  calculate the lowest eigenstates, such as the occupied states. The first
+ *  iteration then uses the MRRR algorithm, while the following iterations
+ *  refine the eigenvectors from the previous iteration using the block
+ *  iterative LOBPCG method. Since the Hamiltonian only changes slightly
+ *  between iterations, this converges in a few steps that each scale as
+ *  \f$O(Nk)\f$ with the number of matrix elements \f$N\f$ and the
+ *  number of states \f$k\f$, instead of \f$O(n^3)\f$.
+ *
+ *  For large Hilbert spaces, setEigenVectorFile() can be used to store the
+ *  eigenvectors in a memory-mapped file rather than in RAM. The eigenvectors
+ *  are then accessed in panels of consecutive eigenstates, and only a
+ *  limited number of panels are kept resident.
+ *
+ *  With setSinglePrecision(), the Hamiltonian is stored and diagonalized in
+ *  single precision using the corresponding LAPACK routines (chpev, chbev,
+ *  cheevd, cheevr), which roughly halves the time and the memory traffic of
+ *  the diagonalization. The eigenvalues and eigenvectors are converted to
+ *  double precision, and have relative errors of the order 1e-6. When
+ *  combined with setIterativeNumStates(), only the first diagonalization is
+ *  performed in single precision, and the LOBPCG iterations refine the
+ *  eigenvectors in double precision. */
 class DiagonalizationSolver{
 public:
+	/** Enum class for specifying the diagonalization algorithm. */
+	enum class Algorithm{
+		/** Packed storage (zhpev), or banded storage (zhbev) if
+		 *  enabled with setBandedStorage() and the bandwidth is small.
+		 *  Requires the least memory. */
+		Packed,
+		/** Divide and conquer (zheevd). Fastest when all eigenvectors
+		 *  are required. */
+		DivideAndConquer,
+		/** Multiple relatively robust representations (zheevr).
+		 *  Supports state and energy windows. */
+		MRRR
+	};
+
 	/** Constructor */
 	DiagonalizationSolver();
 
@@ -55,6 +107,98 @@ public:
 	/** Set maximum number of iterations for the self-consistency loop. */
 	void setMaxIterations(int maxIterations);
 
+	/** Set the diagonalization algorithm. Algorithm::Packed by default. */
+	void setAlgorithm(Algorithm algorithm);
+
+	/** Set whether the Hamiltonian should be diagonalized in single
+	 *  precision. False by default. */
+	void setSinglePrecision(bool singlePrecision);
+
+	/** Set whether the Hamiltonian should be stored on banded format
+	 *  when Algorithm::Packed is used and the bandwidth is small compared
+	 *  to the basis size. The banded eigensolver (zhbev) saves memory, but
+	 *  is only faster than the packed one when the bandwidth is small,
+	 *  which usually requires Model::setBasisReordering(). When
+	 *  eigenvectors are calculated it also has to accumulate the
+	 *  transformations of the band reduction, which often makes it
+	 *  slower than the packed eigensolver. False by default. */
+	void setBandedStorage(bool bandedStorage);
+
+	/** Set whether eigenvectors should be calculated. If set to false,
+	 *  only the eigenvalues are calculated and getAmplitude() and
+	 *  getEigenVectors() can not be used. True by default. */
+	void setCalculateEigenVectors(bool calculateEigenVectors);
+
+	/** Only calculate the eigenstates firstState to lastState, counted
+	 *  from zero in order of increasing energy. Requires
+	 *  Algorithm::MRRR.
+	 *
+	 *  @param firstState First eigenstate to calculate.
+	 *  @param lastState Last eigenstate to calculate. */
+	void setStateWindow(int firstState, int lastState);
+
+	/** Only calculate the eigenstates with energies in the interval
+	 *  (lowerEnergy, upperEnergy]. Requires Algorithm::MRRR.
+	 *
+	 *  @param lowerEnergy Lower bound of the window.
+	 *  @param upperEnergy Upper bound of the window. */
+	void setEnergyWindow(double lowerEnergy, double upperEnergy);
+
+	/** Get number of calculated eigenstates. Equal to the basis size
+	 *  unless a state or energy window is used. */
+	int getNumStates();
+
+	/** Enable warm started iterative diagonalization in the
+	 *  self-consistency loop. Only the numStates lowest eigenstates are
+	 *  calculated. Also sets the algorithm to Algorithm::MRRR and the
+	 *  state window to [0, numStates-1], which are used in the first
+	 *  iteration. Set to -1 to disable, which is the default.
+	 *
+	 *  @param numStates Number of eigenstates to calculate. */
+	void setIterativeNumStates(int numStates);
+
+	/** Set the tolerance for the residual norm
+	 *  \f$|H\Psi_n - E_n\Psi_n|\f$ of each eigenstate in the iterative
+	 *  diagonalization. Default is 1e-8. */
+	void setIterativeTolerance(double iterativeTolerance);
+
+	/** Set the maximum number of LOBPCG steps in each iteration of the
+	 *  self-consistency loop. Default is 1000. */
+	void setMaxIterativeSteps(int maxIterativeSteps);
+
+	/** Store the eigenvectors in a memory-mapped file instead of in RAM.
+	 *  The file is removed from the file system as soon as it has been
+	 *  created, and its storage is released when the solver is destroyed.
+	 *  With Algorithm::DivideAndConquer, the eigenvectors are copied to the
+	 *  file after each diagonalization, since zheevd returns them in place
+	 *  of the Hamiltonian. An empty string, which is the default, stores
+	 *  the eigenvectors in RAM.
+	 *
+	 *  @param eigenVectorFile Path of the file to create. */
+	void setEigenVectorFile(const std::string &eigenVectorFile);
+
+	/** Set the number of eigenstates per panel for eigenvectors stored in
+	 *  a file. Default is 64. */
+	void setEigenVectorPanelSize(int eigenVectorPanelSize);
+
+	/** Set the maximum number of panels to keep resident in memory for
+	 *  eigenvectors stored in a file. Default is 16. */
+	void setMaxResidentPanels(int maxResidentPanels);
+
+	/** Get the number of eigenstates per panel. Equal to the number of
+	 *  eigenstates if the eigenvectors are stored in RAM. */
+	int getEigenVectorPanelSize();
+
+	/** Make the panels containing the eigenstates firstState to lastState
+	 *  resident, and release the least recently used panels beyond the
+	 *  maximum number of resident panels. Released panels remain
+	 *  accessible, but are read back from the file when accessed. Does
+	 *  nothing if the eigenvectors are stored in RAM.
+	 *
+	 *  @param firstState First eigenstate to load.
+	 *  @param lastState Last eigenstate to load. */
+	void loadEigenVectorPanels(int firstState, int lastState);
+
 	/** Run calculations. Diagonalizes ones if no self-consistency callback
 	 *  have been set, or otherwise multiple times until slef-consistencey
 	 *  or maximum number of iterations has been reached. */
@@ -90,15 +234,127 @@ private:
 	/** Model to work on. */
 	Model *model;
 
-	/** pointer to array containing Hamiltonian. */
+	/** Diagonalization algorithm. */
+	Algorithm algorithm;
+
+	/** Flag indicating whether the Hamiltonian is diagonalized in single
+	 *  precision. */
+	bool singlePrecision;
+
+	/** Flag indicating whether the Hamiltonian may be stored on banded
+	 *  format. */
+	bool bandedStorage;
+
+	/** Flag indicating whether eigenvectors should be calculated. */
+	bool calculateEigenVectors;
+
+	/** First eigenstate to calculate, or -1 if no state window is used. */
+	int firstState;
+
+	/** Last eigenstate to calculate. */
+	int lastState;
+
+	/** Flag indicating whether an energy window is used. */
+	bool useEnergyWindow;
+
+	/** Lower bound of the energy window. */
+	double lowerEnergy;
+
+	/** Upper bound of the energy window. */
+	double upperEnergy;
+
+	/** Number of eigenstates to calculate iteratively, or -1 if the
+	 *  iterative diagonalization is disabled. */
+	int iterativeNumStates;
+
+	/** Residual tolerance for the iterative diagonalization. */
+	double iterativeTolerance;
+
+	/** Maximum number of LOBPCG steps per diagonalization. */
+	int maxIterativeSteps;
+
+	/** Flag indicating whether eigenvectors from a previous iteration are
+	 *  available to start the iterative diagonalization from. */
+	bool isWarm;
+
+	/** ChebyshevSolver used to multiply block vectors by the Hamiltonian
+	 *  in the iterative diagonalization. */
+	ChebyshevSolver chebyshevSolver;
+
+	/** pointer to array containing Hamiltonian. Stored on full upper
+	 *  triangular format unless Algorithm::Packed is used. Then it is
+	 *  stored on packed upper triangular format, or on upper banded format
+	 *  if bandwidth is not -1. */
 	std::complex<double> *hamiltonian;
 
+	/** Bandwidth of the Hamiltonian if it is stored on banded format,
+	 *  otherwise -1. */
+	int bandwidth;
+
+	/** The banded format is used if the basis size is at least this many
+	 *  times larger than the number of stored diagonals. */
+	static constexpr int BANDED_BANDWIDTH_RATIO = 4;
+
 	/** Pointer to array containing eigenvalues.*/
 	double *eigenValues;
 
-	/** Pointer to array containing eigenvectors. */
+	/** Pointer to array containing eigenvectors. Points to the same
+	 *  array as hamiltonian when Algorithm::DivideAndConquer is used,
+	 *  since zheevd returns the eigenvectors in place. */
 	std::complex<double> *eigenVectors;
 
+	/** Number of calculated eigenstates. */
+	int numStates;
+
+	/** LAPACK workspaces. Allocated once by init() and reused in every
+	 *  iteration of the self-consistency loop. */
+	std::complex<double> *work;
+	double *rwork;
+	int *iwork;
+	int *isuppz;
+
+	/** Sizes of the LAPACK workspaces. */
+	int lwork;
+	int lrwork;
+	int liwork;
+
+	/** Single precision Hamiltonian, eigenvalues, eigenvectors, and
+	 *  LAPACK workspaces. Used instead of hamiltonian, work, and rwork
+	 *  when singlePrecision is true. The eigenvalues and eigenvectors are
+	 *  converted to double precision after each diagonalization. The
+	 *  eigenvectors are returned in place of the Hamiltonian by cheevd,
+	 *  and eigenVectorsSingle is then not allocated. */
+	std::complex<float> *hamiltonianSingle;
+	float *eigenValuesSingle;
+	std::complex<float> *eigenVectorsSingle;
+	std::complex<float> *workSingle;
+	float *rworkSingle;
+
+	/** File to store the eigenvectors in, or empty to store them in RAM.
+	 */
+	std::string eigenVectorFile;
+
+	/** Number of eigenstates per panel for eigenvectors stored in a file.
+	 */
+	int eigenVectorPanelSize;
+
+	/** Maximum number of resident panels. */
+	int maxResidentPanels;
+
+	/** Panels that have been loaded and not released, most recently used
+	 *  first. */
+	std::list<int> residentPanels;
+
+	/** The memory-mapped eigenvectors. NULL if the eigenvectors are
+	 *  stored in RAM. */
+	std::complex<double> *mappedArray;
+
+	/** Size of the memory-mapped array in bytes. */
+	size_t mappedSize;
+
+	/** File descriptor for the eigenvector file. */
+	int eigenVectorFileDescriptor;
+
 	/** Maximum number of iterations in the self-consistency loop. */
 	int maxIterations;
 
@@ -112,8 +368,34 @@ private:
 	/** Updates Hamiltonian. */
 	void update();
 
+	/** Writes the Hamiltonian to the given array, using the storage
+	 *  format of the selected algorithm. */
+	template<typename T>
+	void setupHamiltonian(std::complex<T> *matrix);
+
 	/** Diagonalizes the Hamiltonian. */
 	void solve();
+
+	/** Diagonalizes the Hamiltonian in double precision. */
+	void solveDoublePrecision();
+
+	/** Diagonalizes the Hamiltonian in single precision and converts the
+	 *  result to double precision. */
+	void solveSinglePrecision();
+
+	/** Free all memory. */
+	void clear();
+
+	/** Allocate an array in the eigenvector file and memory-map it. */
+	std::complex<double>* mapEigenVectorFile(size_t size);
+
+	/** Release the memory occupied by the given byte range of the
+	 *  memory-mapped array. The data remains available in the file. */
+	void releaseMappedRange(size_t begin, size_t end);
+
+	/** Refines the eigenvectors from the previous iteration using
+	 *  LOBPCG. */
+	void solveIterative();
 };
 
 inline void DiagonalizationSolver::setModel(Model *model){
@@ -132,6 +414,131 @@ inline void DiagonalizationSolver::setMaxIterations(int maxIterations){
 	this->maxIterations = maxIterations;
 }
 
+inline void DiagonalizationSolver::setAlgorithm(Algorithm algorithm){
+	this->algorithm = algorithm;
+}
+
+inline void DiagonalizationSolver::setSinglePrecision(bool singlePrecision){
+	this->singlePrecision = singlePrecision;
+}
+
+inline void DiagonalizationSolver::setBandedStorage(bool bandedStorage){
+	this->bandedStorage = bandedStorage;
+}
+
+inline void DiagonalizationSolver::setCalculateEigenVectors(
+	bool calculateEigenVectors
+){
+	this->calculateEigenVectors = calculateEigenVectors;
+}
+
+inline void DiagonalizationSolver::setStateWindow(
+	int firstState,
+	int lastState
+){
+	TBTKAssert(
+		0 <= firstState && firstState <= lastState,
+		"DiagonalizationSolver::setStateWindow()",
+		"Invalid state window [" << firstState << ", " << lastState << "].",
+		""
+	);
+
+	this->firstState = firstState;
+	this->lastState = lastState;
+	useEnergyWindow = false;
+}
+
+inline void DiagonalizationSolver::setEnergyWindow(
+	double lowerEnergy,
+	double upperEnergy
+){
+	TBTKAssert(
+		lowerEnergy < upperEnergy,
+		"DiagonalizationSolver::setEnergyWindow()",
+		"Invalid energy window (" << lowerEnergy << ", " << upperEnergy << "].",
+		""
+	);
+
+	this->lowerEnergy = lowerEnergy;
+	this->upperEnergy = upperEnergy;
+	useEnergyWindow = true;
+	firstState = -1;
+	lastState = -1;
+}
+
+inline void DiagonalizationSolver::setEigenVectorFile(
+	const std::string &eigenVectorFile
+){
+	this->eigenVectorFile = eigenVectorFile;
+}
+
+inline void DiagonalizationSolver::setEigenVectorPanelSize(
+	int eigenVectorPanelSize
+){
+	TBTKAssert(
+		eigenVectorPanelSize > 0,
+		"DiagonalizationSolver::setEigenVectorPanelSize()",
+		"Invalid panel size " << eigenVectorPanelSize << ".",
+		"The panel size has to be larger than zero."
+	);
+
+	this->eigenVectorPanelSize = eigenVectorPanelSize;
+}
+
+inline void DiagonalizationSolver::setMaxResidentPanels(
+	int maxResidentPanels
+){
+	TBTKAssert(
+		maxResidentPanels > 0,
+		"DiagonalizationSolver::setMaxResidentPanels()",
+		"Invalid number of panels " << maxResidentPanels << ".",
+		"At least one panel has to be resident."
+	);
+
+	this->maxResidentPanels = maxResidentPanels;
+}
+
+inline int DiagonalizationSolver::getEigenVectorPanelSize(){
+	if(mappedArray == NULL)
+		return std::max(numStates, 1);
+	else
+		return eigenVectorPanelSize;
+}
+
+inline int DiagonalizationSolver::getNumStates(){
+	return numStates;
+}
+
+inline void DiagonalizationSolver::setIterativeNumStates(int numStates){
+	if(numStates == -1){
+		iterativeNumStates = -1;
+		return;
+	}
+
+	TBTKAssert(
+		numStates > 0,
+		"DiagonalizationSolver::setIterativeNumStates()",
+		"Invalid number of states '" << numStates << "'.",
+		""
+	);
+
+	iterativeNumStates = numStates;
+	algorithm = Algorithm::MRRR;
+	setStateWindow(0, numStates-1);
+}
+
+inline void DiagonalizationSolver::setIterativeTolerance(
+	double iterativeTolerance
+){
+	this->iterativeTolerance = iterativeTolerance;
+}
+
+inline void DiagonalizationSolver::setMaxIterativeSteps(
+	int maxIterativeSteps
+){
+	this->maxIterativeSteps = maxIterativeSteps;
+}
+
 inline const double* DiagonalizationSolver::getEigenValues(){
 	return eigenValues;
 }
@@ -152,7 +559,7 @@ inline const std::complex<double> DiagonalizationSolver::getAmplitude(
 	int state,
 	const Index &index
 ){
-	return eigenVectors[model->getBasisSize()*state + model->getBasisIndex(index)];
+	return eigenVectors[(size_t)model->getBasisSize()*state + model->getBasisIndex(index)];
 }
 
 inline const double DiagonalizationSolver::getEigenValue(int state){
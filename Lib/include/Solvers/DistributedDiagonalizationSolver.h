@@ -0,0 +1,405 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file DistributedDiagonalizationSolver.h
+ *  @brief Solves a Model using distributed memory diagonalization
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_DISTRIBUTED_DIAGONALIZATION_SOLVER
+#define COM_DAFER45_TBTK_DISTRIBUTED_DIAGONALIZATION_SOLVER
+
+#include "Model.h"
+#include "TBTKMacros.h"
+
+#include <complex>
+
+namespace TBTK{
+
+/** Solves a given model by diagonalizing the Hamiltonian distributed over
+ *  the memory of several MPI processes, which allows for Hamiltonians that
+ *  do not fit in the memory of a single node. Each process holds the Model,
+ *  which is sparse, and builds the part of the dense Hamiltonian it owns in a
+ *  two-dimensional block cyclic distribution over a grid of processes. The
+ *  Hamiltonian is diagonalized using the ScaLAPACK routine pzheevd, after
+ *  which the eigenvectors are redistributed into panels of blockSize
+ *  consecutive eigenstates that are assigned to the processes cyclically.
+ *  Each process thereby holds complete eigenvectors for a subset of the
+ *  eigenstates, while all processes hold all eigenvalues.
+ *
+ *  Requires that the library is built with MPI=1, which links against MPI
+ *  and ScaLAPACK. Otherwise the solver runs as a single process using
+ *  LAPACK. MPI has to be initialized before run() is called. The
+ *  DPropertyExtractor sums the contributions from the locally owned
+ *  eigenstates over the processes, and returns the complete properties on
+ *  every process. */
+class DistributedDiagonalizationSolver{
+public:
+	/** Constructor */
+	DistributedDiagonalizationSolver();
+
+	/** Destructor. */
+	~DistributedDiagonalizationSolver();
+
+	/** Set model to work on. */
+	void setModel(Model *model);
+
+	/** Get model. */
+	Model* getModel();
+
+	/** Set self-consistency callback. If set to NULL or never called, the
+	 *  self-consistency loop will not be run. The callback is called on
+	 *  all processes, and has to return the same value on all processes.
+	 */
+	void setSCCallback(
+		bool (*scCallback)(
+			DistributedDiagonalizationSolver *solver
+		)
+	);
+
+	/** Set maximum number of iterations for the self-consistency loop. */
+	void setMaxIterations(int maxIterations);
+
+	/** Set the block size of the block cyclic distribution, which is also
+	 *  the number of eigenstates per panel. Default is 64. */
+	void setBlockSize(int blockSize);
+
+	/** Set the dimensions of the process grid. The product has to be equal
+	 *  to the number of processes. By default, the grid is chosen as close
+	 *  to square as possible.
+	 *
+	 *  @param numProcessRows Number of rows in the process grid.
+	 *  @param numProcessColumns Number of columns in the process grid. */
+	void setProcessGrid(int numProcessRows, int numProcessColumns);
+
+	/** Run calculations. Diagonalizes once if no self-consistency callback
+	 *  has been set, or otherwise multiple times until self-consistency or
+	 *  the maximum number of iterations has been reached. Has to be called
+	 *  on all processes. */
+	void run();
+
+	/** Get the rank of this process. */
+	int getRank();
+
+	/** Get the number of processes. */
+	int getNumProcesses();
+
+	/** Get number of eigenstates. */
+	int getNumStates();
+
+	/** Get eigenvalues. */
+	const double* getEigenValues();
+
+	/** Get eigenvalue. */
+	double getEigenValue(int state);
+
+	/** Get the number of eigenstates owned by this process. */
+	int getNumLocalStates();
+
+	/** Get the eigenstate corresponding to a local eigenstate. */
+	int getState(int localState);
+
+	/** Get the local eigenstate corresponding to an eigenstate, or -1 if
+	 *  the eigenstate is not owned by this process. */
+	int getLocalState(int state);
+
+	/** Get the eigenvectors owned by this process. The eigenvector for
+	 *  local eigenstate n starts at n*basisSize. */
+	const std::complex<double>* getLocalEigenVectors();
+
+	/** Get the eigenvector for the given eigenstate, or NULL if the
+	 *  eigenstate is not owned by this process. */
+	const std::complex<double>* getEigenVector(int state);
+
+	/** Get amplitude for given eigenvector \f$n\f$ and physical index
+	 * \f$x\f$: \f$\Psi_{n}(x)\f$. The eigenstate has to be owned by this
+	 * process.
+	 *  @param state Eigenstate number \f$n\f$.
+	 *  @param index Physical index \f$x\f$.
+	 */
+	const std::complex<double> getAmplitude(int state, const Index &index);
+
+	/** Sum an array over all processes. The sum is stored in the array on
+	 *  every process. Has to be called on all processes. */
+	void sumOverProcesses(double *data, int size);
+
+	/** Sum an array over all processes. The sum is stored in the array on
+	 *  every process. Has to be called on all processes. */
+	void sumOverProcesses(std::complex<double> *data, int size);
+private:
+	/** Model to work on. */
+	Model *model;
+
+	/** Block size of the block cyclic distribution. */
+	int blockSize;
+
+	/** Requested number of rows in the process grid, or -1 to choose
+	 *  automatically. */
+	int requestedProcessRows;
+
+	/** Requested number of columns in the process grid. */
+	int requestedProcessColumns;
+
+	/** Rank of this process and number of processes. */
+	int rank;
+	int numProcesses;
+
+	/** BLACS context and dimensions of the process grid, and the position
+	 *  of this process in the grid. */
+	int context;
+	int numProcessRows;
+	int numProcessColumns;
+	int processRow;
+	int processColumn;
+
+	/** BLACS context of the one-dimensional process grid used for the
+	 *  eigenvector panels. */
+	int panelContext;
+
+	/** Number of rows and columns of the locally owned part of the
+	 *  Hamiltonian. */
+	int numLocalRows;
+	int numLocalColumns;
+
+	/** Locally owned part of the Hamiltonian, stored column major. */
+	std::complex<double> *hamiltonian;
+
+	/** Locally owned part of the eigenvectors, distributed as the
+	 *  Hamiltonian. */
+	std::complex<double> *eigenVectors;
+
+	/** Pointer to array containing all eigenvalues. */
+	double *eigenValues;
+
+	/** Number of locally owned eigenstates. */
+	int numLocalStates;
+
+	/** Eigenvectors of the locally owned eigenstates. */
+	std::complex<double> *localEigenVectors;
+
+	/** Maximum number of iterations in the self-consistency loop. */
+	int maxIterations;
+
+	/** Callback function to call each time a diagonalization has been
+	 *  completed. */
+	bool (*scCallback)(DistributedDiagonalizationSolver *solver);
+
+	/** Allocates space for Hamiltonian etc. */
+	void init();
+
+	/** Updates Hamiltonian. */
+	void update();
+
+	/** Free all memory and release the process grids. */
+	void clear();
+
+	/** Set up the process grids and determine the rank of this process
+	 *  and the number of processes. Implemented by the MPI backend. */
+	void initProcessGrid();
+
+	/** Release the process grids. Implemented by the MPI backend. */
+	void exitProcessGrid();
+
+	/** Diagonalizes the Hamiltonian and redistributes the eigenvectors
+	 *  into panels. Implemented by the MPI backend. */
+	void solve();
+
+	/** Number of rows or columns owned by a process for a block cyclic
+	 *  distribution. Equivalent to ScaLAPACK's numroc. */
+	static int getNumLocal(
+		int size,
+		int blockSize,
+		int process,
+		int numProcesses
+	);
+
+	/** Process owning a row or column for a block cyclic distribution. */
+	static int getOwner(int global, int blockSize, int numProcesses);
+
+	/** Local index of a row or column for a block cyclic distribution. */
+	static int getLocal(int global, int blockSize, int numProcesses);
+
+	/** Global index of a local row or column for a block cyclic
+	 *  distribution. */
+	static int getGlobal(
+		int local,
+		int blockSize,
+		int process,
+		int numProcesses
+	);
+};
+
+inline void DistributedDiagonalizationSolver::setModel(Model *model){
+	this->model = model;
+}
+
+inline Model* DistributedDiagonalizationSolver::getModel(){
+	return model;
+}
+
+inline void DistributedDiagonalizationSolver::setSCCallback(
+	bool (*scCallback)(
+		DistributedDiagonalizationSolver *solver
+	)
+){
+	this->scCallback = scCallback;
+}
+
+inline void DistributedDiagonalizationSolver::setMaxIterations(
+	int maxIterations
+){
+	this->maxIterations = maxIterations;
+}
+
+inline void DistributedDiagonalizationSolver::setBlockSize(int blockSize){
+	TBTKAssert(
+		blockSize > 0,
+		"DistributedDiagonalizationSolver::setBlockSize()",
+		"blockSize has to be larger than 0.",
+		""
+	);
+
+	this->blockSize = blockSize;
+}
+
+inline void DistributedDiagonalizationSolver::setProcessGrid(
+	int numProcessRows,
+	int numProcessColumns
+){
+	TBTKAssert(
+		numProcessRows > 0 && numProcessColumns > 0,
+		"DistributedDiagonalizationSolver::setProcessGrid()",
+		"Invalid process grid " << numProcessRows << "x" << numProcessColumns << ".",
+		""
+	);
+
+	requestedProcessRows = numProcessRows;
+	requestedProcessColumns = numProcessColumns;
+}
+
+inline int DistributedDiagonalizationSolver::getRank(){
+	return rank;
+}
+
+inline int DistributedDiagonalizationSolver::getNumProcesses(){
+	return numProcesses;
+}
+
+inline int DistributedDiagonalizationSolver::getNumStates(){
+	return model->getBasisSize();
+}
+
+inline const double* DistributedDiagonalizationSolver::getEigenValues(){
+	return eigenValues;
+}
+
+inline double DistributedDiagonalizationSolver::getEigenValue(
+	int state
+){
+	return eigenValues[state];
+}
+
+inline int DistributedDiagonalizationSolver::getNumLocalStates(){
+	return numLocalStates;
+}
+
+inline int DistributedDiagonalizationSolver::getState(int localState){
+	return getGlobal(localState, blockSize, rank, numProcesses);
+}
+
+inline int DistributedDiagonalizationSolver::getLocalState(int state){
+	if(getOwner(state, blockSize, numProcesses) != rank)
+		return -1;
+	else
+		return getLocal(state, blockSize, numProcesses);
+}
+
+inline const std::complex<double>* DistributedDiagonalizationSolver::getLocalEigenVectors(){
+	return localEigenVectors;
+}
+
+inline const std::complex<double>* DistributedDiagonalizationSolver::getEigenVector(
+	int state
+){
+	int localState = getLocalState(state);
+	if(localState == -1)
+		return NULL;
+	else
+		return &localEigenVectors[(size_t)model->getBasisSize()*localState];
+}
+
+inline const std::complex<double> DistributedDiagonalizationSolver::getAmplitude(
+	int state,
+	const Index &index
+){
+	const std::complex<double> *eigenVector = getEigenVector(state);
+	TBTKAssert(
+		eigenVector != NULL,
+		"DistributedDiagonalizationSolver::getAmplitude()",
+		"Eigenstate " << state << " is not owned by process " << rank << ".",
+		"Use DistributedDiagonalizationSolver::getLocalState() to check ownership."
+	);
+
+	return eigenVector[model->getBasisIndex(index)];
+}
+
+inline int DistributedDiagonalizationSolver::getNumLocal(
+	int size,
+	int blockSize,
+	int process,
+	int numProcesses
+){
+	int numBlocks = size/blockSize;
+	int numLocal = (numBlocks/numProcesses)*blockSize;
+	int extraBlocks = numBlocks%numProcesses;
+	if(process < extraBlocks)
+		numLocal += blockSize;
+	else if(process == extraBlocks)
+		numLocal += size%blockSize;
+
+	return numLocal;
+}
+
+inline int DistributedDiagonalizationSolver::getOwner(
+	int global,
+	int blockSize,
+	int numProcesses
+){
+	return (global/blockSize)%numProcesses;
+}
+
+inline int DistributedDiagonalizationSolver::getLocal(
+	int global,
+	int blockSize,
+	int numProcesses
+){
+	return (global/(blockSize*numProcesses))*blockSize + global%blockSize;
+}
+
+inline int DistributedDiagonalizationSolver::getGlobal(
+	int local,
+	int blockSize,
+	int process,
+	int numProcesses
+){
+	return ((local/blockSize)*numProcesses + process)*blockSize
+		+ local%blockSize;
+}
+
+};	//End of namespace TBTK
+
+#endif
@@ -0,0 +1,190 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file SelfConsistencyDriver.h
+ *  @brief Mixing of order parameters in self-consistency loops
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_SELF_CONSISTENCY_DRIVER
+#define COM_DAFER45_TBTK_SELF_CONSISTENCY_DRIVER
+
+#include <complex>
+#include <vector>
+
+namespace TBTK{
+
+/** Mixes the input and output order parameters of a self-consistency loop to
+ *  obtain the input for the next iteration, and keeps track of the
+ *  convergence. The order parameter is an array registered with
+ *  setOrderParameter(), which contains the input to the current iteration
+ *  and is used by the callbacks of the Model. After the solver has been run,
+ *  the new order parameter is calculated into a separate array and passed to
+ *  update(), which overwrites the registered array with the input to the
+ *  next iteration.
+ *
+ *  The driver is independent of the solver. With the DiagonalizationSolver,
+ *  update() is called from the self-consistency callback and its return
+ *  value is returned from the callback. With the ChebyshevSolver, update()
+ *  is called at the end of each iteration of the self-consistency loop,
+ *  which is exited when update() returns true.
+ *
+ *  Linear mixing converges slowly when the order parameter responds
+ *  strongly to its input. Anderson (Pulay) mixing and the modified Broyden
+ *  method instead use the history of inputs and residuals to estimate the
+ *  inverse Jacobian of the self-consistency equations, and typically
+ *  reduce the number of iterations several times. */
+class SelfConsistencyDriver{
+public:
+	/** Enum class for specifying the mixing method. */
+	enum class Method{
+		/** Linear mixing of input and output. */
+		Linear,
+		/** Anderson (Pulay, DIIS) mixing. Minimizes the norm of the
+		 *  residual in the space spanned by the previous iterations. */
+		Anderson,
+		/** Modified Broyden method of D. D. Johnson, Phys. Rev. B 38,
+		 *  12807 (1988). Similar to Anderson mixing, but regularized,
+		 *  which makes it more robust far from self-consistency. */
+		Broyden
+	};
+
+	/** Constructor. */
+	SelfConsistencyDriver();
+
+	/** Destructor. */
+	~SelfConsistencyDriver();
+
+	/** Register the order parameter. The array is not copied, and is
+	 *  updated in place by update(). Also resets the driver.
+	 *
+	 *  @param orderParameter Array containing the initial guess.
+	 *  @param size Number of elements in the array. */
+	void setOrderParameter(std::complex<double> *orderParameter, int size);
+
+	/** Set mixing method. Method::Anderson by default. */
+	void setMethod(Method method);
+
+	/** Set the mixing parameter, which is the fraction of the output that
+	 *  is mixed into the input in linear mixing, and the weight of the
+	 *  residual in the other methods. Default is 0.5. */
+	void setMixingParameter(double mixingParameter);
+
+	/** Set the number of previous iterations used by the Anderson and
+	 *  Broyden methods. Default is 8. */
+	void setHistorySize(int historySize);
+
+	/** Set the convergence limit for the relative residual
+	 *  \f$\max_i|x^{out}_i - x^{in}_i|/\max_i|x^{out}_i|\f$. Default is
+	 *  1e-4. */
+	void setConvergenceLimit(double convergenceLimit);
+
+	/** Reset the iteration count and the history, for example before
+	 *  starting a new self-consistency loop with the same order
+	 *  parameter. */
+	void reset();
+
+	/** Mix the output of the current iteration with the registered order
+	 *  parameter, which is overwritten by the input to the next iteration.
+	 *  If the residual is below the convergence limit, the order parameter
+	 *  is instead set equal to the output.
+	 *
+	 *  @param output Order parameter calculated from the solution obtained
+	 *  with the registered order parameter as input.
+	 *
+	 *  @return True if converged, otherwise false. */
+	bool update(const std::complex<double> *output);
+
+	/** Get the number of calls to update() since the last reset. */
+	int getNumIterations();
+
+	/** Get the relative residual of each iteration since the last reset.
+	 */
+	const std::vector<double>& getResidualHistory();
+private:
+	/** Order parameter. */
+	std::complex<double> *orderParameter;
+
+	/** Number of elements in the order parameter. */
+	int size;
+
+	/** Mixing method. */
+	Method method;
+
+	/** Mixing parameter. */
+	double mixingParameter;
+
+	/** Number of previous iterations used for mixing. */
+	int historySize;
+
+	/** Convergence limit for the relative residual. */
+	double convergenceLimit;
+
+	/** Relative residual of each iteration. */
+	std::vector<double> residualHistory;
+
+	/** Input and residual of the previous iteration. */
+	std::vector<std::complex<double>> previousInput;
+	std::vector<std::complex<double>> previousResidual;
+
+	/** Differences between the inputs and the residuals of consecutive
+	 *  iterations, oldest first. */
+	std::vector<std::vector<std::complex<double>>> inputDifferences;
+	std::vector<std::vector<std::complex<double>>> residualDifferences;
+
+	/** Calculate the coefficients of the previous iterations that
+	 *  minimize the residual.
+	 *
+	 *  @param residual The residual of the current iteration.
+	 *  @param coefficients Vector which the coefficients are written to.
+	 *
+	 *  @return False if the equations are singular, otherwise true. */
+	bool calculateCoefficients(
+		const std::vector<std::complex<double>> &residual,
+		std::vector<double> &coefficients
+	);
+};
+
+inline void SelfConsistencyDriver::setMethod(Method method){
+	this->method = method;
+}
+
+inline void SelfConsistencyDriver::setMixingParameter(double mixingParameter){
+	this->mixingParameter = mixingParameter;
+}
+
+inline void SelfConsistencyDriver::setHistorySize(int historySize){
+	this->historySize = historySize;
+}
+
+inline void SelfConsistencyDriver::setConvergenceLimit(
+	double convergenceLimit
+){
+	this->convergenceLimit = convergenceLimit;
+}
+
+inline int SelfConsistencyDriver::getNumIterations(){
+	return residualHistory.size();
+}
+
+inline const std::vector<double>& SelfConsistencyDriver::getResidualHistory(){
+	return residualHistory;
+}
+
+};	//End of namespace TBTK
+
+#endif
@@ -0,0 +1,94 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @package TBTKcalc
+ *  @file DenseLinearAlgebra.h
+ *  @brief Dense linear algebra on blocks of vectors
+ *
+ *  @author agent
+ */
+
+#ifndef COM_DAFER45_TBTK_DENSE_LINEAR_ALGEBRA
+#define COM_DAFER45_TBTK_DENSE_LINEAR_ALGEBRA
+
+#include <complex>
+
+namespace TBTK{
+
+/** Dense linear algebra operations shared by the iterative solvers, which
+ *  work on blocks of vectors stored one after the other and on the small
+ *  dense matrices obtained by projecting the Hamiltonian onto them. The
+ *  operations are thin wrappers around BLAS and LAPACK. */
+class DenseLinearAlgebra{
+public:
+	/** Calculate C = alpha*op(A)*op(B) + beta*C using zgemm. All matrices
+	 *  are stored column major.
+	 *
+	 *  @param transA 'N' for op(A) = A, 'C' for op(A) = A^{\dagger}.
+	 *  @param transB 'N' for op(B) = B, 'C' for op(B) = B^{\dagger}.
+	 *  @param m Number of rows of op(A) and C.
+	 *  @param n Number of columns of op(B) and C.
+	 *  @param k Number of columns of op(A) and rows of op(B). */
+	static void multiply(
+		char transA,
+		char transB,
+		int m,
+		int n,
+		int k,
+		std::complex<double> alpha,
+		const std::complex<double> *a,
+		int lda,
+		const std::complex<double> *b,
+		int ldb,
+		std::complex<double> beta,
+		std::complex<double> *c,
+		int ldc
+	);
+
+	/** Calculate all eigenvalues and eigenvectors of a small dense
+	 *  Hermitian matrix using zheevd.
+	 *
+	 *  @param matrix Matrix of size size*size. Only the upper triangle is
+	 *  used. Contains the eigenvectors on return.
+	 *  @param eigenValues Array able to hold size eigenvalues. Contains
+	 *  the eigenvalues in ascending order on return.
+	 *  @param size Number of rows and columns of the matrix. */
+	static void diagonalizeHermitian(
+		std::complex<double> *matrix,
+		double *eigenValues,
+		int size
+	);
+
+	/** Orthonormalize a block of vectors through a diagonalization of
+	 *  their overlap matrix. Vectors that are linearly dependent on the
+	 *  others are removed.
+	 *
+	 *  @param vectors Vectors stored one after the other. Contains the
+	 *  orthonormal vectors on return.
+	 *  @param vectorSize Number of components of each vector.
+	 *  @param numVectors Number of vectors.
+	 *
+	 *  @return The number of orthonormal vectors, which are stored first
+	 *  in vectors. */
+	static int orthonormalize(
+		std::complex<double> *vectors,
+		int vectorSize,
+		int numVectors
+	);
+};
+
+};	//End of namespace TBTK
+
+#endif
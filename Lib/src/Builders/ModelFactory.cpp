@@ -374,7 +374,8 @@ Model* ModelFactory::merge(
 		AmplitudeSet::Iterator it = m->getAmplitudeSet()->getIterator();
 		const HoppingAmplitude *ha;
 		while((ha = it.getHA())){
-			complex<double> amplitude = ha->getAmplitude();
+			complex<double> amplitude
+				= m->getAmplitudeSet()->getAmplitude(*ha);
 			Index from = ha->fromIndex;
 			Index to = ha->fromIndex;
 
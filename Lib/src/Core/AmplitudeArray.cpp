@@ -0,0 +1,435 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file AmplitudeArray.cpp
+ *
+ *  @author agent
+ */
+
+#include "AmplitudeArray.h"
+#include "TBTKMacros.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_map>
+#include <utility>
+
+using namespace std;
+
+namespace TBTK{
+
+AmplitudeArray::AmplitudeArray(){
+	size = 0;
+	hermitianStorage = false;
+	fromBasisIndices = NULL;
+	toBasisIndices = NULL;
+	values = NULL;
+	callbackIds = NULL;
+	physicalIndexTable = NULL;
+	callbackDirtyTracking = false;
+}
+
+AmplitudeArray::~AmplitudeArray(){
+	clear();
+}
+
+void AmplitudeArray::clear(){
+	if(fromBasisIndices != NULL){
+		delete [] fromBasisIndices;
+		fromBasisIndices = NULL;
+	}
+	if(toBasisIndices != NULL){
+		delete [] toBasisIndices;
+		toBasisIndices = NULL;
+	}
+	if(values != NULL){
+		delete [] values;
+		values = NULL;
+	}
+	if(callbackIds != NULL){
+		delete [] callbackIds;
+		callbackIds = NULL;
+	}
+	callbackGroups.clear();
+	amplitudeCallbackGroupIds.clear();
+	batchCallbackGroupIds.clear();
+	callbackPositions.clear();
+	size = 0;
+	hermitianStorage = false;
+	physicalIndexTable = NULL;
+}
+
+void AmplitudeArray::construct(
+	const TreeNode &tree,
+	const IndexHashTable &indexHashTable,
+	const PhysicalIndexTable &physicalIndexTable,
+	bool hermitianStorage
+){
+	TBTKAssert(
+		tree.basisSize >= 0,
+		"AmplitudeArray::construct()",
+		"Basis indices have not been generated.",
+		"Use TreeNode::generateBasisIndices() first."
+	);
+
+	clear();
+
+	this->physicalIndexTable = &physicalIndexTable;
+	this->hermitianStorage = hermitianStorage;
+
+	size = countAmplitudes(tree);
+	//Allocate at least one element to signal that the arrays have been
+	//constructed also when the tree is empty.
+	fromBasisIndices = new int[size + 1];
+	toBasisIndices = new int[size + 1];
+	values = new complex<double>[size + 1];
+	callbackIds = new int[size + 1];
+
+	//The leaves are visited in basis order rather than in tree order, since
+	//the basis indices may have been permuted after they were generated.
+	vector<const TreeNode*> leaves(tree.basisSize);
+	collectLeaves(tree, leaves.data());
+
+	//Resolve the 'to'-indices of all amplitudes in one batch.
+	vector<const Index*> toIndices(size);
+	int counter = 0;
+	for(int n = 0; n < tree.basisSize; n++){
+		const vector<HoppingAmplitude> &has
+			= leaves[n]->hoppingAmplitudes;
+		for(unsigned int c = 0; c < has.size(); c++)
+			toIndices[counter++] = &has[c].toIndex;
+	}
+	vector<int> amplitudeToBasisIndices(size);
+	indexHashTable.getBasisIndices(
+		toIndices.data(),
+		size,
+		amplitudeToBasisIndices.data()
+	);
+	for(int n = 0; n < size; n++){
+		TBTKAssert(
+			amplitudeToBasisIndices[n] != -1,
+			"AmplitudeArray::construct()",
+			"Found HoppingAmplitude with 'to'-index "
+			<< toIndices[n]->toString() << " that does not"
+			<< " correspond to any basis state.",
+			""
+		);
+	}
+
+	if(hermitianStorage){
+		storeHermitianAmplitudes(
+			leaves.data(),
+			tree.basisSize,
+			amplitudeToBasisIndices.data()
+		);
+	}
+	else{
+		int position = 0;
+		for(int n = 0; n < tree.basisSize; n++){
+			storeAmplitudes(
+				*leaves[n],
+				amplitudeToBasisIndices.data() + position,
+				&position
+			);
+		}
+	}
+}
+
+int AmplitudeArray::getBandwidth() const{
+	int bandwidth = 0;
+	for(int n = 0; n < size; n++){
+		int difference = abs(fromBasisIndices[n] - toBasisIndices[n]);
+		if(difference > bandwidth)
+			bandwidth = difference;
+	}
+
+	return bandwidth;
+}
+
+int AmplitudeArray::countAmplitudes(const TreeNode &treeNode){
+	int numAmplitudes = treeNode.hoppingAmplitudes.size();
+	for(unsigned int n = 0; n < treeNode.getNumChildren(); n++){
+		if(treeNode.getChild(n) != NULL)
+			numAmplitudes += countAmplitudes(*treeNode.getChild(n));
+	}
+
+	return numAmplitudes;
+}
+
+void AmplitudeArray::collectLeaves(
+	const TreeNode &treeNode,
+	const TreeNode **leaves
+){
+	if(treeNode.basisIndex != -1){
+		leaves[treeNode.basisIndex] = &treeNode;
+		return;
+	}
+
+	for(unsigned int n = 0; n < treeNode.getNumChildren(); n++)
+		if(treeNode.getChild(n) != NULL)
+			collectLeaves(*treeNode.getChild(n), leaves);
+}
+
+void AmplitudeArray::storeAmplitudes(
+	const TreeNode &treeNode,
+	const int *amplitudeToBasisIndices,
+	int *position
+){
+	const vector<HoppingAmplitude> &has = treeNode.hoppingAmplitudes;
+
+	//The amplitudes on a leaf all have the same 'from'-basis index. They
+	//are ordered by 'to'-basis index, keeping the order of amplitudes
+	//with the same 'to'-basis index.
+	vector<pair<int, int>> order;
+	order.reserve(has.size());
+	for(unsigned int n = 0; n < has.size(); n++)
+		order.push_back(make_pair(amplitudeToBasisIndices[n], n));
+	stable_sort(
+		order.begin(),
+		order.end(),
+		[](const pair<int, int> &p1, const pair<int, int> &p2){
+			return p1.first < p2.first;
+		}
+	);
+
+	for(unsigned int n = 0; n < order.size(); n++){
+		storeAmplitude(
+			(*position)++,
+			has[order[n].second],
+			treeNode.basisIndex,
+			order[n].first,
+			false
+		);
+	}
+}
+
+void AmplitudeArray::storeHermitianAmplitudes(
+	const TreeNode *const *leaves,
+	int basisSize,
+	const int *amplitudeToBasisIndices
+){
+	//Each amplitude is stored in the row given by the larger of its two
+	//basis indices. Amplitudes with a 'to'-basis index larger than the
+	//'from'-basis index are therefore replaced by their Hermitian
+	//conjugates. The basis indices may have been permuted after the tree
+	//was filled, so this can not be decided when the amplitudes are
+	//added. Count the amplitudes in each row.
+	vector<const HoppingAmplitude*> has(size);
+	vector<int> amplitudeFromBasisIndices(size);
+	vector<int> rowStarts(basisSize+1, 0);
+	int counter = 0;
+	for(int n = 0; n < basisSize; n++){
+		const vector<HoppingAmplitude> &leafHAs
+			= leaves[n]->hoppingAmplitudes;
+		for(unsigned int c = 0; c < leafHAs.size(); c++){
+			int to = amplitudeToBasisIndices[counter];
+			has[counter] = &leafHAs[c];
+			amplitudeFromBasisIndices[counter] = n;
+			rowStarts[max(n, to)+1]++;
+			counter++;
+		}
+	}
+	for(int n = 0; n < basisSize; n++)
+		rowStarts[n+1] += rowStarts[n];
+
+	//Place the amplitudes in their rows, and order each row by column,
+	//keeping the order of amplitudes in the same column.
+	vector<pair<int, int>> order(size);
+	vector<int> rowPositions(rowStarts.begin(), rowStarts.end()-1);
+	for(int n = 0; n < size; n++){
+		int from = amplitudeFromBasisIndices[n];
+		int to = amplitudeToBasisIndices[n];
+		order[rowPositions[max(from, to)]++] = make_pair(min(from, to), n);
+	}
+	for(int n = 0; n < basisSize; n++){
+		stable_sort(
+			order.begin() + rowStarts[n],
+			order.begin() + rowStarts[n+1],
+			[](const pair<int, int> &p1, const pair<int, int> &p2){
+				return p1.first < p2.first;
+			}
+		);
+	}
+
+	for(int n = 0; n < basisSize; n++){
+		for(int p = rowStarts[n]; p < rowStarts[n+1]; p++){
+			int a = order[p].second;
+			storeAmplitude(
+				p,
+				*has[a],
+				n,
+				order[p].first,
+				amplitudeToBasisIndices[a]
+					> amplitudeFromBasisIndices[a]
+			);
+		}
+	}
+}
+
+void AmplitudeArray::storeAmplitude(
+	int p,
+	const HoppingAmplitude &ha,
+	int fromBasisIndex,
+	int toBasisIndex,
+	bool isConjugated
+){
+	fromBasisIndices[p] = fromBasisIndex;
+	toBasisIndices[p] = toBasisIndex;
+	if(ha.amplitudeCallback || ha.batchCallback){
+		//Find the callback group, or create a new one.
+		unordered_map<void*, unsigned int> &ids
+			= ha.batchCallback
+			? batchCallbackGroupIds[ha.batchCallback]
+			: amplitudeCallbackGroupIds[ha.amplitudeCallback];
+		pair<unordered_map<void*, unsigned int>::iterator, bool> entry
+			= ids.insert(
+				make_pair(ha.callbackContext, callbackGroups.size())
+			);
+		unsigned int id = entry.first->second;
+		if(entry.second){
+			callbackGroups.push_back(CallbackGroup());
+			CallbackGroup &group = callbackGroups.back();
+			group.amplitudeCallback = ha.amplitudeCallback;
+			group.batchCallback = ha.batchCallback;
+			group.callbackContext = ha.callbackContext;
+			group.isDirty = true;
+			group.version = 0;
+		}
+
+		//Callbacks are evaluated with the 'to'- and 'from'-indices
+		//above, and therefore give the Hermitian conjugate directly
+		//if the amplitude is conjugated.
+		CallbackGroup &group = callbackGroups[id];
+		group.positions.push_back(p);
+		if(group.batchCallback){
+			group.toBasisIndices.push_back(toBasisIndex);
+			group.fromBasisIndices.push_back(fromBasisIndex);
+		}
+
+		callbackIds[p] = id;
+		callbackPositions.push_back(p);
+		//Callbacks are not evaluated until evaluateCallbacks() is
+		//called, since they may depend on parameters that are not yet
+		//set up.
+		values[p] = 0.;
+	}
+	else{
+		callbackIds[p] = -1;
+		if(isConjugated)
+			values[p] = conj(ha.amplitude);
+		else
+			values[p] = ha.amplitude;
+	}
+}
+
+void AmplitudeArray::evaluateCallbacks(){
+	TBTKAssert(
+		getIsConstructed(),
+		"AmplitudeArray::evaluateCallbacks()",
+		"AmplitudeArray not constructed.",
+		""
+	);
+
+	for(unsigned int c = 0; c < callbackGroups.size(); c++){
+		CallbackGroup &group = callbackGroups[c];
+		if(callbackDirtyTracking && !group.isDirty)
+			continue;
+
+		if(group.batchCallback){
+			group.values.resize(group.positions.size());
+			group.batchCallback(
+				group.toBasisIndices.data(),
+				group.fromBasisIndices.data(),
+				group.positions.size(),
+				group.values.data(),
+				group.callbackContext
+			);
+			for(unsigned int n = 0; n < group.positions.size(); n++)
+				values[group.positions[n]] = group.values[n];
+		}
+		else{
+			for(unsigned int n = 0; n < group.positions.size(); n++){
+				int p = group.positions[n];
+				values[p] = group.amplitudeCallback(
+					physicalIndexTable->getPhysicalIndex(
+						toBasisIndices[p]
+					),
+					physicalIndexTable->getPhysicalIndex(
+						fromBasisIndices[p]
+					)
+				);
+			}
+		}
+
+		group.isDirty = false;
+		group.version++;
+	}
+}
+
+void AmplitudeArray::markCallbackDirty(
+	complex<double> (*amplitudeCallback)(Index, Index)
+){
+	for(unsigned int c = 0; c < callbackGroups.size(); c++)
+		if(callbackGroups[c].amplitudeCallback == amplitudeCallback)
+			callbackGroups[c].isDirty = true;
+}
+
+void AmplitudeArray::markCallbackDirty(
+	HoppingAmplitude::BatchCallback batchCallback,
+	void *callbackContext
+){
+	for(unsigned int c = 0; c < callbackGroups.size(); c++){
+		if(
+			callbackGroups[c].batchCallback == batchCallback
+			&& callbackGroups[c].callbackContext == callbackContext
+		){
+			callbackGroups[c].isDirty = true;
+		}
+	}
+}
+
+void AmplitudeArray::markAllCallbacksDirty(){
+	for(unsigned int c = 0; c < callbackGroups.size(); c++)
+		callbackGroups[c].isDirty = true;
+}
+
+int AmplitudeArray::getNextColumnStart(int position) const{
+	if(position <= 0)
+		return 0;
+	if(position >= size)
+		return size;
+
+	int from = fromBasisIndices[position-1];
+	while(position < size && fromBasisIndices[position] == from)
+		position++;
+
+	return position;
+}
+
+AmplitudeArray::Range AmplitudeArray::getRange(int numParts, int part) const{
+	TBTKAssert(
+		numParts > 0 && part >= 0 && part < numParts,
+		"AmplitudeArray::getRange()",
+		"Invalid part '" << part << "' of '" << numParts << "' parts.",
+		""
+	);
+
+	int begin = getNextColumnStart((long long)size*part/numParts);
+	int end = getNextColumnStart((long long)size*(part+1)/numParts);
+
+	return Range(begin, end);
+}
+
+};	//End of namespace TBTK
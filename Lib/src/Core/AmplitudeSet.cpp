@@ -21,18 +21,37 @@
 #include "AmplitudeSet.h"
 #include "TBTKMacros.h"
 
+#include <algorithm>
+
 using namespace std;
 
 namespace TBTK{
 
 AmplitudeSet::AmplitudeSet(){
 	isConstructed = false;
+	hermitianStorage = false;
+	basisReordering = false;
 	isSorted = false;
 	numMatrixElements = -1;
 
 	cooRowIndices = NULL;
 	cooColIndices = NULL;
 	cooValues = NULL;
+	cooElementStarts = NULL;
+	cooCallbackElements = NULL;
+	numCOOCallbackElements = 0;
+	cooCallbackGroupElements.clear();
+
+	csrRowPointers = NULL;
+
+	sellChunkSize = 0;
+	sellNumChunks = 0;
+	sellChunkPointers = NULL;
+	sellChunkLengths = NULL;
+	sellRowPermutation = NULL;
+	sellColIndices = NULL;
+	sellValues = NULL;
+	sellPositions = NULL;
 }
 
 AmplitudeSet::~AmplitudeSet(){
@@ -42,6 +61,40 @@ AmplitudeSet::~AmplitudeSet(){
 		delete [] cooColIndices;
 	if(cooValues != NULL)
 		delete [] cooValues;
+	if(cooElementStarts != NULL)
+		delete [] cooElementStarts;
+	if(cooCallbackElements != NULL)
+		delete [] cooCallbackElements;
+
+	destructCSR();
+}
+
+void AmplitudeSet::addHAs(
+	const vector<vector<HoppingAmplitude>*> &haLists
+){
+	TBTKAssert(
+		!isConstructed,
+		"AmplitudeSet::addHAs()",
+		"AmplitudeSet is already constructed.",
+		""
+	);
+
+	if(!hermitianStorage){
+		tree.add(haLists);
+		return;
+	}
+
+	//Only add the HoppingAmplitudes in the stored triangle.
+	vector<vector<HoppingAmplitude>> storedLists(haLists.size());
+	vector<vector<HoppingAmplitude>*> storedListPointers(haLists.size());
+	for(unsigned int n = 0; n < haLists.size(); n++){
+		const vector<HoppingAmplitude> &haList = *haLists[n];
+		for(unsigned int c = 0; c < haList.size(); c++)
+			if(isStored(haList[c]))
+				storedLists[n].push_back(haList[c]);
+		storedListPointers[n] = &storedLists[n];
+	}
+	tree.add(storedListPointers);
 }
 
 int AmplitudeSet::getNumMatrixElements() const{
@@ -55,6 +108,61 @@ int AmplitudeSet::getNumMatrixElements() const{
 	return numMatrixElements;
 }
 
+void AmplitudeSet::getBasisIndices(
+	const Index *indices,
+	int numIndices,
+	int *basisIndices
+) const{
+	TBTKAssert(
+		isConstructed,
+		"AmplitudeSet::getBasisIndices()",
+		"AmplitudeSet has to be constructed first.",
+		""
+	);
+
+	constructIndexHashTable();
+	indexHashTable.getBasisIndices(indices, numIndices, basisIndices);
+
+	//Indices not found in the lookup table are passed on to the tree,
+	//which either reports them as invalid or returns -1.
+	for(int n = 0; n < numIndices; n++)
+		if(basisIndices[n] == -1)
+			basisIndices[n] = tree.getBasisIndex(indices[n]);
+}
+
+void AmplitudeSet::getBasisIndices(
+	const vector<Index> &indices,
+	int *basisIndices
+) const{
+	getBasisIndices(indices.data(), indices.size(), basisIndices);
+}
+
+complex<double> AmplitudeSet::getAmplitude(const HoppingAmplitude &ha) const{
+	if(ha.batchCallback == NULL)
+		return ha.getAmplitude();
+
+	TBTKAssert(
+		isConstructed,
+		"AmplitudeSet::getAmplitude()",
+		"AmplitudeSet has to be constructed before amplitudes given by"
+		<< " batch callbacks can be evaluated.",
+		"Use Model::construct() to construct the AmplitudeSet."
+	);
+
+	int toBasisIndex = getBasisIndex(ha.toIndex);
+	int fromBasisIndex = getBasisIndex(ha.fromIndex);
+	complex<double> amplitude;
+	ha.batchCallback(
+		&toBasisIndex,
+		&fromBasisIndex,
+		1,
+		&amplitude,
+		ha.callbackContext
+	);
+
+	return amplitude;
+}
+
 void AmplitudeSet::constructCOO(){
 	TBTKAssert(
 		isSorted,
@@ -69,67 +177,85 @@ void AmplitudeSet::constructCOO(){
 		""
 	);
 
-	//Count number of matrix elements
-	AmplitudeSet::Iterator it = getIterator();
-	const HoppingAmplitude *ha;
+	constructAmplitudeArray();
+	amplitudeArray.evaluateCallbacks();
+	int numAmplitudes = amplitudeArray.getSize();
+	const int *fromBasisIndices = amplitudeArray.getFromBasisIndices();
+	const int *toBasisIndices = amplitudeArray.getToBasisIndices();
+
+	//The amplitudes are ordered by 'from'- and 'to'-basis index, so
+	//amplitudes that contribute to the same matrix element are adjacent.
+	//Count the matrix elements.
 	numMatrixElements = 0;
-	int currentCol = -1;
-	int currentRow = -1;
-	while((ha = it.getHA())){
-		int col = getBasisIndex(ha->fromIndex);
-		int row = getBasisIndex(ha->toIndex);
-		if(col > currentCol){
-			currentCol = col;
-			currentRow = -1;
-		}
-		if(row > currentRow){
-			currentRow = row;
+	for(int n = 0; n < numAmplitudes; n++){
+		if(
+			n == 0
+			|| fromBasisIndices[n] != fromBasisIndices[n-1]
+			|| toBasisIndices[n] != toBasisIndices[n-1]
+		){
 			numMatrixElements++;
 		}
+	}
 
-		it.searchNextHA();
+	//Find the first amplitude of each matrix element.
+	cooElementStarts = new int[numMatrixElements+1];
+	int counter = 0;
+	for(int n = 0; n < numAmplitudes; n++){
+		if(
+			n == 0
+			|| fromBasisIndices[n] != fromBasisIndices[n-1]
+			|| toBasisIndices[n] != toBasisIndices[n-1]
+		){
+			cooElementStarts[counter++] = n;
+		}
+	}
+	cooElementStarts[numMatrixElements] = numAmplitudes;
+
+	//Find the matrix elements that callback amplitudes contribute to.
+	//These are the only elements that need to be updated by
+	//reconstructCOO().
+	vector<int> callbackElements = getCOOElements(
+		amplitudeArray.getCallbackPositions()
+	);
+	numCOOCallbackElements = callbackElements.size();
+	cooCallbackElements = new int[numCOOCallbackElements];
+	for(int n = 0; n < numCOOCallbackElements; n++)
+		cooCallbackElements[n] = callbackElements[n];
+
+	cooCallbackGroupElements.clear();
+	cooCallbackVersions.clear();
+	for(int c = 0; c < amplitudeArray.getNumCallbacks(); c++){
+		cooCallbackGroupElements.push_back(
+			getCOOElements(amplitudeArray.getCallbackGroupPositions(c))
+		);
+		cooCallbackVersions.push_back(
+			amplitudeArray.getCallbackVersion(c)
+		);
 	}
 
 	cooRowIndices = new int[numMatrixElements];
 	cooColIndices = new int[numMatrixElements];
 	cooValues = new complex<double>[numMatrixElements];
 
-	//Setup matrix on COO format
-	it.reset();
-	int currentMatrixElement = -1;
-	currentCol = -1;
-	currentRow = -1;
-	while((ha = it.getHA())){
-		int col = getBasisIndex(ha->fromIndex);
-		int row = getBasisIndex(ha->toIndex);
-		complex<double> amplitude = ha->getAmplitude();
-
-		if(col > currentCol){
-			currentCol = col;
-			currentRow = -1;
-		}
-		if(row > currentRow){
-			currentRow = row;
-			currentMatrixElement++;
-
-			//Note: The sorted AmplitudeSet is in ordered column
-			//major order, while the COO format is in row major
-			//order. The Hermitian conjugat eis therefore taken
-			//here. (That is, conjugate and intercahnge of rows and
-			// columns is intentional)
-			cooRowIndices[currentMatrixElement] = col;
-			cooColIndices[currentMatrixElement] = row;
-			cooValues[currentMatrixElement] = conj(amplitude);
-		}
-		else{
-			cooValues[currentMatrixElement] += conj(amplitude);
-		}
-
-		it.searchNextHA();
+	//Setup matrix on COO format. With Hermitian storage, the 'to'-basis
+	//index is smaller than or equal to the 'from'-basis index for every
+	//amplitude, and only the lower triangle is therefore stored.
+	#pragma omp parallel for
+	for(int e = 0; e < numMatrixElements; e++){
+		//Note: The sorted AmplitudeSet is in ordered column major
+		//order, while the COO format is in row major order. The
+		//Hermitian conjugat eis therefore taken here. (That is,
+		//conjugate and intercahnge of rows and columns is
+		//intentional)
+		cooRowIndices[e] = fromBasisIndices[cooElementStarts[e]];
+		cooColIndices[e] = toBasisIndices[cooElementStarts[e]];
+		updateCOOValue(e);
 	}
 }
 
 void AmplitudeSet::destructCOO(){
+	destructCSR();
+
 	numMatrixElements = -1;
 	if(cooRowIndices != NULL){
 		delete [] cooRowIndices;
@@ -143,45 +269,372 @@ void AmplitudeSet::destructCOO(){
 		delete [] cooValues;
 		cooValues = NULL;
 	}
+	if(cooElementStarts != NULL){
+		delete [] cooElementStarts;
+		cooElementStarts = NULL;
+	}
+	if(cooCallbackElements != NULL){
+		delete [] cooCallbackElements;
+		cooCallbackElements = NULL;
+	}
+	numCOOCallbackElements = 0;
+	cooCallbackGroupElements.clear();
+	cooCallbackVersions.clear();
 }
 
-void AmplitudeSet::reconstructCOO(){
-	if(numMatrixElements != -1){
-		destructCOO();
+void AmplitudeSet::constructCSR(){
+	TBTKAssert(
+		csrRowPointers == NULL,
+		"AmplitudeSet::constructCSR()",
+		"Hamiltonain on CSR format already constructed.",
+		""
+	);
+
+	if(numMatrixElements == -1)
 		constructCOO();
+
+	//The COO matrix elements are sorted by row, so only the row pointers
+	//need to be calculated.
+	int basisSize = getBasisSize();
+	csrRowPointers = new int[basisSize+1];
+	for(int n = 0; n <= basisSize; n++)
+		csrRowPointers[n] = 0;
+	for(int n = 0; n < numMatrixElements; n++)
+		csrRowPointers[cooRowIndices[n]+1]++;
+	for(int n = 0; n < basisSize; n++)
+		csrRowPointers[n+1] += csrRowPointers[n];
+}
+
+void AmplitudeSet::destructCSR(){
+	destructSELL();
+
+	if(csrRowPointers != NULL){
+		delete [] csrRowPointers;
+		csrRowPointers = NULL;
 	}
 }
 
+void AmplitudeSet::constructSELL(int chunkSize, int sortingScope){
+	TBTKAssert(
+		sellChunkPointers == NULL,
+		"AmplitudeSet::constructSELL()",
+		"Hamiltonain on SELL format already constructed.",
+		""
+	);
+	TBTKAssert(
+		chunkSize > 0 && sortingScope > 0,
+		"AmplitudeSet::constructSELL()",
+		"Invalid chunk size '" << chunkSize << "' or sorting scope '"
+		<< sortingScope << "'.",
+		"Both have to be positive."
+	);
+
+	if(csrRowPointers == NULL)
+		constructCSR();
+
+	int basisSize = getBasisSize();
+	sellChunkSize = chunkSize;
+	sellNumChunks = (basisSize + chunkSize - 1)/chunkSize;
+
+	//Sort rows by decreasing length within each sorting window.
+	int numSlots = sellNumChunks*chunkSize;
+	sellRowPermutation = new int[numSlots];
+	for(int n = 0; n < numSlots; n++)
+		sellRowPermutation[n] = (n < basisSize) ? n : -1;
+	const int *rowPointers = csrRowPointers;
+	for(int window = 0; window < basisSize; window += sortingScope){
+		int windowEnd = window + sortingScope;
+		if(windowEnd > basisSize)
+			windowEnd = basisSize;
+
+		stable_sort(
+			sellRowPermutation + window,
+			sellRowPermutation + windowEnd,
+			[rowPointers](int row0, int row1){
+				return rowPointers[row0+1] - rowPointers[row0]
+					> rowPointers[row1+1] - rowPointers[row1];
+			}
+		);
+	}
+
+	//Calculate chunk lengths and chunk pointers.
+	sellChunkLengths = new int[sellNumChunks];
+	sellChunkPointers = new int[sellNumChunks+1];
+	sellChunkPointers[0] = 0;
+	for(int c = 0; c < sellNumChunks; c++){
+		int length = 0;
+		for(int r = 0; r < chunkSize; r++){
+			int row = sellRowPermutation[c*chunkSize + r];
+			if(row == -1)
+				continue;
+
+			int rowLength = rowPointers[row+1] - rowPointers[row];
+			if(rowLength > length)
+				length = rowLength;
+		}
+		sellChunkLengths[c] = length;
+		sellChunkPointers[c+1] = sellChunkPointers[c] + length*chunkSize;
+	}
+
+	//Fill the chunks. Padding elements are given the row itself as column
+	//index to keep memory accesses in SpMV kernels within bounds.
+	int size = sellChunkPointers[sellNumChunks];
+	sellColIndices = new int[size];
+	sellValues = new complex<double>[size];
+	sellPositions = new int[rowPointers[basisSize]];
+	#pragma omp parallel for
+	for(int c = 0; c < sellNumChunks; c++){
+		for(int r = 0; r < chunkSize; r++){
+			int row = sellRowPermutation[c*chunkSize + r];
+			int rowStart = 0;
+			int rowLength = 0;
+			if(row != -1){
+				rowStart = rowPointers[row];
+				rowLength = rowPointers[row+1] - rowStart;
+			}
+
+			for(int m = 0; m < sellChunkLengths[c]; m++){
+				int position = sellChunkPointers[c] + m*chunkSize + r;
+				if(m < rowLength){
+					sellColIndices[position] = cooColIndices[rowStart + m];
+					sellValues[position] = cooValues[rowStart + m];
+					sellPositions[rowStart + m] = position;
+				}
+				else{
+					sellColIndices[position] = (row == -1) ? 0 : row;
+					sellValues[position] = 0.;
+				}
+			}
+		}
+	}
+}
+
+void AmplitudeSet::destructSELL(){
+	sellChunkSize = 0;
+	sellNumChunks = 0;
+	if(sellChunkPointers != NULL){
+		delete [] sellChunkPointers;
+		sellChunkPointers = NULL;
+	}
+	if(sellChunkLengths != NULL){
+		delete [] sellChunkLengths;
+		sellChunkLengths = NULL;
+	}
+	if(sellRowPermutation != NULL){
+		delete [] sellRowPermutation;
+		sellRowPermutation = NULL;
+	}
+	if(sellColIndices != NULL){
+		delete [] sellColIndices;
+		sellColIndices = NULL;
+	}
+	if(sellValues != NULL){
+		delete [] sellValues;
+		sellValues = NULL;
+	}
+	if(sellPositions != NULL){
+		delete [] sellPositions;
+		sellPositions = NULL;
+	}
+}
+
+void AmplitudeSet::reconstructCOO(){
+	if(numMatrixElements == -1)
+		return;
+
+	//Only callback amplitudes can change. Reevaluate the callbacks and
+	//find the matrix elements of the callback groups that have been
+	//evaluated since the COO values were last updated. The groups may
+	//also have been evaluated by someone else since then, which is
+	//detected by comparing versions rather than through the dirty flags.
+	amplitudeArray.evaluateCallbacks();
+
+	bool allChanged = true;
+	vector<int> changedElements;
+	for(int c = 0; c < amplitudeArray.getNumCallbacks(); c++){
+		unsigned int version = amplitudeArray.getCallbackVersion(c);
+		if(version != cooCallbackVersions[c]){
+			changedElements.insert(
+				changedElements.end(),
+				cooCallbackGroupElements[c].begin(),
+				cooCallbackGroupElements[c].end()
+			);
+			cooCallbackVersions[c] = version;
+		}
+		else{
+			allChanged = false;
+		}
+	}
+
+	const int *elements;
+	int numElements;
+	if(allChanged){
+		elements = cooCallbackElements;
+		numElements = numCOOCallbackElements;
+	}
+	else{
+		std::sort(changedElements.begin(), changedElements.end());
+		changedElements.erase(
+			unique(changedElements.begin(), changedElements.end()),
+			changedElements.end()
+		);
+		elements = changedElements.data();
+		numElements = changedElements.size();
+	}
+
+	//Update the affected matrix elements in place.
+	#pragma omp parallel for
+	for(int n = 0; n < numElements; n++)
+		updateCOOValue(elements[n]);
+}
+
+void AmplitudeSet::constructIndexHashTable() const{
+	call_once(
+		indexHashTableFlag,
+		[this](){
+			indexHashTable.construct(tree);
+		}
+	);
+}
+
+void AmplitudeSet::constructPhysicalIndexTable() const{
+	call_once(
+		physicalIndexTableFlag,
+		[this](){
+			physicalIndexTable.construct(tree);
+		}
+	);
+}
+
+void AmplitudeSet::constructAmplitudeArray() const{
+	constructIndexHashTable();
+	constructPhysicalIndexTable();
+	call_once(
+		amplitudeArrayFlag,
+		[this](){
+			amplitudeArray.construct(
+				tree,
+				indexHashTable,
+				physicalIndexTable,
+				hermitianStorage
+			);
+		}
+	);
+}
+
+void AmplitudeSet::constructBlockStructure() const{
+	constructAmplitudeArray();
+	call_once(
+		blockStructureFlag,
+		[this](){
+			blockStructure.construct(
+				amplitudeArray,
+				tree.basisSize
+			);
+		}
+	);
+}
+
+vector<int> AmplitudeSet::getCOOElements(const vector<int> &positions) const{
+	vector<int> elements;
+	for(unsigned int n = 0; n < positions.size(); n++){
+		int element = upper_bound(
+			cooElementStarts,
+			cooElementStarts + numMatrixElements,
+			positions[n]
+		) - cooElementStarts - 1;
+		if(elements.size() == 0 || elements.back() != element)
+			elements.push_back(element);
+	}
+
+	return elements;
+}
+
 void AmplitudeSet::print(){
 	tree.print();
 }
 
 AmplitudeSet::Iterator AmplitudeSet::getIterator() const{
-	return AmplitudeSet::Iterator(&tree);
+	return AmplitudeSet::Iterator(&tree, hermitianStorage);
 }
 
 AmplitudeSet::Iterator AmplitudeSet::getIterator(const Index &subspace) const{
-	return AmplitudeSet::Iterator(tree.getSubTree(subspace));
+	return AmplitudeSet::Iterator(
+		tree.getSubTree(subspace),
+		hermitianStorage,
+		hermitianStorage ? &subspace : NULL
+	);
 }
 
-AmplitudeSet::Iterator::Iterator(const TreeNode* tree){
+AmplitudeSet::Iterator::Iterator(
+	const TreeNode* tree,
+	bool hermitianStorage,
+	const Index *subspace
+) :
+	conjugate(0., Index({}), Index({}))
+{
 	it = new TreeNode::Iterator(tree);
+	this->hermitianStorage = hermitianStorage;
+	if(subspace != NULL)
+		this->subspace = new Index(*subspace);
+	else
+		this->subspace = NULL;
+	atConjugate = false;
 }
 
 AmplitudeSet::Iterator::~Iterator(){
 	delete it;
+	if(subspace != NULL)
+		delete subspace;
 }
 
 void AmplitudeSet::Iterator::reset(){
 	it->reset();
+	atConjugate = false;
 }
 
 void AmplitudeSet::Iterator::searchNextHA(){
-	it->searchNextHA();
+	if(atConjugate){
+		atConjugate = false;
+		it->searchNextHA();
+		return;
+	}
+
+	//With Hermitian storage, the Hermitian conjugate of an off-diagonal
+	//HoppingAmplitude is visited before the TreeNode iterator advances.
+	const HoppingAmplitude *ha = it->getHA();
+	if(
+		hermitianStorage
+		&& ha != NULL
+		&& !ha->toIndex.equals(ha->fromIndex)
+		&& isInSubspace(ha->toIndex)
+	){
+		conjugate = ha->getHermitianConjugate();
+		atConjugate = true;
+	}
+	else{
+		it->searchNextHA();
+	}
 }
 
 const HoppingAmplitude* AmplitudeSet::Iterator::getHA() const{
-	return it->getHA();
+	if(atConjugate)
+		return &conjugate;
+	else
+		return it->getHA();
+}
+
+bool AmplitudeSet::Iterator::isInSubspace(const Index &index) const{
+	if(subspace == NULL)
+		return true;
+	if(index.size() < subspace->size())
+		return false;
+
+	for(unsigned int n = 0; n < subspace->size(); n++)
+		if(index.at(n) != subspace->at(n))
+			return false;
+
+	return true;
 }
 
 void AmplitudeSet::tabulate(
@@ -217,7 +670,7 @@ void AmplitudeSet::tabulate(
 			(*table)[2*(*maxIndexSize)*counter+n] = ha->fromIndex.at(n);
 		for(unsigned int n = 0; n < ha->toIndex.size(); n++)
 			(*table)[2*(*maxIndexSize)*counter+n+(*maxIndexSize)] = ha->toIndex.at(n);
-		(*amplitudes)[counter] = ha->getAmplitude();
+		(*amplitudes)[counter] = getAmplitude(*ha);
 
 		it.searchNextHA();
 		counter++;
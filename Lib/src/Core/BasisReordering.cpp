@@ -0,0 +1,165 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file BasisReordering.cpp
+ *
+ *  @author agent
+ */
+
+#include "BasisReordering.h"
+#include "TBTKMacros.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace TBTK{
+
+void BasisReordering::calculateReverseCuthillMcKee(
+	const TreeNode &tree,
+	int *permutation
+){
+	TBTKAssert(
+		tree.basisSize >= 0,
+		"BasisReordering::calculateReverseCuthillMcKee()",
+		"Basis indices have not been generated.",
+		"Use TreeNode::generateBasisIndices() first."
+	);
+
+	int basisSize = tree.basisSize;
+
+	//The Hamiltonian is not necessarily symmetric in its sparsity pattern,
+	//so the connections are added in both directions.
+	vector<vector<int>> adjacency(basisSize);
+	addConnections(tree, tree, adjacency);
+	for(int n = 0; n < basisSize; n++){
+		sort(adjacency[n].begin(), adjacency[n].end());
+		adjacency[n].erase(
+			unique(adjacency[n].begin(), adjacency[n].end()),
+			adjacency[n].end()
+		);
+	}
+
+	vector<int> levels(basisSize, -1);
+	vector<int> order;
+	order.reserve(basisSize);
+	for(int n = 0; n < basisSize; n++){
+		if(levels[n] != -1)
+			continue;
+
+		//Find a pseudo-peripheral start state for the connected
+		//component by repeatedly restarting the traversal from a
+		//state with minimal degree in the last level, for as long as
+		//the number of levels increases.
+		int componentStart = order.size();
+		int numLevels = traverse(n, adjacency, levels, order);
+		while(true){
+			int candidate = -1;
+			for(unsigned int c = componentStart; c < order.size(); c++){
+				int state = order[c];
+				if(
+					levels[state] == numLevels-1
+					&& (
+						candidate == -1
+						|| adjacency[state].size()
+						< adjacency[candidate].size()
+					)
+				){
+					candidate = state;
+				}
+			}
+
+			for(unsigned int c = componentStart; c < order.size(); c++)
+				levels[order[c]] = -1;
+			order.resize(componentStart);
+
+			int candidateNumLevels = traverse(
+				candidate,
+				adjacency,
+				levels,
+				order
+			);
+			if(candidateNumLevels <= numLevels)
+				break;
+
+			numLevels = candidateNumLevels;
+		}
+	}
+
+	//Reverse the Cuthill-McKee order.
+	for(int n = 0; n < basisSize; n++)
+		permutation[order[n]] = basisSize - 1 - n;
+}
+
+void BasisReordering::addConnections(
+	const TreeNode &treeNode,
+	const TreeNode &tree,
+	vector<vector<int>> &adjacency
+){
+	if(treeNode.basisIndex != -1){
+		int from = treeNode.basisIndex;
+		const vector<HoppingAmplitude> &has = treeNode.hoppingAmplitudes;
+		for(unsigned int n = 0; n < has.size(); n++){
+			int to = tree.getBasisIndex(has[n].toIndex);
+			if(to != from){
+				adjacency[from].push_back(to);
+				adjacency[to].push_back(from);
+			}
+		}
+
+		return;
+	}
+
+	for(unsigned int n = 0; n < treeNode.getNumChildren(); n++)
+		if(treeNode.getChild(n) != NULL)
+			addConnections(*treeNode.getChild(n), tree, adjacency);
+}
+
+int BasisReordering::traverse(
+	int start,
+	const vector<vector<int>> &adjacency,
+	vector<int> &levels,
+	vector<int> &order
+){
+	levels[start] = 0;
+	order.push_back(start);
+
+	vector<int> neighbors;
+	for(unsigned int head = order.size()-1; head < order.size(); head++){
+		int state = order[head];
+
+		neighbors.clear();
+		for(unsigned int n = 0; n < adjacency[state].size(); n++)
+			if(levels[adjacency[state][n]] == -1)
+				neighbors.push_back(adjacency[state][n]);
+		stable_sort(
+			neighbors.begin(),
+			neighbors.end(),
+			[&adjacency](int state1, int state2){
+				return adjacency[state1].size()
+					< adjacency[state2].size();
+			}
+		);
+
+		for(unsigned int n = 0; n < neighbors.size(); n++){
+			levels[neighbors[n]] = levels[state] + 1;
+			order.push_back(neighbors[n]);
+		}
+	}
+
+	return levels[order.back()] + 1;
+}
+
+};	//End of namespace TBTK
@@ -0,0 +1,144 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file BlockStructure.cpp
+ *
+ *  @author agent
+ */
+
+#include "BlockStructure.h"
+
+using namespace std;
+
+namespace TBTK{
+
+BlockStructure::BlockStructure(){
+	basisSize = 0;
+	numBlocks = 0;
+	blockStarts = NULL;
+	basisIndices = NULL;
+	blocks = NULL;
+	intraBlockIndices = NULL;
+}
+
+BlockStructure::~BlockStructure(){
+	clear();
+}
+
+void BlockStructure::clear(){
+	if(blockStarts != NULL){
+		delete [] blockStarts;
+		blockStarts = NULL;
+	}
+	if(basisIndices != NULL){
+		delete [] basisIndices;
+		basisIndices = NULL;
+	}
+	if(blocks != NULL){
+		delete [] blocks;
+		blocks = NULL;
+	}
+	if(intraBlockIndices != NULL){
+		delete [] intraBlockIndices;
+		intraBlockIndices = NULL;
+	}
+	basisSize = 0;
+	numBlocks = 0;
+}
+
+void BlockStructure::construct(
+	const AmplitudeArray &amplitudeArray,
+	int basisSize
+){
+	TBTKAssert(
+		basisSize >= 0,
+		"BlockStructure::construct()",
+		"Invalid basis size.",
+		""
+	);
+
+	clear();
+
+	this->basisSize = basisSize;
+
+	//Join the basis states connected by each amplitude using union-find.
+	//The root of each set is always its smallest element.
+	int *parents = new int[basisSize];
+	for(int n = 0; n < basisSize; n++)
+		parents[n] = n;
+
+	const int *fromBasisIndices = amplitudeArray.getFromBasisIndices();
+	const int *toBasisIndices = amplitudeArray.getToBasisIndices();
+	for(int n = 0; n < amplitudeArray.getSize(); n++){
+		int fromRoot = findRoot(parents, fromBasisIndices[n]);
+		int toRoot = findRoot(parents, toBasisIndices[n]);
+		if(fromRoot < toRoot)
+			parents[toRoot] = fromRoot;
+		else if(toRoot < fromRoot)
+			parents[fromRoot] = toRoot;
+	}
+
+	//Number the blocks in order of their smallest basis index, which is
+	//the root of the set.
+	blocks = new int[basisSize];
+	for(int n = 0; n < basisSize; n++){
+		int root = findRoot(parents, n);
+		if(root == n)
+			blocks[n] = numBlocks++;
+		else
+			blocks[n] = blocks[root];
+	}
+	delete [] parents;
+
+	//Count the basis states in each block and turn the counts into
+	//offsets.
+	blockStarts = new int[numBlocks+1];
+	for(int n = 0; n <= numBlocks; n++)
+		blockStarts[n] = 0;
+	for(int n = 0; n < basisSize; n++)
+		blockStarts[blocks[n]+1]++;
+	for(int n = 0; n < numBlocks; n++)
+		blockStarts[n+1] += blockStarts[n];
+
+	//Group the basis indices by block, keeping them in increasing order
+	//within each block.
+	basisIndices = new int[basisSize];
+	intraBlockIndices = new int[basisSize];
+	int *counters = new int[numBlocks];
+	for(int n = 0; n < numBlocks; n++)
+		counters[n] = 0;
+	for(int n = 0; n < basisSize; n++){
+		int block = blocks[n];
+		intraBlockIndices[n] = counters[block]++;
+		basisIndices[blockStarts[block] + intraBlockIndices[n]] = n;
+	}
+	delete [] counters;
+}
+
+int BlockStructure::findRoot(int *parents, int element){
+	int root = element;
+	while(parents[root] != root)
+		root = parents[root];
+
+	while(parents[element] != root){
+		int next = parents[element];
+		parents[element] = root;
+		element = next;
+	}
+
+	return root;
+}
+
+};	//End of namespace TBTK
@@ -35,6 +35,8 @@ HoppingAmplitude::HoppingAmplitude(
 {
 	this->amplitude = amplitude;
 	this->amplitudeCallback = NULL;
+	batchCallback = NULL;
+	callbackContext = NULL;
 };
 
 HoppingAmplitude::HoppingAmplitude(
@@ -46,6 +48,8 @@ HoppingAmplitude::HoppingAmplitude(
 	toIndex(toIndex)
 {
 	this->amplitudeCallback = amplitudeCallback;
+	batchCallback = NULL;
+	callbackContext = NULL;
 };
 
 HoppingAmplitude::HoppingAmplitude(
@@ -58,6 +62,8 @@ HoppingAmplitude::HoppingAmplitude(
 {
 	this->amplitude = amplitude;
 	this->amplitudeCallback = NULL;
+	batchCallback = NULL;
+	callbackContext = NULL;
 };
 
 HoppingAmplitude::HoppingAmplitude(
@@ -69,6 +75,8 @@ HoppingAmplitude::HoppingAmplitude(
 	toIndex(toIndex)
 {
 	this->amplitudeCallback = amplitudeCallback;
+	batchCallback = NULL;
+	callbackContext = NULL;
 };
 
 HoppingAmplitude::HoppingAmplitude(
@@ -81,6 +89,8 @@ HoppingAmplitude::HoppingAmplitude(
 	toIndex(toIndex)
 {
 	amplitudeCallback = NULL;
+	batchCallback = NULL;
+	callbackContext = NULL;
 }
 
 HoppingAmplitude::HoppingAmplitude(
@@ -93,6 +103,36 @@ HoppingAmplitude::HoppingAmplitude(
 	toIndex(toIndex)
 {
 	this->amplitudeCallback = amplitudeCallback;
+	batchCallback = NULL;
+	callbackContext = NULL;
+}
+
+HoppingAmplitude::HoppingAmplitude(
+	Index fromIndex,
+	Index toIndex,
+	BatchCallback batchCallback,
+	void *callbackContext
+) :
+	fromIndex(fromIndex),
+	toIndex(toIndex)
+{
+	amplitudeCallback = NULL;
+	this->batchCallback = batchCallback;
+	this->callbackContext = callbackContext;
+}
+
+HoppingAmplitude::HoppingAmplitude(
+	BatchCallback batchCallback,
+	void *callbackContext,
+	Index toIndex,
+	Index fromIndex
+) :
+	fromIndex(fromIndex),
+	toIndex(toIndex)
+{
+	amplitudeCallback = NULL;
+	this->batchCallback = batchCallback;
+	this->callbackContext = callbackContext;
 }
 
 HoppingAmplitude::HoppingAmplitude(
@@ -103,11 +143,15 @@ HoppingAmplitude::HoppingAmplitude(
 {
 	amplitude = ha.amplitude;
 	this->amplitudeCallback = ha.amplitudeCallback;
+	batchCallback = ha.batchCallback;
+	callbackContext = ha.callbackContext;
 }
 
 HoppingAmplitude HoppingAmplitude::getHermitianConjugate() const{
 	if(amplitudeCallback)
 		return HoppingAmplitude(toIndex, fromIndex, amplitudeCallback);
+	else if(batchCallback)
+		return HoppingAmplitude(toIndex, fromIndex, batchCallback, callbackContext);
 	else
 		return HoppingAmplitude(toIndex, fromIndex, conj(amplitude));
 }
@@ -123,7 +167,10 @@ void HoppingAmplitude::print(){
 		Streams::out << toIndex.at(n) << " ";
 	}
 	Streams::out << "\n";
-	Streams::out << "Amplitude:\t" << getAmplitude() << "\n";
+	if(batchCallback)
+		Streams::out << "Amplitude:\t" << "Batch callback" << "\n";
+	else
+		Streams::out << "Amplitude:\t" << getAmplitude() << "\n";
 }
 
 };	//End of namespace TBTK
@@ -26,10 +26,34 @@ using namespace std;
 namespace TBTK{
 
 Index::Index(const Index &head, const Index &tail){
-	for(unsigned int n = 0; n < head.size(); n++)
-		indices.push_back(head.at(n));
-	for(unsigned int n = 0; n < tail.size(); n++)
-		indices.push_back(tail.at(n));
+	numSubindices = 0;
+	capacity = INLINE_CAPACITY;
+	reserve(head.numSubindices + tail.numSubindices);
+
+	int *subindices = getData();
+	const int *headSubindices = head.getData();
+	const int *tailSubindices = tail.getData();
+	for(unsigned int n = 0; n < head.numSubindices; n++)
+		subindices[n] = headSubindices[n];
+	for(unsigned int n = 0; n < tail.numSubindices; n++)
+		subindices[head.numSubindices + n] = tailSubindices[n];
+	numSubindices = head.numSubindices + tail.numSubindices;
+}
+
+void Index::reserve(unsigned int newCapacity){
+	if(newCapacity <= capacity)
+		return;
+
+	int *newSubindices = new int[newCapacity];
+	const int *oldSubindices = getData();
+	for(unsigned int n = 0; n < numSubindices; n++)
+		newSubindices[n] = oldSubindices[n];
+
+	if(!isInline())
+		delete [] heapSubindices;
+
+	heapSubindices = newSubindices;
+	capacity = newCapacity;
 }
 
 bool operator<(const Index &i1, const Index &i2){
@@ -90,11 +114,11 @@ Index Index::getUnitRange(){
 }
 
 Index Index::getSubIndex(int first, int last){
-	vector<int> newSubindices;
+	Index subIndex({});
 	for(int n = first; n <= last; n++)
-		newSubindices.push_back(indices.at(n));
+		subIndex.push_back(at(n));
 
-	return Index(newSubindices);
+	return subIndex;
 }
 
 };
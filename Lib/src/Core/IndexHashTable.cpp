@@ -0,0 +1,181 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file IndexHashTable.cpp
+ *
+ *  @author agent
+ */
+
+#include "IndexHashTable.h"
+#include "TBTKMacros.h"
+
+using namespace std;
+
+namespace TBTK{
+
+IndexHashTable::IndexHashTable(){
+	numSlots = 0;
+	slotSize = 0;
+	maxKeySize = 0;
+	slots = NULL;
+}
+
+IndexHashTable::~IndexHashTable(){
+	clear();
+}
+
+void IndexHashTable::clear(){
+	if(slots != NULL){
+		delete [] slots;
+		slots = NULL;
+	}
+	numSlots = 0;
+	slotSize = 0;
+	maxKeySize = 0;
+}
+
+void IndexHashTable::construct(const TreeNode &tree){
+	TBTKAssert(
+		tree.basisSize >= 0,
+		"IndexHashTable::construct()",
+		"Basis indices have not been generated.",
+		"Use TreeNode::generateBasisIndices() first."
+	);
+
+	clear();
+
+	maxKeySize = getMaxKeySize(tree, 0);
+	slotSize = 2 + maxKeySize;
+
+	//Keep the load factor below 0.75 to keep probe sequences short.
+	numSlots = 1;
+	while(3*(unsigned long long)numSlots < 4*(unsigned long long)tree.basisSize + 1)
+		numSlots *= 2;
+
+	slots = new int[numSlots*slotSize];
+	for(unsigned int n = 0; n < numSlots; n++)
+		slots[n*slotSize] = -1;
+
+	Index key({});
+	insert(tree, key);
+}
+
+void IndexHashTable::insert(const TreeNode &treeNode, Index &key){
+	if(treeNode.basisIndex != -1){
+		unsigned int mask = numSlots - 1;
+		unsigned int s = hash(key) & mask;
+		while(slots[s*slotSize] != -1)
+			s = (s + 1) & mask;
+
+		int *slot = &slots[s*slotSize];
+		slot[0] = treeNode.basisIndex;
+		slot[1] = key.size();
+		for(unsigned int n = 0; n < key.size(); n++)
+			slot[2+n] = key.at(n);
+
+		return;
+	}
+
+	for(unsigned int n = 0; n < treeNode.getNumChildren(); n++){
+		const TreeNode *child = treeNode.getChild(n);
+		if(child == NULL)
+			continue;
+
+		key.push_back(treeNode.getChildSubindex(n));
+		insert(*child, key);
+		key.popBack();
+	}
+}
+
+unsigned int IndexHashTable::getMaxKeySize(
+	const TreeNode &treeNode,
+	unsigned int depth
+){
+	if(treeNode.basisIndex != -1)
+		return depth;
+
+	unsigned int maxKeySize = 0;
+	for(unsigned int n = 0; n < treeNode.getNumChildren(); n++){
+		const TreeNode *child = treeNode.getChild(n);
+		if(child == NULL)
+			continue;
+
+		unsigned int keySize = getMaxKeySize(*child, depth+1);
+		if(keySize > maxKeySize)
+			maxKeySize = keySize;
+	}
+
+	return maxKeySize;
+}
+
+template<typename IndexAccessor>
+void IndexHashTable::resolveBasisIndices(
+	IndexAccessor getIndex,
+	int numIndices,
+	int *basisIndices
+) const{
+	//The slots of a whole block are located before any of them are
+	//probed, so that the block is resolved with overlapping rather than
+	//consecutive cache misses.
+	unsigned int mask = numSlots - 1;
+	#pragma omp parallel for
+	for(int b = 0; b < numIndices; b += BATCH_BLOCK_SIZE){
+		int blockSize = numIndices - b;
+		if(blockSize > BATCH_BLOCK_SIZE)
+			blockSize = BATCH_BLOCK_SIZE;
+
+		unsigned int blockSlots[BATCH_BLOCK_SIZE];
+		for(int n = 0; n < blockSize; n++){
+			blockSlots[n] = hash(getIndex(b + n)) & mask;
+#ifdef __GNUC__
+			__builtin_prefetch(&slots[blockSlots[n]*slotSize]);
+#endif
+		}
+		for(int n = 0; n < blockSize; n++){
+			basisIndices[b + n]
+				= probe(getIndex(b + n), blockSlots[n]);
+		}
+	}
+}
+
+void IndexHashTable::getBasisIndices(
+	const Index *indices,
+	int numIndices,
+	int *basisIndices
+) const{
+	resolveBasisIndices(
+		[indices](int n) -> const Index&{
+			return indices[n];
+		},
+		numIndices,
+		basisIndices
+	);
+}
+
+void IndexHashTable::getBasisIndices(
+	const Index *const *indices,
+	int numIndices,
+	int *basisIndices
+) const{
+	resolveBasisIndices(
+		[indices](int n) -> const Index&{
+			return *indices[n];
+		},
+		numIndices,
+		basisIndices
+	);
+}
+
+};	//End of namespace TBTK
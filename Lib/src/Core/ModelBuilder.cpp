@@ -0,0 +1,68 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file ModelBuilder.cpp
+ *
+ *  @author agent
+ */
+
+#include "ModelBuilder.h"
+
+using namespace std;
+
+namespace TBTK{
+
+ModelBuilder::ModelBuilder(){
+	numBuffers = omp_get_max_threads();
+	buffers = new vector<HoppingAmplitude>*[numBuffers];
+	for(int n = 0; n < numBuffers; n++)
+		buffers[n] = new vector<HoppingAmplitude>();
+}
+
+ModelBuilder::~ModelBuilder(){
+	for(int n = 0; n < numBuffers; n++)
+		delete buffers[n];
+	delete [] buffers;
+}
+
+unsigned int ModelBuilder::getNumHAs() const{
+	unsigned int numHAs = 0;
+	for(int n = 0; n < numBuffers; n++)
+		numHAs += buffers[n]->size();
+
+	return numHAs;
+}
+
+void ModelBuilder::build(Model &model){
+	TBTKAssert(
+		!model.getIsConstructed(),
+		"ModelBuilder::build()",
+		"Model is already constructed.",
+		""
+	);
+
+	vector<vector<HoppingAmplitude>*> haLists;
+	for(int n = 0; n < numBuffers; n++)
+		haLists.push_back(buffers[n]);
+	model.getAmplitudeSet()->addHAs(haLists);
+
+	for(int n = 0; n < numBuffers; n++)
+		vector<HoppingAmplitude>().swap(*buffers[n]);
+
+	model.construct();
+	model.getAmplitudeSet()->sort();
+}
+
+};	//End of namespace TBTK
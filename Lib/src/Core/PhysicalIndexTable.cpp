@@ -0,0 +1,124 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file PhysicalIndexTable.cpp
+ *
+ *  @author agent
+ */
+
+#include "PhysicalIndexTable.h"
+
+using namespace std;
+
+namespace TBTK{
+
+PhysicalIndexTable::PhysicalIndexTable(){
+	basisSize = 0;
+	keyOffsets = NULL;
+	keys = NULL;
+}
+
+PhysicalIndexTable::~PhysicalIndexTable(){
+	clear();
+}
+
+void PhysicalIndexTable::clear(){
+	if(keyOffsets != NULL){
+		delete [] keyOffsets;
+		keyOffsets = NULL;
+	}
+	if(keys != NULL){
+		delete [] keys;
+		keys = NULL;
+	}
+	basisSize = 0;
+}
+
+void PhysicalIndexTable::construct(const TreeNode &tree){
+	TBTKAssert(
+		tree.basisSize >= 0,
+		"PhysicalIndexTable::construct()",
+		"Basis indices have not been generated.",
+		"Use TreeNode::generateBasisIndices() first."
+	);
+
+	clear();
+
+	basisSize = tree.basisSize;
+	keyOffsets = new int[basisSize+1];
+
+	//Count the subindices of each basis state and turn the counts into
+	//offsets.
+	countSubindices(tree, 0);
+	int offset = 0;
+	for(int n = 0; n < basisSize; n++){
+		int numSubindices = keyOffsets[n];
+		keyOffsets[n] = offset;
+		offset += numSubindices;
+	}
+	keyOffsets[basisSize] = offset;
+
+	keys = new int[offset];
+	Index key({});
+	storeSubindices(tree, key);
+}
+
+void PhysicalIndexTable::countSubindices(const TreeNode &treeNode, int depth){
+	if(treeNode.basisIndex != -1){
+		keyOffsets[treeNode.basisIndex] = depth;
+		return;
+	}
+
+	for(unsigned int n = 0; n < treeNode.getNumChildren(); n++)
+		if(treeNode.getChild(n) != NULL)
+			countSubindices(*treeNode.getChild(n), depth+1);
+}
+
+void PhysicalIndexTable::storeSubindices(const TreeNode &treeNode, Index &key){
+	if(treeNode.basisIndex != -1){
+		int *destination = &keys[keyOffsets[treeNode.basisIndex]];
+		for(unsigned int n = 0; n < key.size(); n++)
+			destination[n] = key.at(n);
+
+		return;
+	}
+
+	for(unsigned int n = 0; n < treeNode.getNumChildren(); n++){
+		const TreeNode *child = treeNode.getChild(n);
+		if(child == NULL)
+			continue;
+
+		key.push_back(treeNode.getChildSubindex(n));
+		storeSubindices(*child, key);
+		key.popBack();
+	}
+}
+
+Index PhysicalIndexTable::getPhysicalIndex(int basisIndex) const{
+	TBTKAssert(
+		basisIndex >= 0 && basisIndex < basisSize,
+		"PhysicalIndexTable::getPhysicalIndex()",
+		"Hilbert space index out of bound.",
+		""
+	);
+
+	Index index({});
+	for(int n = keyOffsets[basisIndex]; n < keyOffsets[basisIndex+1]; n++)
+		index.push_back(keys[n]);
+
+	return index;
+}
+
+};	//End of namespace TBTK
@@ -23,14 +23,44 @@
 #include "TBTKMacros.h"
 
 #include <algorithm>
+#include <new>
+
+#include <omp.h>
 
 using namespace std;
 
 namespace TBTK{
 
+/** Empty node used in place of children that do not exist for subindices
+ *  within the range of the children of a node. */
+static const TreeNode emptyTreeNode;
+
 TreeNode::TreeNode(){
+	initialize(NULL);
+}
+
+TreeNode::TreeNode(Arena *arena){
+	initialize(arena);
+}
+
+TreeNode::~TreeNode(){
+	if(children != NULL)
+		delete [] children;
+	if(childSubindices != NULL)
+		delete [] childSubindices;
+	if(isArenaOwner)
+		delete arena;
+}
+
+void TreeNode::initialize(Arena *arena){
 	basisIndex = -1;
 	basisSize = -1;
+	children = NULL;
+	childSubindices = NULL;
+	numChildSlots = 0;
+	numChildren = 0;
+	this->arena = arena;
+	isArenaOwner = false;
 	isPotentialBlockSeparator = true;
 }
 
@@ -42,8 +72,9 @@ void TreeNode::print(unsigned int subindex){
 	for(unsigned int n = 0; n < subindex; n++)
 		Streams::out << "\t";
 	Streams::out << basisIndex << ":" << hoppingAmplitudes.size() << "\n";
-	for(unsigned int n = 0; n < children.size(); n++)
-		children.at(n).print(subindex + 1);
+	for(unsigned int n = 0; n < numChildSlots; n++)
+		if(children[n] != NULL)
+			children[n]->print(subindex + 1);
 }
 
 void TreeNode::add(HoppingAmplitude ha){
@@ -57,13 +88,6 @@ void TreeNode::add(HoppingAmplitude &ha, unsigned int subindex){
 
 		//Get current subindex
 		int currentIndex = ha.fromIndex.at(subindex);
-		//If the subindex is bigger than the current number of child
-		//nodes, create empty nodes.
-		if(currentIndex >= (int)children.size()){
-			for(int n = children.size(); n <= currentIndex; n++){
-				children.push_back(TreeNode());
-			}
-		}
 		//Error detection:
 		//If a HoppingAmplitude is found on this level, another
 		//HoppingAmplitude with fewer subindices than the current
@@ -79,11 +103,17 @@ void TreeNode::add(HoppingAmplitude &ha, unsigned int subindex){
 		}
 		//Ensure isPotentialBlockSeparator is set to false in case the
 		//'toIndex' and the 'fromIndex' differs in the subindex
-		//corresponding to this TreeNode level.
-		if(currentIndex != ha.toIndex.at(subindex))
+		//corresponding to this TreeNode level, or if the 'toIndex'
+		//has fewer subindices than the 'fromIndex'.
+		if(
+			subindex >= ha.toIndex.size()
+			|| currentIndex != ha.toIndex.at(subindex)
+		){
 			isPotentialBlockSeparator = false;
-		//Propagate to the next node level.
-		children.at(currentIndex).add(ha, subindex+1);
+		}
+		//Propagate to the next node level. The child node is created
+		//if it does not already exist.
+		getOrCreateChild(currentIndex)->add(ha, subindex+1);
 	}
 	else{
 		//If the current subindex is the last, the HoppingAmplitude
@@ -95,7 +125,7 @@ void TreeNode::add(HoppingAmplitude &ha, unsigned int subindex){
 		//error because different number of subindices is only allowed
 		//if the HoppingAmplitudes differ in one of their common
 		//indices.
-		if(children.size() != 0){
+		if(numChildren != 0){
 			Streams::err << "Error, incompatible amplitudes:\n";
 			ha.print();
 			getFirstHA().print();
@@ -106,6 +136,279 @@ void TreeNode::add(HoppingAmplitude &ha, unsigned int subindex){
 	}
 }
 
+void TreeNode::add(const vector<vector<HoppingAmplitude>*> &haLists){
+	if(omp_get_max_threads() == 1){
+		for(unsigned int n = 0; n < haLists.size(); n++)
+			for(unsigned int c = 0; c < haLists[n]->size(); c++)
+				add(haLists[n]->at(c), 0);
+
+		return;
+	}
+
+	unsigned int numHAs = 0;
+	for(unsigned int n = 0; n < haLists.size(); n++)
+		numHAs += haLists[n]->size();
+
+	vector<HoppingAmplitude*> has;
+	has.reserve(numHAs);
+	for(unsigned int n = 0; n < haLists.size(); n++)
+		for(unsigned int c = 0; c < haLists[n]->size(); c++)
+			has.push_back(&haLists[n]->at(c));
+
+	add(has, 0);
+}
+
+void TreeNode::add(vector<HoppingAmplitude*> &has, unsigned int subindex){
+	//Create the child nodes serially, in the same order as the serial
+	//TreeNode::add() would. HoppingAmplitudes that end on this node are
+	//added directly.
+	unsigned int numPropagated = 0;
+	for(unsigned int n = 0; n < has.size(); n++){
+		HoppingAmplitude &ha = *has[n];
+		if(subindex < ha.fromIndex.size()){
+			int currentIndex = ha.fromIndex.at(subindex);
+			if(hoppingAmplitudes.size() != 0){
+				Streams::err << "Error, incompatible amplitudes:";
+				ha.print();
+				hoppingAmplitudes.at(0).print();
+				exit(1);
+			}
+			if(
+				subindex >= ha.toIndex.size()
+				|| currentIndex != ha.toIndex.at(subindex)
+			){
+				isPotentialBlockSeparator = false;
+			}
+			getOrCreateChild(currentIndex);
+			numPropagated++;
+		}
+		else{
+			add(ha, subindex);
+		}
+	}
+	if(numPropagated == 0)
+		return;
+
+	//Sort the HoppingAmplitudes into one bucket per child slot, keeping
+	//their relative order.
+	vector<unsigned int> slots;
+	slots.reserve(numPropagated);
+	vector<unsigned int> bucketStarts(numChildSlots+1, 0);
+	for(unsigned int n = 0; n < has.size(); n++){
+		if(subindex < has[n]->fromIndex.size()){
+			slots.push_back(getChildSlot(has[n]->fromIndex.at(subindex)));
+			bucketStarts[slots.back()+1]++;
+		}
+	}
+	for(unsigned int n = 0; n < numChildSlots; n++)
+		bucketStarts[n+1] += bucketStarts[n];
+
+	vector<HoppingAmplitude*> buckets(numPropagated);
+	vector<unsigned int> positions(
+		bucketStarts.begin(),
+		bucketStarts.end() - 1
+	);
+	unsigned int counter = 0;
+	for(unsigned int n = 0; n < has.size(); n++)
+		if(subindex < has[n]->fromIndex.size())
+			buckets[positions[slots[counter++]]++] = has[n];
+	vector<unsigned int>().swap(slots);
+	vector<unsigned int>().swap(positions);
+	vector<HoppingAmplitude*>().swap(has);
+
+	if(numChildren < 2*(unsigned int)omp_get_max_threads()){
+		//Too few children to keep all threads busy. Continue the
+		//partitioning on the next node level.
+		for(unsigned int n = 0; n < numChildSlots; n++){
+			if(bucketStarts[n] == bucketStarts[n+1])
+				continue;
+
+			vector<HoppingAmplitude*> childHAs(
+				buckets.begin() + bucketStarts[n],
+				buckets.begin() + bucketStarts[n+1]
+			);
+			children[n]->add(childHAs, subindex+1);
+		}
+	}
+	else{
+		//Fill the subtrees in parallel. Each subtree gets its own arena
+		//since the arena is not thread safe.
+		#pragma omp parallel for schedule(dynamic)
+		for(int n = 0; n < (int)numChildSlots; n++){
+			if(bucketStarts[n] == bucketStarts[n+1])
+				continue;
+
+			TreeNode *child = children[n];
+			if(!child->isArenaOwner){
+				child->arena = new Arena();
+				child->isArenaOwner = true;
+			}
+			for(unsigned int c = bucketStarts[n]; c < bucketStarts[n+1]; c++)
+				child->add(*buckets[c], subindex+1);
+		}
+	}
+}
+
+TreeNode* TreeNode::getOrCreateChild(int subindex){
+	TreeNode *child = findChild(subindex);
+	if(child != NULL)
+		return child;
+
+	if(subindex < 0){
+		TBTKExit(
+			"TreeNode::add()",
+			"Invalid subindex '" << subindex << "'.",
+			"Indices cannot have negative subindices."
+		);
+	}
+
+	if(arena == NULL){
+		arena = new Arena();
+		isArenaOwner = true;
+	}
+	child = arena->allocate();
+
+	if(childSubindices == NULL){
+		if((unsigned int)subindex < numChildSlots){
+			//Empty slot in dense mode.
+			children[subindex] = child;
+			numChildren++;
+
+			return child;
+		}
+		else if((unsigned int)subindex + 1 <= 2*(numChildren + 1)){
+			//Grow the dense array as long as at least half of the
+			//slots are occupied.
+			reserveChildren(subindex + 1);
+			for(unsigned int n = numChildSlots; n < (unsigned int)subindex; n++)
+				children[n] = NULL;
+			children[subindex] = child;
+			numChildSlots = subindex + 1;
+			numChildren++;
+
+			return child;
+		}
+		else{
+			convertChildrenToSparse();
+		}
+	}
+
+	//Insert into the sorted sparse array. Subindices are typically added
+	//in increasing order, in which case the child is appended without
+	//searching.
+	unsigned int position;
+	if(subindex > getMaxChildSubindex())
+		position = numChildSlots;
+	else
+		position = getChildSlot(subindex);
+	reserveChildren(numChildSlots + 1);
+	for(unsigned int n = numChildSlots; n > position; n--){
+		children[n] = children[n-1];
+		childSubindices[n] = childSubindices[n-1];
+	}
+	children[position] = child;
+	childSubindices[position] = subindex;
+	numChildSlots++;
+	numChildren++;
+
+	//Switch to dense mode once at least half of the subindices in the
+	//range are used.
+	if((unsigned int)getMaxChildSubindex() + 1 <= 2*numChildren)
+		convertChildrenToDense();
+
+	return child;
+}
+
+unsigned int TreeNode::getChildCapacity(unsigned int size){
+	if(size == 0)
+		return 0;
+
+	unsigned int capacity = 1;
+	while(capacity < size)
+		capacity *= 2;
+
+	return capacity;
+}
+
+void TreeNode::reserveChildren(unsigned int size){
+	unsigned int capacity = getChildCapacity(numChildSlots);
+	if(size <= capacity)
+		return;
+
+	unsigned int newCapacity = getChildCapacity(size);
+
+	TreeNode **newChildren = new TreeNode*[newCapacity];
+	for(unsigned int n = 0; n < numChildSlots; n++)
+		newChildren[n] = children[n];
+	if(children != NULL)
+		delete [] children;
+	children = newChildren;
+
+	if(childSubindices != NULL){
+		int *newChildSubindices = new int[newCapacity];
+		for(unsigned int n = 0; n < numChildSlots; n++)
+			newChildSubindices[n] = childSubindices[n];
+		delete [] childSubindices;
+		childSubindices = newChildSubindices;
+	}
+}
+
+void TreeNode::convertChildrenToSparse(){
+	unsigned int capacity = getChildCapacity(numChildren);
+	TreeNode **newChildren = NULL;
+	int *newChildSubindices = NULL;
+	if(capacity != 0){
+		newChildren = new TreeNode*[capacity];
+		newChildSubindices = new int[capacity];
+	}
+	else{
+		//Sparse mode is signaled by a non-NULL childSubindices.
+		newChildren = new TreeNode*[1];
+		newChildSubindices = new int[1];
+	}
+
+	unsigned int counter = 0;
+	for(unsigned int n = 0; n < numChildSlots; n++){
+		if(children[n] != NULL){
+			newChildren[counter] = children[n];
+			newChildSubindices[counter] = n;
+			counter++;
+		}
+	}
+
+	if(children != NULL)
+		delete [] children;
+	children = newChildren;
+	childSubindices = newChildSubindices;
+	numChildSlots = numChildren;
+}
+
+void TreeNode::convertChildrenToDense(){
+	unsigned int size = getMaxChildSubindex() + 1;
+	TreeNode **newChildren = new TreeNode*[getChildCapacity(size)];
+	for(unsigned int n = 0; n < size; n++)
+		newChildren[n] = NULL;
+	for(unsigned int n = 0; n < numChildSlots; n++)
+		newChildren[childSubindices[n]] = children[n];
+
+	delete [] children;
+	delete [] childSubindices;
+	children = newChildren;
+	childSubindices = NULL;
+	numChildSlots = size;
+}
+
+const TreeNode* TreeNode::getChildForLookup(int subindex) const{
+	const TreeNode *child = findChild(subindex);
+	if(child != NULL)
+		return child;
+
+	if(subindex >= 0 && subindex <= getMaxChildSubindex())
+		return &emptyTreeNode;
+	else
+		return NULL;
+}
+
 const TreeNode* TreeNode::getSubTree(const Index &subspace) const{
 	for(unsigned int n = 0; n < subspace.size(); n++){
 		if(subspace.at(n) < 0){
@@ -127,8 +430,9 @@ const TreeNode* TreeNode::getSubTree(const Index &subspace, unsigned int subinde
 		return this;
 	}
 
-	if((unsigned int)subspace.at(subindex) < children.size()){
-		return children.at(subspace.at(subindex)).getSubTree(subspace, subindex+1);
+	const TreeNode *child = getChildForLookup(subspace.at(subindex));
+	if(child != NULL){
+		return child->getSubTree(subspace, subindex+1);
 	}
 	else{
 		TBTKExit(
@@ -158,7 +462,7 @@ bool TreeNode::isProperSubspace(const Index &subspace, unsigned int subindex){
 		return isPotentialBlockSeparator;
 
 	if(isPotentialBlockSeparator){
-		if((unsigned int)subspace.at(subindex) < children.size()){
+		if(subspace.at(subindex) <= getMaxChildSubindex()){
 			return isProperSubspace(subspace, subindex+1);
 		}
 		else{
@@ -174,11 +478,11 @@ bool TreeNode::isProperSubspace(const Index &subspace, unsigned int subindex){
 	}
 }
 
-const std::vector<HoppingAmplitude>* TreeNode::getHAs(Index index) const{
+const std::vector<HoppingAmplitude>* TreeNode::getHAs(const Index &index) const{
 	return getHAs(index, 0);
 }
 
-const std::vector<HoppingAmplitude>* TreeNode::getHAs(Index index, unsigned int subindex) const{
+const std::vector<HoppingAmplitude>* TreeNode::getHAs(const Index &index, unsigned int subindex) const{
 	if(subindex < index.size()){
 		//If the current subindex is not the last, continue to the next
 		//node level.
@@ -188,13 +492,14 @@ const std::vector<HoppingAmplitude>* TreeNode::getHAs(Index index, unsigned int
 		//Error detection:
 		//If the subindex is bigger than the current number of child
 		//nodes, an error has occured.
-		if(currentIndex >= (int)children.size()){
+		const TreeNode *child = getChildForLookup(currentIndex);
+		if(child == NULL){
 			Streams::err << "Error, index out of bound: ";
 			index.print();
 			exit(1);
 		}
 		//Continue to the next node level.
-		return children.at(currentIndex).getHAs(index, subindex+1);
+		return child->getHAs(index, subindex+1);
 	}
 	else{
 		//If the current subindex is the last, return HoppingAmplitudes.
@@ -216,13 +521,14 @@ int TreeNode::getBasisIndex(const Index &index, unsigned int subindex) const{
 		//Error detection:
 		//If the subindex is bigger than the current number of child
 		//nodes, an error has occured.
-		if(currentIndex >= (int)children.size()){
+		const TreeNode *child = getChildForLookup(currentIndex);
+		if(child == NULL){
 			Streams::err << "Error, index out of bound: ";
 			index.print();
 			exit(1);
 		}
 		//Continue to the next node level.
-		return children.at(currentIndex).getBasisIndex(index, subindex+1);
+		return child->getBasisIndex(index, subindex+1);
 	}
 	else{
 		//If the current subindex is the last, return HoppingAmplitudes.
@@ -244,78 +550,133 @@ Index TreeNode::getPhysicalIndex(int basisIndex) const{
 	return Index(indices);
 }
 
-void TreeNode::getPhysicalIndex(int basisIndex, vector<int> *indices) const{
+bool TreeNode::getPhysicalIndex(int basisIndex, vector<int> *indices) const{
 	if(this->basisIndex != -1)
-		return;
+		return this->basisIndex == basisIndex;
 
-	for(unsigned int n = 0; n < children.size(); n++){
-		int min = children.at(n).getMinIndex();
-		int max = children.at(n).getMaxIndex();
-
-		if(min == -1)
+	for(unsigned int n = 0; n < numChildSlots; n++){
+		if(children[n] == NULL)
 			continue;
 
-		if(min <= basisIndex && basisIndex <= max){
-			indices->push_back(n);
-			children.at(n).getPhysicalIndex(basisIndex, indices);
-			break;
-		}
+		indices->push_back(getChildSubindex(n));
+		if(children[n]->getPhysicalIndex(basisIndex, indices))
+			return true;
+		indices->pop_back();
 	}
+
+	return false;
 }
 
-int TreeNode::getMinIndex() const{
-	if(basisIndex != -1)
-		return basisIndex;
+void TreeNode::addMissingToIndices(){
+	//The indices are collected before any leaf is added, since adding
+	//children while the tree is traversed would move the child slots.
+	vector<Index> missingIndices;
+	collectMissingToIndices(*this, missingIndices);
+	for(unsigned int n = 0; n < missingIndices.size(); n++)
+		addLeaf(missingIndices[n]);
+}
 
-	int min = -1;
-	for(unsigned int n = 0; n < children.size(); n++){
-		min = children.at(n).getMinIndex();
-		if(min != -1)
-			break;
+void TreeNode::collectMissingToIndices(
+	const TreeNode &rootNode,
+	vector<Index> &missingIndices
+) const{
+	for(unsigned int n = 0; n < hoppingAmplitudes.size(); n++){
+		const Index &toIndex = hoppingAmplitudes[n].toIndex;
+		if(!rootNode.hasLeaf(toIndex))
+			missingIndices.push_back(toIndex);
 	}
 
-	return min;
+	for(unsigned int n = 0; n < numChildSlots; n++){
+		if(children[n] != NULL){
+			children[n]->collectMissingToIndices(
+				rootNode,
+				missingIndices
+			);
+		}
+	}
 }
 
-int TreeNode::getMaxIndex() const{
-	if(basisIndex != -1)
-		return basisIndex;
+bool TreeNode::hasLeaf(const Index &index) const{
+	const TreeNode *node = this;
+	for(unsigned int subindex = 0; subindex < index.size(); subindex++){
+		if(node->hoppingAmplitudes.size() != 0){
+			TBTKExit(
+				"TreeNode::addMissingToIndices()",
+				"Incompatible 'to'-index " << index.toString()
+				<< ".",
+				"The index has more subindices than a"
+				<< " 'from'-index that it agrees with in all"
+				<< " common subindices."
+			);
+		}
+
+		node = node->findChild(index.at(subindex));
+		if(node == NULL)
+			return false;
+	}
 
-	int max = -1;
-	for(int n = children.size()-1; n >= 0; n--){
-		max = children.at(n).getMaxIndex();
-		if(max != -1)
-			break;
+	if(node->numChildren != 0){
+		TBTKExit(
+			"TreeNode::addMissingToIndices()",
+			"Incompatible 'to'-index " << index.toString() << ".",
+			"The index has fewer subindices than a 'from'-index"
+			<< " that it agrees with in all common subindices."
+		);
 	}
 
-	return max;
+	return true;
+}
+
+void TreeNode::addLeaf(const Index &index){
+	if(hasLeaf(index))
+		return;
+
+	//The isPotentialBlockSeparator flags are left untouched. Any
+	//HoppingAmplitude that has the index as 'to'-index has already cleared
+	//the flag of the node where the 'to'- and 'from'-index part.
+	TreeNode *node = this;
+	for(unsigned int subindex = 0; subindex < index.size(); subindex++)
+		node = node->getOrCreateChild(index.at(subindex));
 }
 
 void TreeNode::generateBasisIndices(){
-	basisSize = generateBasisIndices(0);
+	//An empty tree has no leaves, although the root has no children.
+	if(numChildren == 0 && hoppingAmplitudes.size() == 0)
+		basisSize = 0;
+	else
+		basisSize = generateBasisIndices(0);
 }
 
 int TreeNode::generateBasisIndices(int i){
-	if(children.size() == 0){
-		if(hoppingAmplitudes.size() != 0){
-			basisIndex = i;
-			return i + 1;
-		}
-		else{
-			return i;
-		}
+	if(numChildren == 0){
+		basisIndex = i;
+		return i + 1;
 	}
 
-	for(unsigned int n = 0; n < children.size(); n++){
-		i = children.at(n).generateBasisIndices(i);
-	}
+	for(unsigned int n = 0; n < numChildSlots; n++)
+		if(children[n] != NULL)
+			i = children[n]->generateBasisIndices(i);
 
 	return i;
 }
 
+void TreeNode::permuteBasisIndices(const int *permutation){
+	if(basisIndex != -1){
+		basisIndex = permutation[basisIndex];
+		return;
+	}
+
+	for(unsigned int n = 0; n < numChildSlots; n++)
+		if(children[n] != NULL)
+			children[n]->permuteBasisIndices(permutation);
+}
+
 class SortHelperClass{
 public:
-	static TreeNode *rootNode;
+	TreeNode *rootNode;
+	SortHelperClass(TreeNode *rootNode){
+		this->rootNode = rootNode;
+	}
 	inline bool operator() (const HoppingAmplitude& ha1, const HoppingAmplitude& ha2){
 		int basisIndex1 = rootNode->getBasisIndex(ha1.toIndex);
 		int basisIndex2 = rootNode->getBasisIndex(ha2.toIndex);
@@ -326,16 +687,26 @@ public:
 	}
 };
 
-TreeNode *SortHelperClass::rootNode = NULL;
-
 void TreeNode::sort(TreeNode *rootNode){
 	if(hoppingAmplitudes.size() != 0){
-		SortHelperClass::rootNode = rootNode;
-		std::sort(hoppingAmplitudes.begin(), hoppingAmplitudes.end(), SortHelperClass());
+		std::sort(
+			hoppingAmplitudes.begin(),
+			hoppingAmplitudes.end(),
+			SortHelperClass(rootNode)
+		);
 	}
-	else if(children.size() != 0){
-		for(unsigned int n = 0; n < children.size(); n++)
-			children.at(n).sort(rootNode);
+	else if(numChildren != 0){
+		if(this == rootNode){
+			#pragma omp parallel for schedule(dynamic)
+			for(int n = 0; n < (int)numChildSlots; n++)
+				if(children[n] != NULL)
+					children[n]->sort(rootNode);
+		}
+		else{
+			for(unsigned int n = 0; n < numChildSlots; n++)
+				if(children[n] != NULL)
+					children[n]->sort(rootNode);
+		}
 	}
 }
 
@@ -343,6 +714,7 @@ TreeNode::Iterator::Iterator(const TreeNode *tree){
 	this->tree = tree;
 	currentIndex.push_back(0);
 	currentHoppingAmplitude = -1;
+	currentLeaf = NULL;
 	searchNext(tree, 0);
 }
 
@@ -350,6 +722,7 @@ void TreeNode::Iterator::reset(){
 	currentIndex.clear();
 	currentIndex.push_back(0);
 	currentHoppingAmplitude = -1;
+	currentLeaf = NULL;
 	searchNext(tree, 0);
 }
 
@@ -386,7 +759,7 @@ bool TreeNode::Iterator::searchNext(const TreeNode *treeNode, unsigned int subin
 		//a state where it is iterating over HoppingAmplitudes on this
 		//node.
 
-		if(treeNode->children.size() == 0){
+		if(treeNode->numChildren == 0){
 			//The node has no children and is therefore either a
 			//leaf node with HoppingAmplitudes stored on it, or an
 			//empty dummy node.
@@ -397,6 +770,7 @@ bool TreeNode::Iterator::searchNext(const TreeNode *treeNode, unsigned int subin
 				//over these. Return true to indicate that a
 				//HoppingAmplitude was found.
 				currentHoppingAmplitude = 0;
+				currentLeaf = treeNode;
 				return true;
 			}
 			else{
@@ -417,14 +791,19 @@ bool TreeNode::Iterator::searchNext(const TreeNode *treeNode, unsigned int subin
 	//Perform depth first search for the next HoppingAmplitude. Starts from
 	//the child node reffered to by currentIndex.
 	unsigned int n = currentIndex.at(subindex);
-	while(n < treeNode->children.size()){
+	while(n < treeNode->numChildSlots){
+		if(treeNode->children[n] == NULL){
+			//Empty slot in a dense child array. Skip it.
+			n = ++currentIndex.back();
+			continue;
+		}
 		if(subindex+1 == currentIndex.size()){
 			//The deepest point visited so far on this branch has
 			//been reached. Initialize the depth first search for
 			//child n to start from child n's zeroth child.
 			currentIndex.push_back(0);
 		}
-		if(searchNext(&treeNode->children.at(n), subindex+1)){
+		if(searchNext(treeNode->children[n], subindex+1)){
 			//Depth first search on child n succeded at finding a
 			//HoppingAmplitude. Return true to indicate success.
 			return true;
@@ -443,15 +822,44 @@ bool TreeNode::Iterator::searchNext(const TreeNode *treeNode, unsigned int subin
 }
 
 const HoppingAmplitude* TreeNode::Iterator::getHA() const{
-	if(currentIndex.at(0) == (int)tree->children.size()){
+	if(currentIndex.at(0) == (int)tree->numChildSlots){
 		return NULL;
 	}
-	const TreeNode *tn = this->tree;
-	for(unsigned int n = 0; n < currentIndex.size()-1; n++){
-		tn = &tn->children.at(currentIndex.at(n));
+
+	return &currentLeaf->hoppingAmplitudes.at(currentHoppingAmplitude);
+}
+
+TreeNode::Arena::Arena(){
+	blockCapacity = 0;
+}
+
+TreeNode::Arena::~Arena(){
+	for(unsigned int b = 0; b < blocks.size(); b++){
+		for(unsigned int n = 0; n < blockSizes.at(b); n++)
+			blocks.at(b)[n].~TreeNode();
+		delete [] reinterpret_cast<char*>(blocks.at(b));
+	}
+}
+
+TreeNode* TreeNode::Arena::allocate(){
+	if(blocks.size() == 0 || blockSizes.back() == blockCapacity){
+		if(blockCapacity == 0)
+			blockCapacity = MIN_BLOCK_CAPACITY;
+		else if(blockCapacity < MAX_BLOCK_CAPACITY)
+			blockCapacity *= 2;
+
+		blocks.push_back(
+			reinterpret_cast<TreeNode*>(
+				new char[blockCapacity*sizeof(TreeNode)]
+			)
+		);
+		blockSizes.push_back(0);
 	}
 
-	return &tn->hoppingAmplitudes.at(currentHoppingAmplitude);
+	TreeNode *treeNode = new (&blocks.back()[blockSizes.back()]) TreeNode(this);
+	blockSizes.back()++;
+
+	return treeNode;
 }
 
 TreeNode::Iterator TreeNode::begin(){
@@ -459,12 +867,15 @@ TreeNode::Iterator TreeNode::begin(){
 }
 
 HoppingAmplitude TreeNode::getFirstHA() const{
-	if(children.size() == 0)
+	if(numChildren == 0)
 		return hoppingAmplitudes.at(0);
 
-	for(unsigned int n = 0; n < children.size(); n++){
-		if(children.at(n).children.size() != 0 || children.at(n).hoppingAmplitudes.size() != 0)
-			return children.at(n).getFirstHA();
+	for(unsigned int n = 0; n < numChildSlots; n++){
+		if(children[n] == NULL)
+			continue;
+
+		if(children[n]->numChildren != 0 || children[n]->hoppingAmplitudes.size() != 0)
+			return children[n]->getFirstHA();
 	}
 
 	//Sould never happen. Line added to avoid compiler warnings.
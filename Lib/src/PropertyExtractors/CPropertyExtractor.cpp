@@ -23,6 +23,11 @@
 #include "TBTKMacros.h"
 #include "Streams.h"
 
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <omp.h>
+
 using namespace std;
 
 namespace TBTK{
@@ -62,15 +67,15 @@ CPropertyExtractor::CPropertyExtractor(
 		""
 	);
 	TBTKAssert(
-		lowerBound >= -cSolver->getScaleFactor(),
+		lowerBound >= cSolver->getEnergyShift() - cSolver->getScaleFactor(),
 		"CPropertyExtractor::CPropertyExtractor()",
-		"Argument lowerBound has to be larger than -cSolver->getScaleFactor().",
+		"Argument lowerBound has to be larger than cSolver->getEnergyShift() - cSolver->getScaleFactor().",
 		"Use ChebyshevSolver::setScaleFactor() to set a larger scale factor."
 	);
 	TBTKAssert(
-		upperBound <= cSolver->getScaleFactor(),
+		upperBound <= cSolver->getEnergyShift() + cSolver->getScaleFactor(),
 		"CPropertyExtractor::CPropertyExtractor()",
-		"Argument upperBound has to be smaller than cSolver->getScaleFactor().",
+		"Argument upperBound has to be smaller than cSolver->getEnergyShift() + cSolver->getScaleFactor().",
 		"Use ChebyshevSolver::setScaleFactor() to set a larger scale factor."
 	);
 
@@ -82,6 +87,8 @@ CPropertyExtractor::CPropertyExtractor(
 	this->useGPUToCalculateCoefficients = useGPUToCalculateCoefficients;
 	this->useGPUToGenerateGreensFunctions = useGPUToGenerateGreensFunctions;
 	this->useLookupTable = useLookupTable;
+	numRandomVectors = 0;
+	randomGenerator.seed(0);
 
 	if(useLookupTable){
 		cSolver->generateLookupTable(numCoefficients, energyResolution, lowerBound, upperBound);
@@ -118,50 +125,220 @@ complex<double>* CPropertyExtractor::calculateGreensFunctions(
 	Index from,
 	ChebyshevSolver::GreensFunctionType type
 ){
-	complex<double> *coefficients = new complex<double>[numCoefficients*to.size()];
+	vector<Index> fromIndices;
+	fromIndices.push_back(from);
+	complex<double> *coefficients = calculateCoefficients(to, fromIndices);
+
+	complex<double> *greensFunction = new complex<double>[energyResolution*to.size()];
+
+	for(unsigned int n = 0; n < to.size(); n++){
+		complex<double> *gf = generateGreensFunction(
+			&coefficients[n*numCoefficients],
+			type
+		);
+		for(int e = 0; e < energyResolution; e++)
+			greensFunction[n*energyResolution + e] = gf[e];
+
+		delete [] gf;
+	}
+
+	delete [] coefficients;
+
+	return greensFunction;
+}
+
+complex<double>* CPropertyExtractor::calculateCoefficients(
+	vector<Index> &to,
+	vector<Index> &from
+){
+	complex<double> *coefficients = new complex<double>[(size_t)numCoefficients*to.size()*from.size()];
 
 	if(useGPUToCalculateCoefficients){
-		cSolver->calculateCoefficientsGPU(to, from, coefficients, numCoefficients);
+		for(unsigned int n = 0; n < from.size(); n++){
+			cSolver->calculateCoefficientsGPU(
+				to,
+				from[n],
+				&coefficients[(size_t)n*to.size()*numCoefficients],
+				numCoefficients
+			);
+		}
 	}
 	else{
 		cSolver->calculateCoefficients(to, from, coefficients, numCoefficients);
 	}
 
-	complex<double> *greensFunction = new complex<double>[energyResolution*to.size()];
+	return coefficients;
+}
+
+complex<double>* CPropertyExtractor::generateGreensFunction(
+	complex<double> *coefficients,
+	ChebyshevSolver::GreensFunctionType type
+){
+	complex<double> *greensFunction = new complex<double>[energyResolution];
 
 	if(useGPUToGenerateGreensFunctions){
-		for(unsigned int n = 0; n < to.size(); n++){
-			cSolver->generateGreensFunctionGPU(greensFunction,
-								&(coefficients[n*numCoefficients]),
-								type);
-		}
+		cSolver->generateGreensFunctionGPU(
+			greensFunction,
+			coefficients,
+			type
+		);
+	}
+	else if(useLookupTable){
+		cSolver->generateGreensFunction(
+			greensFunction,
+			coefficients,
+			type
+		);
 	}
 	else{
-		if(useLookupTable){
-			#pragma omp parallel for
-			for(unsigned int n = 0; n < to.size(); n++){
-				cSolver->generateGreensFunction(greensFunction,
-								&(coefficients[n*numCoefficients]),
-								type);
-			}
+		cSolver->generateGreensFunction(
+			greensFunction,
+			coefficients,
+			numCoefficients,
+			energyResolution,
+			lowerBound,
+			upperBound,
+			type
+		);
+	}
+
+	return greensFunction;
+}
+
+Property::DOS* CPropertyExtractor::calculateDOS(
+	int numRandomVectors,
+	Property::DOS **standardError
+){
+	vector<int> basisIndices;
+	for(int n = 0; n < cSolver->getModel()->getBasisSize(); n++)
+		basisIndices.push_back(n);
+
+	return calculateDOS(basisIndices, numRandomVectors, standardError);
+}
+
+Property::DOS* CPropertyExtractor::calculateDOS(
+	const Index &pattern,
+	int numRandomVectors,
+	Property::DOS **standardError
+){
+	Model *model = cSolver->getModel();
+	vector<int> basisIndices;
+	for(int n = 0; n < model->getBasisSize(); n++){
+		if(pattern.equals(model->getPhysicalIndex(n), true))
+			basisIndices.push_back(n);
+	}
+
+	return calculateDOS(basisIndices, numRandomVectors, standardError);
+}
+
+Property::DOS* CPropertyExtractor::calculateDOS(
+	const vector<int> &basisIndices,
+	int numRandomVectors,
+	Property::DOS **standardError
+){
+	TBTKAssert(
+		numRandomVectors > 0,
+		"CPropertyExtractor::calculateDOS()",
+		"numRandomVectors has to be larger than 0.",
+		""
+	);
+	TBTKAssert(
+		standardError == NULL || numRandomVectors > 1,
+		"CPropertyExtractor::calculateDOS()",
+		"At least two random vectors are required to estimate the standard error.",
+		""
+	);
+
+	complex<double> *coefficients = calculateRandomStateCoefficients(
+		basisIndices,
+		numRandomVectors
+	);
+
+	//One estimate of the DOS per random vector.
+	double *samples = new double[numRandomVectors*energyResolution];
+	for(int n = 0; n < numRandomVectors*energyResolution; n++)
+		samples[n] = 0.;
+	for(int n = 0; n < numRandomVectors; n++){
+		calculateLDOSFromCoefficients(
+			this,
+			&coefficients[(size_t)n*numCoefficients],
+			&samples[n*energyResolution]
+		);
+	}
+
+	Property::DOS *dos = new Property::DOS(
+		lowerBound,
+		upperBound,
+		energyResolution
+	);
+	for(int n = 0; n < numRandomVectors; n++){
+		for(int e = 0; e < energyResolution; e++){
+			dos->data[e]
+				+= samples[n*energyResolution + e]/numRandomVectors;
 		}
-		else{
-			#pragma omp parallel for
-			for(unsigned int n = 0; n < to.size(); n++){
-				cSolver->generateGreensFunction(greensFunction,
-								&(coefficients[n*numCoefficients]),
-								numCoefficients,
-								energyResolution,
-								lowerBound,
-								upperBound,
-								type);
+	}
+
+	if(standardError != NULL){
+		*standardError = new Property::DOS(
+			lowerBound,
+			upperBound,
+			energyResolution
+		);
+		double *error = (*standardError)->data;
+		for(int n = 0; n < numRandomVectors; n++){
+			for(int e = 0; e < energyResolution; e++){
+				double deviation = samples[n*energyResolution + e]
+					- dos->data[e];
+				error[e] += deviation*deviation;
 			}
 		}
+		for(int e = 0; e < energyResolution; e++){
+			error[e] = sqrt(
+				error[e]/(numRandomVectors*(numRandomVectors - 1.))
+			);
+		}
 	}
 
+	delete [] samples;
 	delete [] coefficients;
 
-	return greensFunction;
+	return dos;
+}
+
+complex<double>* CPropertyExtractor::calculateRandomStateCoefficients(
+	const vector<int> &basisIndices,
+	int numStates
+){
+	int basisSize = cSolver->getModel()->getBasisSize();
+	int blockSize = min(cSolver->getBlockSize(), numStates);
+	complex<double> *coefficients = new complex<double>[(size_t)numCoefficients*numStates];
+
+	//The random vectors are generated and propagated one block at a
+	//time.
+	uniform_real_distribution<double> distribution(0., 2*M_PI);
+	complex<double> *states = new complex<double>[(size_t)blockSize*basisSize];
+	for(int b = 0; b < numStates; b += blockSize){
+		int numBlockStates = min(blockSize, numStates - b);
+		for(size_t n = 0; n < (size_t)numBlockStates*basisSize; n++)
+			states[n] = 0.;
+		for(int k = 0; k < numBlockStates; k++){
+			for(unsigned int n = 0; n < basisIndices.size(); n++){
+				states[(size_t)k*basisSize + basisIndices[n]]
+					= polar(1., distribution(randomGenerator));
+			}
+		}
+
+		cSolver->calculateStateCoefficients(
+			states,
+			numBlockStates,
+			&coefficients[(size_t)b*numCoefficients],
+			numCoefficients
+		);
+	}
+
+	delete [] states;
+
+	return coefficients;
 }
 
 complex<double> CPropertyExtractor::calculateExpectationValue(
@@ -228,7 +405,14 @@ Property::Density* CPropertyExtractor::calculateDensity(
 	getLoopRanges(pattern, ranges, &lDimensions, &lRanges);
 	Property::Density *density = new Property::Density(lDimensions, lRanges);
 
-	calculate(calculateDensityCallback, (void*)density->data, pattern, ranges, 0, 1);
+	calculate(
+		calculateDensityCallback,
+		calculateDensityFromCoefficients,
+		(void*)density->data,
+		1,
+		pattern,
+		ranges
+	);
 
 	return density;
 }
@@ -260,7 +444,14 @@ Property::Magnetization* CPropertyExtractor::calculateMagnetization(
 	getLoopRanges(pattern, ranges, &lDimensions, &lRanges);
 	Property::Magnetization *magnetization = new Property::Magnetization(lDimensions, lRanges);
 
-	calculate(calculateMAGCallback, (void*)magnetization->data, pattern, ranges, 0, 1);
+	calculate(
+		calculateMAGCallback,
+		NULL,
+		(void*)magnetization->data,
+		8,
+		pattern,
+		ranges
+	);
 
 	delete [] (int*)hint;
 
@@ -295,7 +486,14 @@ Property::LDOS* CPropertyExtractor::calculateLDOS(Index pattern, Index ranges){
 	getLoopRanges(pattern, ranges, &lDimensions, &lRanges);
 	Property::LDOS *ldos = new Property::LDOS(lDimensions, lRanges, lowerBound, upperBound, energyResolution);
 
-	calculate(calculateLDOSCallback, (void*)ldos->data, pattern, ranges, 0, 1);
+	calculate(
+		calculateLDOSCallback,
+		calculateLDOSFromCoefficients,
+		(void*)ldos->data,
+		energyResolution,
+		pattern,
+		ranges
+	);
 
 	return ldos;
 }
@@ -327,7 +525,14 @@ Property::SpinPolarizedLDOS* CPropertyExtractor::calculateSpinPolarizedLDOS(
 	getLoopRanges(pattern, ranges, &lDimensions, &lRanges);
 	Property::SpinPolarizedLDOS *spinPolarizedLDOS = new Property::SpinPolarizedLDOS(lDimensions, lRanges, lowerBound, upperBound, energyResolution);
 
-	calculate(calculateSP_LDOSCallback, (void*)spinPolarizedLDOS->data, pattern, ranges, 0, 1);
+	calculate(
+		calculateSP_LDOSCallback,
+		NULL,
+		(void*)spinPolarizedLDOS->data,
+		8*energyResolution,
+		pattern,
+		ranges
+	);
 
 	delete [] (int*)hint;
 
@@ -337,10 +542,31 @@ Property::SpinPolarizedLDOS* CPropertyExtractor::calculateSpinPolarizedLDOS(
 void CPropertyExtractor::calculateDensityCallback(
 	CPropertyExtractor *cb_this,
 	void *density,
-	const Index &index,
-	int offset
+	vector<Index> &indices
+){
+	int numIndices = indices.size();
+	complex<double> *coefficients = cb_this->calculateCoefficients(indices, indices);
+
+	for(int n = 0; n < numIndices; n++){
+		calculateDensityFromCoefficients(
+			cb_this,
+			&coefficients[(n*numIndices + n)*cb_this->numCoefficients],
+			&((double*)density)[n]
+		);
+	}
+
+	delete [] coefficients;
+}
+
+void CPropertyExtractor::calculateDensityFromCoefficients(
+	CPropertyExtractor *cb_this,
+	complex<double> *coefficients,
+	double *density
 ){
-	complex<double> *greensFunction = cb_this->calculateGreensFunction(index, index, ChebyshevSolver::GreensFunctionType::NonPrincipal);
+	complex<double> *greensFunction = cb_this->generateGreensFunction(
+		coefficients,
+		ChebyshevSolver::GreensFunctionType::NonPrincipal
+	);
 	Model::Statistics statistics = cb_this->cSolver->getModel()->getStatistics();
 
 	const double dE = (cb_this->upperBound - cb_this->lowerBound)/cb_this->energyResolution;
@@ -357,7 +583,7 @@ void CPropertyExtractor::calculateDensityCallback(
 									cb_this->cSolver->getModel()->getTemperature());
 		}
 
-		((double*)density)[offset] += weight*imag(greensFunction[e])/M_PI*dE;
+		density[0] += weight*imag(greensFunction[e])/M_PI*dE;
 	}
 
 	delete [] greensFunction;
@@ -366,52 +592,88 @@ void CPropertyExtractor::calculateDensityCallback(
 void CPropertyExtractor::calculateMAGCallback(
 	CPropertyExtractor *cb_this,
 	void *mag,
-	const Index &index,
-	int offset
+	vector<Index> &indices
 ){
 	int spinIndex = ((int*)(cb_this->hint))[0];
-	Index to(index);
-	Index from(index);
-	complex<double> *greensFunction;
+	int numIndices = indices.size();
+
+	//Both spin components of every index are expanded together, with
+	//the expansion for spin s of index n at position 2*n + s.
+	vector<Index> spinIndices;
+	for(int n = 0; n < numIndices; n++){
+		for(int s = 0; s < 2; s++){
+			spinIndices.push_back(indices[n]);
+			spinIndices.back().at(spinIndex) = s;
+		}
+	}
+	complex<double> *coefficients = cb_this->calculateCoefficients(spinIndices, spinIndices);
 	Model::Statistics statistics = cb_this->cSolver->getModel()->getStatistics();
 
 	const double dE = (cb_this->upperBound - cb_this->lowerBound)/cb_this->energyResolution;
-	for(int n = 0; n < 4; n++){
-		to.at(spinIndex) = n/2;		//up, up, down, down
-		from.at(spinIndex) = n%2;	//up, down, up, down
-		greensFunction = cb_this->calculateGreensFunction(to, from, ChebyshevSolver::GreensFunctionType::NonPrincipal);
-
-		for(int e = 0; e < cb_this->energyResolution; e++){
-			double weight;
-			if(statistics == Model::Statistics::FermiDirac){
-				weight = Functions::fermiDiracDistribution(cb_this->lowerBound + (e/(double)cb_this->energyResolution)*(cb_this->upperBound - cb_this->lowerBound),
-										cb_this->cSolver->getModel()->getChemicalPotential(),
-										cb_this->cSolver->getModel()->getTemperature());
-			}
-			else{
-				weight = Functions::boseEinsteinDistribution(cb_this->lowerBound + (e/(double)cb_this->energyResolution)*(cb_this->upperBound - cb_this->lowerBound),
-										cb_this->cSolver->getModel()->getChemicalPotential(),
-										cb_this->cSolver->getModel()->getTemperature());
+	for(int n = 0; n < numIndices; n++){
+		for(int s = 0; s < 4; s++){
+			int to = 2*n + s/2;	//up, up, down, down
+			int from = 2*n + s%2;	//up, down, up, down
+			complex<double> *greensFunction = cb_this->generateGreensFunction(
+				&coefficients[(from*2*numIndices + to)*cb_this->numCoefficients],
+				ChebyshevSolver::GreensFunctionType::NonPrincipal
+			);
+
+			for(int e = 0; e < cb_this->energyResolution; e++){
+				double weight;
+				if(statistics == Model::Statistics::FermiDirac){
+					weight = Functions::fermiDiracDistribution(cb_this->lowerBound + (e/(double)cb_this->energyResolution)*(cb_this->upperBound - cb_this->lowerBound),
+											cb_this->cSolver->getModel()->getChemicalPotential(),
+											cb_this->cSolver->getModel()->getTemperature());
+				}
+				else{
+					weight = Functions::boseEinsteinDistribution(cb_this->lowerBound + (e/(double)cb_this->energyResolution)*(cb_this->upperBound - cb_this->lowerBound),
+											cb_this->cSolver->getModel()->getChemicalPotential(),
+											cb_this->cSolver->getModel()->getTemperature());
+				}
+
+				((complex<double>*)mag)[4*n + s] += weight*imag(greensFunction[e])/M_PI*dE;
 			}
 
-			((complex<double>*)mag)[4*offset + n] += weight*imag(greensFunction[e])/M_PI*dE;
+			delete [] greensFunction;
 		}
-
-		delete [] greensFunction;
 	}
+
+	delete [] coefficients;
 }
 
 void CPropertyExtractor::calculateLDOSCallback(
 	CPropertyExtractor *cb_this,
 	void *ldos,
-	const Index &index,
-	int offset
+	vector<Index> &indices
 ){
-	complex<double> *greensFunction = cb_this->calculateGreensFunction(index, index, ChebyshevSolver::GreensFunctionType::NonPrincipal);
+	int numIndices = indices.size();
+	complex<double> *coefficients = cb_this->calculateCoefficients(indices, indices);
+
+	for(int n = 0; n < numIndices; n++){
+		calculateLDOSFromCoefficients(
+			cb_this,
+			&coefficients[(n*numIndices + n)*cb_this->numCoefficients],
+			&((double*)ldos)[cb_this->energyResolution*n]
+		);
+	}
+
+	delete [] coefficients;
+}
+
+void CPropertyExtractor::calculateLDOSFromCoefficients(
+	CPropertyExtractor *cb_this,
+	complex<double> *coefficients,
+	double *ldos
+){
+	complex<double> *greensFunction = cb_this->generateGreensFunction(
+		coefficients,
+		ChebyshevSolver::GreensFunctionType::NonPrincipal
+	);
 
 	const double dE = (cb_this->upperBound - cb_this->lowerBound)/cb_this->energyResolution;
-	for(int n = 0; n < cb_this->energyResolution; n++)
-		((double*)ldos)[cb_this->energyResolution*offset + n] += imag(greensFunction[n])/M_PI*dE;
+	for(int e = 0; e < cb_this->energyResolution; e++)
+		ldos[e] += imag(greensFunction[e])/M_PI*dE;
 
 	delete [] greensFunction;
 }
@@ -419,35 +681,164 @@ void CPropertyExtractor::calculateLDOSCallback(
 void CPropertyExtractor::calculateSP_LDOSCallback(
 	CPropertyExtractor *cb_this,
 	void *sp_ldos,
-	const Index &index,
-	int offset
+	vector<Index> &indices
 ){
 	int spinIndex = ((int*)(cb_this->hint))[0];
-	Index to(index);
-	Index from(index);
-	complex<double> *greensFunction;
+	int numIndices = indices.size();
+
+	//Both spin components of every index are expanded together, with
+	//the expansion for spin s of index n at position 2*n + s.
+	vector<Index> spinIndices;
+	for(int n = 0; n < numIndices; n++){
+		for(int s = 0; s < 2; s++){
+			spinIndices.push_back(indices[n]);
+			spinIndices.back().at(spinIndex) = s;
+		}
+	}
+	complex<double> *coefficients = cb_this->calculateCoefficients(spinIndices, spinIndices);
 
 	const double dE = (cb_this->upperBound - cb_this->lowerBound)/cb_this->energyResolution;
-	for(int n = 0; n < 4; n++){
-		to.at(spinIndex) = n/2;		//up, up, down, down
-		from.at(spinIndex) = n%2;	//up, down, up, down
-		greensFunction = cb_this->calculateGreensFunction(to, from, ChebyshevSolver::GreensFunctionType::NonPrincipal);
+	for(int n = 0; n < numIndices; n++){
+		for(int s = 0; s < 4; s++){
+			int to = 2*n + s/2;	//up, up, down, down
+			int from = 2*n + s%2;	//up, down, up, down
+			complex<double> *greensFunction = cb_this->generateGreensFunction(
+				&coefficients[(from*2*numIndices + to)*cb_this->numCoefficients],
+				ChebyshevSolver::GreensFunctionType::NonPrincipal
+			);
 
-		for(int e = 0; e < cb_this->energyResolution; e++)
-			((complex<double>*)sp_ldos)[4*cb_this->energyResolution*offset + 4*e + n] += imag(greensFunction[e])/M_PI*dE;
+			for(int e = 0; e < cb_this->energyResolution; e++)
+				((complex<double>*)sp_ldos)[4*cb_this->energyResolution*n + 4*e + s] += imag(greensFunction[e])/M_PI*dE;
 
-		delete [] greensFunction;
+			delete [] greensFunction;
+		}
 	}
+
+	delete [] coefficients;
 }
 
 void CPropertyExtractor::calculate(
 	void (*callback)(
 		CPropertyExtractor *cb_this,
 		void *memory,
-		const Index &index,
-		int offset
+		vector<Index> &indices
+	),
+	void (*traceCallback)(
+		CPropertyExtractor *cb_this,
+		complex<double> *coefficients,
+		double *memory
 	),
 	void *memory,
+	int resultSize,
+	Index pattern,
+	const Index &ranges
+){
+	vector<Index> indices;
+	vector<int> offsets;
+	getIndices(indices, offsets, pattern, ranges, 0, 1);
+
+	//Indices with the same offset are summed over IDX_SUM_ALL subindices.
+	//Sums with more terms than the number of random vectors are estimated
+	//here, using one expansion per random vector rather than one per
+	//term, while the remaining indices are calculated below.
+	if(traceCallback != NULL && numRandomVectors > 0){
+		map<int, vector<int>> terms;
+		for(unsigned int n = 0; n < indices.size(); n++)
+			terms[offsets[n]].push_back(n);
+
+		vector<Index> remainingIndices;
+		vector<int> remainingOffsets;
+		double *results = new double[resultSize];
+		for(auto &term : terms){
+			if((int)term.second.size() <= numRandomVectors){
+				for(unsigned int n = 0; n < term.second.size(); n++){
+					remainingIndices.push_back(indices[term.second[n]]);
+					remainingOffsets.push_back(term.first);
+				}
+				continue;
+			}
+
+			vector<int> basisIndices;
+			for(unsigned int n = 0; n < term.second.size(); n++){
+				basisIndices.push_back(
+					cSolver->getModel()->getBasisIndex(
+						indices[term.second[n]]
+					)
+				);
+			}
+			complex<double> *coefficients = calculateRandomStateCoefficients(
+				basisIndices,
+				numRandomVectors
+			);
+			for(int k = 1; k < numRandomVectors; k++){
+				for(int n = 0; n < numCoefficients; n++)
+					coefficients[n] += coefficients[(size_t)k*numCoefficients + n];
+			}
+			for(int n = 0; n < numCoefficients; n++)
+				coefficients[n] /= numRandomVectors;
+
+			for(int c = 0; c < resultSize; c++)
+				results[c] = 0.;
+			traceCallback(this, coefficients, results);
+			for(int c = 0; c < resultSize; c++)
+				((double*)memory)[resultSize*term.first + c] += results[c];
+
+			delete [] coefficients;
+		}
+		delete [] results;
+
+		indices.swap(remainingIndices);
+		offsets.swap(remainingOffsets);
+	}
+
+	int blockSize = cSolver->getBlockSize();
+	int numIndices = indices.size();
+	int numBlocks = (numIndices + blockSize - 1)/blockSize;
+
+	//The blocks are distributed over the threads if there are enough
+	//blocks to keep all threads busy, in which case each block is
+	//calculated by a single thread. Otherwise the blocks are calculated
+	//one at a time, using all threads for each block. The GPU is not
+	//shared between threads.
+	bool parallelBlocks = numBlocks >= omp_get_max_threads()
+		&& !useGPUToCalculateCoefficients
+		&& !useGPUToGenerateGreensFunctions;
+	if(!useGPUToCalculateCoefficients)
+		cSolver->updateHamiltonian();
+
+	//The callback stores resultSize doubles per index in a buffer for
+	//the block, which are added to memory at the offsets of the indices.
+	//The blocks are added in order, which makes sums over IDX_SUM_ALL
+	//subindices independent of the number of threads.
+	#pragma omp parallel for schedule(dynamic) ordered if(parallelBlocks)
+	for(int b = 0; b < numBlocks; b++){
+		int begin = b*blockSize;
+		int end = min(begin + blockSize, numIndices);
+		vector<Index> blockIndices(
+			indices.begin() + begin,
+			indices.begin() + end
+		);
+		double *results = new double[resultSize*(end - begin)];
+		for(int n = 0; n < resultSize*(end - begin); n++)
+			results[n] = 0.;
+
+		callback(this, results, blockIndices);
+
+		#pragma omp ordered
+		for(int n = begin; n < end; n++){
+			for(int c = 0; c < resultSize; c++){
+				((double*)memory)[resultSize*offsets[n] + c]
+					+= results[resultSize*(n - begin) + c];
+			}
+		}
+
+		delete [] results;
+	}
+}
+
+void CPropertyExtractor::getIndices(
+	vector<Index> &indices,
+	vector<int> &offsets,
 	Index pattern,
 	const Index &ranges,
 	int currentOffset,
@@ -460,7 +851,8 @@ void CPropertyExtractor::calculate(
 	}
 
 	if(currentSubindex == -1){
-		callback(this, memory, pattern, currentOffset);
+		indices.push_back(pattern);
+		offsets.push_back(currentOffset);
 	}
 	else{
 		int nextOffsetMultiplier = offsetMultiplier;
@@ -471,12 +863,13 @@ void CPropertyExtractor::calculate(
 			isSumIndex = true;
 		for(int n = 0; n < ranges.at(currentSubindex); n++){
 			pattern.at(currentSubindex) = n;
-			calculate(callback,
-					memory,
-					pattern,
-					ranges,
-					currentOffset,
-					nextOffsetMultiplier
+			getIndices(
+				indices,
+				offsets,
+				pattern,
+				ranges,
+				currentOffset,
+				nextOffsetMultiplier
 			);
 			if(!isSumIndex)
 				currentOffset += offsetMultiplier;
@@ -22,6 +22,10 @@
 #include "Functions.h"
 #include "Streams.h"
 
+#include <algorithm>
+
+#include <omp.h>
+
 using namespace std;
 
 namespace TBTK{
@@ -32,6 +36,32 @@ namespace{
 
 DPropertyExtractor::DPropertyExtractor(DiagonalizationSolver *dSolver){
 	this->dSolver = dSolver;
+	this->bSolver = NULL;
+	this->cfSolver = NULL;
+	this->ddSolver = NULL;
+}
+
+DPropertyExtractor::DPropertyExtractor(BlockDiagonalizationSolver *bSolver){
+	this->dSolver = NULL;
+	this->bSolver = bSolver;
+	this->cfSolver = NULL;
+	this->ddSolver = NULL;
+}
+
+DPropertyExtractor::DPropertyExtractor(ChebyshevFilterSolver *cfSolver){
+	this->dSolver = NULL;
+	this->bSolver = NULL;
+	this->cfSolver = cfSolver;
+	this->ddSolver = NULL;
+}
+
+DPropertyExtractor::DPropertyExtractor(
+	DistributedDiagonalizationSolver *ddSolver
+){
+	this->dSolver = NULL;
+	this->bSolver = NULL;
+	this->cfSolver = NULL;
+	this->ddSolver = ddSolver;
 }
 
 DPropertyExtractor::~DPropertyExtractor(){
@@ -45,8 +75,8 @@ void DPropertyExtractor::saveEigenValues(string path, string filename){
 	ss << filename;
 	ofstream fout;
 	fout.open(ss.str().c_str());
-	for(int n = 0; n < dSolver->getModel()->getBasisSize(); n++){
-		fout << dSolver->getEigenValues()[n] << "\n";
+	for(int n = 0; n < getNumStates(); n++){
+		fout << getSolverEigenValues()[n] << "\n";
 	}
 	fout.close();
 }
@@ -57,7 +87,7 @@ void DPropertyExtractor::getTabulatedAmplitudeSet(
 	int *numHoppingAmplitudes,
 	int *maxIndexSize
 ){
-	dSolver->getModel()->getAmplitudeSet()->tabulate(
+	getModel()->getAmplitudeSet()->tabulate(
 		amplitudes,
 		indices,
 		numHoppingAmplitudes,
@@ -66,8 +96,8 @@ void DPropertyExtractor::getTabulatedAmplitudeSet(
 }
 
 Property::EigenValues* DPropertyExtractor::getEigenValues(){
-	int size = dSolver->getModel()->getBasisSize();
-	const double *ev = dSolver->getEigenValues();
+	int size = getNumStates();
+	const double *ev = getSolverEigenValues();
 
 	Property::EigenValues *eigenValues = new Property::EigenValues(size);
 	for(int n = 0; n < size; n++)
@@ -81,10 +111,10 @@ Property::DOS* DPropertyExtractor::calculateDOS(
 	double upperBound,
 	int resolution
 ){
-	const double *ev = dSolver->getEigenValues();
+	const double *ev = getSolverEigenValues();
 
 	Property::DOS *dos = new Property::DOS(lowerBound, upperBound, resolution);
-	for(int n = 0; n < dSolver->getModel()->getBasisSize(); n++){
+	for(int n = 0; n < getNumStates(); n++){
 		int e = (int)(((ev[n] - lowerBound)/(upperBound - lowerBound))*resolution);
 		if(e >= 0 && e < resolution){
 			dos->data[e] += 1.;
@@ -98,35 +128,43 @@ complex<double> DPropertyExtractor::calculateExpectationValue(
 	Index to,
 	Index from
 ){
-	const complex<double> i(0, 1);
-
-	complex<double> expectationValue = 0.;
+	vector<double> occupations;
+	calculateOccupations(occupations);
 
-	Model::Statistics statistics = dSolver->getModel()->getStatistics();
+	int toVectorIndex, toBlock;
+	int fromVectorIndex, fromBlock;
+	resolveIndex(to, toVectorIndex, toBlock);
+	resolveIndex(from, fromVectorIndex, fromBlock);
 
-	for(int n = 0; n < dSolver->getModel()->getBasisSize(); n++){
-		double weight;
-		if(statistics == Model::Statistics::FermiDirac){
-			weight = Functions::fermiDiracDistribution(
-				dSolver->getEigenValue(n),
-				dSolver->getModel()->getChemicalPotential(),
-				dSolver->getModel()->getTemperature()
-			);
-		}
-		else{
-			weight = Functions::boseEinsteinDistribution(
-				dSolver->getEigenValue(n),
-				dSolver->getModel()->getChemicalPotential(),
-				dSolver->getModel()->getTemperature()
-			);
+	complex<double> expectationValue = 0.;
+	int numStates = getNumStates();
+	int panelSize = getEigenVectorPanelSize();
+	for(int panelStart = 0; panelStart < numStates; panelStart += panelSize){
+		int panelEnd = min(panelStart + panelSize, numStates);
+		loadEigenVectorPanels(panelStart, panelEnd-1);
+		for(int n = panelStart; n < panelEnd; n++){
+			int block = getStateBlock(n);
+			if(
+				occupations[n] == 0
+				|| block != toBlock
+				|| block != fromBlock
+			){
+				continue;
+			}
+
+			const complex<double> *eigenVector = getEigenVector(n);
+			if(eigenVector == NULL)
+				continue;
+
+			complex<double> u_to = eigenVector[toVectorIndex];
+			complex<double> u_from = eigenVector[fromVectorIndex];
+
+			expectationValue += occupations[n]*conj(u_to)*u_from;
 		}
-
-		complex<double> u_to = dSolver->getAmplitude(n, to);
-		complex<double> u_from = dSolver->getAmplitude(n, from);
-
-		expectationValue += weight*conj(u_to)*u_from;
 	}
 
+	sumOverProcesses(&expectationValue, 1);
+
 	return expectationValue;
 }
 
@@ -141,7 +179,57 @@ Property::Density* DPropertyExtractor::calculateDensity(
 	getLoopRanges(pattern, ranges, &lDimensions, &lRanges);
 	Property::Density *density = new Property::Density(lDimensions, lRanges);
 
-	calculate(calculateDensityCallback, (void*)density->data, pattern, ranges, 0, 1);
+	ResolvedIndices resolvedIndices;
+	resolveIndices(pattern, ranges, -1, resolvedIndices);
+	vector<double> occupations;
+	calculateOccupations(occupations);
+
+	const int *offsets = resolvedIndices.offsets.data();
+	const int *vectorIndices = resolvedIndices.vectorIndices[0].data();
+	const int *blocks = resolvedIndices.blocks[0].data();
+	int numStates = getNumStates();
+	double *data = density->data;
+
+	//Each thread processes a range of indices with offsets that no other
+	//thread processes, and loops over the states in the outer loop to
+	//read each eigenvector only once. The states are processed in panels
+	//to limit the number of resident eigenvectors when they are stored in
+	//a file.
+	int panelSize = getEigenVectorPanelSize();
+	for(int panelStart = 0; panelStart < numStates; panelStart += panelSize){
+		int panelEnd = min(panelStart + panelSize, numStates);
+		loadEigenVectorPanels(panelStart, panelEnd-1);
+
+		#pragma omp parallel
+		{
+			int begin, end;
+			getIndexRange(
+				resolvedIndices,
+				omp_get_num_threads(),
+				omp_get_thread_num(),
+				begin,
+				end
+			);
+			for(int n = panelStart; n < panelEnd; n++){
+				if(occupations[n] == 0)
+					continue;
+
+				const complex<double> *eigenVector = getEigenVector(n);
+				if(eigenVector == NULL)
+					continue;
+
+				int block = getStateBlock(n);
+				for(int c = begin; c < end; c++){
+					if(blocks[c] == block){
+						data[offsets[c]] += norm(
+							eigenVector[vectorIndices[c]]
+						)*occupations[n];
+					}
+				}
+			}
+		}
+	}
+	sumOverProcesses(density->data, density->getSize());
 
 	return density;
 }
@@ -150,19 +238,17 @@ Property::Magnetization* DPropertyExtractor::calculateMagnetization(
 	Index pattern,
 	Index ranges
 ){
-	hint = new int[1];
-	((int*)hint)[0] = -1;
+	int spinIndex = -1;
 	for(unsigned int n = 0; n < pattern.size(); n++){
 		if(pattern.at(n) == IDX_SPIN){
-			((int*)hint)[0] = n;
+			spinIndex = n;
 			pattern.at(n) = 0;
 			ranges.at(n) = 1;
 			break;
 		}
 	}
-	if(((int*)hint)[0] == -1){
+	if(spinIndex == -1){
 		Streams::err << "Error in PropertyExtractor::calculateMAG: No spin index indicated.\n";
-		delete [] (int*)hint;
 		return NULL;
 	}
 
@@ -173,9 +259,62 @@ Property::Magnetization* DPropertyExtractor::calculateMagnetization(
 	getLoopRanges(pattern, ranges, &lDimensions, &lRanges);
 	Property::Magnetization *magnetization = new Property::Magnetization(lDimensions, lRanges);
 
-	calculate(calculateMAGCallback, (void*)magnetization->data, pattern, ranges, 0, 1);
-
-	delete [] (int*)hint;
+	ResolvedIndices resolvedIndices;
+	resolveIndices(pattern, ranges, spinIndex, resolvedIndices);
+	vector<double> occupations;
+	calculateOccupations(occupations);
+
+	const int *offsets = resolvedIndices.offsets.data();
+	const int *vectorIndices_u = resolvedIndices.vectorIndices[0].data();
+	const int *vectorIndices_d = resolvedIndices.vectorIndices[1].data();
+	const int *blocks_u = resolvedIndices.blocks[0].data();
+	const int *blocks_d = resolvedIndices.blocks[1].data();
+	int numStates = getNumStates();
+	complex<double> *data = magnetization->data;
+
+	int panelSize = getEigenVectorPanelSize();
+	for(int panelStart = 0; panelStart < numStates; panelStart += panelSize){
+		int panelEnd = min(panelStart + panelSize, numStates);
+		loadEigenVectorPanels(panelStart, panelEnd-1);
+
+		#pragma omp parallel
+		{
+			int begin, end;
+			getIndexRange(
+				resolvedIndices,
+				omp_get_num_threads(),
+				omp_get_thread_num(),
+				begin,
+				end
+			);
+			for(int n = panelStart; n < panelEnd; n++){
+				if(occupations[n] == 0)
+					continue;
+
+				const complex<double> *eigenVector = getEigenVector(n);
+				if(eigenVector == NULL)
+					continue;
+
+				int block = getStateBlock(n);
+				for(int c = begin; c < end; c++){
+					complex<double> u_u = 0.;
+					complex<double> u_d = 0.;
+					if(blocks_u[c] == block)
+						u_u = eigenVector[vectorIndices_u[c]];
+					if(blocks_d[c] == block)
+						u_d = eigenVector[vectorIndices_d[c]];
+
+					double weight = occupations[n];
+					complex<double> *m = &data[4*offsets[c]];
+					m[0] += conj(u_u)*u_u*weight;
+					m[1] += conj(u_u)*u_d*weight;
+					m[2] += conj(u_d)*u_u*weight;
+					m[3] += conj(u_d)*u_d*weight;
+				}
+			}
+		}
+	}
+	sumOverProcesses(magnetization->data, magnetization->getSize());
 
 	return magnetization;
 }
@@ -187,18 +326,6 @@ Property::LDOS* DPropertyExtractor::calculateLDOS(
 	double upperBound,
 	int resolution
 ){
-	//hint[0] is an array of doubles, hint[1] is an array of ints
-	//hint[0][0]: upperBound
-	//hint[0][1]: lowerBound
-	//hint[1][0]: resolution
-	//hint[1][1]: spin_index
-	hint = new void*[2];
-	((double**)hint)[0] = new double[2];
-	((int**)hint)[1] = new int[1];
-	((double**)hint)[0][0] = upperBound;
-	((double**)hint)[0][1] = lowerBound;
-	((int**)hint)[1][0] = resolution;
-
 	ensureCompliantRanges(pattern, ranges);
 
 	int lDimensions;
@@ -206,7 +333,53 @@ Property::LDOS* DPropertyExtractor::calculateLDOS(
 	getLoopRanges(pattern, ranges, &lDimensions, &lRanges);
 	Property::LDOS *ldos = new Property::LDOS(lDimensions, lRanges, lowerBound, upperBound, resolution);
 
-	calculate(calculateLDOSCallback, (void*)ldos->data, pattern, ranges, 0, 1);
+	ResolvedIndices resolvedIndices;
+	resolveIndices(pattern, ranges, -1, resolvedIndices);
+	vector<int> energyIndices;
+	calculateEnergyIndices(lowerBound, upperBound, resolution, energyIndices);
+
+	const int *offsets = resolvedIndices.offsets.data();
+	const int *vectorIndices = resolvedIndices.vectorIndices[0].data();
+	const int *blocks = resolvedIndices.blocks[0].data();
+	int numStates = getNumStates();
+	double *data = ldos->data;
+
+	int panelSize = getEigenVectorPanelSize();
+	for(int panelStart = 0; panelStart < numStates; panelStart += panelSize){
+		int panelEnd = min(panelStart + panelSize, numStates);
+		loadEigenVectorPanels(panelStart, panelEnd-1);
+
+		#pragma omp parallel
+		{
+			int begin, end;
+			getIndexRange(
+				resolvedIndices,
+				omp_get_num_threads(),
+				omp_get_thread_num(),
+				begin,
+				end
+			);
+			for(int n = panelStart; n < panelEnd; n++){
+				int e = energyIndices[n];
+				if(e == -1)
+					continue;
+
+				const complex<double> *eigenVector = getEigenVector(n);
+				if(eigenVector == NULL)
+					continue;
+
+				int block = getStateBlock(n);
+				for(int c = begin; c < end; c++){
+					if(blocks[c] == block){
+						data[resolution*offsets[c] + e] += norm(
+							eigenVector[vectorIndices[c]]
+						);
+					}
+				}
+			}
+		}
+	}
+	sumOverProcesses(ldos->data, ldos->getSize());
 
 	return ldos;
 }
@@ -218,32 +391,17 @@ Property::SpinPolarizedLDOS* DPropertyExtractor::calculateSpinPolarizedLDOS(
 	double upperBound,
 	int resolution
 ){
-	//hint[0] is an array of doubles, hint[1] is an array of ints
-	//hint[0][0]: upperBound
-	//hint[0][1]: lowerBound
-	//hint[1][0]: resolution
-	//hint[1][1]: spin_index
-	hint = new void*[2];
-	((double**)hint)[0] = new double[2];
-	((int**)hint)[1] = new int[2];
-	((double**)hint)[0][0] = upperBound;
-	((double**)hint)[0][1] = lowerBound;
-	((int**)hint)[1][0] = resolution;
-
-	((int**)hint)[1][1] = -1;
+	int spinIndex = -1;
 	for(unsigned int n = 0; n < pattern.size(); n++){
 		if(pattern.at(n) == IDX_SPIN){
-			((int**)hint)[1][1] = n;
+			spinIndex = n;
 			pattern.at(n) = 0;
 			ranges.at(n) = 1;
 			break;
 		}
 	}
-	if(((int**)hint)[1][1] == -1){
+	if(spinIndex == -1){
 		Streams::err << "Error in PropertyExtractor::calculateSP_LDOS_E: No spin index indicated.\n";
-		delete [] ((double**)hint)[0];
-		delete [] ((int**)hint)[1];
-		delete [] (void**)hint;
 		return NULL;
 	}
 
@@ -254,136 +412,223 @@ Property::SpinPolarizedLDOS* DPropertyExtractor::calculateSpinPolarizedLDOS(
 	getLoopRanges(pattern, ranges, &lDimensions, &lRanges);
 	Property::SpinPolarizedLDOS *spinPolarizedLDOS = new Property::SpinPolarizedLDOS(lDimensions, lRanges, lowerBound, upperBound, resolution);
 
-	calculate(calculateSP_LDOSCallback, (void*)spinPolarizedLDOS->data, pattern, ranges, 0, 1);
-
-	delete [] ((double**)hint)[0];
-	delete [] ((int**)hint)[1];
-	delete [] (void**)hint;
+	ResolvedIndices resolvedIndices;
+	resolveIndices(pattern, ranges, spinIndex, resolvedIndices);
+	vector<int> energyIndices;
+	calculateEnergyIndices(lowerBound, upperBound, resolution, energyIndices);
+
+	const int *offsets = resolvedIndices.offsets.data();
+	const int *vectorIndices_u = resolvedIndices.vectorIndices[0].data();
+	const int *vectorIndices_d = resolvedIndices.vectorIndices[1].data();
+	const int *blocks_u = resolvedIndices.blocks[0].data();
+	const int *blocks_d = resolvedIndices.blocks[1].data();
+	int numStates = getNumStates();
+	complex<double> *data = spinPolarizedLDOS->data;
+
+	int panelSize = getEigenVectorPanelSize();
+	for(int panelStart = 0; panelStart < numStates; panelStart += panelSize){
+		int panelEnd = min(panelStart + panelSize, numStates);
+		loadEigenVectorPanels(panelStart, panelEnd-1);
+
+		#pragma omp parallel
+		{
+			int begin, end;
+			getIndexRange(
+				resolvedIndices,
+				omp_get_num_threads(),
+				omp_get_thread_num(),
+				begin,
+				end
+			);
+			for(int n = panelStart; n < panelEnd; n++){
+				int e = energyIndices[n];
+				if(e == -1)
+					continue;
+
+				const complex<double> *eigenVector = getEigenVector(n);
+				if(eigenVector == NULL)
+					continue;
+
+				int block = getStateBlock(n);
+				for(int c = begin; c < end; c++){
+					complex<double> u_u = 0.;
+					complex<double> u_d = 0.;
+					if(blocks_u[c] == block)
+						u_u = eigenVector[vectorIndices_u[c]];
+					if(blocks_d[c] == block)
+						u_d = eigenVector[vectorIndices_d[c]];
+
+					complex<double> *rho = &data[4*resolution*offsets[c] + 4*e];
+					rho[0] += conj(u_u)*u_u;
+					rho[1] += conj(u_u)*u_d;
+					rho[2] += conj(u_d)*u_u;
+					rho[3] += conj(u_d)*u_d;
+				}
+			}
+		}
+	}
+	sumOverProcesses(spinPolarizedLDOS->data, spinPolarizedLDOS->getSize());
 
 	return spinPolarizedLDOS;
 }
 
-void DPropertyExtractor::calculateDensityCallback(
+void DPropertyExtractor::resolveIndexCallback(
 	DPropertyExtractor *cb_this,
-	void* density,
+	void *resolvedIndices,
 	const Index &index,
 	int offset
 ){
-	const double *eigen_values = cb_this->dSolver->getEigenValues();
-	Model::Statistics statistics = cb_this->dSolver->getModel()->getStatistics();
-	for(int n = 0; n < cb_this->dSolver->getModel()->getBasisSize(); n++){
-		double weight;
-		if(statistics == Model::Statistics::FermiDirac){
-			weight = Functions::fermiDiracDistribution(eigen_values[n],
-									cb_this->dSolver->getModel()->getChemicalPotential(),
-									cb_this->dSolver->getModel()->getTemperature());
-		}
-		else{
-			weight = Functions::boseEinsteinDistribution(eigen_values[n],
-									cb_this->dSolver->getModel()->getChemicalPotential(),
-									cb_this->dSolver->getModel()->getTemperature());
+	ResolvedIndices &r = *((ResolvedIndices*)resolvedIndices);
+	r.offsets.push_back(offset);
+	if(r.spinIndex == -1){
+		int vectorIndex, block;
+		cb_this->resolveIndex(index, vectorIndex, block);
+		r.vectorIndices[0].push_back(vectorIndex);
+		r.blocks[0].push_back(block);
+	}
+	else{
+		Index spinResolvedIndex(index);
+		for(int s = 0; s < 2; s++){
+			spinResolvedIndex.at(r.spinIndex) = s;
+			int vectorIndex, block;
+			cb_this->resolveIndex(spinResolvedIndex, vectorIndex, block);
+			r.vectorIndices[s].push_back(vectorIndex);
+			r.blocks[s].push_back(block);
 		}
-
-		complex<double> u = cb_this->dSolver->getAmplitude(n, index);
-
-		((double*)density)[offset] += pow(abs(u), 2)*weight;
 	}
 }
 
-void DPropertyExtractor::calculateMAGCallback(
-	DPropertyExtractor *cb_this,
-	void *mag,
-	const Index &index,
-	int offset
+void DPropertyExtractor::resolveIndices(
+	const Index &pattern,
+	const Index &ranges,
+	int spinIndex,
+	ResolvedIndices &resolvedIndices
 ){
-	const double *eigen_values = cb_this->dSolver->getEigenValues();
-	Model::Statistics statistics = cb_this->dSolver->getModel()->getStatistics();
-
-	int spin_index = ((int*)cb_this->hint)[0];
-	Index index_u(index);
-	Index index_d(index);
-	index_u.at(spin_index) = 0;
-	index_d.at(spin_index) = 1;
-	for(int n = 0; n < cb_this->dSolver->getModel()->getBasisSize(); n++){
-		double weight;
-		if(statistics == Model::Statistics::FermiDirac){
-			weight = Functions::fermiDiracDistribution(eigen_values[n],
-									cb_this->dSolver->getModel()->getChemicalPotential(),
-									cb_this->dSolver->getModel()->getTemperature());
-		}
-		else{
-			weight = Functions::boseEinsteinDistribution(eigen_values[n],
-									cb_this->dSolver->getModel()->getChemicalPotential(),
-									cb_this->dSolver->getModel()->getTemperature());
-		}
+	resolvedIndices.spinIndex = spinIndex;
+	calculate(
+		resolveIndexCallback,
+		(void*)&resolvedIndices,
+		pattern,
+		ranges,
+		0,
+		1
+	);
 
-		complex<double> u_u = cb_this->dSolver->getAmplitude(n, index_u);
-		complex<double> u_d = cb_this->dSolver->getAmplitude(n, index_d);
+	//Summation indices can make the same offset appear at several places.
+	//Group the indices by offset so that ranges of offsets can be
+	//processed independently.
+	int size = resolvedIndices.offsets.size();
+	vector<int> order(size);
+	for(int n = 0; n < size; n++)
+		order[n] = n;
+	const vector<int> &offsets = resolvedIndices.offsets;
+	stable_sort(
+		order.begin(),
+		order.end(),
+		[&offsets](int n1, int n2){
+			return offsets[n1] < offsets[n2];
+		}
+	);
 
-		((complex<double>*)mag)[4*offset + 0] += conj(u_u)*u_u*weight;
-		((complex<double>*)mag)[4*offset + 1] += conj(u_u)*u_d*weight;
-		((complex<double>*)mag)[4*offset + 2] += conj(u_d)*u_u*weight;
-		((complex<double>*)mag)[4*offset + 3] += conj(u_d)*u_d*weight;
+	vector<int> sorted(size);
+	for(int n = 0; n < size; n++)
+		sorted[n] = resolvedIndices.offsets[order[n]];
+	resolvedIndices.offsets.swap(sorted);
+	for(int s = 0; s < 2; s++){
+		if(resolvedIndices.vectorIndices[s].size() == 0)
+			continue;
+
+		for(int n = 0; n < size; n++)
+			sorted[n] = resolvedIndices.vectorIndices[s][order[n]];
+		resolvedIndices.vectorIndices[s].swap(sorted);
+		for(int n = 0; n < size; n++)
+			sorted[n] = resolvedIndices.blocks[s][order[n]];
+		resolvedIndices.blocks[s].swap(sorted);
 	}
 }
 
-void DPropertyExtractor::calculateLDOSCallback(
-	DPropertyExtractor *cb_this,
-	void *ldos,
+void DPropertyExtractor::resolveIndex(
 	const Index &index,
-	int offset
+	int &vectorIndex,
+	int &block
 ){
-	const double *eigen_values = cb_this->dSolver->getEigenValues();
+	int basisIndex = getModel()->getBasisIndex(index);
+	if(bSolver != NULL){
+		const BlockStructure &blockStructure
+			= getModel()->getBlockStructure();
+		vectorIndex = blockStructure.getIntraBlockIndex(basisIndex);
+		block = blockStructure.getBlock(basisIndex);
+	}
+	else{
+		vectorIndex = basisIndex;
+		block = 0;
+	}
+}
 
-	double u_lim = ((double**)cb_this->hint)[0][0];
-	double l_lim = ((double**)cb_this->hint)[0][1];
-	int resolution = ((int**)cb_this->hint)[1][0];
+void DPropertyExtractor::getIndexRange(
+	const ResolvedIndices &resolvedIndices,
+	int numThreads,
+	int thread,
+	int &begin,
+	int &end
+){
+	const vector<int> &offsets = resolvedIndices.offsets;
+	int size = offsets.size();
 
-	double step_size = (u_lim - l_lim)/(double)resolution;
+	begin = (int)(((long)size*thread)/numThreads);
+	while(begin > 0 && begin < size && offsets[begin] == offsets[begin-1])
+		begin++;
 
-	for(int n = 0; n < cb_this->dSolver->getModel()->getBasisSize(); n++){
-		if(eigen_values[n] > l_lim && eigen_values[n] < u_lim){
-			complex<double> u = cb_this->dSolver->getAmplitude(n, index);
+	end = (int)(((long)size*(thread+1))/numThreads);
+	while(end > 0 && end < size && offsets[end] == offsets[end-1])
+		end++;
+}
 
-			int e = (int)((eigen_values[n] - l_lim)/step_size);
-			if(e >= resolution)
-				e = resolution-1;
-			((double*)ldos)[resolution*offset + e] += real(conj(u)*u);
+void DPropertyExtractor::calculateOccupations(vector<double> &occupations){
+	Model *model = getModel();
+	Model::Statistics statistics = model->getStatistics();
+	double chemicalPotential = model->getChemicalPotential();
+	double temperature = model->getTemperature();
+	const double *eigenValues = getSolverEigenValues();
+
+	occupations.resize(getNumStates());
+	for(int n = 0; n < getNumStates(); n++){
+		if(statistics == Model::Statistics::FermiDirac){
+			occupations[n] = Functions::fermiDiracDistribution(
+				eigenValues[n],
+				chemicalPotential,
+				temperature
+			);
+		}
+		else{
+			occupations[n] = Functions::boseEinsteinDistribution(
+				eigenValues[n],
+				chemicalPotential,
+				temperature
+			);
 		}
 	}
 }
 
-void DPropertyExtractor::calculateSP_LDOSCallback(
-	DPropertyExtractor *cb_this,
-	void *sp_ldos,
-	const Index &index,
-	int offset
+void DPropertyExtractor::calculateEnergyIndices(
+	double lowerBound,
+	double upperBound,
+	int resolution,
+	vector<int> &energyIndices
 ){
-	const double *eigen_values = cb_this->dSolver->getEigenValues();
+	const double *eigenValues = getSolverEigenValues();
+	double stepSize = (upperBound - lowerBound)/(double)resolution;
 
-	double u_lim = ((double**)cb_this->hint)[0][0];
-	double l_lim = ((double**)cb_this->hint)[0][1];
-	int resolution = ((int**)cb_this->hint)[1][0];
-	int spin_index = ((int**)cb_this->hint)[1][1];
-
-	double step_size = (u_lim - l_lim)/(double)resolution;
-
-	Index index_u(index);
-	Index index_d(index);
-	index_u.at(spin_index) = 0;
-	index_d.at(spin_index) = 1;
-	for(int n = 0; n < cb_this->dSolver->getModel()->getBasisSize(); n++){
-		if(eigen_values[n] > l_lim && eigen_values[n] < u_lim){
-			complex<double> u_u = cb_this->dSolver->getAmplitude(n, index_u);
-			complex<double> u_d = cb_this->dSolver->getAmplitude(n, index_d);
-
-			int e = (int)((eigen_values[n] - l_lim)/step_size);
+	energyIndices.resize(getNumStates());
+	for(int n = 0; n < getNumStates(); n++){
+		if(eigenValues[n] > lowerBound && eigenValues[n] < upperBound){
+			int e = (int)((eigenValues[n] - lowerBound)/stepSize);
 			if(e >= resolution)
 				e = resolution-1;
-			((complex<double>*)sp_ldos)[4*resolution*offset + 4*e + 0] += conj(u_u)*u_u;
-			((complex<double>*)sp_ldos)[4*resolution*offset + 4*e + 1] += conj(u_u)*u_d;
-			((complex<double>*)sp_ldos)[4*resolution*offset + 4*e + 2] += conj(u_d)*u_u;
-			((complex<double>*)sp_ldos)[4*resolution*offset + 4*e + 3] += conj(u_d)*u_d;
+			energyIndices[n] = e;
+		}
+		else{
+			energyIndices[n] = -1;
 		}
 	}
 }
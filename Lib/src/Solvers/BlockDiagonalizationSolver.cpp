@@ -0,0 +1,299 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file BlockDiagonalizationSolver.cpp
+ *
+ *  @author agent
+ */
+
+#include "BlockDiagonalizationSolver.h"
+#include "Streams.h"
+#include "TBTKMacros.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <omp.h>
+
+using namespace std;
+
+namespace TBTK{
+
+BlockDiagonalizationSolver::BlockDiagonalizationSolver(){
+	model = NULL;
+	blockStructure = NULL;
+
+	hamiltonian = NULL;
+	hamiltonianOffsets = NULL;
+	blockEigenValues = NULL;
+	eigenVectors = NULL;
+	eigenVectorOffsets = NULL;
+	eigenValues = NULL;
+	stateBlocks = NULL;
+	stateOffsets = NULL;
+
+	maxIterations = 50;
+	scCallback = NULL;
+}
+
+BlockDiagonalizationSolver::~BlockDiagonalizationSolver(){
+	clear();
+}
+
+void BlockDiagonalizationSolver::clear(){
+	if(hamiltonian != NULL){
+		delete [] hamiltonian;
+		hamiltonian = NULL;
+	}
+	if(hamiltonianOffsets != NULL){
+		delete [] hamiltonianOffsets;
+		hamiltonianOffsets = NULL;
+	}
+	if(blockEigenValues != NULL){
+		delete [] blockEigenValues;
+		blockEigenValues = NULL;
+	}
+	if(eigenVectors != NULL){
+		delete [] eigenVectors;
+		eigenVectors = NULL;
+	}
+	if(eigenVectorOffsets != NULL){
+		delete [] eigenVectorOffsets;
+		eigenVectorOffsets = NULL;
+	}
+	if(eigenValues != NULL){
+		delete [] eigenValues;
+		eigenValues = NULL;
+	}
+	if(stateBlocks != NULL){
+		delete [] stateBlocks;
+		stateBlocks = NULL;
+	}
+	if(stateOffsets != NULL){
+		delete [] stateOffsets;
+		stateOffsets = NULL;
+	}
+}
+
+void BlockDiagonalizationSolver::run(){
+	TBTKAssert(
+		model != NULL,
+		"BlockDiagonalizationSolver::run()",
+		"Model not set.",
+		"Use BlockDiagonalizationSolver::setModel() to set model."
+	);
+
+	int iterationCounter = 0;
+	init();
+
+	Streams::out << "Running BlockDiagonalizationSolver\n";
+	while(iterationCounter++ < maxIterations){
+		if(iterationCounter%10 == 1)
+			Streams::out << " ";
+		if(iterationCounter%50 == 1)
+			Streams::out << "\n";
+		Streams::out << "." << flush;
+
+		solve();
+
+		if(scCallback){
+			if(scCallback(this))
+				break;
+			else
+				update();
+		}
+		else{
+			break;
+		}
+	}
+	Streams::out << "\n";
+}
+
+void BlockDiagonalizationSolver::init(){
+	Streams::out << "Initializing BlockDiagonalizationSolver\n";
+
+	clear();
+
+	blockStructure = &model->getBlockStructure();
+	int numBlocks = blockStructure->getNumBlocks();
+	int basisSize = model->getBasisSize();
+	Streams::out << "\tBasis size: " << basisSize << "\n";
+	Streams::out << "\tNumber of blocks: " << numBlocks << "\n";
+
+	hamiltonianOffsets = new int[numBlocks+1];
+	eigenVectorOffsets = new int[numBlocks+1];
+	hamiltonianOffsets[0] = 0;
+	eigenVectorOffsets[0] = 0;
+	for(int n = 0; n < numBlocks; n++){
+		int blockSize = blockStructure->getBlockSize(n);
+		hamiltonianOffsets[n+1] = hamiltonianOffsets[n]
+			+ (blockSize*(blockSize+1))/2;
+		eigenVectorOffsets[n+1] = eigenVectorOffsets[n]
+			+ blockSize*blockSize;
+	}
+
+	hamiltonian = new complex<double>[hamiltonianOffsets[numBlocks]];
+	blockEigenValues = new double[basisSize];
+	eigenVectors = new complex<double>[eigenVectorOffsets[numBlocks]];
+	eigenValues = new double[basisSize];
+	stateBlocks = new int[basisSize];
+	stateOffsets = new int[basisSize];
+
+	update();
+}
+
+void BlockDiagonalizationSolver::update(){
+	int numBlocks = blockStructure->getNumBlocks();
+	for(int n = 0; n < hamiltonianOffsets[numBlocks]; n++)
+		hamiltonian[n] = 0.;
+
+	AmplitudeArray &amplitudeArray = model->getAmplitudeSet()->getAmplitudeArray();
+	amplitudeArray.evaluateCallbacks();
+	const int *fromBasisIndices = amplitudeArray.getFromBasisIndices();
+	const int *toBasisIndices = amplitudeArray.getToBasisIndices();
+	const complex<double> *values = amplitudeArray.getValues();
+
+	//Each thread processes a range of amplitudes with 'from'-basis indices
+	//that no other thread processes, and therefore writes to its own set of
+	//matrix elements. The order of the basis indices is preserved within
+	//each block, so from >= to also holds for the intra block indices.
+	#pragma omp parallel
+	{
+		AmplitudeArray::Range range = amplitudeArray.getRange(
+			omp_get_num_threads(),
+			omp_get_thread_num()
+		);
+		for(int n = range.begin; n < range.end; n++){
+			int from = fromBasisIndices[n];
+			int to = toBasisIndices[n];
+			if(from >= to){
+				int block = blockStructure->getBlock(from);
+				int f = blockStructure->getIntraBlockIndex(from);
+				int t = blockStructure->getIntraBlockIndex(to);
+				hamiltonian[
+					hamiltonianOffsets[block] + t + (f*(f+1))/2
+				] += values[n];
+			}
+		}
+	}
+}
+
+//Lapack function for matrix diagonalization of triangular matrix.
+extern "C" void zhpev_(char *jobz,		//'E' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+			char *uplo,		//'U' = Stored as upper triangular, 'L' = Stored as lower triangular.
+			int *n,			//n*n = Matrix size
+			complex<double> *ap,	//Input matrix
+			double *w,		//Eigenvalues, is in accending order if info = 0
+			complex<double> *z,	//Eigenvectors
+			int *ldz,		//
+			complex<double> *work,	//Workspace, dimension = max(1, 2*N-1)
+			double *rwork,		//Workspace, dimension = max(1, 3*N-2)
+			int *info);		//0 = successful, <0 = -info value was illegal, >0 = info number of off-diagonal elements failed to converge.
+
+void BlockDiagonalizationSolver::solve(){
+	int numBlocks = blockStructure->getNumBlocks();
+	int basisSize = model->getBasisSize();
+
+	//Process the largest blocks first to balance the load between the
+	//threads.
+	vector<int> blockOrder(numBlocks);
+	for(int n = 0; n < numBlocks; n++)
+		blockOrder[n] = n;
+	stable_sort(
+		blockOrder.begin(),
+		blockOrder.end(),
+		[this](int block1, int block2){
+			return blockStructure->getBlockSize(block1)
+				> blockStructure->getBlockSize(block2);
+		}
+	);
+
+	//Offsets into blockEigenValues for each block.
+	vector<int> blockStarts(numBlocks);
+	int blockStart = 0;
+	for(int n = 0; n < numBlocks; n++){
+		blockStarts[n] = blockStart;
+		blockStart += blockStructure->getBlockSize(n);
+	}
+
+	vector<int> infos(numBlocks, 0);
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int b = 0; b < numBlocks; b++){
+		int block = blockOrder[b];
+		//Setup zhpev to calculate...
+		char jobz = 'V';					//...eigenvalues and eigenvectors...
+		char uplo = 'U';					//...for an upper triangular...
+		int n = blockStructure->getBlockSize(block);	//...nxn-matrix.
+		//Initialize workspaces
+		complex<double> *work = new complex<double>[max(1, 2*n-1)];
+		double *rwork = new double[max(1, 3*n-2)];
+		//Solve brop
+		zhpev_(
+			&jobz,
+			&uplo,
+			&n,
+			&hamiltonian[hamiltonianOffsets[block]],
+			&blockEigenValues[blockStarts[block]],
+			&eigenVectors[eigenVectorOffsets[block]],
+			&n,
+			work,
+			rwork,
+			&infos[block]
+		);
+
+		//Delete workspaces
+		delete [] work;
+		delete [] rwork;
+	}
+
+	for(int n = 0; n < numBlocks; n++){
+		TBTKAssert(
+			infos[n] == 0,
+			"BlockDiagonalizationSolver:solve()",
+			"Diagonalization routine zhpev exited with INFO=" + to_string(infos[n]) + " for block " + to_string(n) + ".",
+			"See LAPACK documentation for zhpev for further information."
+		);
+	}
+
+	//Order the eigenstates of all blocks by eigenvalue.
+	vector<int> states(basisSize);
+	vector<int> blocks(basisSize);
+	vector<int> offsets(basisSize);
+	int counter = 0;
+	for(int block = 0; block < numBlocks; block++){
+		int blockSize = blockStructure->getBlockSize(block);
+		for(int n = 0; n < blockSize; n++){
+			states[counter] = counter;
+			blocks[counter] = block;
+			offsets[counter] = eigenVectorOffsets[block] + blockSize*n;
+			counter++;
+		}
+	}
+	stable_sort(
+		states.begin(),
+		states.end(),
+		[this](int state1, int state2){
+			return blockEigenValues[state1]
+				< blockEigenValues[state2];
+		}
+	);
+	for(int n = 0; n < basisSize; n++){
+		eigenValues[n] = blockEigenValues[states[n]];
+		stateBlocks[n] = blocks[states[n]];
+		stateOffsets[n] = offsets[states[n]];
+	}
+}
+
+};	//End of namespace TBTK
@@ -0,0 +1,265 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file ChebyshevFilterSolver.cpp
+ *
+ *  @author agent
+ */
+
+#include "ChebyshevFilterSolver.h"
+#include "DenseLinearAlgebra.h"
+#include "Streams.h"
+#include "TBTKMacros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace TBTK{
+
+ChebyshevFilterSolver::ChebyshevFilterSolver(){
+	model = NULL;
+	lowerBound = -1.;
+	upperBound = 1.;
+	subspaceSize = 0;
+	numCoefficients = 1000;
+	tolerance = 1e-8;
+	maxIterations = 100;
+
+	numStates = 0;
+	eigenValues = NULL;
+	eigenVectors = NULL;
+}
+
+ChebyshevFilterSolver::~ChebyshevFilterSolver(){
+	clear();
+}
+
+void ChebyshevFilterSolver::clear(){
+	if(eigenValues != NULL){
+		delete [] eigenValues;
+		eigenValues = NULL;
+	}
+	if(eigenVectors != NULL){
+		delete [] eigenVectors;
+		eigenVectors = NULL;
+	}
+	numStates = 0;
+}
+
+namespace{
+	//Fill the vectors with random components. A fixed seed is used to
+	//make the calculation reproducible.
+	void randomize(complex<double> *x, size_t size, mt19937 &generator){
+		uniform_real_distribution<double> distribution(-1., 1.);
+		for(size_t n = 0; n < size; n++){
+			double re = distribution(generator);
+			double im = distribution(generator);
+			x[n] = complex<double>(re, im);
+		}
+	}
+}
+
+void ChebyshevFilterSolver::run(){
+	TBTKAssert(
+		model != NULL,
+		"ChebyshevFilterSolver::run()",
+		"Model not set.",
+		"Use ChebyshevFilterSolver::setModel() to set model."
+	);
+	double scaleFactor = chebyshevSolver.getScaleFactor();
+	double energyShift = chebyshevSolver.getEnergyShift();
+	TBTKAssert(
+		energyShift - scaleFactor <= lowerBound
+		&& lowerBound < upperBound
+		&& upperBound <= energyShift + scaleFactor,
+		"ChebyshevFilterSolver::run()",
+		"Invalid energy window [" << lowerBound << ", " << upperBound << "].",
+		"The energy window has to be contained in [energyShift - scaleFactor, energyShift + scaleFactor]. Use ChebyshevFilterSolver::setEnergyWindow() and ChebyshevFilterSolver::setScaleFactor()."
+	);
+	int basisSize = model->getBasisSize();
+	TBTKAssert(
+		subspaceSize > 0 && subspaceSize <= basisSize,
+		"ChebyshevFilterSolver::run()",
+		"Invalid subspace size " << subspaceSize << ".",
+		"Use ChebyshevFilterSolver::setSubspaceSize() to set a subspace size between 1 and the basis size."
+	);
+	TBTKAssert(
+		numCoefficients > 1,
+		"ChebyshevFilterSolver::run()",
+		"numCoefficients has to be larger than 1.",
+		"Use ChebyshevFilterSolver::setNumCoefficients()."
+	);
+
+	clear();
+
+	Streams::out << "Running ChebyshevFilterSolver\n";
+	Streams::out << "\tBasis size: " << basisSize << "\n";
+	Streams::out << "\tSubspace size: " << subspaceSize << "\n";
+
+	chebyshevSolver.updateHamiltonian();
+
+	//Chebyshev coefficients for the indicator function of the scaled
+	//window, with the Jackson kernel applied to remedy Gibb's
+	//oscillations.
+	double thetaLower = acos((lowerBound - energyShift)/scaleFactor);
+	double thetaUpper = acos((upperBound - energyShift)/scaleFactor);
+	vector<double> coefficients(numCoefficients);
+	coefficients[0] = (thetaLower - thetaUpper)/M_PI;
+	for(int n = 1; n < numCoefficients; n++){
+		coefficients[n] = 2.*(sin(n*thetaLower) - sin(n*thetaUpper))
+			/(n*M_PI);
+	}
+	double kernelAngle = M_PI/(numCoefficients + 1);
+	for(int n = 0; n < numCoefficients; n++){
+		coefficients[n] *= (
+			(numCoefficients - n + 1)*cos(n*kernelAngle)
+			+ sin(n*kernelAngle)/tan(kernelAngle)
+		)/(numCoefficients + 1);
+	}
+
+	int n = basisSize;
+	size_t blockVectorSize = (size_t)n*subspaceSize;
+	vector<complex<double>> x(blockVectorSize);
+	vector<complex<double>> hx(blockVectorSize);
+	vector<complex<double>> ritzVectors(blockVectorSize);
+	vector<complex<double>> hRitzVectors(blockVectorSize);
+	vector<complex<double>> reduced(subspaceSize*subspaceSize);
+	vector<double> ritzValues(subspaceSize);
+
+	mt19937 generator(0);
+	randomize(x.data(), blockVectorSize, generator);
+
+	int previousNumInWindow = -1;
+	int iterationCounter = 0;
+	while(true){
+		if(iterationCounter%10 == 0)
+			Streams::out << " ";
+		if(iterationCounter%50 == 0)
+			Streams::out << "\n";
+		Streams::out << "." << flush;
+
+		TBTKAssert(
+			iterationCounter++ < maxIterations,
+			"ChebyshevFilterSolver::run()",
+			"Subspace iteration did not converge in " << maxIterations << " iterations.",
+			"Use ChebyshevFilterSolver::setMaxIterations() to increase the number of iterations, ChebyshevFilterSolver::setNumCoefficients() to sharpen the filter, or ChebyshevFilterSolver::setTolerance() to relax the tolerance."
+		);
+
+		filter(x.data(), subspaceSize, coefficients.data());
+		int m = DenseLinearAlgebra::orthonormalize(x.data(), n, subspaceSize);
+		chebyshevSolver.multiplyScaledHamiltonian(x.data(), hx.data(), m);
+		for(size_t c = 0; c < (size_t)n*m; c++)
+			hx[c] = scaleFactor*hx[c] + energyShift*x[c];
+
+		//Rayleigh-Ritz: diagonalize X^{\dagger}HX.
+		DenseLinearAlgebra::multiply('C', 'N', m, m, n, 1., x.data(), n, hx.data(), n, 0., reduced.data(), m);
+		DenseLinearAlgebra::diagonalizeHermitian(reduced.data(), ritzValues.data(), m);
+		DenseLinearAlgebra::multiply('N', 'N', n, m, m, 1., x.data(), n, reduced.data(), m, 0., ritzVectors.data(), n);
+		DenseLinearAlgebra::multiply('N', 'N', n, m, m, 1., hx.data(), n, reduced.data(), m, 0., hRitzVectors.data(), n);
+
+		//Check the residuals of the Ritz pairs inside the window. The
+		//number of Ritz values inside the window is required to be
+		//stable to avoid accepting a subspace in which some of the
+		//eigenstates have not yet emerged.
+		int firstInWindow = 0;
+		while(firstInWindow < m && ritzValues[firstInWindow] < lowerBound)
+			firstInWindow++;
+		int numInWindow = 0;
+		while(
+			firstInWindow + numInWindow < m
+			&& ritzValues[firstInWindow + numInWindow] <= upperBound
+		){
+			numInWindow++;
+		}
+
+		double maxResidual = 0.;
+		for(int j = firstInWindow; j < firstInWindow + numInWindow; j++){
+			double norm = 0.;
+			for(int c = 0; c < n; c++){
+				complex<double> r = hRitzVectors[(size_t)n*j + c]
+					- ritzValues[j]*ritzVectors[(size_t)n*j + c];
+				norm += real(conj(r)*r);
+			}
+			maxResidual = max(maxResidual, sqrt(norm));
+		}
+
+		if(
+			maxResidual < tolerance
+			&& numInWindow == previousNumInWindow
+		){
+			TBTKAssert(
+				numInWindow < m,
+				"ChebyshevFilterSolver::run()",
+				"The subspace is too small to contain all eigenstates in the energy window.",
+				"Use ChebyshevFilterSolver::setSubspaceSize() to increase the subspace size."
+			);
+
+			numStates = numInWindow;
+			eigenValues = new double[numStates];
+			eigenVectors = new complex<double>[(size_t)n*numStates];
+			for(int j = 0; j < numStates; j++)
+				eigenValues[j] = ritzValues[firstInWindow + j];
+			for(size_t c = 0; c < (size_t)n*numStates; c++)
+				eigenVectors[c] = ritzVectors[(size_t)n*firstInWindow + c];
+
+			break;
+		}
+		previousNumInWindow = numInWindow;
+
+		//Continue from the Ritz vectors, replacing dropped linearly
+		//dependent directions by new random vectors.
+		for(size_t c = 0; c < (size_t)n*m; c++)
+			x[c] = ritzVectors[c];
+		randomize(&x[(size_t)n*m], (size_t)n*(subspaceSize - m), generator);
+	}
+	Streams::out << "\n";
+	Streams::out << "\tEigenstates in window: " << numStates << "\n";
+}
+
+void ChebyshevFilterSolver::filter(
+	complex<double> *x,
+	int numVectors,
+	const double *coefficients
+){
+	size_t size = (size_t)model->getBasisSize()*numVectors;
+
+	//Use the recursion T_{k+1}(H) = 2HT_{k}(H) - T_{k-1}(H) on the whole
+	//block and accumulate the filtered vectors in x.
+	vector<complex<double>> jIn1(x, x + size);
+	vector<complex<double>> jIn2(size);
+	vector<complex<double>> jResult(size);
+
+	chebyshevSolver.multiplyScaledHamiltonian(jIn1.data(), jIn2.data(), numVectors);
+	jIn1.swap(jIn2);
+	for(size_t c = 0; c < size; c++)
+		x[c] = coefficients[0]*jIn2[c] + coefficients[1]*jIn1[c];
+
+	for(int k = 2; k < numCoefficients; k++){
+		chebyshevSolver.multiplyScaledHamiltonian(jIn1.data(), jResult.data(), numVectors);
+		for(size_t c = 0; c < size; c++){
+			jResult[c] = 2.*jResult[c] - jIn2[c];
+			x[c] += coefficients[k]*jResult[c];
+		}
+
+		jIn2.swap(jIn1);
+		jIn1.swap(jResult);
+	}
+}
+
+};	//End of namespace TBTK
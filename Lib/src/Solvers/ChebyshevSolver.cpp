@@ -24,15 +24,526 @@
 #include "TBTKMacros.h"
 #include "Streams.h"
 
+#include <algorithm>
 #include <math.h>
 #include <iostream>
+#include <limits>
+#include <random>
 
 using namespace std;
 
 namespace TBTK{
 
+//Lapack function for diagonalization of a real symmetric tridiagonal matrix.
+extern "C" void dstev_(
+	char *jobz,	//'N' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+	int *n,		//Matrix size
+	double *d,	//Diagonal elements. Contains the eigenvalues in accending order on exit
+	double *e,	//Subdiagonal elements in the first n-1 elements. Destroyed on exit
+	double *z,	//Eigenvectors if jobz = 'V'
+	int *ldz,	//Leading dimension of z
+	double *work,	//Workspace of size max(1, 2*n-2)
+	int *info);	//0 = successful, <0 = -info value was illegal, >0 = failed to converge.
+
 namespace{
 	const complex<double> i(0, 1);
+
+	//Matrix elements in the precision of the Chebyshev vectors. The
+	//matrix elements are used directly in double precision, and
+	//converted otherwise. The converted matrix elements are deleted by
+	//the caller.
+	const complex<double>* convertValues(
+		const complex<double> *values,
+		int numValues,
+		complex<double> *&convertedValues
+	){
+		convertedValues = NULL;
+
+		return values;
+	}
+
+	const complex<float>* convertValues(
+		const complex<double> *values,
+		int numValues,
+		complex<float> *&convertedValues
+	){
+		convertedValues = new complex<float>[numValues];
+		#pragma omp parallel for
+		for(int n = 0; n < numValues; n++)
+			convertedValues[n] = complex<float>(values[n]);
+
+		return convertedValues;
+	}
+
+	//Range of chunks [begin, end) on SELL format, or rows on CSR format,
+	//to be processed by the given thread, chosen such that the threads
+	//process about the same number of matrix elements.
+	void getChunkRange(
+		const int *chunkPointers,
+		int numChunks,
+		int numThreads,
+		int thread,
+		int &begin,
+		int &end
+	){
+		long numElements = chunkPointers[numChunks];
+		begin = lower_bound(
+			chunkPointers,
+			chunkPointers + numChunks,
+			numElements*thread/numThreads
+		) - chunkPointers;
+		if(thread == numThreads-1){
+			end = numChunks;
+		}
+		else{
+			end = lower_bound(
+				chunkPointers,
+				chunkPointers + numChunks,
+				numElements*(thread+1)/numThreads
+			) - chunkPointers;
+		}
+	}
+
+	//Calculates the rows in the chunks [begin, end) of
+	//y = d*(m(H - c)x1 - d*x2), where H is on SELL format, m is the
+	//multiplier, c is the shift, and d is the damping mask, or one if
+	//dampingT is NULL. The rows of a
+	//chunk are processed in SIMD lanes, with the real and imaginary parts
+	//accumulated separately. The components of y for the rows in
+	//toBasisIndices are written to the coefficients as the rows are
+	//calculated. For CHUNK_SIZE > 0, the chunk size is known at compile
+	//time, which allows the sums to be kept in registers. Otherwise the
+	//sums are accumulated in sumRealBuffer and sumImagBuffer, which have
+	//chunkSize elements.
+	template<typename T, int CHUNK_SIZE>
+	void calculateChebyshevChunks(
+		int begin,
+		int end,
+		int chunkSize,
+		const int *chunkPointers,
+		const int *chunkLengths,
+		const int *rowPermutation,
+		const int *columnIndices,
+		const complex<T> *values,
+		T multiplier,
+		T shift,
+		const complex<T> *dampingT,
+		const complex<T> *x1,
+		const complex<T> *x2,
+		complex<T> *y,
+		T *sumRealBuffer,
+		T *sumImagBuffer,
+		const int *firstToIndex,
+		const int *nextToIndex,
+		complex<double> *coefficients,
+		int numCoefficients,
+		int n
+	){
+		if(CHUNK_SIZE > 0)
+			chunkSize = CHUNK_SIZE;
+		T sumRealLocal[CHUNK_SIZE > 0 ? CHUNK_SIZE : 1];
+		T sumImagLocal[CHUNK_SIZE > 0 ? CHUNK_SIZE : 1];
+		T *sumReal = CHUNK_SIZE > 0 ? sumRealLocal : sumRealBuffer;
+		T *sumImag = CHUNK_SIZE > 0 ? sumImagLocal : sumImagBuffer;
+
+		const T flushLimit = numeric_limits<T>::min()
+			/numeric_limits<T>::epsilon();
+
+		const T *v = reinterpret_cast<const T*>(values);
+		const T *x = reinterpret_cast<const T*>(x1);
+		for(int chunk = begin; chunk < end; chunk++){
+			for(int r = 0; r < chunkSize; r++){
+				sumReal[r] = 0;
+				sumImag[r] = 0;
+			}
+			for(int m = 0; m < chunkLengths[chunk]; m++){
+				int offset = chunkPointers[chunk] + m*chunkSize;
+				#pragma omp simd
+				for(int r = 0; r < chunkSize; r++){
+					int e = offset + r;
+					int c = columnIndices[e];
+					sumReal[r] += v[2*e]*x[2*c] - v[2*e+1]*x[2*c+1];
+					sumImag[r] += v[2*e]*x[2*c+1] + v[2*e+1]*x[2*c];
+				}
+			}
+
+			for(int r = 0; r < chunkSize; r++){
+				int row = rowPermutation[chunk*chunkSize + r];
+				if(row == -1)
+					continue;
+
+				complex<T> result(
+					multiplier*(sumReal[r] - shift*x1[row].real()),
+					multiplier*(sumImag[r] - shift*x1[row].imag())
+				);
+				if(dampingT == NULL){
+					result -= x2[row];
+				}
+				else{
+					result = dampingT[row]*(
+						result - dampingT[row]*x2[row]
+					);
+				}
+
+				//Components outside of the front of the expansion
+				//decay rapidly and would otherwise pass through the
+				//denormal range, where arithmetic is very slow. They
+				//are far below the precision of the vector and are
+				//flushed to zero.
+				if(abs(result.real()) < flushLimit)
+					result.real(0);
+				if(abs(result.imag()) < flushLimit)
+					result.imag(0);
+				y[row] = result;
+
+				for(
+					int c = firstToIndex[row];
+					c != -1;
+					c = nextToIndex[c]
+				){
+					coefficients[c*numCoefficients + n]
+						= complex<double>(y[row]);
+				}
+			}
+		}
+	}
+
+	//Buffers for the contributions that the Hermitian conjugates of the
+	//stored matrix elements make to rows of other threads when only the
+	//lower triangle of H is stored. The thread that processes the rows
+	//[begin, end) adds the contributions to the rows [scatterBegin, begin)
+	//to its buffer, where scatterBegin is the smallest column index in its
+	//rows. The rows are added to the rows of the other threads once all
+	//threads are done with their own rows.
+	template<typename T>
+	struct ScatterBuffers{
+		vector<vector<T>> buffers;
+		vector<int> rowBegins;
+		vector<int> scatterBegins;
+
+		ScatterBuffers(int maxThreads) :
+			buffers(maxThreads),
+			rowBegins(maxThreads),
+			scatterBegins(maxThreads)
+		{
+		}
+
+		//Sets up the buffer of the given thread for the rows
+		//[begin, end) and a block of blockSize vectors. Has to be
+		//called by each thread before the rows are calculated.
+		void prepare(
+			int thread,
+			int begin,
+			int end,
+			int blockSize,
+			const int *rowPointers,
+			const int *columnIndices
+		){
+			int scatterBegin = begin;
+			for(int row = begin; row < end; row++){
+				if(rowPointers[row] != rowPointers[row+1]){
+					scatterBegin = min(
+						scatterBegin,
+						columnIndices[rowPointers[row]]
+					);
+				}
+			}
+			rowBegins[thread] = begin;
+			scatterBegins[thread] = scatterBegin;
+			buffers[thread].resize(
+				2*(size_t)blockSize*(begin - scatterBegin)
+			);
+		}
+	};
+
+	//Calculates row of Y = d*(m(H - c)X1 - d*X2) given that the row of y
+	//contains the row of HX1. See calculateChebyshevBlockRows().
+	template<typename T, int BLOCK_SIZE>
+	inline void finishChebyshevBlockRow(
+		int row,
+		int blockSize,
+		T multiplier,
+		T shift,
+		const complex<T> *dampingT,
+		const T *x1,
+		const T *x2,
+		T *y,
+		const int *firstToIndex,
+		const int *nextToIndex,
+		complex<double> *coefficients,
+		int numToIndices,
+		int numCoefficients,
+		int n,
+		double *momentSums
+	){
+		if(BLOCK_SIZE > 0)
+			blockSize = BLOCK_SIZE;
+
+		const T flushLimit = numeric_limits<T>::min()
+			/numeric_limits<T>::epsilon();
+
+		const T *x1Real = &x1[2*blockSize*row];
+		const T *x1Imag = x1Real + blockSize;
+		const T *x2Real = &x2[2*blockSize*row];
+		const T *x2Imag = x2Real + blockSize;
+		T *yReal = &y[2*blockSize*row];
+		T *yImag = yReal + blockSize;
+		if(dampingT == NULL){
+			#pragma omp simd
+			for(int k = 0; k < blockSize; k++){
+				T rReal = multiplier*(yReal[k] - shift*x1Real[k])
+					- x2Real[k];
+				T rImag = multiplier*(yImag[k] - shift*x1Imag[k])
+					- x2Imag[k];
+				yReal[k] = abs(rReal) < flushLimit ? 0 : rReal;
+				yImag[k] = abs(rImag) < flushLimit ? 0 : rImag;
+			}
+		}
+		else{
+			T dReal = dampingT[row].real();
+			T dImag = dampingT[row].imag();
+			#pragma omp simd
+			for(int k = 0; k < blockSize; k++){
+				T sReal = multiplier*(yReal[k] - shift*x1Real[k])
+					- (dReal*x2Real[k] - dImag*x2Imag[k]);
+				T sImag = multiplier*(yImag[k] - shift*x1Imag[k])
+					- (dReal*x2Imag[k] + dImag*x2Real[k]);
+				T rReal = dReal*sReal - dImag*sImag;
+				T rImag = dReal*sImag + dImag*sReal;
+				yReal[k] = abs(rReal) < flushLimit ? 0 : rReal;
+				yImag[k] = abs(rImag) < flushLimit ? 0 : rImag;
+			}
+		}
+
+		if(momentSums != NULL){
+			for(int k = 0; k < blockSize; k++){
+				momentSums[k] += (double)x1Real[k]*x1Real[k]
+					+ (double)x1Imag[k]*x1Imag[k];
+				momentSums[blockSize + k]
+					+= (double)yReal[k]*x1Real[k]
+					+ (double)yImag[k]*x1Imag[k];
+			}
+		}
+
+		if(firstToIndex == NULL)
+			return;
+		for(
+			int c = firstToIndex[row];
+			c != -1;
+			c = nextToIndex[c]
+		){
+			for(int k = 0; k < blockSize; k++){
+				coefficients[
+					(k*numToIndices + c)*numCoefficients + n
+				] = complex<double>(yReal[k], yImag[k]);
+			}
+		}
+	}
+
+	//Calculates the rows [begin, end) of Y = d*(m(H - c)X1 - d*X2) for a
+	//block of blockSize vectors, where H is on CSR format, m is the
+	//multiplier, c is the shift, and d is the damping mask, or one if
+	//dampingT is NULL. The block
+	//vectors are stored row by row, with the real parts of the blockSize
+	//components of a row followed by the imaginary parts, such that each
+	//matrix element is loaded once and applied to all vectors in SIMD
+	//lanes. The components of Y for the rows in toBasisIndices are
+	//written to the coefficients of each vector as the rows are
+	//calculated, unless firstToIndex is NULL. If momentSums is not NULL,
+	//the products <X1|X1> and Re<Y|X1> of the rows are added to its first
+	//and last blockSize elements, respectively. For BLOCK_SIZE > 0, the
+	//block size is known at compile time, which allows the sums to be
+	//kept in registers. Otherwise the sums are accumulated in
+	//sumRealBuffer and sumImagBuffer, which have blockSize elements.
+	//
+	//If scatterBuffers is not NULL, the CSR format only contains the
+	//lower triangle of H, and each off-diagonal element H_ij is also
+	//applied as H_ji = conj(H_ij) to row j. The rows are then completed
+	//after all threads have processed their rows, which requires every
+	//thread in the team to call the function, and the buffers to be
+	//prepared for the rows [begin, end).
+	template<typename T, int BLOCK_SIZE>
+	void calculateChebyshevBlockRows(
+		int begin,
+		int end,
+		int blockSize,
+		const int *rowPointers,
+		const int *columnIndices,
+		const complex<T> *values,
+		T multiplier,
+		T shift,
+		const complex<T> *dampingT,
+		const T *x1,
+		const T *x2,
+		T *y,
+		T *sumRealBuffer,
+		T *sumImagBuffer,
+		const int *firstToIndex,
+		const int *nextToIndex,
+		complex<double> *coefficients,
+		int numToIndices,
+		int numCoefficients,
+		int n,
+		double *momentSums,
+		ScatterBuffers<T> *scatterBuffers
+	){
+		if(BLOCK_SIZE > 0)
+			blockSize = BLOCK_SIZE;
+		T sumRealLocal[BLOCK_SIZE > 0 ? BLOCK_SIZE : 1];
+		T sumImagLocal[BLOCK_SIZE > 0 ? BLOCK_SIZE : 1];
+		T *sumReal = BLOCK_SIZE > 0 ? sumRealLocal : sumRealBuffer;
+		T *sumImag = BLOCK_SIZE > 0 ? sumImagLocal : sumImagBuffer;
+
+		const T *v = reinterpret_cast<const T*>(values);
+		if(scatterBuffers == NULL){
+			for(int row = begin; row < end; row++){
+				for(int k = 0; k < blockSize; k++){
+					sumReal[k] = 0;
+					sumImag[k] = 0;
+				}
+				for(
+					int e = rowPointers[row];
+					e < rowPointers[row+1];
+					e++
+				){
+					T vReal = v[2*e];
+					T vImag = v[2*e+1];
+					const T *xReal
+						= &x1[2*blockSize*columnIndices[e]];
+					const T *xImag = xReal + blockSize;
+					#pragma omp simd
+					for(int k = 0; k < blockSize; k++){
+						sumReal[k] += vReal*xReal[k]
+							- vImag*xImag[k];
+						sumImag[k] += vReal*xImag[k]
+							+ vImag*xReal[k];
+					}
+				}
+
+				//The sums are stored in y before the remaining
+				//terms are added, which allows the compiler to
+				//keep the sums in registers in the loop above.
+				T *yReal = &y[2*blockSize*row];
+				T *yImag = yReal + blockSize;
+				for(int k = 0; k < blockSize; k++){
+					yReal[k] = sumReal[k];
+					yImag[k] = sumImag[k];
+				}
+				finishChebyshevBlockRow<T, BLOCK_SIZE>(
+					row,
+					blockSize,
+					multiplier,
+					shift,
+					dampingT,
+					x1,
+					x2,
+					y,
+					firstToIndex,
+					nextToIndex,
+					coefficients,
+					numToIndices,
+					numCoefficients,
+					n,
+					momentSums
+				);
+			}
+
+			return;
+		}
+
+		//Every column index of row r is smaller than or equal to r, so
+		//the rows of y have been initialized by the time the Hermitian
+		//conjugates of later rows are added to them.
+		int thread = omp_get_thread_num();
+		int numThreads = omp_get_num_threads();
+		int scatterBegin = scatterBuffers->scatterBegins[thread];
+		T *buffer = scatterBuffers->buffers[thread].data();
+		fill(
+			buffer,
+			buffer + scatterBuffers->buffers[thread].size(),
+			0
+		);
+		for(int row = begin; row < end; row++){
+			for(int k = 0; k < blockSize; k++){
+				sumReal[k] = 0;
+				sumImag[k] = 0;
+			}
+			const T *xRowReal = &x1[2*blockSize*row];
+			const T *xRowImag = xRowReal + blockSize;
+			for(int e = rowPointers[row]; e < rowPointers[row+1]; e++){
+				int column = columnIndices[e];
+				T vReal = v[2*e];
+				T vImag = v[2*e+1];
+				const T *xReal = &x1[2*blockSize*column];
+				const T *xImag = xReal + blockSize;
+				#pragma omp simd
+				for(int k = 0; k < blockSize; k++){
+					sumReal[k] += vReal*xReal[k] - vImag*xImag[k];
+					sumImag[k] += vReal*xImag[k] + vImag*xReal[k];
+				}
+				if(column == row)
+					continue;
+
+				T *targetReal = column >= begin
+					? &y[2*blockSize*column]
+					: &buffer[2*blockSize*(column - scatterBegin)];
+				T *targetImag = targetReal + blockSize;
+				#pragma omp simd
+				for(int k = 0; k < blockSize; k++){
+					targetReal[k] += vReal*xRowReal[k]
+						+ vImag*xRowImag[k];
+					targetImag[k] += vReal*xRowImag[k]
+						- vImag*xRowReal[k];
+				}
+			}
+
+			T *yReal = &y[2*blockSize*row];
+			T *yImag = yReal + blockSize;
+			for(int k = 0; k < blockSize; k++){
+				yReal[k] = sumReal[k];
+				yImag[k] = sumImag[k];
+			}
+		}
+
+		//Only threads with later rows add contributions to the rows of
+		//this thread. The buffers are added in thread order, which makes
+		//the result independent of the timing of the threads.
+		#pragma omp barrier
+		for(int t = thread+1; t < numThreads; t++){
+			int first = max(begin, scatterBuffers->scatterBegins[t]);
+			int last = min(end, scatterBuffers->rowBegins[t]);
+			const T *source = scatterBuffers->buffers[t].data();
+			for(int row = first; row < last; row++){
+				const T *sourceRow = &source[
+					2*blockSize*(row - scatterBuffers->scatterBegins[t])
+				];
+				T *yRow = &y[2*blockSize*row];
+				#pragma omp simd
+				for(int k = 0; k < 2*blockSize; k++)
+					yRow[k] += sourceRow[k];
+			}
+		}
+
+		for(int row = begin; row < end; row++){
+			finishChebyshevBlockRow<T, BLOCK_SIZE>(
+				row,
+				blockSize,
+				multiplier,
+				shift,
+				dampingT,
+				x1,
+				x2,
+				y,
+				firstToIndex,
+				nextToIndex,
+				coefficients,
+				numToIndices,
+				numCoefficients,
+				n,
+				momentSums
+			);
+		}
+	}
 }
 
 /*int ChebyshevSolver::numChebyshevSolvers = 0;
@@ -48,8 +559,12 @@ ChebyshevSolver::StaticConstructor::StaticConstructor(){
 ChebyshevSolver::ChebyshevSolver(){
 	model = NULL;
 	scaleFactor = 1.;
+	energyShift = 0.;
 	damping = NULL;
+	singlePrecision = false;
+	blockSize = 8;
 	generatingFunctionLookupTable = NULL;
+	generatingFunctionLookupTableSingle = NULL;
 	generatingFunctionLookupTable_device = NULL;
 	lookupTableNumCoefficients = 0;
 	lookupTableResolution = 0;
@@ -67,12 +582,7 @@ ChebyshevSolver::ChebyshevSolver(){
 }
 
 ChebyshevSolver::~ChebyshevSolver(){
-	if(generatingFunctionLookupTable != NULL){
-		for(int n = 0; n < lookupTableNumCoefficients; n++)
-			delete [] generatingFunctionLookupTable[n];
-
-		delete [] generatingFunctionLookupTable;
-	}
+	deleteLookupTable();
 
 /*	omp_set_lock(&busyDevicesLock);
 	#pragma omp flush
@@ -90,153 +600,921 @@ void ChebyshevSolver::setModel(Model *model){
 	model->getAmplitudeSet()->sort();	//Required for GPU evaluation
 }
 
-void ChebyshevSolver::calculateCoefficients(
-	Index to,
-	Index from,
-	complex<double> *coefficients,
-	int numCoefficients,
-	double broadening
-){
+void ChebyshevSolver::updateHamiltonian(){
 	TBTKAssert(
 		model != NULL,
-		"ChebyshevSolver::calculateCoefficients()",
+		"ChebyshevSolver::updateHamiltonian()",
 		"Model not set.",
 		"Use ChebyshevSolver::setModel() to set model."
 	);
+
+	//Constructing the SELL format also constructs the CSR format. With
+	//Hermitian storage, the kernels work on the stored triangle on CSR
+	//format, and the SELL format is not constructed.
+	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
+	if(!hamiltonianIsConstructed()){
+		if(amplitudeSet->getHermitianStorage())
+			model->constructCSR();
+		else
+			model->constructSELL();
+	}
+	else{
+		amplitudeSet->reconstructCOO();
+	}
+}
+
+bool ChebyshevSolver::hamiltonianIsConstructed() const{
+	const AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
+	if(amplitudeSet->getHermitianStorage())
+		return amplitudeSet->getCSRRowPointers() != NULL;
+	else
+		return amplitudeSet->getSELLChunkPointers() != NULL;
+}
+
+void ChebyshevSolver::estimateSpectralBounds(
+	double &lowerBound,
+	double &upperBound,
+	int numLanczosSteps
+){
 	TBTKAssert(
-		scaleFactor > 0,
-		"ChebyshevSolver::calculateCoefficients()",
-		"Scale factor must be larger than zero.",
-		"Use ChebyshevSolver::setScaleFactor() to set scale factor."
+		model != NULL,
+		"ChebyshevSolver::estimateSpectralBounds()",
+		"Model not set.",
+		"Use ChebyshevSolver::setModel() to set model."
 	);
 	TBTKAssert(
-		numCoefficients > 0,
-		"ChebyshevSolver::calculateCoefficients()",
-		"numCoefficients has to be larger than 0.",
+		numLanczosSteps >= 0,
+		"ChebyshevSolver::estimateSpectralBounds()",
+		"numLanczosSteps cannot be negative.",
 		""
 	);
 
+	updateHamiltonian();
 	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
-
-	int fromBasisIndex = amplitudeSet->getBasisIndex(from);
-	int toBasisIndex = amplitudeSet->getBasisIndex(to);
+	int basisSize = amplitudeSet->getBasisSize();
+
+	//Gershgorin bounds. Every eigenvalue lies within the distance
+	//sum_{j != i}|H_ij| from H_ii for some row i. With Hermitian storage
+	//the COO format only contains one triangle, and each off-diagonal
+	//element also contributes to the row of its Hermitian conjugate.
+	int numMatrixElements = amplitudeSet->getNumMatrixElements();
+	const int *cooRowIndices = amplitudeSet->getCOORowIndices();
+	const int *cooColIndices = amplitudeSet->getCOOColIndices();
+	const complex<double> *cooValues = amplitudeSet->getCOOValues();
+	bool hermitianStorage = amplitudeSet->getHermitianStorage();
+	vector<double> centers(basisSize, 0.);
+	vector<double> radii(basisSize, 0.);
+	for(int n = 0; n < numMatrixElements; n++){
+		if(cooRowIndices[n] == cooColIndices[n]){
+			centers[cooRowIndices[n]] += real(cooValues[n]);
+		}
+		else{
+			radii[cooRowIndices[n]] += abs(cooValues[n]);
+			if(hermitianStorage)
+				radii[cooColIndices[n]] += abs(cooValues[n]);
+		}
+	}
+	lowerBound = numeric_limits<double>::max();
+	upperBound = -numeric_limits<double>::max();
+	for(int n = 0; n < basisSize; n++){
+		lowerBound = min(lowerBound, centers[n] - radii[n]);
+		upperBound = max(upperBound, centers[n] + radii[n]);
+	}
 
 	if(isTalkative){
-		Streams::out << "ChebyshevSolver::calculateCoefficients\n";
-		Streams::out << "\tFrom Index: " << fromBasisIndex << "\n";
-		Streams::out << "\tTo Index: " << toBasisIndex << "\n";
-		Streams::out << "\tBasis size: " << amplitudeSet->getBasisSize() << "\n";
-		Streams::out << "\tProgress (100 coefficients per dot): ";
+		Streams::out << "ChebyshevSolver::estimateSpectralBounds\n";
+		Streams::out << "\tGershgorin bounds: [" << lowerBound << ", " << upperBound << "]\n";
 	}
 
-	complex<double> *jIn1 = new complex<double>[amplitudeSet->getBasisSize()];
-	complex<double> *jIn2 = new complex<double>[amplitudeSet->getBasisSize()];
-	complex<double> *jResult = new complex<double>[amplitudeSet->getBasisSize()];
-	complex<double> *jTemp = NULL;
-	for(int n = 0; n < amplitudeSet->getBasisSize(); n++){
-		jIn1[n] = 0.;
-		jIn2[n] = 0.;
-		jResult[n] = 0.;
+	//Lanczos iteration from a random state. The extreme eigenvalues of
+	//the tridiagonal matrix converge to the extreme eigenvalues of the
+	//Hamiltonian from the inside within a few steps, and are pushed
+	//outwards by the residual norm of the corresponding Ritz vectors.
+	//A fixed seed is used to make the bounds reproducible.
+	int numSteps = min(numLanczosSteps, basisSize);
+	if(numSteps == 0)
+		return;
+
+	//The Hamiltonian is multiplied by the kernel of the block recursion
+	//with a single vector, whose layout coincides with that of a complex
+	//vector.
+	const int *rowPointers = amplitudeSet->getCSRRowPointers();
+	const int *columnIndices = amplitudeSet->getCSRColIndices();
+	const complex<double> *values = amplitudeSet->getCSRValues();
+	ScatterBuffers<double> scatterBuffers(omp_get_max_threads());
+
+	vector<complex<double>> v(basisSize);
+	vector<complex<double>> vPrevious(basisSize, 0.);
+	vector<complex<double>> w(basisSize);
+	vector<complex<double>> zero(basisSize, 0.);
+	mt19937 generator(0);
+	uniform_real_distribution<double> distribution(-1., 1.);
+	double vNorm = 0.;
+	for(int n = 0; n < basisSize; n++){
+		v[n] = complex<double>(
+			distribution(generator),
+			distribution(generator)
+		);
+		vNorm += norm(v[n]);
 	}
-	//Set up initial state (|j0>)
-	jIn1[fromBasisIndex] = 1.;
+	vNorm = sqrt(vNorm);
+	for(int n = 0; n < basisSize; n++)
+		v[n] /= vNorm;
+
+	const double breakdownLimit = numeric_limits<double>::epsilon()
+		*max(abs(lowerBound), abs(upperBound));
+	vector<double> alpha;
+	vector<double> beta;
+	for(int step = 0; step < numSteps; step++){
+		#pragma omp parallel
+		{
+			int thread = omp_get_thread_num();
+			int begin, end;
+			getChunkRange(
+				rowPointers,
+				basisSize,
+				omp_get_num_threads(),
+				thread,
+				begin,
+				end
+			);
+			if(hermitianStorage){
+				scatterBuffers.prepare(
+					thread,
+					begin,
+					end,
+					1,
+					rowPointers,
+					columnIndices
+				);
+			}
+			calculateChebyshevBlockRows<double, 1>(
+				begin,
+				end,
+				1,
+				rowPointers,
+				columnIndices,
+				values,
+				1.,
+				0.,
+				NULL,
+				reinterpret_cast<const double*>(v.data()),
+				reinterpret_cast<const double*>(zero.data()),
+				reinterpret_cast<double*>(w.data()),
+				NULL,
+				NULL,
+				NULL,
+				NULL,
+				NULL,
+				0,
+				0,
+				0,
+				NULL,
+				hermitianStorage ? &scatterBuffers : NULL
+			);
+		}
 
-	coefficients[0] = jIn1[toBasisIndex];
+		double a = 0.;
+		for(int n = 0; n < basisSize; n++)
+			a += real(conj(v[n])*w[n]);
+		double bPrevious = step == 0 ? 0. : beta.back();
+		double b = 0.;
+		for(int n = 0; n < basisSize; n++){
+			w[n] -= a*v[n] + bPrevious*vPrevious[n];
+			b += norm(w[n]);
+		}
+		b = sqrt(b);
+		alpha.push_back(a);
+		beta.push_back(b);
 
-	//Generate a fixed hopping amplitude and inde list, for speed.
-	AmplitudeSet::Iterator it = amplitudeSet->getIterator();
-	const HoppingAmplitude *ha;
-	int numHoppingAmplitudes = 0;
-	while((ha = it.getHA())){
-		numHoppingAmplitudes++;
-		it.searchNextHA();
+		//The Krylov space is invariant and the Ritz values are exact.
+		if(b <= breakdownLimit)
+			break;
+
+		for(int n = 0; n < basisSize; n++){
+			vPrevious[n] = v[n];
+			v[n] = w[n]/b;
+		}
+	}
+
+	//Setup LAPACK to calculate...
+	char jobz = 'V';		//...eigenvalues and eigenvectors...
+	int k = alpha.size();		//...of the kxk tridiagonal matrix.
+	vector<double> d = alpha;
+	vector<double> e(beta.begin(), beta.begin() + k - 1);
+	e.push_back(0.);
+	vector<double> z(k*k);
+	vector<double> work(max(1, 2*k - 2));
+	int info;
+	dstev_(&jobz, &k, d.data(), e.data(), z.data(), &k, work.data(), &info);
+
+	//The Gershgorin bounds are kept if the tridiagonal matrix could not
+	//be diagonalized.
+	if(info != 0){
+		if(isTalkative)
+			Streams::out << "\tLanczos bounds unavailable, dstev exited with INFO=" << info << ".\n";
+		return;
 	}
 
-	complex<double> *hoppingAmplitudes = new complex<double>[numHoppingAmplitudes];
-	int *toIndices = new int[numHoppingAmplitudes];
-	int *fromIndices = new int[numHoppingAmplitudes];
-	it.reset();
-	int counter = 0;
-	while((ha = it.getHA())){
-		toIndices[counter] = amplitudeSet->getBasisIndex(ha->toIndex);
-		fromIndices[counter] = amplitudeSet->getBasisIndex(ha->fromIndex);
-		hoppingAmplitudes[counter] = ha->getAmplitude()/scaleFactor;
+	double residual = beta.back();
+	double lanczosLowerBound = d[0] - residual*abs(z[k-1]);
+	double lanczosUpperBound = d[k-1] + residual*abs(z[(k-1) + k*(k-1)]);
+	lowerBound = max(lowerBound, lanczosLowerBound);
+	upperBound = min(upperBound, lanczosUpperBound);
 
-		it.searchNextHA();
-		counter++;
+	if(isTalkative){
+		Streams::out << "\tLanczos bounds (" << k << " steps): [" << lanczosLowerBound << ", " << lanczosUpperBound << "]\n";
 	}
+}
 
-	//Calculate |j1>
-	for(int c = 0; c < amplitudeSet->getBasisSize(); c++)
-		jResult[c] = 0.;
-	for(int n = 0; n < numHoppingAmplitudes; n++){
-		int from = fromIndices[n];
-		int to = toIndices[n];
+void ChebyshevSolver::estimateScaleFactor(
+	int numLanczosSteps,
+	double safetyMargin,
+	bool centerSpectrum
+){
+	TBTKAssert(
+		safetyMargin >= 0,
+		"ChebyshevSolver::estimateScaleFactor()",
+		"safetyMargin cannot be negative.",
+		""
+	);
+
+	double lowerBound, upperBound;
+	estimateSpectralBounds(lowerBound, upperBound, numLanczosSteps);
 
-		jResult[to] += hoppingAmplitudes[n]*jIn1[from];
+	if(centerSpectrum){
+		energyShift = (lowerBound + upperBound)/2.;
+		scaleFactor = (1 + safetyMargin)*(upperBound - lowerBound)/2.;
+	}
+	else{
+		energyShift = 0.;
+		scaleFactor = (1 + safetyMargin)*max(
+			abs(lowerBound),
+			abs(upperBound)
+		);
 	}
 
-	if(damping != NULL){
-		for(int n = 0; n < amplitudeSet->getBasisSize(); n++)
-			jResult[n] *= damping[n];
+	//A spectrum consisting of a single energy has no natural scale.
+	if(scaleFactor == 0)
+		scaleFactor = 1.;
+
+	if(isTalkative){
+		Streams::out << "\tScale factor: " << scaleFactor << "\n";
+		Streams::out << "\tEnergy shift: " << energyShift << "\n";
 	}
+}
 
-	jTemp = jIn2;
-	jIn2 = jIn1;
-	jIn1 = jResult;
-	jResult = jTemp;
+template<typename T>
+void ChebyshevSolver::calculateCoefficientsCPU(
+	const vector<int> &toBasisIndices,
+	int fromBasisIndex,
+	complex<double> *coefficients,
+	int numCoefficients
+){
+	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
+	int basisSize = amplitudeSet->getBasisSize();
+	int numToIndices = toBasisIndices.size();
+
+	//The recursion is performed on the SELL format. With Hermitian
+	//storage, the SELL format is not constructed, and the recursion is
+	//instead performed on the stored triangle on CSR format as a block
+	//with a single vector. See updateHamiltonian().
+	if(amplitudeSet->getHermitianStorage()){
+		calculateCoefficientsBlockCPU<T>(
+			toBasisIndices,
+			&fromBasisIndex,
+			1,
+			coefficients,
+			numCoefficients
+		);
 
-	coefficients[1] = jIn1[toBasisIndex];
+		return;
+	}
 
-	//Multiply hopping amplitudes by factor two, to spped up calculation of 2H|j(n-1)> - |j(n-2)>.
-	for(int n = 0; n < numHoppingAmplitudes; n++)
-		hoppingAmplitudes[n] *= 2.;
+	int chunkSize = amplitudeSet->getSELLChunkSize();
+	int numChunks = amplitudeSet->getSELLNumChunks();
+	const int *chunkPointers = amplitudeSet->getSELLChunkPointers();
+	const int *chunkLengths = amplitudeSet->getSELLChunkLengths();
+	const int *rowPermutation = amplitudeSet->getSELLRowPermutation();
+	const int *columnIndices = amplitudeSet->getSELLColIndices();
+	complex<T> *convertedValues;
+	const complex<T> *values = convertValues(
+		amplitudeSet->getSELLValues(),
+		chunkPointers[numChunks],
+		convertedValues
+	);
 
-	//Iteratively calculate |jn> and corresponding Chebyshev coefficients.
-	for(int n = 2; n < numCoefficients; n++){
-		for(int c = 0; c < amplitudeSet->getBasisSize(); c++)
-			jResult[c] = -jIn2[c];
+	//Damping mask converted to the precision of the vectors.
+	complex<T> *dampingT = NULL;
+	if(damping != NULL){
+		dampingT = new complex<T>[basisSize];
+		for(int n = 0; n < basisSize; n++)
+			dampingT[n] = complex<T>(damping[n]);
+	}
+
+	//Coefficients are extracted for the rows in toBasisIndices while the
+	//rows are calculated. The to-indices of each row are stored as a
+	//linked list, since the same row can occur several times.
+	int *firstToIndex = new int[basisSize];
+	int *nextToIndex = new int[numToIndices];
+	for(int n = 0; n < basisSize; n++)
+		firstToIndex[n] = -1;
+	for(int n = numToIndices-1; n >= 0; n--){
+		nextToIndex[n] = firstToIndex[toBasisIndices[n]];
+		firstToIndex[toBasisIndices[n]] = n;
+	}
+
+	complex<T> *jIn1 = new complex<T>[basisSize];
+	complex<T> *jIn2 = new complex<T>[basisSize];
+	complex<T> *jResult = new complex<T>[basisSize];
+
+	//The chunk sizes that are powers of two up to 16 have specialized
+	//kernels.
+	auto calculateChunks = &calculateChebyshevChunks<T, 0>;
+	switch(chunkSize){
+	case 4:
+		calculateChunks = &calculateChebyshevChunks<T, 4>;
+		break;
+	case 8:
+		calculateChunks = &calculateChebyshevChunks<T, 8>;
+		break;
+	case 16:
+		calculateChunks = &calculateChebyshevChunks<T, 16>;
+		break;
+	}
 
-		if(damping != NULL){
-			for(int c = 0; c < amplitudeSet->getBasisSize(); c++)
-				jResult[c] *= damping[c];
+	//Each thread calculates a range of chunks with about the same number
+	//of matrix elements, and swaps its own copies of the vector pointers.
+	//|j1> = (H - c)|j0>/s, while |jn> = 2(H - c)|j(n-1)>/s - |j(n-2)> for
+	//n > 1, where c is the energy shift.
+	//Since |j(-1)> = 0, the same expression can be used for n = 1 with
+	//the factor two replaced by one. When called from a parallel region,
+	//the calling thread performs the whole calculation and does not print
+	//its progress.
+	bool printProgress = isTalkative && !omp_in_parallel();
+	#pragma omp parallel if(!omp_in_parallel())
+	{
+		int begin, end;
+		getChunkRange(
+			chunkPointers,
+			numChunks,
+			omp_get_num_threads(),
+			omp_get_thread_num(),
+			begin,
+			end
+		);
+		T *sumReal = new T[chunkSize];
+		T *sumImag = new T[chunkSize];
+
+		complex<T> *x1 = jIn1;
+		complex<T> *x2 = jIn2;
+		complex<T> *y = jResult;
+		for(int n = begin*chunkSize; n < end*chunkSize; n++){
+			int row = rowPermutation[n];
+			if(row != -1){
+				x1[row] = 0.;
+				x2[row] = 0.;
+				y[row] = 0.;
+			}
+		}
+		#pragma omp barrier
+
+		//Set up initial state (|j0>)
+		#pragma omp single
+		{
+			x1[fromBasisIndex] = 1.;
+			for(int n = 0; n < numToIndices; n++){
+				coefficients[n*numCoefficients] = complex<double>(
+					x1[toBasisIndices[n]]
+				);
+			}
+		}
+
+		for(int n = 1; n < numCoefficients; n++){
+			T multiplier = (n == 1 ? 1 : 2)/scaleFactor;
+			calculateChunks(
+				begin,
+				end,
+				chunkSize,
+				chunkPointers,
+				chunkLengths,
+				rowPermutation,
+				columnIndices,
+				values,
+				multiplier,
+				(T)energyShift,
+				dampingT,
+				x1,
+				x2,
+				y,
+				sumReal,
+				sumImag,
+				firstToIndex,
+				nextToIndex,
+				coefficients,
+				numCoefficients,
+				n
+			);
+
+			complex<T> *temp = x2;
+			x2 = x1;
+			x1 = y;
+			y = temp;
+
+			#pragma omp barrier
+
+			#pragma omp master
+			{
+				if(printProgress){
+					if(n%100 == 0)
+						Streams::out << "." << flush;
+					if(n%1000 == 0)
+						Streams::out << " " << flush;
+				}
+			}
 		}
 
-		for(int c = 0; c < numHoppingAmplitudes; c++){
-			int from = fromIndices[c];
-			int to = toIndices[c];
+		delete [] sumReal;
+		delete [] sumImag;
+	}
+	if(printProgress)
+		Streams::out << "\n";
+
+	delete [] jIn1;
+	delete [] jIn2;
+	delete [] jResult;
+	delete [] firstToIndex;
+	delete [] nextToIndex;
+	if(convertedValues != NULL)
+		delete [] convertedValues;
+	if(dampingT != NULL)
+		delete [] dampingT;
+}
+
+template<typename T>
+void ChebyshevSolver::calculateCoefficientsBlockCPU(
+	const vector<int> &toBasisIndices,
+	const int *fromBasisIndices,
+	int numFromIndices,
+	complex<double> *coefficients,
+	int numCoefficients
+){
+	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
+	int basisSize = amplitudeSet->getBasisSize();
+	int numToIndices = toBasisIndices.size();
+
+	//The recursion is performed on the CSR format. See
+	//updateHamiltonian(). With Hermitian storage, the CSR format only
+	//contains the lower triangle, and the Hermitian conjugates of the
+	//matrix elements are added through the scatter buffers.
+	const int *rowPointers = amplitudeSet->getCSRRowPointers();
+	const int *columnIndices = amplitudeSet->getCSRColIndices();
+	complex<T> *convertedValues;
+	const complex<T> *values = convertValues(
+		amplitudeSet->getCSRValues(),
+		rowPointers[basisSize],
+		convertedValues
+	);
+	bool hermitianStorage = amplitudeSet->getHermitianStorage();
+	ScatterBuffers<T> scatterBuffers(
+		omp_in_parallel() ? 1 : omp_get_max_threads()
+	);
+
+	//Damping mask converted to the precision of the vectors.
+	complex<T> *dampingT = NULL;
+	if(damping != NULL){
+		dampingT = new complex<T>[basisSize];
+		for(int n = 0; n < basisSize; n++)
+			dampingT[n] = complex<T>(damping[n]);
+	}
+
+	//Coefficients are extracted for the rows in toBasisIndices while the
+	//rows are calculated. The to-indices of each row are stored as a
+	//linked list, since the same row can occur several times.
+	int *firstToIndex = new int[basisSize];
+	int *nextToIndex = new int[numToIndices];
+	for(int n = 0; n < basisSize; n++)
+		firstToIndex[n] = -1;
+	for(int n = numToIndices-1; n >= 0; n--){
+		nextToIndex[n] = firstToIndex[toBasisIndices[n]];
+		firstToIndex[toBasisIndices[n]] = n;
+	}
+
+	//Block vectors with 2*numFromIndices real numbers per row.
+	size_t blockVectorSize = 2*(size_t)numFromIndices*basisSize;
+	T *jIn1 = new T[blockVectorSize];
+	T *jIn2 = new T[blockVectorSize];
+	T *jResult = new T[blockVectorSize];
+
+	//The block sizes that are powers of two from 4 to 16 have specialized
+	//kernels, as does a single vector, which is calculated here with
+	//Hermitian storage. See calculateCoefficientsCPU().
+	auto calculateRows = &calculateChebyshevBlockRows<T, 0>;
+	switch(numFromIndices){
+	case 1:
+		calculateRows = &calculateChebyshevBlockRows<T, 1>;
+		break;
+	case 4:
+		calculateRows = &calculateChebyshevBlockRows<T, 4>;
+		break;
+	case 8:
+		calculateRows = &calculateChebyshevBlockRows<T, 8>;
+		break;
+	case 16:
+		calculateRows = &calculateChebyshevBlockRows<T, 16>;
+		break;
+	}
 
-			jResult[to] += hoppingAmplitudes[c]*jIn1[from];
+	//Same recursion as in calculateCoefficientsCPU(), with each row
+	//holding the components of all vectors in the block.
+	bool printProgress = isTalkative && !omp_in_parallel();
+	#pragma omp parallel if(!omp_in_parallel())
+	{
+		int thread = omp_get_thread_num();
+		int begin, end;
+		getChunkRange(
+			rowPointers,
+			basisSize,
+			omp_get_num_threads(),
+			thread,
+			begin,
+			end
+		);
+		if(hermitianStorage){
+			scatterBuffers.prepare(
+				thread,
+				begin,
+				end,
+				numFromIndices,
+				rowPointers,
+				columnIndices
+			);
+		}
+		T *sumReal = new T[numFromIndices];
+		T *sumImag = new T[numFromIndices];
+
+		T *x1 = jIn1;
+		T *x2 = jIn2;
+		T *y = jResult;
+		for(
+			size_t n = 2*(size_t)numFromIndices*begin;
+			n < 2*(size_t)numFromIndices*end;
+			n++
+		){
+			x1[n] = 0;
+			x2[n] = 0;
+			y[n] = 0;
+		}
+		#pragma omp barrier
+
+		//Set up initial states (|j0>)
+		#pragma omp single
+		{
+			for(int k = 0; k < numFromIndices; k++)
+				x1[2*numFromIndices*fromBasisIndices[k] + k] = 1;
+			for(int k = 0; k < numFromIndices; k++){
+				for(int n = 0; n < numToIndices; n++){
+					const T *xTo = &x1[
+						2*numFromIndices*toBasisIndices[n]
+					];
+					coefficients[
+						(k*numToIndices + n)*numCoefficients
+					] = complex<double>(
+						xTo[k],
+						xTo[numFromIndices + k]
+					);
+				}
+			}
 		}
 
-		if(damping != NULL){
-			for(int c = 0; c < amplitudeSet->getBasisSize(); c++)
-				jResult[c] *= damping[c];
+		for(int n = 1; n < numCoefficients; n++){
+			T multiplier = (n == 1 ? 1 : 2)/scaleFactor;
+			calculateRows(
+				begin,
+				end,
+				numFromIndices,
+				rowPointers,
+				columnIndices,
+				values,
+				multiplier,
+				(T)energyShift,
+				dampingT,
+				x1,
+				x2,
+				y,
+				sumReal,
+				sumImag,
+				firstToIndex,
+				nextToIndex,
+				coefficients,
+				numToIndices,
+				numCoefficients,
+				n,
+				NULL,
+				hermitianStorage ? &scatterBuffers : NULL
+			);
+
+			T *temp = x2;
+			x2 = x1;
+			x1 = y;
+			y = temp;
+
+			#pragma omp barrier
+
+			#pragma omp master
+			{
+				if(printProgress){
+					if(n%100 == 0)
+						Streams::out << "." << flush;
+					if(n%1000 == 0)
+						Streams::out << " " << flush;
+				}
+			}
 		}
 
-		jTemp = jIn2;
-		jIn2 = jIn1;
-		jIn1 = jResult;
-		jResult = jTemp;
+		delete [] sumReal;
+		delete [] sumImag;
+	}
+	if(printProgress)
+		Streams::out << "\n";
 
-		coefficients[n] = jIn1[toBasisIndex];
+	delete [] jIn1;
+	delete [] jIn2;
+	delete [] jResult;
+	delete [] firstToIndex;
+	delete [] nextToIndex;
+	if(convertedValues != NULL)
+		delete [] convertedValues;
+	if(dampingT != NULL)
+		delete [] dampingT;
+}
 
-		if(isTalkative){
-			if(n%100 == 0)
-				Streams::out << "." << flush;
-			if(n%1000 == 0)
-				Streams::out << " " << flush;
+template<typename T>
+void ChebyshevSolver::calculateStateCoefficientsBlockCPU(
+	const complex<double> *states,
+	int numStates,
+	complex<double> *coefficients,
+	int numCoefficients
+){
+	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
+	int basisSize = amplitudeSet->getBasisSize();
+
+	//The recursion is performed on the CSR format. See
+	//updateHamiltonian(). With Hermitian storage, the CSR format only
+	//contains the lower triangle, and the Hermitian conjugates of the
+	//matrix elements are added through the scatter buffers.
+	const int *rowPointers = amplitudeSet->getCSRRowPointers();
+	const int *columnIndices = amplitudeSet->getCSRColIndices();
+	complex<T> *convertedValues;
+	const complex<T> *values = convertValues(
+		amplitudeSet->getCSRValues(),
+		rowPointers[basisSize],
+		convertedValues
+	);
+	bool hermitianStorage = amplitudeSet->getHermitianStorage();
+	ScatterBuffers<T> scatterBuffers(
+		omp_in_parallel() ? 1 : omp_get_max_threads()
+	);
+
+	//Block vectors with 2*numStates real numbers per row.
+	size_t blockVectorSize = 2*(size_t)numStates*basisSize;
+	T *jIn1 = new T[blockVectorSize];
+	T *jIn2 = new T[blockVectorSize];
+	T *jResult = new T[blockVectorSize];
+
+	auto calculateRows = &calculateChebyshevBlockRows<T, 0>;
+	switch(numStates){
+	case 4:
+		calculateRows = &calculateChebyshevBlockRows<T, 4>;
+		break;
+	case 8:
+		calculateRows = &calculateChebyshevBlockRows<T, 8>;
+		break;
+	case 16:
+		calculateRows = &calculateChebyshevBlockRows<T, 16>;
+		break;
+	}
+
+	//The coefficients are obtained from the relations
+	//T_{2s} = 2T_sT_s - T_0 and T_{2s+1} = 2T_{s+1}T_s - T_1, which for a
+	//Hermitian Hamiltonian gives two coefficients per multiplication.
+	//While |j_s> is calculated, each thread accumulates <j_{s-1}|j_{s-1}>
+	//and <j_s|j_{s-1}> for its rows. The partial sums of every other step
+	//are stored in the same buffer, which allows the master thread to add
+	//up the partial sums of one step while the other threads proceed with
+	//the next.
+	int numSteps = (numCoefficients + 1)/2;
+	int maxThreads = omp_in_parallel() ? 1 : omp_get_max_threads();
+	double *partialSums = new double[2*maxThreads*2*numStates];
+
+	bool printProgress = isTalkative && !omp_in_parallel();
+	#pragma omp parallel if(!omp_in_parallel())
+	{
+		int numThreads = omp_get_num_threads();
+		int thread = omp_get_thread_num();
+		int begin, end;
+		getChunkRange(
+			rowPointers,
+			basisSize,
+			numThreads,
+			thread,
+			begin,
+			end
+		);
+		if(hermitianStorage){
+			scatterBuffers.prepare(
+				thread,
+				begin,
+				end,
+				numStates,
+				rowPointers,
+				columnIndices
+			);
+		}
+		T *sumReal = new T[numStates];
+		T *sumImag = new T[numStates];
+
+		//Set up initial states (|j0>)
+		T *x1 = jIn1;
+		T *x2 = jIn2;
+		T *y = jResult;
+		for(int row = begin; row < end; row++){
+			for(int k = 0; k < numStates; k++){
+				complex<double> c = states[(size_t)k*basisSize + row];
+				x1[2*numStates*row + k] = c.real();
+				x1[2*numStates*row + numStates + k] = c.imag();
+				x2[2*numStates*row + k] = 0;
+				x2[2*numStates*row + numStates + k] = 0;
+				y[2*numStates*row + k] = 0;
+				y[2*numStates*row + numStates + k] = 0;
+			}
+		}
+		#pragma omp barrier
+
+		for(int s = 1; s <= numSteps; s++){
+			double *momentSums = &partialSums[
+				2*numStates*(numThreads*(s%2) + thread)
+			];
+			for(int k = 0; k < 2*numStates; k++)
+				momentSums[k] = 0;
+
+			T multiplier = (s == 1 ? 1 : 2)/scaleFactor;
+			calculateRows(
+				begin,
+				end,
+				numStates,
+				rowPointers,
+				columnIndices,
+				values,
+				multiplier,
+				(T)energyShift,
+				NULL,
+				x1,
+				x2,
+				y,
+				sumReal,
+				sumImag,
+				NULL,
+				NULL,
+				NULL,
+				0,
+				numCoefficients,
+				s,
+				momentSums,
+				hermitianStorage ? &scatterBuffers : NULL
+			);
+
+			T *temp = x2;
+			x2 = x1;
+			x1 = y;
+			y = temp;
+
+			#pragma omp barrier
+
+			#pragma omp master
+			{
+				//The partial sums are added in thread order, which
+				//makes the coefficients independent of the timing
+				//of the threads.
+				for(int k = 0; k < numStates; k++){
+					double overlap = 0;
+					double nextOverlap = 0;
+					for(int t = 0; t < numThreads; t++){
+						const double *sums = &partialSums[
+							2*numStates*(numThreads*(s%2) + t)
+						];
+						overlap += sums[k];
+						nextOverlap += sums[numStates + k];
+					}
+
+					complex<double> *c = &coefficients[
+						(size_t)k*numCoefficients
+					];
+					if(s == 1){
+						c[0] = overlap;
+						if(numCoefficients > 1)
+							c[1] = nextOverlap;
+					}
+					else{
+						c[2*s - 2] = 2*overlap - c[0].real();
+						if(2*s - 1 < numCoefficients){
+							c[2*s - 1] = 2*nextOverlap
+								- c[1].real();
+						}
+					}
+				}
+
+				if(printProgress){
+					if(s%50 == 0)
+						Streams::out << "." << flush;
+					if(s%500 == 0)
+						Streams::out << " " << flush;
+				}
+			}
 		}
+
+		delete [] sumReal;
+		delete [] sumImag;
 	}
-	if(isTalkative)
+	if(printProgress)
 		Streams::out << "\n";
 
 	delete [] jIn1;
 	delete [] jIn2;
 	delete [] jResult;
-	delete [] hoppingAmplitudes;
-	delete [] toIndices;
-	delete [] fromIndices;
+	delete [] partialSums;
+	if(convertedValues != NULL)
+		delete [] convertedValues;
+}
+
+void ChebyshevSolver::calculateCoefficients(
+	Index to,
+	Index from,
+	complex<double> *coefficients,
+	int numCoefficients,
+	double broadening
+){
+	TBTKAssert(
+		model != NULL,
+		"ChebyshevSolver::calculateCoefficients()",
+		"Model not set.",
+		"Use ChebyshevSolver::setModel() to set model."
+	);
+	TBTKAssert(
+		scaleFactor > 0,
+		"ChebyshevSolver::calculateCoefficients()",
+		"Scale factor must be larger than zero.",
+		"Use ChebyshevSolver::setScaleFactor() to set scale factor."
+	);
+	TBTKAssert(
+		numCoefficients > 0,
+		"ChebyshevSolver::calculateCoefficients()",
+		"numCoefficients has to be larger than 0.",
+		""
+	);
+
+	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
+
+	//The Hamiltonian is only brought up to date outside of parallel
+	//regions, which allows coefficients to be calculated from several
+	//threads at once.
+	if(!omp_in_parallel())
+		updateHamiltonian();
+	TBTKAssert(
+		hamiltonianIsConstructed(),
+		"ChebyshevSolver::calculateCoefficients()",
+		"Hamiltonian not constructed.",
+		"Use ChebyshevSolver::updateHamiltonian() before calculating coefficients in a parallel region."
+	);
+
+	int fromBasisIndex = amplitudeSet->getBasisIndex(from);
+	int toBasisIndex = amplitudeSet->getBasisIndex(to);
+
+	if(isTalkative && !omp_in_parallel()){
+		Streams::out << "ChebyshevSolver::calculateCoefficients\n";
+		Streams::out << "\tFrom Index: " << fromBasisIndex << "\n";
+		Streams::out << "\tTo Index: " << toBasisIndex << "\n";
+		Streams::out << "\tBasis size: " << amplitudeSet->getBasisSize() << "\n";
+		Streams::out << "\tProgress (100 coefficients per dot): ";
+	}
+
+	vector<int> toBasisIndices(1, toBasisIndex);
+	if(singlePrecision){
+		calculateCoefficientsCPU<float>(
+			toBasisIndices,
+			fromBasisIndex,
+			coefficients,
+			numCoefficients
+		);
+	}
+	else{
+		calculateCoefficientsCPU<double>(
+			toBasisIndices,
+			fromBasisIndex,
+			coefficients,
+			numCoefficients
+		);
+	}
 
 	//Lorentzian convolution
 	double lambda = broadening*numCoefficients;
@@ -244,6 +1522,153 @@ void ChebyshevSolver::calculateCoefficients(
 		coefficients[n] = coefficients[n]*sinh(lambda*(1 - n/(double)numCoefficients))/sinh(lambda);
 }
 
+void ChebyshevSolver::multiplyScaledHamiltonian(
+	const complex<double> *x,
+	complex<double> *y,
+	int numVectors
+){
+	TBTKAssert(
+		model != NULL,
+		"ChebyshevSolver::multiplyScaledHamiltonian()",
+		"Model not set.",
+		"Use ChebyshevSolver::setModel() to set model."
+	);
+	TBTKAssert(
+		scaleFactor > 0,
+		"ChebyshevSolver::multiplyScaledHamiltonian()",
+		"Scale factor must be larger than zero.",
+		"Use ChebyshevSolver::setScaleFactor() to set scale factor."
+	);
+
+	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
+
+	//The multiplication is typically repeated many times for the same
+	//Hamiltonian, which is therefore only constructed if it does not
+	//exist yet. Otherwise it is used as it is.
+	if(!hamiltonianIsConstructed() && !omp_in_parallel())
+		updateHamiltonian();
+	TBTKAssert(
+		hamiltonianIsConstructed(),
+		"ChebyshevSolver::multiplyScaledHamiltonian()",
+		"Hamiltonian not constructed.",
+		"Use ChebyshevSolver::updateHamiltonian() before multiplying in a parallel region."
+	);
+
+	int basisSize = amplitudeSet->getBasisSize();
+	const int *rowPointers = amplitudeSet->getCSRRowPointers();
+	const int *columnIndices = amplitudeSet->getCSRColIndices();
+	const complex<double> *values = amplitudeSet->getCSRValues();
+	bool hermitianStorage = amplitudeSet->getHermitianStorage();
+	ScatterBuffers<double> scatterBuffers(
+		omp_in_parallel() ? 1 : omp_get_max_threads()
+	);
+
+	//The vectors are multiplied in blocks of at most blockSize vectors,
+	//using the kernel of the block recursion with a zero vector in place
+	//of the previous vector. See calculateCoefficientsBlockCPU() for the
+	//layout of the block vectors.
+	size_t blockVectorSize = 2*(size_t)blockSize*basisSize;
+	vector<double> xBlock(blockVectorSize);
+	vector<double> zeroBlock(blockVectorSize, 0.);
+	vector<double> yBlock(blockVectorSize);
+	for(int b = 0; b < numVectors; b += blockSize){
+		int numBlockVectors = min(blockSize, numVectors - b);
+		const complex<double> *xb = &x[(size_t)b*basisSize];
+		complex<double> *yb = &y[(size_t)b*basisSize];
+
+		auto multiplyRows = &calculateChebyshevBlockRows<double, 0>;
+		switch(numBlockVectors){
+		case 4:
+			multiplyRows = &calculateChebyshevBlockRows<double, 4>;
+			break;
+		case 8:
+			multiplyRows = &calculateChebyshevBlockRows<double, 8>;
+			break;
+		case 16:
+			multiplyRows = &calculateChebyshevBlockRows<double, 16>;
+			break;
+		}
+
+		#pragma omp parallel if(!omp_in_parallel())
+		{
+			int thread = omp_get_thread_num();
+			int begin, end;
+			getChunkRange(
+				rowPointers,
+				basisSize,
+				omp_get_num_threads(),
+				thread,
+				begin,
+				end
+			);
+			if(hermitianStorage){
+				scatterBuffers.prepare(
+					thread,
+					begin,
+					end,
+					numBlockVectors,
+					rowPointers,
+					columnIndices
+				);
+			}
+			vector<double> sumReal(numBlockVectors);
+			vector<double> sumImag(numBlockVectors);
+
+			for(int row = begin; row < end; row++){
+				double *xReal = &xBlock[2*(size_t)numBlockVectors*row];
+				double *xImag = xReal + numBlockVectors;
+				for(int k = 0; k < numBlockVectors; k++){
+					const complex<double> &element
+						= xb[(size_t)k*basisSize + row];
+					xReal[k] = real(element);
+					xImag[k] = imag(element);
+				}
+			}
+			#pragma omp barrier
+
+			multiplyRows(
+				begin,
+				end,
+				numBlockVectors,
+				rowPointers,
+				columnIndices,
+				values,
+				1./scaleFactor,
+				energyShift,
+				NULL,
+				xBlock.data(),
+				zeroBlock.data(),
+				yBlock.data(),
+				sumReal.data(),
+				sumImag.data(),
+				NULL,
+				NULL,
+				NULL,
+				0,
+				0,
+				0,
+				NULL,
+				hermitianStorage ? &scatterBuffers : NULL
+			);
+
+			for(int row = begin; row < end; row++){
+				const double *yReal
+					= &yBlock[2*(size_t)numBlockVectors*row];
+				const double *yImag = yReal + numBlockVectors;
+				for(int k = 0; k < numBlockVectors; k++){
+					yb[(size_t)k*basisSize + row] = complex<double>(
+						yReal[k],
+						yImag[k]
+					);
+				}
+			}
+
+			//The block vectors are reused by the next block.
+			#pragma omp barrier
+		}
+	}
+}
+
 void ChebyshevSolver::calculateCoefficients(
 	vector<Index> &to,
 	Index from,
@@ -272,139 +1697,258 @@ void ChebyshevSolver::calculateCoefficients(
 
 	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
 
+	//The Hamiltonian is only brought up to date outside of parallel
+	//regions, which allows coefficients to be calculated from several
+	//threads at once.
+	if(!omp_in_parallel())
+		updateHamiltonian();
+	TBTKAssert(
+		hamiltonianIsConstructed(),
+		"ChebyshevSolver::calculateCoefficients()",
+		"Hamiltonian not constructed.",
+		"Use ChebyshevSolver::updateHamiltonian() before calculating coefficients in a parallel region."
+	);
+
 	int fromBasisIndex = amplitudeSet->getBasisIndex(from);
-	int *coefficientMap = new int[amplitudeSet->getBasisSize()];
-	for(int n = 0; n < amplitudeSet->getBasisSize(); n++)
-		coefficientMap[n] = -1;
-	for(unsigned int n = 0; n < to.size(); n++)
-		coefficientMap[amplitudeSet->getBasisIndex(to.at(n))] = n;
+	vector<int> toBasisIndices(to.size());
+	amplitudeSet->getBasisIndices(to, toBasisIndices.data());
 
-	if(isTalkative){
+	if(isTalkative && !omp_in_parallel()){
 		Streams::out << "ChebyshevSolver::calculateCoefficients\n";
 		Streams::out << "\tFrom Index: " << fromBasisIndex << "\n";
 		Streams::out << "\tBasis size: " << amplitudeSet->getBasisSize() << "\n";
 		Streams::out << "\tProgress (100 coefficients per dot): ";
 	}
 
-	complex<double> *jIn1 = new complex<double>[amplitudeSet->getBasisSize()];
-	complex<double> *jIn2 = new complex<double>[amplitudeSet->getBasisSize()];
-	complex<double> *jResult = new complex<double>[amplitudeSet->getBasisSize()];
-	complex<double> *jTemp = NULL;
-	for(int n = 0; n < amplitudeSet->getBasisSize(); n++){
-		jIn1[n] = 0.;
-		jIn2[n] = 0.;
-		jResult[n] = 0.;
+	if(singlePrecision){
+		calculateCoefficientsCPU<float>(
+			toBasisIndices,
+			fromBasisIndex,
+			coefficients,
+			numCoefficients
+		);
+	}
+	else{
+		calculateCoefficientsCPU<double>(
+			toBasisIndices,
+			fromBasisIndex,
+			coefficients,
+			numCoefficients
+		);
 	}
-	//Set up initial state (|j0>)
-	jIn1[fromBasisIndex] = 1.;
 
-	for(int n = 0; n < amplitudeSet->getBasisSize(); n++)
-		if(coefficientMap[n] != -1)
-			coefficients[coefficientMap[n]*numCoefficients] = jIn1[n];
+	//Lorentzian convolution
+	double lambda = broadening*numCoefficients;
+	for(int n = 0; n < numCoefficients; n++)
+		coefficients[n] = coefficients[n]*sinh(lambda*(1 - n/(double)numCoefficients))/sinh(lambda);
+}
 
-	//Generate a fixed hopping amplitude and inde list, for speed.
-	AmplitudeSet::Iterator it = amplitudeSet->getIterator();
-	const HoppingAmplitude *ha;
-	int numHoppingAmplitudes = 0;
-	while((ha = it.getHA())){
-		numHoppingAmplitudes++;
-		it.searchNextHA();
-	}
+void ChebyshevSolver::calculateCoefficients(
+	vector<Index> &to,
+	vector<Index> &from,
+	complex<double> *coefficients,
+	int numCoefficients,
+	double broadening
+){
+	TBTKAssert(
+		model != NULL,
+		"ChebyshevSolver::calculateCoefficients()",
+		"Model not set.",
+		"Use ChebyshevSolver::setModel() to set model."
+	);
+	TBTKAssert(
+		scaleFactor > 0,
+		"ChebyshevSolver::calculateCoefficients()",
+		"Scale factor must be larger than zero.",
+		"Use ChebyshevSolver::setScaleFactor() to set scale factor."
+	);
+	TBTKAssert(
+		numCoefficients > 0,
+		"ChebyshevSolver::calculateCoefficients()",
+		"numCoefficients has to be larger than 0.",
+		""
+	);
+
+	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
+
+	//The Hamiltonian is only brought up to date outside of parallel
+	//regions, which allows coefficients to be calculated from several
+	//threads at once.
+	if(!omp_in_parallel())
+		updateHamiltonian();
+	TBTKAssert(
+		hamiltonianIsConstructed(),
+		"ChebyshevSolver::calculateCoefficients()",
+		"Hamiltonian not constructed.",
+		"Use ChebyshevSolver::updateHamiltonian() before calculating coefficients in a parallel region."
+	);
 
-	complex<double> *hoppingAmplitudes = new complex<double>[numHoppingAmplitudes];
-	int *toIndices = new int[numHoppingAmplitudes];
-	int *fromIndices = new int[numHoppingAmplitudes];
-	it.reset();
-	int counter = 0;
-	while((ha = it.getHA())){
-		toIndices[counter] = amplitudeSet->getBasisIndex(ha->toIndex);
-		fromIndices[counter] = amplitudeSet->getBasisIndex(ha->fromIndex);
-		hoppingAmplitudes[counter] = ha->getAmplitude()/scaleFactor;
+	vector<int> fromBasisIndices(from.size());
+	amplitudeSet->getBasisIndices(from, fromBasisIndices.data());
+	vector<int> toBasisIndices(to.size());
+	amplitudeSet->getBasisIndices(to, toBasisIndices.data());
 
-		it.searchNextHA();
-		counter++;
+	if(isTalkative && !omp_in_parallel()){
+		Streams::out << "ChebyshevSolver::calculateCoefficients\n";
+		Streams::out << "\tNumber of from indices: " << from.size() << "\n";
+		Streams::out << "\tBlock size: " << blockSize << "\n";
+		Streams::out << "\tBasis size: " << amplitudeSet->getBasisSize() << "\n";
 	}
 
-	//Calculate |j1>
-	for(int c = 0; c < amplitudeSet->getBasisSize(); c++)
-		jResult[c] = 0.;
-	for(int n = 0; n < numHoppingAmplitudes; n++){
-		int from = fromIndices[n];
-		int to = toIndices[n];
+	//The 'from'-indices are propagated together in blocks of at most
+	//blockSize vectors.
+	int numFromIndices = from.size();
+	int numToIndices = to.size();
+	for(int b = 0; b < numFromIndices; b += blockSize){
+		int numBlockIndices = min(blockSize, numFromIndices - b);
+		complex<double> *blockCoefficients
+			= &coefficients[(size_t)b*numToIndices*numCoefficients];
+
+		if(isTalkative && !omp_in_parallel()){
+			Streams::out << "\tFrom indices " << b << "-" << b + numBlockIndices - 1;
+			Streams::out << " (100 coefficients per dot): ";
+		}
 
-		jResult[to] += hoppingAmplitudes[n]*jIn1[from];
+		//A single vector is calculated on SELL format, where the
+		//rows rather than the vectors are processed in SIMD lanes,
+		//unless Hermitian storage is enabled.
+		if(numBlockIndices == 1){
+			if(singlePrecision){
+				calculateCoefficientsCPU<float>(
+					toBasisIndices,
+					fromBasisIndices[b],
+					blockCoefficients,
+					numCoefficients
+				);
+			}
+			else{
+				calculateCoefficientsCPU<double>(
+					toBasisIndices,
+					fromBasisIndices[b],
+					blockCoefficients,
+					numCoefficients
+				);
+			}
+		}
+		else if(singlePrecision){
+			calculateCoefficientsBlockCPU<float>(
+				toBasisIndices,
+				&fromBasisIndices[b],
+				numBlockIndices,
+				blockCoefficients,
+				numCoefficients
+			);
+		}
+		else{
+			calculateCoefficientsBlockCPU<double>(
+				toBasisIndices,
+				&fromBasisIndices[b],
+				numBlockIndices,
+				blockCoefficients,
+				numCoefficients
+			);
+		}
 	}
 
-	if(damping != NULL){
-		for(int c = 0; c < amplitudeSet->getBasisSize(); c++)
-			jResult[c] *= damping[c];
+	//Lorentzian convolution
+	double lambda = broadening*numCoefficients;
+	for(int n = 0; n < numCoefficients; n++){
+		double factor = sinh(lambda*(1 - n/(double)numCoefficients))/sinh(lambda);
+		for(int c = 0; c < numFromIndices*numToIndices; c++)
+			coefficients[(size_t)c*numCoefficients + n] *= factor;
 	}
+}
 
-	jTemp = jIn2;
-	jIn2 = jIn1;
-	jIn1 = jResult;
-	jResult = jTemp;
+void ChebyshevSolver::calculateStateCoefficients(
+	const complex<double> *states,
+	int numStates,
+	complex<double> *coefficients,
+	int numCoefficients,
+	double broadening
+){
+	TBTKAssert(
+		model != NULL,
+		"ChebyshevSolver::calculateStateCoefficients()",
+		"Model not set.",
+		"Use ChebyshevSolver::setModel() to set model."
+	);
+	TBTKAssert(
+		scaleFactor > 0,
+		"ChebyshevSolver::calculateStateCoefficients()",
+		"Scale factor must be larger than zero.",
+		"Use ChebyshevSolver::setScaleFactor() to set scale factor."
+	);
+	TBTKAssert(
+		numCoefficients > 0,
+		"ChebyshevSolver::calculateStateCoefficients()",
+		"numCoefficients has to be larger than 0.",
+		""
+	);
+	TBTKAssert(
+		damping == NULL,
+		"ChebyshevSolver::calculateStateCoefficients()",
+		"Damping is not supported.",
+		"Use ChebyshevSolver::setDamping(NULL) to disable damping."
+	);
 
-	for(int n = 0; n < amplitudeSet->getBasisSize(); n++)
-		if(coefficientMap[n] != -1)
-			coefficients[coefficientMap[n]*numCoefficients + 1] = jIn1[n];
+	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
 
-	//Multiply hopping amplitudes by factor two, to spped up calculation of 2H|j(n-1)> - |j(n-2)>.
-	for(int n = 0; n < numHoppingAmplitudes; n++)
-		hoppingAmplitudes[n] *= 2.;
+	//The Hamiltonian is only brought up to date outside of parallel
+	//regions, which allows coefficients to be calculated from several
+	//threads at once.
+	if(!omp_in_parallel())
+		updateHamiltonian();
+	TBTKAssert(
+		hamiltonianIsConstructed(),
+		"ChebyshevSolver::calculateStateCoefficients()",
+		"Hamiltonian not constructed.",
+		"Use ChebyshevSolver::updateHamiltonian() before calculating coefficients in a parallel region."
+	);
 
-	//Iteratively calculate |jn> and corresponding Chebyshev coefficients.
-	for(int n = 2; n < numCoefficients; n++){
-		for(int c = 0; c < amplitudeSet->getBasisSize(); c++)
-			jResult[c] = -jIn2[c];
+	int basisSize = amplitudeSet->getBasisSize();
 
-		if(damping != NULL){
-			for(int c = 0; c < amplitudeSet->getBasisSize(); c++)
-				jResult[c] *= damping[c];
-		}
+	if(isTalkative && !omp_in_parallel()){
+		Streams::out << "ChebyshevSolver::calculateStateCoefficients\n";
+		Streams::out << "\tNumber of states: " << numStates << "\n";
+		Streams::out << "\tBlock size: " << blockSize << "\n";
+		Streams::out << "\tBasis size: " << basisSize << "\n";
+	}
 
-		for(int c = 0; c < numHoppingAmplitudes; c++){
-			int from = fromIndices[c];
-			int to = toIndices[c];
+	//The states are propagated together in blocks of at most blockSize
+	//vectors.
+	for(int b = 0; b < numStates; b += blockSize){
+		int numBlockStates = min(blockSize, numStates - b);
 
-			jResult[to] += hoppingAmplitudes[c]*jIn1[from];
+		if(isTalkative && !omp_in_parallel()){
+			Streams::out << "\tStates " << b << "-" << b + numBlockStates - 1;
+			Streams::out << " (100 coefficients per dot): ";
 		}
 
-		if(damping != NULL){
-			for(int c = 0; c < amplitudeSet->getBasisSize(); c++)
-				jResult[c] *= damping[c];
+		if(singlePrecision){
+			calculateStateCoefficientsBlockCPU<float>(
+				&states[(size_t)b*basisSize],
+				numBlockStates,
+				&coefficients[(size_t)b*numCoefficients],
+				numCoefficients
+			);
 		}
-
-		jTemp = jIn2;
-		jIn2 = jIn1;
-		jIn1 = jResult;
-		jResult = jTemp;
-
-		for(int c = 0; c < amplitudeSet->getBasisSize(); c++)
-			if(coefficientMap[c] != -1)
-				coefficients[coefficientMap[c]*numCoefficients + n] = jIn1[c];
-
-		if(isTalkative){
-			if(n%100 == 0)
-				Streams::out << "." << flush;
-			if(n%1000 == 0)
-				Streams::out << " " << flush;
+		else{
+			calculateStateCoefficientsBlockCPU<double>(
+				&states[(size_t)b*basisSize],
+				numBlockStates,
+				&coefficients[(size_t)b*numCoefficients],
+				numCoefficients
+			);
 		}
 	}
-	if(isTalkative)
-		Streams::out << "\n";
-
-	delete [] jIn1;
-	delete [] jIn2;
-	delete [] jResult;
-	delete [] hoppingAmplitudes;
-	delete [] toIndices;
-	delete [] fromIndices;
 
 	//Lorentzian convolution
 	double lambda = broadening*numCoefficients;
-	for(int n = 0; n < numCoefficients; n++)
-		coefficients[n] = coefficients[n]*sinh(lambda*(1 - n/(double)numCoefficients))/sinh(lambda);
+	for(int n = 0; n < numCoefficients; n++){
+		double factor = sinh(lambda*(1 - n/(double)numCoefficients))/sinh(lambda);
+		for(int k = 0; k < numStates; k++)
+			coefficients[(size_t)k*numCoefficients + n] *= factor;
+	}
 }
 
 void ChebyshevSolver::calculateCoefficientsWithCutoff(
@@ -433,6 +1977,12 @@ void ChebyshevSolver::calculateCoefficientsWithCutoff(
 		"numCoefficients has to be larger than 0.",
 		""
 	);
+	TBTKAssert(
+		energyShift == 0,
+		"ChebyshevSolver::calculateCoefficientsWithCutoff()",
+		"Energy shift is not supported.",
+		"Use ChebyshevSolver::setEnergyShift(0) to disable the energy shift."
+	);
 
 	AmplitudeSet *amplitudeSet = model->getAmplitudeSet();
 
@@ -602,15 +2152,15 @@ void ChebyshevSolver::generateLookupTable(
 		""
 	);
 	TBTKAssert(
-		lowerBound >= -scaleFactor,
+		lowerBound >= energyShift - scaleFactor,
 		"ChebyshevSolver::generateLookupTable()",
-		"lowerBound has to be larger than -scaleFactor.",
+		"lowerBound has to be larger than energyShift - scaleFactor.",
 		"Use ChebyshevSolver::setScaleFactor to set a larger scale factor."
 	);
 	TBTKAssert(
-		upperBound <= scaleFactor,
+		upperBound <= energyShift + scaleFactor,
 		"ChebyshevSolver::generateLookupTable()",
-		"upperBound has to be smaller than scaleFactor.",
+		"upperBound has to be smaller than energyShift + scaleFactor.",
 		"Use ChebyshevSolver::setScaleFactor to set a larger scale factor."
 	);
 
@@ -622,19 +2172,23 @@ void ChebyshevSolver::generateLookupTable(
 		Streams::out << "\tUpper bound: " << upperBound << "\n";
 	}
 
-	if(generatingFunctionLookupTable != NULL){
-		for(int n = 0; n < lookupTableNumCoefficients; n++)
-			delete [] generatingFunctionLookupTable[n];
-
-		delete [] generatingFunctionLookupTable;
-	}
+	deleteLookupTable();
 
 	lookupTableNumCoefficients = numCoefficients;
 	lookupTableResolution = energyResolution;
 
-	generatingFunctionLookupTable = new complex<double>*[numCoefficients];
-	for(int n = 0; n < numCoefficients; n++)
-		generatingFunctionLookupTable[n] = new complex<double>[energyResolution];
+	//The entries are calculated in double precision also when they are
+	//stored in single precision.
+	if(singlePrecision){
+		generatingFunctionLookupTableSingle = new complex<float>*[numCoefficients];
+		for(int n = 0; n < numCoefficients; n++)
+			generatingFunctionLookupTableSingle[n] = new complex<float>[energyResolution];
+	}
+	else{
+		generatingFunctionLookupTable = new complex<double>*[numCoefficients];
+		for(int n = 0; n < numCoefficients; n++)
+			generatingFunctionLookupTable[n] = new complex<double>[energyResolution];
+	}
 
 	const double DELTA = 0.0001;
 	#pragma omp parallel for
@@ -644,12 +2198,33 @@ void ChebyshevSolver::generateLookupTable(
 			denominator = 2.;
 
 		for(int e = 0; e < energyResolution; e++){
-			double E = (lowerBound + (upperBound - lowerBound)*e/(double)energyResolution)/scaleFactor;
-			generatingFunctionLookupTable[n][e] = (1/scaleFactor)*(-2.*i/sqrt(1+DELTA - E*E))*exp(-i*((double)n)*acos(E))/denominator;
+			double E = getScaledEnergy(lowerBound, upperBound, e, energyResolution);
+			complex<double> value = (1/scaleFactor)*(-2.*i/sqrt(1+DELTA - E*E))*exp(-i*((double)n)*acos(E))/denominator;
+			if(singlePrecision)
+				generatingFunctionLookupTableSingle[n][e] = complex<float>(value);
+			else
+				generatingFunctionLookupTable[n][e] = value;
 		}
 	}
 }
 
+void ChebyshevSolver::deleteLookupTable(){
+	if(generatingFunctionLookupTable != NULL){
+		for(int n = 0; n < lookupTableNumCoefficients; n++)
+			delete [] generatingFunctionLookupTable[n];
+
+		delete [] generatingFunctionLookupTable;
+		generatingFunctionLookupTable = NULL;
+	}
+	if(generatingFunctionLookupTableSingle != NULL){
+		for(int n = 0; n < lookupTableNumCoefficients; n++)
+			delete [] generatingFunctionLookupTableSingle[n];
+
+		delete [] generatingFunctionLookupTableSingle;
+		generatingFunctionLookupTableSingle = NULL;
+	}
+}
+
 void ChebyshevSolver::generateGreensFunction(
 	complex<double> *greensFunction,
 	complex<double> *coefficients,
@@ -678,15 +2253,15 @@ void ChebyshevSolver::generateGreensFunction(
 		""
 	);
 	TBTKAssert(
-		lowerBound > -scaleFactor,
+		lowerBound > energyShift - scaleFactor,
 		"ChebyshevSolver::generateLookupTable()",
-		"lowerBound has to be larger than -scaleFactor.",
+		"lowerBound has to be larger than energyShift - scaleFactor.",
 		"Use ChebyshevSolver::setScaleFactor to set a larger scale factor."
 	);
 	TBTKAssert(
-		upperBound < scaleFactor,
+		upperBound < energyShift + scaleFactor,
 		"ChebyshevSolver::generateLookupTable()",
-		"upperBound has to be smaller than scaleFactor.",
+		"upperBound has to be smaller than energyShift + scaleFactor.",
 		"Use ChebyshevSolver::setScaleFactor to set a larger scale factor."
 	);
 
@@ -701,7 +2276,7 @@ void ChebyshevSolver::generateGreensFunction(
 				denominator = 2.;
 
 			for(int e = 0; e < energyResolution; e++){
-				double E = (lowerBound + (upperBound - lowerBound)*e/(double)energyResolution)/scaleFactor;
+				double E = getScaledEnergy(lowerBound, upperBound, e, energyResolution);
 				greensFunction[e] += coefficients[n]*(1/scaleFactor)*(-2.*i/sqrt(1+DELTA - E*E))*exp(-i*((double)n)*acos(E))/denominator;
 			}
 		}
@@ -713,7 +2288,7 @@ void ChebyshevSolver::generateGreensFunction(
 				denominator = 2.;
 
 			for(int e = 0; e < energyResolution; e++){
-				double E = (lowerBound + (upperBound - lowerBound)*e/(double)energyResolution)/scaleFactor;
+				double E = getScaledEnergy(lowerBound, upperBound, e, energyResolution);
 				greensFunction[e] += coefficients[n]*conj((1/scaleFactor)*(-2.*i/sqrt(1+DELTA - E*E))*exp(-i*((double)n)*acos(E))/denominator);
 			}
 		}
@@ -725,7 +2300,7 @@ void ChebyshevSolver::generateGreensFunction(
 				denominator = 2.;
 
 			for(int e = 0; e < energyResolution; e++){
-				double E = (lowerBound + (upperBound - lowerBound)*e/(double)energyResolution)/scaleFactor;
+				double E = getScaledEnergy(lowerBound, upperBound, e, energyResolution);
 				greensFunction[e] += -coefficients[n]*real((1/scaleFactor)*(-2.*i/sqrt(1+DELTA - E*E))*exp(-i*((double)n)*acos(E))/denominator);
 			}
 		}
@@ -737,7 +2312,7 @@ void ChebyshevSolver::generateGreensFunction(
 				denominator = 2.;
 
 			for(int e = 0; e < energyResolution; e++){
-				double E = (lowerBound + (upperBound - lowerBound)*e/(double)energyResolution)/scaleFactor;
+				double E = getScaledEnergy(lowerBound, upperBound, e, energyResolution);
 				greensFunction[e] -= coefficients[n]*i*imag((1/scaleFactor)*(-2.*i/sqrt(1+DELTA - E*E))*exp(-i*((double)n)*acos(E))/denominator);
 			}
 		}
@@ -757,40 +2332,66 @@ void ChebyshevSolver::generateGreensFunction(
 	GreensFunctionType type
 ){
 	TBTKAssert(
-		generatingFunctionLookupTable != NULL,
+		generatingFunctionLookupTable != NULL
+		|| generatingFunctionLookupTableSingle != NULL,
 		"ChebyshevSolver::generateGreensFunction()",
 		"Lookup table has not been generated.",
 		"Use ChebyshevSolver::generateLookupTable() to generate lookup table."
 	);
 
+	if(generatingFunctionLookupTableSingle != NULL){
+		generateGreensFunction(
+			greensFunction,
+			coefficients,
+			generatingFunctionLookupTableSingle,
+			type
+		);
+	}
+	else{
+		generateGreensFunction(
+			greensFunction,
+			coefficients,
+			generatingFunctionLookupTable,
+			type
+		);
+	}
+}
+
+template<typename T>
+void ChebyshevSolver::generateGreensFunction(
+	complex<double> *greensFunction,
+	complex<double> *coefficients,
+	complex<T> **lookupTable,
+	GreensFunctionType type
+){
 	for(int e = 0; e < lookupTableResolution; e++)
 		greensFunction[e] = 0.;
 
 	if(type == GreensFunctionType::Retarded){
 		for(int n = 0; n < lookupTableNumCoefficients; n++){
 			for(int e = 0; e < lookupTableResolution; e++){
-				greensFunction[e] += generatingFunctionLookupTable[n][e]*coefficients[n];
+				greensFunction[e] += complex<double>(lookupTable[n][e])*coefficients[n];
 			}
 		}
 	}
 	else if(type == GreensFunctionType::Advanced){
 		for(int n = 0; n < lookupTableNumCoefficients; n++){
 			for(int e = 0; e < lookupTableResolution; e++){
-				greensFunction[e] += coefficients[n]*conj(generatingFunctionLookupTable[n][e]);
+				greensFunction[e] += coefficients[n]*conj(complex<double>(lookupTable[n][e]));
 			}
 		}
 	}
 	else if(type == GreensFunctionType::Principal){
 		for(int n = 0; n < lookupTableNumCoefficients; n++){
 			for(int e = 0; e < lookupTableResolution; e++){
-				greensFunction[e] += -coefficients[n]*real(generatingFunctionLookupTable[n][e]);
+				greensFunction[e] += -coefficients[n]*(double)real(lookupTable[n][e]);
 			}
 		}
 	}
 	else if(type == GreensFunctionType::NonPrincipal){
 		for(int n = 0; n < lookupTableNumCoefficients; n++){
 			for(int e = 0; e < lookupTableResolution; e++){
-				greensFunction[e] -= coefficients[n]*i*imag(generatingFunctionLookupTable[n][e]);
+				greensFunction[e] -= coefficients[n]*i*(double)imag(lookupTable[n][e]);
 			}
 		}
 	}
@@ -19,9 +19,19 @@
  */
 
 #include "DiagonalizationSolver.h"
+#include "DenseLinearAlgebra.h"
 #include "TBTKMacros.h"
 #include "Streams.h"
-#include "TBTKMacros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <omp.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -30,21 +40,114 @@ namespace TBTK{
 DiagonalizationSolver::DiagonalizationSolver(){
 	model = NULL;
 
+	algorithm = Algorithm::Packed;
+	singlePrecision = false;
+	bandedStorage = false;
+	calculateEigenVectors = true;
+	firstState = -1;
+	lastState = -1;
+	useEnergyWindow = false;
+	lowerEnergy = 0.;
+	upperEnergy = 0.;
+	iterativeNumStates = -1;
+	iterativeTolerance = 1e-8;
+	maxIterativeSteps = 1000;
+	isWarm = false;
+
 	hamiltonian = NULL;
+	bandwidth = -1;
 	eigenValues = NULL;
 	eigenVectors = NULL;
+	numStates = 0;
+
+	work = NULL;
+	rwork = NULL;
+	iwork = NULL;
+	isuppz = NULL;
+	lwork = 0;
+	lrwork = 0;
+	liwork = 0;
+
+	hamiltonianSingle = NULL;
+	eigenValuesSingle = NULL;
+	eigenVectorsSingle = NULL;
+	workSingle = NULL;
+	rworkSingle = NULL;
+
+	eigenVectorFile = "";
+	eigenVectorPanelSize = 64;
+	maxResidentPanels = 16;
+	mappedArray = NULL;
+	mappedSize = 0;
+	eigenVectorFileDescriptor = -1;
 
 	maxIterations = 50;
 	scCallback = NULL;
 }
 
 DiagonalizationSolver::~DiagonalizationSolver(){
-	if(hamiltonian != NULL)
+	clear();
+}
+
+void DiagonalizationSolver::clear(){
+	if(mappedArray != NULL){
+		eigenVectors = NULL;
+		munmap(mappedArray, mappedSize);
+		close(eigenVectorFileDescriptor);
+		mappedArray = NULL;
+		mappedSize = 0;
+		eigenVectorFileDescriptor = -1;
+		residentPanels.clear();
+	}
+	//The divide and conquer algorithm returns the eigenvectors in place
+	//of the Hamiltonian.
+	if(eigenVectors != NULL && eigenVectors != hamiltonian)
+		delete [] eigenVectors;
+	eigenVectors = NULL;
+	if(hamiltonian != NULL){
 		delete [] hamiltonian;
-	if(eigenValues != NULL)
+		hamiltonian = NULL;
+	}
+	if(eigenValues != NULL){
 		delete [] eigenValues;
-	if(eigenVectors != NULL)
-		delete eigenVectors;
+		eigenValues = NULL;
+	}
+	if(work != NULL){
+		delete [] work;
+		work = NULL;
+	}
+	if(rwork != NULL){
+		delete [] rwork;
+		rwork = NULL;
+	}
+	if(iwork != NULL){
+		delete [] iwork;
+		iwork = NULL;
+	}
+	if(isuppz != NULL){
+		delete [] isuppz;
+		isuppz = NULL;
+	}
+	if(hamiltonianSingle != NULL){
+		delete [] hamiltonianSingle;
+		hamiltonianSingle = NULL;
+	}
+	if(eigenValuesSingle != NULL){
+		delete [] eigenValuesSingle;
+		eigenValuesSingle = NULL;
+	}
+	if(eigenVectorsSingle != NULL){
+		delete [] eigenVectorsSingle;
+		eigenVectorsSingle = NULL;
+	}
+	if(workSingle != NULL){
+		delete [] workSingle;
+		workSingle = NULL;
+	}
+	if(rworkSingle != NULL){
+		delete [] rworkSingle;
+		rworkSingle = NULL;
+	}
 }
 
 void DiagonalizationSolver::run(){
@@ -81,39 +184,6 @@ void DiagonalizationSolver::run(){
 	Streams::out << "\n";
 }
 
-void DiagonalizationSolver::init(){
-	Streams::out << "Initializing DiagonalizationSolver\n";
-
-//	model->amplitudeSet.construct();
-
-	int basisSize = model->getBasisSize();
-	Streams::out << "\tBasis size: " << basisSize << "\n";
-
-	hamiltonian = new complex<double>[(basisSize*(basisSize+1))/2];
-	eigenValues = new double[basisSize];
-	eigenVectors = new complex<double>[basisSize*basisSize];
-
-	update();
-}
-
-void DiagonalizationSolver::update(){
-	int basisSize = model->getBasisSize();
-
-	for(int n = 0; n < (basisSize*(basisSize+1))/2; n++)
-		hamiltonian[n] = 0.;
-
-	AmplitudeSet::Iterator it = model->getAmplitudeSet()->getIterator();
-	const HoppingAmplitude *ha;
-	while((ha = it.getHA())){
-		int from = model->getAmplitudeSet()->getBasisIndex(ha->fromIndex);
-		int to = model->getAmplitudeSet()->getBasisIndex(ha->toIndex);
-		if(from >= to)
-			hamiltonian[to + (from*(from+1))/2] += ha->getAmplitude();
-
-		it.searchNextHA();
-	}
-}
-
 //Lapack function for matrix diagonalization of triangular matrix.
 extern "C" void zhpev_(char *jobz,		//'E' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
 			char *uplo,		//'U' = Stored as upper triangular, 'L' = Stored as lower triangular.
@@ -127,7 +197,7 @@ extern "C" void zhpev_(char *jobz,		//'E' = Eigenvalues only, 'V' = Eigenvalues
 			int *info);		//0 = successful, <0 = -info value was illegal, >0 = info number of off-diagonal elements failed to converge.
 
 //Lapack function for matrix diagonalization of banded triangular matrix
-extern "C" void zhbeb_(
+extern "C" void zhbev_(
 	char *jobz,		//'E' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
 	char *uplo,		//'U' = Stored as upper triangular, 'L' = Stored as lower triangular.
 	int *n,			//n*n = Matrix size
@@ -137,58 +207,702 @@ extern "C" void zhbeb_(
 	double *w,		//Eigenvalues, is in accending order if info = 0
 	complex<double> *z,	//Eigenvectors
 	int *ldz,		//
-	complex<double> *work,	//Workspace, dimension = max(1, 2*N-1)
+	complex<double> *work,	//Workspace, dimension = N
 	double *rwork,		//Workspace, dimension = max(1, 3*N-2)
 	int *info);		//0 = successful, <0 = -info value was illegal, >0 = info number of off-diagonal elements failed to converge.
 
-void DiagonalizationSolver::solve(){
-	if(true){//Currently no support for banded matrices.
-		//Setup zhpev to calculate...
-		char jobz = 'V';		//...eigenvalues and eigenvectors...
-		char uplo = 'U';		//...for an upper triangular...
-		int n = model->getBasisSize();	//...nxn-matrix.
-		//Initialize workspaces
-		complex<double> *work = new complex<double>[(2*n-1)];
-		double *rwork = new double[3*n-2];
+//Lapack function for divide and conquer diagonalization of full matrix.
+extern "C" void zheevd_(
+	char *jobz,		//'N' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+	char *uplo,		//'U' = Stored as upper triangular, 'L' = Stored as lower triangular.
+	int *n,			//n*n = Matrix size
+	complex<double> *a,	//Input matrix. Contains the eigenvectors on exit if jobz = 'V'
+	int *lda,		//Leading dimension of a
+	double *w,		//Eigenvalues, is in accending order if info = 0
+	complex<double> *work,	//Workspace
+	int *lwork,		//Size of work. -1 = workspace query
+	double *rwork,		//Workspace
+	int *lrwork,		//Size of rwork. -1 = workspace query
+	int *iwork,		//Workspace
+	int *liwork,		//Size of iwork. -1 = workspace query
+	int *info);		//0 = successful, <0 = -info value was illegal, >0 = failed to converge.
+
+//Lapack function for MRRR diagonalization of full matrix, with support for
+//calculating a subset of the eigenvalues and eigenvectors.
+extern "C" void zheevr_(
+	char *jobz,		//'N' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+	char *range,		//'A' = All, 'V' = Eigenvalues in (vl, vu], 'I' = Eigenvalues il to iu
+	char *uplo,		//'U' = Stored as upper triangular, 'L' = Stored as lower triangular.
+	int *n,			//n*n = Matrix size
+	complex<double> *a,	//Input matrix. Destroyed on exit
+	int *lda,		//Leading dimension of a
+	double *vl,		//Lower bound of the energy window
+	double *vu,		//Upper bound of the energy window
+	int *il,		//Index of the first eigenvalue (starting from 1)
+	int *iu,		//Index of the last eigenvalue (starting from 1)
+	double *abstol,		//Absolute error tolerance. <= 0 = default
+	int *m,			//Number of eigenvalues found
+	double *w,		//Eigenvalues, is in accending order if info = 0
+	complex<double> *z,	//Eigenvectors
+	int *ldz,		//Leading dimension of z
+	int *isuppz,		//Support of the eigenvectors, dimension = 2*max(1, m)
+	complex<double> *work,	//Workspace
+	int *lwork,		//Size of work. -1 = workspace query
+	double *rwork,		//Workspace
+	int *lrwork,		//Size of rwork. -1 = workspace query
+	int *iwork,		//Workspace
+	int *liwork,		//Size of iwork. -1 = workspace query
+	int *info);		//0 = successful, <0 = -info value was illegal, >0 = internal error.
+
+//Single precision versions of the LAPACK functions above.
+extern "C" void chpev_(
+	char *jobz,
+	char *uplo,
+	int *n,
+	complex<float> *ap,
+	float *w,
+	complex<float> *z,
+	int *ldz,
+	complex<float> *work,
+	float *rwork,
+	int *info
+);
+
+extern "C" void chbev_(
+	char *jobz,
+	char *uplo,
+	int *n,
+	int *kd,
+	complex<float> *ab,
+	int *ldab,
+	float *w,
+	complex<float> *z,
+	int *ldz,
+	complex<float> *work,
+	float *rwork,
+	int *info
+);
+
+extern "C" void cheevd_(
+	char *jobz,
+	char *uplo,
+	int *n,
+	complex<float> *a,
+	int *lda,
+	float *w,
+	complex<float> *work,
+	int *lwork,
+	float *rwork,
+	int *lrwork,
+	int *iwork,
+	int *liwork,
+	int *info
+);
+
+extern "C" void cheevr_(
+	char *jobz,
+	char *range,
+	char *uplo,
+	int *n,
+	complex<float> *a,
+	int *lda,
+	float *vl,
+	float *vu,
+	int *il,
+	int *iu,
+	float *abstol,
+	int *m,
+	float *w,
+	complex<float> *z,
+	int *ldz,
+	int *isuppz,
+	complex<float> *work,
+	int *lwork,
+	float *rwork,
+	int *lrwork,
+	int *iwork,
+	int *liwork,
+	int *info
+);
+
+void DiagonalizationSolver::init(){
+	Streams::out << "Initializing DiagonalizationSolver\n";
+
+	TBTKAssert(
+		algorithm == Algorithm::MRRR
+		|| (firstState == -1 && !useEnergyWindow),
+		"DiagonalizationSolver::init()",
+		"State and energy windows are only supported by the MRRR algorithm.",
+		"Use DiagonalizationSolver::setAlgorithm(DiagonalizationSolver::Algorithm::MRRR)."
+	);
+
+	TBTKAssert(
+		iterativeNumStates == -1 || calculateEigenVectors,
+		"DiagonalizationSolver::init()",
+		"The iterative diagonalization requires eigenvectors.",
+		"Use DiagonalizationSolver::setCalculateEigenVectors(true)."
+	);
+
+	clear();
+	isWarm = false;
+
+	int basisSize = model->getBasisSize();
+	Streams::out << "\tBasis size: " << basisSize << "\n";
+	if(singlePrecision)
+		Streams::out << "\tPrecision: single\n";
+
+	size_t hamiltonianSize;
+	if(algorithm == Algorithm::Packed){
+		//Store the Hamiltonian on banded format if requested and the
+		//bandwidth is small enough for the banded eigensolver to pay
+		//off, for example when the basis has been reordered using
+		//Model::setBasisReordering().
+		int kd = -1;
+		if(bandedStorage)
+			kd = model->getAmplitudeSet()->getAmplitudeArray().getBandwidth();
+		if(bandedStorage && BANDED_BANDWIDTH_RATIO*(kd+1) <= basisSize){
+			bandwidth = kd;
+			Streams::out << "\tBandwidth: " << bandwidth << "\n";
+			hamiltonianSize = (size_t)(bandwidth+1)*basisSize;
+			lwork = max(1, basisSize);
+		}
+		else{
+			bandwidth = -1;
+			hamiltonianSize = ((size_t)basisSize*(basisSize+1))/2;
+			lwork = max(1, 2*basisSize-1);
+		}
+		lrwork = max(1, 3*basisSize-2);
+	}
+	else{
+		bandwidth = -1;
+		hamiltonianSize = (size_t)basisSize*basisSize;
+	}
+	if(singlePrecision){
+		hamiltonianSingle = new complex<float>[hamiltonianSize];
+		eigenValuesSingle = new float[basisSize];
+	}
+	else{
+		hamiltonian = new complex<double>[hamiltonianSize];
+	}
+
+	eigenValues = new double[basisSize];
+	numStates = basisSize;
+	if(firstState != -1)
+		numStates = lastState - firstState + 1;
+	if(calculateEigenVectors){
+		if(eigenVectorFile.compare("") != 0)
+			eigenVectors = mapEigenVectorFile((size_t)basisSize*numStates);
+		else if(algorithm == Algorithm::DivideAndConquer && !singlePrecision)
+			eigenVectors = hamiltonian;
+		else
+			eigenVectors = new complex<double>[(size_t)basisSize*numStates];
+
+		if(singlePrecision && algorithm != Algorithm::DivideAndConquer)
+			eigenVectorsSingle = new complex<float>[(size_t)basisSize*numStates];
+	}
+	if(mappedArray != NULL){
+		Streams::out << "\tEigenvector file: " << eigenVectorFile << "\n";
+		Streams::out << "\tPanel size: " << eigenVectorPanelSize << "\n";
+	}
+
+	//Query the optimal workspace sizes once, so that the workspaces can
+	//be reused in every iteration of the self-consistency loop.
+	if(algorithm != Algorithm::Packed){
+		char jobz = calculateEigenVectors ? 'V' : 'N';
+		char uplo = 'U';
+		int n = basisSize;
+		int lda = max(1, n);
+		int query = -1;
+		complex<double> workQuery;
+		double rworkQuery;
+		int iworkQuery;
 		int info;
-		//Solve brop
-		zhpev_(&jobz, &uplo, &n, hamiltonian, eigenValues, eigenVectors, &n, work, rwork, &info);
+		if(singlePrecision){
+			complex<float> workQuerySingle;
+			float rworkQuerySingle;
+			if(algorithm == Algorithm::DivideAndConquer){
+				cheevd_(&jobz, &uplo, &n, hamiltonianSingle, &lda, eigenValuesSingle, &workQuerySingle, &query, &rworkQuerySingle, &query, &iworkQuery, &query, &info);
+			}
+			else{
+				char range = 'A';
+				float vl = 0.;
+				float vu = 0.;
+				int il = 1;
+				int iu = 1;
+				float abstol = 0.;
+				int m;
+				complex<float> z;
+				int ldz = lda;
+				int isuppzQuery[2];
+				cheevr_(&jobz, &range, &uplo, &n, hamiltonianSingle, &lda, &vl, &vu, &il, &iu, &abstol, &m, eigenValuesSingle, &z, &ldz, isuppzQuery, &workQuerySingle, &query, &rworkQuerySingle, &query, &iworkQuery, &query, &info);
+				isuppz = new int[2*max(1, n)];
+			}
+			workQuery = complex<double>(workQuerySingle);
+			rworkQuery = rworkQuerySingle;
+		}
+		else if(algorithm == Algorithm::DivideAndConquer){
+			zheevd_(&jobz, &uplo, &n, hamiltonian, &lda, eigenValues, &workQuery, &query, &rworkQuery, &query, &iworkQuery, &query, &info);
+		}
+		else{
+			char range = 'A';
+			double vl = 0.;
+			double vu = 0.;
+			int il = 1;
+			int iu = 1;
+			double abstol = 0.;
+			int m;
+			complex<double> z;
+			int ldz = lda;
+			int isuppzQuery[2];
+			zheevr_(&jobz, &range, &uplo, &n, hamiltonian, &lda, &vl, &vu, &il, &iu, &abstol, &m, eigenValues, &z, &ldz, isuppzQuery, &workQuery, &query, &rworkQuery, &query, &iworkQuery, &query, &info);
+			isuppz = new int[2*max(1, n)];
+		}
 
 		TBTKAssert(
 			info == 0,
-			"DiagonalizationSolver:solve()",
-			"Diagonalization routine zhpev exited with INFO=" + to_string(info) + ".",
-			"See LAPACK documentation for zhpev for further information."
+			"DiagonalizationSolver::init()",
+			"Workspace query exited with INFO=" + to_string(info) + ".",
+			"See LAPACK documentation for zheevd, zheevr, cheevd, and cheevr for further information."
 		);
 
-		//Delete workspaces
-		delete [] work;
-		delete [] rwork;
+		lwork = max(1, (int)real(workQuery));
+		lrwork = max(1, (int)rworkQuery);
+		liwork = max(1, iworkQuery);
+		iwork = new int[liwork];
+	}
+	if(singlePrecision){
+		workSingle = new complex<float>[lwork];
+		rworkSingle = new float[lrwork];
+	}
+	else{
+		work = new complex<double>[lwork];
+		rwork = new double[lrwork];
 	}
-/*	else{
-		int kd;
-		if(size_z != 1)
-			kd = orbitals*size_x*size_y*size_z;
-		else if(size_y != 1)
-			kd = orbitals*size_x*size_y;
-		else
-			kd = orbitals*size_x;
-		//Setup zhbev to calculate...
-		char jobz = 'V';			//...eigenvalues and eigenvectors...
-		char uplo = 'U';			//...for and upper triangluar...
-		int n = orbitals*size_x*size_y*size_z;	//...nxn-matrix.
-		int ldab = kd + 1;
-		//Initialize workspaces
-		complex<double> *work = new complex<double>[n];
-		double *rwork = new double[3*n-2];
-		int info;
-		//Solve brop
-		zhbev_(&jobz, &uplo, &n, &kd, hamiltonian, &ldab, eigenValues, eigenVectors, &n, work, rwork, &info);
 
-		//delete workspaces
-		delete [] work;
-		delete [] rwork;
-	}*/
+	update();
+}
+
+void DiagonalizationSolver::update(){
+	//The iterative diagonalization works directly on the AmplitudeArray.
+	if(isWarm){
+		model->getAmplitudeSet()->getAmplitudeArray().evaluateCallbacks();
+		return;
+	}
+
+	if(singlePrecision)
+		setupHamiltonian(hamiltonianSingle);
+	else
+		setupHamiltonian(hamiltonian);
+}
+
+template<typename T>
+void DiagonalizationSolver::setupHamiltonian(complex<T> *matrix){
+	int basisSize = model->getBasisSize();
+
+	size_t hamiltonianSize;
+	if(algorithm != Algorithm::Packed)
+		hamiltonianSize = (size_t)basisSize*basisSize;
+	else if(bandwidth == -1)
+		hamiltonianSize = ((size_t)basisSize*(basisSize+1))/2;
+	else
+		hamiltonianSize = (size_t)(bandwidth+1)*basisSize;
+	for(size_t n = 0; n < hamiltonianSize; n++)
+		matrix[n] = 0.;
+
+	AmplitudeArray &amplitudeArray = model->getAmplitudeSet()->getAmplitudeArray();
+	amplitudeArray.evaluateCallbacks();
+	const int *fromBasisIndices = amplitudeArray.getFromBasisIndices();
+	const int *toBasisIndices = amplitudeArray.getToBasisIndices();
+	const complex<double> *values = amplitudeArray.getValues();
+
+	//Each thread processes a range of amplitudes with 'from'-basis indices
+	//that no other thread processes, and therefore writes to its own set of
+	//matrix elements.
+	#pragma omp parallel
+	{
+		AmplitudeArray::Range range = amplitudeArray.getRange(
+			omp_get_num_threads(),
+			omp_get_thread_num()
+		);
+		for(int n = range.begin; n < range.end; n++){
+			int from = fromBasisIndices[n];
+			int to = toBasisIndices[n];
+			if(from >= to){
+				complex<T> value(values[n]);
+				if(algorithm != Algorithm::Packed)
+					matrix[to + (size_t)basisSize*from] += value;
+				else if(bandwidth == -1)
+					matrix[to + ((size_t)from*(from+1))/2] += value;
+				else
+					matrix[bandwidth + to - from + (bandwidth+1)*from] += value;
+			}
+		}
+	}
+}
+
+void DiagonalizationSolver::solve(){
+	if(isWarm){
+		solveIterative();
+		return;
+	}
+
+	if(singlePrecision)
+		solveSinglePrecision();
+	else
+		solveDoublePrecision();
+
+	//LAPACK has touched every page of the eigenvectors. Write them to the
+	//file and release them, so that the memory is only occupied by the
+	//panels that are loaded later.
+	if(mappedArray != NULL){
+		msync(mappedArray, mappedSize, MS_SYNC);
+		releaseMappedRange(0, mappedSize);
+		residentPanels.clear();
+	}
+
+	//The following iterations start from the eigenvectors found here,
+	//and do not need the dense Hamiltonian.
+	if(iterativeNumStates != -1){
+		isWarm = true;
+		if(hamiltonian != NULL){
+			delete [] hamiltonian;
+			hamiltonian = NULL;
+		}
+		if(hamiltonianSingle != NULL){
+			delete [] hamiltonianSingle;
+			hamiltonianSingle = NULL;
+		}
+	}
+}
+
+void DiagonalizationSolver::solveDoublePrecision(){
+	//Setup LAPACK to calculate...
+	char jobz = calculateEigenVectors ? 'V' : 'N';	//...eigenvalues and possibly eigenvectors...
+	char uplo = 'U';				//...for an upper triangular...
+	int n = model->getBasisSize();			//...nxn-matrix.
+	int ldz = max(1, n);
+	//Eigenvectors are not referenced by LAPACK in eigenvalues only mode,
+	//but a valid pointer is still required.
+	complex<double> dummy;
+	complex<double> *z = calculateEigenVectors ? eigenVectors : &dummy;
+	int info;
+	string routine;
+
+	switch(algorithm){
+	case Algorithm::Packed:
+		if(bandwidth == -1){
+			routine = "zhpev";
+			zhpev_(&jobz, &uplo, &n, hamiltonian, eigenValues, z, &ldz, work, rwork, &info);
+		}
+		else{
+			routine = "zhbev";
+			int kd = bandwidth;
+			int ldab = kd + 1;
+			zhbev_(&jobz, &uplo, &n, &kd, hamiltonian, &ldab, eigenValues, z, &ldz, work, rwork, &info);
+		}
+		break;
+	case Algorithm::DivideAndConquer:
+		routine = "zheevd";
+		zheevd_(&jobz, &uplo, &n, hamiltonian, &ldz, eigenValues, work, &lwork, rwork, &lrwork, iwork, &liwork, &info);
+		//zheevd returns the eigenvectors in place of the Hamiltonian.
+		if(info == 0 && calculateEigenVectors && eigenVectors != hamiltonian)
+			copy(hamiltonian, hamiltonian + (size_t)n*n, eigenVectors);
+		break;
+	case Algorithm::MRRR:
+	{
+		routine = "zheevr";
+		char range = 'A';
+		double vl = lowerEnergy;
+		double vu = upperEnergy;
+		int il = firstState + 1;
+		int iu = lastState + 1;
+		if(firstState != -1)
+			range = 'I';
+		else if(useEnergyWindow)
+			range = 'V';
+		double abstol = 0.;
+		zheevr_(&jobz, &range, &uplo, &n, hamiltonian, &ldz, &vl, &vu, &il, &iu, &abstol, &numStates, eigenValues, z, &ldz, isuppz, work, &lwork, rwork, &lrwork, iwork, &liwork, &info);
+		break;
+	}
+	default:
+		TBTKExit(
+			"DiagonalizationSolver::solve()",
+			"Unknown algorithm.",
+			"This should never happen, contact the developer."
+		);
+	}
+
+	TBTKAssert(
+		info == 0,
+		"DiagonalizationSolver:solve()",
+		"Diagonalization routine " + routine + " exited with INFO=" + to_string(info) + ".",
+		"See LAPACK documentation for " + routine + " for further information."
+	);
+}
+
+void DiagonalizationSolver::solveSinglePrecision(){
+	//Setup LAPACK to calculate...
+	char jobz = calculateEigenVectors ? 'V' : 'N';	//...eigenvalues and possibly eigenvectors...
+	char uplo = 'U';				//...for an upper triangular...
+	int n = model->getBasisSize();			//...nxn-matrix.
+	int ldz = max(1, n);
+	complex<float> dummy;
+	complex<float> *z = calculateEigenVectors ? eigenVectorsSingle : &dummy;
+	int info;
+	string routine;
+
+	switch(algorithm){
+	case Algorithm::Packed:
+		if(bandwidth == -1){
+			routine = "chpev";
+			chpev_(&jobz, &uplo, &n, hamiltonianSingle, eigenValuesSingle, z, &ldz, workSingle, rworkSingle, &info);
+		}
+		else{
+			routine = "chbev";
+			int kd = bandwidth;
+			int ldab = kd + 1;
+			chbev_(&jobz, &uplo, &n, &kd, hamiltonianSingle, &ldab, eigenValuesSingle, z, &ldz, workSingle, rworkSingle, &info);
+		}
+		break;
+	case Algorithm::DivideAndConquer:
+		routine = "cheevd";
+		cheevd_(&jobz, &uplo, &n, hamiltonianSingle, &ldz, eigenValuesSingle, workSingle, &lwork, rworkSingle, &lrwork, iwork, &liwork, &info);
+		//cheevd returns the eigenvectors in place of the Hamiltonian.
+		z = hamiltonianSingle;
+		break;
+	case Algorithm::MRRR:
+	{
+		routine = "cheevr";
+		char range = 'A';
+		float vl = lowerEnergy;
+		float vu = upperEnergy;
+		int il = firstState + 1;
+		int iu = lastState + 1;
+		if(firstState != -1)
+			range = 'I';
+		else if(useEnergyWindow)
+			range = 'V';
+		float abstol = 0.;
+		cheevr_(&jobz, &range, &uplo, &n, hamiltonianSingle, &ldz, &vl, &vu, &il, &iu, &abstol, &numStates, eigenValuesSingle, z, &ldz, isuppz, workSingle, &lwork, rworkSingle, &lrwork, iwork, &liwork, &info);
+		break;
+	}
+	default:
+		TBTKExit(
+			"DiagonalizationSolver::solveSinglePrecision()",
+			"Unknown algorithm.",
+			"This should never happen, contact the developer."
+		);
+	}
+
+	TBTKAssert(
+		info == 0,
+		"DiagonalizationSolver:solve()",
+		"Diagonalization routine " + routine + " exited with INFO=" + to_string(info) + ".",
+		"See LAPACK documentation for " + routine + " for further information."
+	);
+
+	for(int state = 0; state < numStates; state++)
+		eigenValues[state] = eigenValuesSingle[state];
+
+	if(calculateEigenVectors){
+		size_t size = (size_t)n*numStates;
+		#pragma omp parallel for
+		for(size_t c = 0; c < size; c++)
+			eigenVectors[c] = complex<double>(z[c]);
+	}
+}
+
+complex<double>* DiagonalizationSolver::mapEigenVectorFile(size_t size){
+	eigenVectorFileDescriptor = open(
+		eigenVectorFile.c_str(),
+		O_RDWR | O_CREAT | O_TRUNC,
+		S_IRUSR | S_IWUSR
+	);
+	TBTKAssert(
+		eigenVectorFileDescriptor != -1,
+		"DiagonalizationSolver::init()",
+		"Unable to create eigenvector file '" << eigenVectorFile << "'.",
+		"Use DiagonalizationSolver::setEigenVectorFile() to set a writable path."
+	);
+	unlink(eigenVectorFile.c_str());
+
+	mappedSize = size*sizeof(complex<double>);
+	int result = ftruncate(eigenVectorFileDescriptor, mappedSize);
+	TBTKAssert(
+		result == 0,
+		"DiagonalizationSolver::init()",
+		"Unable to allocate " << mappedSize << " bytes in eigenvector file '" << eigenVectorFile << "'.",
+		"Make sure that there is enough space on the file system."
+	);
+
+	void *address = mmap(
+		NULL,
+		mappedSize,
+		PROT_READ | PROT_WRITE,
+		MAP_SHARED,
+		eigenVectorFileDescriptor,
+		0
+	);
+	TBTKAssert(
+		address != MAP_FAILED,
+		"DiagonalizationSolver::init()",
+		"Unable to memory-map eigenvector file '" << eigenVectorFile << "'.",
+		""
+	);
+
+	mappedArray = (complex<double>*)address;
+
+	return mappedArray;
+}
+
+void DiagonalizationSolver::releaseMappedRange(size_t begin, size_t end){
+	//Only release whole pages, since the neighboring panels may be
+	//resident.
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	begin = ((begin + pageSize - 1)/pageSize)*pageSize;
+	end = (end/pageSize)*pageSize;
+	if(begin >= end)
+		return;
+
+	madvise((char*)mappedArray + begin, end - begin, MADV_DONTNEED);
+	posix_fadvise(
+		eigenVectorFileDescriptor,
+		begin,
+		end - begin,
+		POSIX_FADV_DONTNEED
+	);
+}
+
+void DiagonalizationSolver::loadEigenVectorPanels(
+	int firstState,
+	int lastState
+){
+	if(mappedArray == NULL)
+		return;
+
+	size_t panelBytes = (size_t)model->getBasisSize()*eigenVectorPanelSize
+		*sizeof(complex<double>);
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	for(
+		int panel = firstState/eigenVectorPanelSize;
+		panel <= lastState/eigenVectorPanelSize;
+		panel++
+	){
+		list<int>::iterator iterator = find(
+			residentPanels.begin(),
+			residentPanels.end(),
+			panel
+		);
+		if(iterator != residentPanels.end()){
+			residentPanels.splice(
+				residentPanels.begin(),
+				residentPanels,
+				iterator
+			);
+			continue;
+		}
+
+		size_t begin = ((panel*panelBytes)/pageSize)*pageSize;
+		size_t end = min((panel + 1)*panelBytes, mappedSize);
+		madvise((char*)mappedArray + begin, end - begin, MADV_WILLNEED);
+		residentPanels.push_front(panel);
+	}
+
+	while((int)residentPanels.size() > maxResidentPanels){
+		int panel = residentPanels.back();
+		residentPanels.pop_back();
+		releaseMappedRange(
+			panel*panelBytes,
+			min((panel + 1)*panelBytes, mappedSize)
+		);
+	}
+}
+
+void DiagonalizationSolver::solveIterative(){
+	int n = model->getBasisSize();
+	int k = iterativeNumStates;
+
+	//The Hamiltonian is multiplied by the block vectors using the CSR
+	//block kernel of the ChebyshevSolver, with unit scale factor and no
+	//energy shift. The default block size is kept, since the specialized
+	//kernels outperform a single pass with the generic kernel.
+	chebyshevSolver.setModel(model);
+	chebyshevSolver.updateHamiltonian();
+
+	//The basis for the Rayleigh-Ritz procedure consists of the current
+	//eigenvectors X, the residuals R, and the search directions P.
+	size_t blockVectorSize = (size_t)n*k;
+	vector<complex<double>> s(3*blockVectorSize);
+	vector<complex<double>> hs(3*blockVectorSize);
+	vector<complex<double>> hx(blockVectorSize);
+	vector<complex<double>> p(blockVectorSize);
+	vector<complex<double>> xNew(blockVectorSize);
+	vector<complex<double>> reduced(9*k*k);
+	vector<complex<double>> overlap(k*k);
+	vector<double> ritzValues(3*k);
+	complex<double> *x = eigenVectors;
+	int numP = 0;
+
+	chebyshevSolver.multiplyScaledHamiltonian(x, hx.data(), k);
+	for(int j = 0; j < k; j++){
+		complex<double> rayleighQuotient = 0.;
+		for(int c = 0; c < n; c++)
+			rayleighQuotient += conj(x[(size_t)n*j + c])*hx[(size_t)n*j + c];
+		eigenValues[j] = real(rayleighQuotient);
+	}
+
+	int step = 0;
+	while(true){
+		//Calculate the residuals and check for convergence.
+		double maxResidual = 0.;
+		for(int j = 0; j < k; j++){
+			double norm = 0.;
+			for(int c = 0; c < n; c++){
+				size_t element = (size_t)n*j + c;
+				complex<double> r = hx[element] - eigenValues[j]*x[element];
+				s[blockVectorSize + element] = r;
+				norm += real(conj(r)*r);
+			}
+			maxResidual = max(maxResidual, sqrt(norm));
+		}
+		if(maxResidual < iterativeTolerance)
+			break;
+
+		TBTKAssert(
+			step++ < maxIterativeSteps,
+			"DiagonalizationSolver::solveIterative()",
+			"LOBPCG did not converge in " << maxIterativeSteps << " steps. Residual: " << maxResidual << ".",
+			"Use DiagonalizationSolver::setMaxIterativeSteps() to increase the number of steps, or DiagonalizationSolver::setIterativeTolerance() to relax the tolerance."
+		);
+
+		for(size_t c = 0; c < blockVectorSize; c++)
+			s[c] = x[c];
+		for(size_t c = 0; c < (size_t)n*numP; c++)
+			s[2*blockVectorSize + c] = p[c];
+
+		int m = DenseLinearAlgebra::orthonormalize(s.data(), n, 2*k + numP);
+		chebyshevSolver.multiplyScaledHamiltonian(s.data(), hs.data(), m);
+
+		//Rayleigh-Ritz: diagonalize S^{\dagger}HS and keep the k lowest
+		//Ritz pairs.
+		DenseLinearAlgebra::multiply('C', 'N', m, m, n, 1., s.data(), n, hs.data(), n, 0., reduced.data(), m);
+		DenseLinearAlgebra::diagonalizeHermitian(reduced.data(), ritzValues.data(), m);
+		DenseLinearAlgebra::multiply('N', 'N', n, k, m, 1., s.data(), n, reduced.data(), m, 0., xNew.data(), n);
+		DenseLinearAlgebra::multiply('N', 'N', n, k, m, 1., hs.data(), n, reduced.data(), m, 0., hx.data(), n);
+
+		//The new search directions are the parts of the new eigenvectors
+		//that are orthogonal to the old ones.
+		DenseLinearAlgebra::multiply('C', 'N', k, k, n, 1., x, n, xNew.data(), n, 0., overlap.data(), k);
+		for(size_t c = 0; c < blockVectorSize; c++)
+			p[c] = xNew[c];
+		DenseLinearAlgebra::multiply('N', 'N', n, k, k, -1., x, n, overlap.data(), k, 1., p.data(), n);
+		numP = k;
+
+		for(size_t c = 0; c < blockVectorSize; c++)
+			x[c] = xNew[c];
+		for(int j = 0; j < k; j++)
+			eigenValues[j] = ritzValues[j];
+	}
 }
 
 };	//End of namespace TBTK
@@ -0,0 +1,202 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file DistributedDiagonalizationSolver.cpp
+ *
+ *  @author agent
+ */
+
+#include "DistributedDiagonalizationSolver.h"
+#include "Streams.h"
+#include "TBTKMacros.h"
+
+#include <omp.h>
+
+using namespace std;
+
+namespace TBTK{
+
+DistributedDiagonalizationSolver::DistributedDiagonalizationSolver(){
+	model = NULL;
+
+	blockSize = 64;
+	requestedProcessRows = -1;
+	requestedProcessColumns = -1;
+
+	rank = 0;
+	numProcesses = 1;
+	context = -1;
+	numProcessRows = 1;
+	numProcessColumns = 1;
+	processRow = 0;
+	processColumn = 0;
+	panelContext = -1;
+
+	numLocalRows = 0;
+	numLocalColumns = 0;
+	hamiltonian = NULL;
+	eigenVectors = NULL;
+	eigenValues = NULL;
+	numLocalStates = 0;
+	localEigenVectors = NULL;
+
+	maxIterations = 50;
+	scCallback = NULL;
+}
+
+DistributedDiagonalizationSolver::~DistributedDiagonalizationSolver(){
+	clear();
+}
+
+void DistributedDiagonalizationSolver::clear(){
+	if(hamiltonian != NULL){
+		delete [] hamiltonian;
+		hamiltonian = NULL;
+	}
+	if(eigenVectors != NULL){
+		delete [] eigenVectors;
+		eigenVectors = NULL;
+	}
+	if(eigenValues != NULL){
+		delete [] eigenValues;
+		eigenValues = NULL;
+	}
+	if(localEigenVectors != NULL){
+		delete [] localEigenVectors;
+		localEigenVectors = NULL;
+	}
+	if(context != -1){
+		exitProcessGrid();
+		context = -1;
+		panelContext = -1;
+	}
+}
+
+void DistributedDiagonalizationSolver::run(){
+	TBTKAssert(
+		model != NULL,
+		"DistributedDiagonalizationSolver::run()",
+		"Model not set.",
+		"Use DistributedDiagonalizationSolver::setModel() to set model."
+	);
+
+	int iterationCounter = 0;
+	init();
+
+	if(rank == 0)
+		Streams::out << "Running DistributedDiagonalizationSolver\n";
+	while(iterationCounter++ < maxIterations){
+		if(rank == 0){
+			if(iterationCounter%10 == 1)
+				Streams::out << " ";
+			if(iterationCounter%50 == 1)
+				Streams::out << "\n";
+			Streams::out << "." << flush;
+		}
+
+		solve();
+
+		if(scCallback){
+			if(scCallback(this))
+				break;
+			else
+				update();
+		}
+		else{
+			break;
+		}
+	}
+	if(rank == 0)
+		Streams::out << "\n";
+}
+
+void DistributedDiagonalizationSolver::init(){
+	clear();
+	initProcessGrid();
+
+	int basisSize = model->getBasisSize();
+	if(rank == 0){
+		Streams::out << "Initializing DistributedDiagonalizationSolver\n";
+		Streams::out << "\tBasis size: " << basisSize << "\n";
+		Streams::out << "\tProcess grid: " << numProcessRows << "x" << numProcessColumns << "\n";
+		Streams::out << "\tBlock size: " << blockSize << "\n";
+	}
+
+	numLocalRows = getNumLocal(
+		basisSize,
+		blockSize,
+		processRow,
+		numProcessRows
+	);
+	numLocalColumns = getNumLocal(
+		basisSize,
+		blockSize,
+		processColumn,
+		numProcessColumns
+	);
+	hamiltonian = new complex<double>[(size_t)numLocalRows*numLocalColumns];
+	eigenVectors = new complex<double>[(size_t)numLocalRows*numLocalColumns];
+	eigenValues = new double[basisSize];
+
+	numLocalStates = getNumLocal(basisSize, blockSize, rank, numProcesses);
+	localEigenVectors = new complex<double>[(size_t)basisSize*numLocalStates];
+
+	update();
+}
+
+void DistributedDiagonalizationSolver::update(){
+	size_t hamiltonianSize = (size_t)numLocalRows*numLocalColumns;
+	for(size_t n = 0; n < hamiltonianSize; n++)
+		hamiltonian[n] = 0.;
+
+	AmplitudeArray &amplitudeArray = model->getAmplitudeSet()->getAmplitudeArray();
+	amplitudeArray.evaluateCallbacks();
+	const int *fromBasisIndices = amplitudeArray.getFromBasisIndices();
+	const int *toBasisIndices = amplitudeArray.getToBasisIndices();
+	const complex<double> *values = amplitudeArray.getValues();
+
+	//Each process keeps the upper triangular matrix elements it owns. Each
+	//thread processes a range of amplitudes with 'from'-basis indices,
+	//which are the columns, that no other thread processes.
+	#pragma omp parallel
+	{
+		AmplitudeArray::Range range = amplitudeArray.getRange(
+			omp_get_num_threads(),
+			omp_get_thread_num()
+		);
+		for(int n = range.begin; n < range.end; n++){
+			int from = fromBasisIndices[n];
+			int to = toBasisIndices[n];
+			if(
+				from >= to
+				&& getOwner(to, blockSize, numProcessRows)
+					== processRow
+				&& getOwner(from, blockSize, numProcessColumns)
+					== processColumn
+			){
+				int row = getLocal(to, blockSize, numProcessRows);
+				int column = getLocal(
+					from,
+					blockSize,
+					numProcessColumns
+				);
+				hamiltonian[row + (size_t)numLocalRows*column]
+					+= values[n];
+			}
+		}
+	}
+}
+
+};	//End of namespace TBTK
@@ -0,0 +1,218 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file SelfConsistencyDriver.cpp
+ *
+ *  @author agent
+ */
+
+#include "SelfConsistencyDriver.h"
+#include "TBTKMacros.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace TBTK{
+
+namespace{
+	//Regularization of the modified Broyden method. Johnson recommends
+	//0.01.
+	const double BROYDEN_W0 = 0.01;
+
+	//Real inner product of two complex vectors, regarded as real vectors
+	//with twice as many components.
+	double innerProduct(
+		const vector<complex<double>> &v0,
+		const vector<complex<double>> &v1
+	){
+		double result = 0.;
+		for(unsigned int n = 0; n < v0.size(); n++)
+			result += real(conj(v0[n])*v1[n]);
+
+		return result;
+	}
+}
+
+SelfConsistencyDriver::SelfConsistencyDriver(){
+	orderParameter = NULL;
+	size = 0;
+	method = Method::Anderson;
+	mixingParameter = 0.5;
+	historySize = 8;
+	convergenceLimit = 1e-4;
+}
+
+SelfConsistencyDriver::~SelfConsistencyDriver(){
+}
+
+void SelfConsistencyDriver::setOrderParameter(
+	complex<double> *orderParameter,
+	int size
+){
+	this->orderParameter = orderParameter;
+	this->size = size;
+	reset();
+}
+
+void SelfConsistencyDriver::reset(){
+	residualHistory.clear();
+	previousInput.clear();
+	previousResidual.clear();
+	inputDifferences.clear();
+	residualDifferences.clear();
+}
+
+bool SelfConsistencyDriver::update(const complex<double> *output){
+	TBTKAssert(
+		orderParameter != NULL,
+		"SelfConsistencyDriver::update()",
+		"Order parameter not set.",
+		"Use SelfConsistencyDriver::setOrderParameter() to set order parameter."
+	);
+	TBTKAssert(
+		historySize > 0,
+		"SelfConsistencyDriver::update()",
+		"historySize has to be larger than 0.",
+		"Use SelfConsistencyDriver::setHistorySize() to set history size."
+	);
+
+	vector<complex<double>> input(orderParameter, orderParameter + size);
+	vector<complex<double>> residual(size);
+	double maxResidual = 0.;
+	double maxOutput = 0.;
+	for(int n = 0; n < size; n++){
+		residual[n] = output[n] - input[n];
+		maxResidual = max(maxResidual, abs(residual[n]));
+		maxOutput = max(maxOutput, abs(output[n]));
+	}
+
+	double relativeResidual = maxResidual;
+	if(maxOutput > 0)
+		relativeResidual /= maxOutput;
+	residualHistory.push_back(relativeResidual);
+
+	if(relativeResidual < convergenceLimit){
+		for(int n = 0; n < size; n++)
+			orderParameter[n] = output[n];
+
+		return true;
+	}
+
+	//Add the differences to the previous iteration to the history. The
+	//modified Broyden method normalizes the differences by the norm of
+	//the residual difference.
+	if(method != Method::Linear && previousInput.size() != 0){
+		vector<complex<double>> inputDifference(size);
+		vector<complex<double>> residualDifference(size);
+		for(int n = 0; n < size; n++){
+			inputDifference[n] = input[n] - previousInput[n];
+			residualDifference[n] = residual[n] - previousResidual[n];
+		}
+
+		if(method == Method::Broyden){
+			double norm = sqrt(
+				innerProduct(residualDifference, residualDifference)
+			);
+			if(norm > 0){
+				for(int n = 0; n < size; n++){
+					inputDifference[n] /= norm;
+					residualDifference[n] /= norm;
+				}
+			}
+		}
+
+		inputDifferences.push_back(inputDifference);
+		residualDifferences.push_back(residualDifference);
+		if((int)inputDifferences.size() > historySize){
+			inputDifferences.erase(inputDifferences.begin());
+			residualDifferences.erase(residualDifferences.begin());
+		}
+	}
+	previousInput = input;
+	previousResidual = residual;
+
+	//x_{k+1} = x_k + a*F_k - sum_i c_i*(dx_i + a*dF_i), where the
+	//coefficients c_i minimize |F_k - sum_i c_i*dF_i|. Falls back to
+	//linear mixing and restarts the history if the minimization is
+	//singular.
+	vector<double> coefficients;
+	if(
+		inputDifferences.size() != 0
+		&& !calculateCoefficients(residual, coefficients)
+	){
+		inputDifferences.clear();
+		residualDifferences.clear();
+		coefficients.clear();
+	}
+
+	for(int n = 0; n < size; n++)
+		orderParameter[n] = input[n] + mixingParameter*residual[n];
+	for(unsigned int c = 0; c < coefficients.size(); c++){
+		const vector<complex<double>> &dx = inputDifferences[c];
+		const vector<complex<double>> &dF = residualDifferences[c];
+		for(int n = 0; n < size; n++){
+			orderParameter[n] -= coefficients[c]*(
+				dx[n] + mixingParameter*dF[n]
+			);
+		}
+	}
+
+	return false;
+}
+
+//Lapack function for solving a system of linear equations.
+extern "C" void dgesv_(
+	int *n,		//Number of equations
+	int *nrhs,	//Number of right hand sides
+	double *a,	//Coefficient matrix. Destroyed on exit
+	int *lda,	//Leading dimension of a
+	int *ipiv,	//Pivot indices
+	double *b,	//Right hand sides. Contains the solution on exit
+	int *ldb,	//Leading dimension of b
+	int *info	//0 = successful, <0 = -info value was illegal, >0 = singular
+);
+
+bool SelfConsistencyDriver::calculateCoefficients(
+	const vector<complex<double>> &residual,
+	vector<double> &coefficients
+){
+	int m = inputDifferences.size();
+	vector<double> overlaps(m*m);
+	coefficients.resize(m);
+	for(int r = 0; r < m; r++){
+		for(int c = 0; c <= r; c++){
+			overlaps[r + m*c] = innerProduct(
+				residualDifferences[r],
+				residualDifferences[c]
+			);
+			overlaps[c + m*r] = overlaps[r + m*c];
+		}
+		if(method == Method::Broyden)
+			overlaps[r + m*r] += BROYDEN_W0*BROYDEN_W0;
+
+		coefficients[r] = innerProduct(residualDifferences[r], residual);
+	}
+
+	int nrhs = 1;
+	vector<int> ipiv(m);
+	int info;
+	dgesv_(&m, &nrhs, overlaps.data(), &m, ipiv.data(), coefficients.data(), &m, &info);
+
+	return info == 0;
+}
+
+};	//End of namespace TBTK
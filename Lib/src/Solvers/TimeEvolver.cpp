@@ -103,17 +103,43 @@ void TimeEvolver::run(){
 		for(int n = 0; n < basisSize*basisSize; n++)
 			dPsi[n] = 0.;
 
-		AmplitudeSet::Iterator it = model->getAmplitudeSet()->getIterator();
-		const HoppingAmplitude *ha;
-		while((ha = it.getHA())){
-			int fromIndex = model->getAmplitudeSet()->getBasisIndex(ha->fromIndex);
-			int toIndex = model->getAmplitudeSet()->getBasisIndex(ha->toIndex);
-			complex<double> amplitude = ha->getAmplitude();
-			#pragma omp parallel for
-			for(int n = 0; n < basisSize; n++){
-				dPsi[basisSize*n + toIndex] += amplitude*eigenVectorsMap[n][fromIndex];
+		AmplitudeArray &amplitudeArray = model->getAmplitudeSet()->getAmplitudeArray();
+		amplitudeArray.evaluateCallbacks();
+		const int *fromBasisIndices = amplitudeArray.getFromBasisIndices();
+		const int *toBasisIndices = amplitudeArray.getToBasisIndices();
+		const complex<double> *values = amplitudeArray.getValues();
+		if(amplitudeArray.getHermitianStorage()){
+			//Each stored off-diagonal amplitude is applied both as
+			//itself and as its Hermitian conjugate.
+			for(int a = 0; a < amplitudeArray.getSize(); a++){
+				int fromIndex = fromBasisIndices[a];
+				int toIndex = toBasisIndices[a];
+				complex<double> amplitude = values[a];
+				if(fromIndex == toIndex){
+					#pragma omp parallel for
+					for(int n = 0; n < basisSize; n++){
+						dPsi[basisSize*n + toIndex] += amplitude*eigenVectorsMap[n][fromIndex];
+					}
+				}
+				else{
+					#pragma omp parallel for
+					for(int n = 0; n < basisSize; n++){
+						dPsi[basisSize*n + toIndex] += amplitude*eigenVectorsMap[n][fromIndex];
+						dPsi[basisSize*n + fromIndex] += conj(amplitude)*eigenVectorsMap[n][toIndex];
+					}
+				}
+			}
+		}
+		else{
+			for(int a = 0; a < amplitudeArray.getSize(); a++){
+				int fromIndex = fromBasisIndices[a];
+				int toIndex = toBasisIndices[a];
+				complex<double> amplitude = values[a];
+				#pragma omp parallel for
+				for(int n = 0; n < basisSize; n++){
+					dPsi[basisSize*n + toIndex] += amplitude*eigenVectorsMap[n][fromIndex];
+				}
 			}
-			it.searchNextHA();
 		}
 
 		#pragma omp parallel for
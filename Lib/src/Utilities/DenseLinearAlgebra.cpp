@@ -0,0 +1,160 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file DenseLinearAlgebra.cpp
+ *
+ *  @author agent
+ */
+
+#include "DenseLinearAlgebra.h"
+#include "TBTKMacros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+namespace TBTK{
+
+//Lapack function for divide and conquer diagonalization of full matrix.
+extern "C" void zheevd_(
+	char *jobz,		//'N' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+	char *uplo,		//'U' = Stored as upper triangular, 'L' = Stored as lower triangular.
+	int *n,			//n*n = Matrix size
+	complex<double> *a,	//Input matrix. Contains the eigenvectors on exit if jobz = 'V'
+	int *lda,		//Leading dimension of a
+	double *w,		//Eigenvalues, is in accending order if info = 0
+	complex<double> *work,	//Workspace
+	int *lwork,		//Size of work. -1 = workspace query
+	double *rwork,		//Workspace
+	int *lrwork,		//Size of rwork. -1 = workspace query
+	int *iwork,		//Workspace
+	int *liwork,		//Size of iwork. -1 = workspace query
+	int *info);		//0 = successful, <0 = -info value was illegal, >0 = failed to converge.
+
+//BLAS function for matrix-matrix multiplication.
+extern "C" void zgemm_(
+	char *transa,			//'N' = A, 'C' = A^{\dagger}
+	char *transb,			//'N' = B, 'C' = B^{\dagger}
+	int *m,				//Number of rows of op(A) and C
+	int *n,				//Number of columns of op(B) and C
+	int *k,				//Number of columns of op(A) and rows of op(B)
+	complex<double> *alpha,		//C = alpha*op(A)*op(B) + beta*C
+	const complex<double> *a,	//Matrix A
+	int *lda,			//Leading dimension of A
+	const complex<double> *b,	//Matrix B
+	int *ldb,			//Leading dimension of B
+	complex<double> *beta,		//C = alpha*op(A)*op(B) + beta*C
+	complex<double> *c,		//Matrix C
+	int *ldc);			//Leading dimension of C
+
+void DenseLinearAlgebra::multiply(
+	char transA,
+	char transB,
+	int m,
+	int n,
+	int k,
+	complex<double> alpha,
+	const complex<double> *a,
+	int lda,
+	const complex<double> *b,
+	int ldb,
+	complex<double> beta,
+	complex<double> *c,
+	int ldc
+){
+	zgemm_(&transA, &transB, &m, &n, &k, &alpha, a, &lda, b, &ldb, &beta, c, &ldc);
+}
+
+void DenseLinearAlgebra::diagonalizeHermitian(
+	complex<double> *matrix,
+	double *eigenValues,
+	int size
+){
+	char jobz = 'V';
+	char uplo = 'U';
+	int query = -1;
+	complex<double> workQuery;
+	double rworkQuery;
+	int iworkQuery;
+	int info;
+	zheevd_(&jobz, &uplo, &size, matrix, &size, eigenValues, &workQuery, &query, &rworkQuery, &query, &iworkQuery, &query, &info);
+
+	int lwork = max(1, (int)real(workQuery));
+	int lrwork = max(1, (int)rworkQuery);
+	int liwork = max(1, iworkQuery);
+	vector<complex<double>> work(lwork);
+	vector<double> rwork(lrwork);
+	vector<int> iwork(liwork);
+	zheevd_(&jobz, &uplo, &size, matrix, &size, eigenValues, work.data(), &lwork, rwork.data(), &lrwork, iwork.data(), &liwork, &info);
+
+	TBTKAssert(
+		info == 0,
+		"DenseLinearAlgebra::diagonalizeHermitian()",
+		"Diagonalization routine zheevd exited with INFO=" + to_string(info) + ".",
+		"See LAPACK documentation for zheevd for further information."
+	);
+}
+
+int DenseLinearAlgebra::orthonormalize(
+	complex<double> *vectors,
+	int vectorSize,
+	int numVectors
+){
+	int n = vectorSize;
+	int m = numVectors;
+
+	//Calculate the overlap matrix, scaled to unit diagonal.
+	vector<complex<double>> gram(m*m);
+	multiply('C', 'N', m, m, n, 1., vectors, n, vectors, n, 0., gram.data(), m);
+	vector<double> scales(m);
+	for(int c = 0; c < m; c++){
+		double norm = real(gram[m*c + c]);
+		scales[c] = norm > 0 ? 1./sqrt(norm) : 0.;
+	}
+	for(int c = 0; c < m; c++)
+		for(int r = 0; r < m; r++)
+			gram[m*c + r] *= scales[r]*scales[c];
+
+	vector<double> w(m);
+	diagonalizeHermitian(gram.data(), w.data(), m);
+
+	//Keep the directions with non-negligible overlap eigenvalues and form
+	//the transformation to an orthonormal basis.
+	const double THRESHOLD = 1e-12;
+	int first = 0;
+	while(first < m && w[first] <= THRESHOLD*w[m-1])
+		first++;
+	int numKept = m - first;
+	vector<complex<double>> transformation(m*numKept);
+	for(int c = 0; c < numKept; c++){
+		double eigenValueScale = 1./sqrt(w[first + c]);
+		for(int r = 0; r < m; r++){
+			transformation[m*c + r] = scales[r]
+				*gram[m*(first + c) + r]*eigenValueScale;
+		}
+	}
+
+	size_t size = (size_t)n*numKept;
+	vector<complex<double>> orthonormal(size);
+	multiply('N', 'N', n, numKept, m, 1., vectors, n, transformation.data(), m, 0., orthonormal.data(), n);
+	for(size_t c = 0; c < size; c++)
+		vectors[c] = orthonormal[c];
+
+	return numKept;
+}
+
+};	//End of namespace TBTK
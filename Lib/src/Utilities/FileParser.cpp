@@ -348,7 +348,7 @@ void FileParser::writeAmplitudes(Model *model, AmplitudeMode amplitudeMode){
 		switch(amplitudeMode){
 		case AmplitudeMode::ALL:
 			fout << left << setw(30);
-			write(ha->getAmplitude());
+			write(model->getAmplitudeSet()->getAmplitude(*ha));
 			fout << left << setw(20);
 			write(ha->toIndex);
 			write(ha->fromIndex);
@@ -360,7 +360,7 @@ void FileParser::writeAmplitudes(Model *model, AmplitudeMode amplitudeMode){
 			int to = model->getBasisIndex(ha->toIndex);
 			if(from <= to){
 				fout << left << setw(30);
-				write(ha->getAmplitude());
+				write(model->getAmplitudeSet()->getAmplitude(*ha));
 				fout << setw(20);
 				write(ha->toIndex);
 				write(ha->fromIndex);
@@ -44,7 +44,7 @@ HALinkedList::HALinkedList(AmplitudeSet &as){
 	while((ha = it.getHA())){
 		linkArray[counter].from = as.getBasisIndex(ha->fromIndex);
 		linkArray[counter].to = as.getBasisIndex(ha->toIndex);
-		linkArray[counter].amplitude = ha->getAmplitude();
+		linkArray[counter].amplitude = as.getAmplitude(*ha);
 		linkArray[counter].next1 = NULL;
 		linkArray[counter].next2 = NULL;
 
@@ -53,6 +53,27 @@ void extractCoefficients(
 		coefficients[coefficientMap[to]*numCoefficients + currentCoefficient] = jResult[to];
 }
 
+//Subtracts multiplier*shift*jIn from jResult, which together with the
+//matrix-vector multiplication gives multiplier*(H - shift)*jIn.
+__global__
+void subtractShift(
+	cuDoubleComplex *jResult,
+	cuDoubleComplex *jIn,
+	int basisSize,
+	double multipliedShift
+){
+	int n = blockIdx.x*blockDim.x + threadIdx.x;
+	if(n < basisSize){
+		jResult[n] = cuCsub(
+			jResult[n],
+			make_cuDoubleComplex(
+				multipliedShift*cuCreal(jIn[n]),
+				multipliedShift*cuCimag(jIn[n])
+			)
+		);
+	}
+}
+
 void ChebyshevSolver::calculateCoefficientsGPU(
 	Index to,
 	Index from,
@@ -363,15 +384,30 @@ void ChebyshevSolver::calculateCoefficientsGPU(
 		""
 	);
 
+	//With Hermitian storage the COO format only contains the lower
+	//triangle, which cuSPARSE expands in the multiplication.
 	TBTKAssert(
 		cusparseSetMatType(
 			descr,
-			CUSPARSE_MATRIX_TYPE_GENERAL
+			amplitudeSet->getHermitianStorage()
+				? CUSPARSE_MATRIX_TYPE_HERMITIAN
+				: CUSPARSE_MATRIX_TYPE_GENERAL
 		) == CUSPARSE_STATUS_SUCCESS,
 		"ChebyshevSolver::calculateCoefficientsGPU()",
 		"cuSPARSE set matrix type error.",
 		""
 	);
+	if(amplitudeSet->getHermitianStorage()){
+		TBTKAssert(
+			cusparseSetMatFillMode(
+				descr,
+				CUSPARSE_FILL_MODE_LOWER
+			) == CUSPARSE_STATUS_SUCCESS,
+			"ChebyshevSolver::calculateCoefficientsGPU()",
+			"cuSPARSE set matrix fill mode error.",
+			""
+		);
+	}
 	TBTKAssert(
 		cusparseSetMatIndexBase(
 			descr,
@@ -425,6 +461,12 @@ void ChebyshevSolver::calculateCoefficientsGPU(
 		"Matrix-vector multiplication error.",
 		""
 	);
+	if(energyShift != 0){
+		subtractShift <<< num_blocks, block_size >>> ((cuDoubleComplex*)jIn2_device,
+								(cuDoubleComplex*)jIn1_device,
+								amplitudeSet->getBasisSize(),
+								real(multiplier)*energyShift);
+	}
 
 	extractCoefficients <<< num_blocks, block_size >>> ((cuDoubleComplex*)jIn2_device,
 								amplitudeSet->getBasisSize(),
@@ -462,6 +504,12 @@ void ChebyshevSolver::calculateCoefficientsGPU(
 			"Matrix-vector multiplication error.",
 			""
 		);
+		if(energyShift != 0){
+			subtractShift <<< num_blocks, block_size >>> ((cuDoubleComplex*)jIn2_device,
+									(cuDoubleComplex*)jIn1_device,
+									amplitudeSet->getBasisSize(),
+									real(multiplier)*energyShift);
+		}
 
 		extractCoefficients <<< num_blocks, block_size >>> ((cuDoubleComplex*)jIn2_device,
 									amplitudeSet->getBasisSize(),
@@ -557,7 +605,8 @@ void ChebyshevSolver::loadLookupTableGPU(){
 		Streams::out << "CheyshevSolver::loadLookupTableGPU\n";
 
 	TBTKAssert(
-		generatingFunctionLookupTable != NULL,
+		generatingFunctionLookupTable != NULL
+		|| generatingFunctionLookupTableSingle != NULL,
 		"ChebyshevSolver::loadLookupTableGPU()",
 		"Lookup table has not been generated.",
 		"Call ChebyshevSolver::generateLokupTable() to generate lookup table."
@@ -572,7 +621,9 @@ void ChebyshevSolver::loadLookupTableGPU(){
 	complex<double> *generatingFunctionLookupTable_host = new complex<double>[lookupTableNumCoefficients*lookupTableResolution];
 	for(int n = 0; n < lookupTableNumCoefficients; n++)
 		for(int e = 0; e < lookupTableResolution; e++)
-			generatingFunctionLookupTable_host[n*lookupTableResolution + e] = generatingFunctionLookupTable[n][e];
+			generatingFunctionLookupTable_host[n*lookupTableResolution + e] = generatingFunctionLookupTable != NULL
+				? generatingFunctionLookupTable[n][e]
+				: complex<double>(generatingFunctionLookupTableSingle[n][e]);
 
 	int memoryRequirement = lookupTableNumCoefficients*lookupTableResolution*sizeof(complex<double>);
 	if(isTalkative){
@@ -347,26 +347,44 @@ void ArnoldiSolver::init(){
 
 	//Copy rowIndices (Note that COO is on row major order. Therefore
 	//columns and rows are interchanged and values complex conjugated.)
-	int *rowIndicesH = new int[numMatrixElements];
-	doublecomplex *valuesH = new doublecomplex[numMatrixElements];
+	//With Hermitian storage the COO format only contains the lower
+	//triangle, and each off-diagonal element is also added as its
+	//Hermitian conjugate in the column of its column index. Since the
+	//COO format is sorted by row, and the conjugate elements have row
+	//indices larger than the column, the rows end up sorted within each
+	//column.
+	bool hermitianStorage = model->getAmplitudeSet()->getHermitianStorage();
+	int *colPointersH = new int[basisSize+1];
+	for(int n = 0; n <= basisSize; n++)
+		colPointersH[n] = 0;
 	for(int n = 0; n < numMatrixElements; n++){
-		rowIndicesH[n] = cooColIndices[n];
-		valuesH[n].r = real(cooValues[n]);
-		valuesH[n].i = -imag(cooValues[n]);
+		colPointersH[cooRowIndices[n]+1]++;
+		if(hermitianStorage && cooColIndices[n] != cooRowIndices[n])
+			colPointersH[cooColIndices[n]+1]++;
 	}
-
-	//Create column pointer for compressed format used by SuperLU (Note
-	//that COO is on row major order. Therefore columns and rows are
-	//interchanged and values complex conjugated.)
-	int *colPointersH = new int[basisSize+1];
-	int currentColumn = -1;
+	for(int n = 0; n < basisSize; n++)
+		colPointersH[n+1] += colPointersH[n];
+
+	int numElementsH = colPointersH[basisSize];
+	int *rowIndicesH = new int[numElementsH];
+	doublecomplex *valuesH = new doublecomplex[numElementsH];
+	int *columnPositions = new int[basisSize];
+	for(int n = 0; n < basisSize; n++)
+		columnPositions[n] = colPointersH[n];
 	for(int n = 0; n < numMatrixElements; n++){
-		if(cooRowIndices[n] > currentColumn){
-			currentColumn = cooRowIndices[n];
-			colPointersH[currentColumn] = n;
+		int position = columnPositions[cooRowIndices[n]]++;
+		rowIndicesH[position] = cooColIndices[n];
+		valuesH[position].r = real(cooValues[n]);
+		valuesH[position].i = -imag(cooValues[n]);
+
+		if(hermitianStorage && cooColIndices[n] != cooRowIndices[n]){
+			position = columnPositions[cooColIndices[n]]++;
+			rowIndicesH[position] = cooRowIndices[n];
+			valuesH[position].r = real(cooValues[n]);
+			valuesH[position].i = imag(cooValues[n]);
 		}
 	}
-	colPointersH[basisSize] = numMatrixElements;
+	delete [] columnPositions;
 
 	//Create Hamiltonian
 	hamiltonian = new SuperMatrix;
@@ -374,7 +392,7 @@ void ArnoldiSolver::init(){
 		hamiltonian,
 		basisSize,
 		basisSize,
-		numMatrixElements,
+		numElementsH,
 		valuesH,
 		rowIndicesH,
 		colPointersH,
@@ -0,0 +1,266 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file DistributedDiagonalizationSolver.cpp
+ *  @brief MPI and ScaLAPACK backend of the DistributedDiagonalizationSolver
+ *
+ *  @author agent
+ */
+
+#include "DistributedDiagonalizationSolver.h"
+#include "TBTKMacros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mpi.h>
+
+using namespace std;
+
+namespace TBTK{
+
+//BLACS function for getting internal BLACS values.
+extern "C" void Cblacs_get(
+	int context,	//Context, or -1 for the default system context
+	int what,	//0 = Default system context
+	int *value	//Requested value
+);
+
+//BLACS function for creating a process grid.
+extern "C" void Cblacs_gridinit(
+	int *context,		//System context on input. Grid context on exit
+	const char *order,	//"Row" = Processes are assigned in row major order
+	int numRows,		//Number of process rows
+	int numColumns		//Number of process columns
+);
+
+//BLACS function for getting the position of the process in a process grid.
+extern "C" void Cblacs_gridinfo(
+	int context,	//Grid context
+	int *numRows,	//Number of process rows
+	int *numColumns,//Number of process columns
+	int *row,	//Process row of calling process
+	int *column	//Process column of calling process
+);
+
+//BLACS function for releasing a process grid.
+extern "C" void Cblacs_gridexit(
+	int context	//Grid context
+);
+
+//ScaLAPACK function for divide and conquer diagonalization of a distributed
+//matrix.
+extern "C" void pzheevd_(
+	char *jobz,		//'N' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+	char *uplo,		//'U' = Stored as upper triangular, 'L' = Stored as lower triangular.
+	int *n,			//n*n = Matrix size
+	complex<double> *a,	//Local part of input matrix. Destroyed on exit
+	int *ia,		//First row of a
+	int *ja,		//First column of a
+	int *desca,		//Descriptor of a
+	double *w,		//Eigenvalues, is in accending order if info = 0
+	complex<double> *z,	//Local part of the eigenvectors
+	int *iz,		//First row of z
+	int *jz,		//First column of z
+	int *descz,		//Descriptor of z
+	complex<double> *work,	//Workspace
+	int *lwork,		//Size of work. -1 = workspace query
+	double *rwork,		//Workspace
+	int *lrwork,		//Size of rwork. -1 = workspace query
+	int *iwork,		//Workspace
+	int *liwork,		//Size of iwork. -1 = workspace query
+	int *info);		//0 = successful, <0 = illegal value, >0 = failed to converge.
+
+//ScaLAPACK function for copying a distributed matrix between two
+//distributions.
+extern "C" void pzgemr2d_(
+	int *m,			//Number of rows to copy
+	int *n,			//Number of columns to copy
+	complex<double> *a,	//Local part of source matrix
+	int *ia,		//First row of a
+	int *ja,		//First column of a
+	int *desca,		//Descriptor of a
+	complex<double> *b,	//Local part of destination matrix
+	int *ib,		//First row of b
+	int *jb,		//First column of b
+	int *descb,		//Descriptor of b
+	int *context		//Context containing all processes of both grids
+);
+
+void DistributedDiagonalizationSolver::initProcessGrid(){
+	int isInitialized;
+	MPI_Initialized(&isInitialized);
+	TBTKAssert(
+		isInitialized,
+		"DistributedDiagonalizationSolver::initProcessGrid()",
+		"MPI not initialized.",
+		"Call MPI_Init() before DistributedDiagonalizationSolver::run()."
+	);
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+
+	if(requestedProcessRows == -1){
+		//Choose the grid as close to square as possible.
+		numProcessRows = (int)sqrt((double)numProcesses);
+		while(numProcesses%numProcessRows != 0)
+			numProcessRows--;
+		numProcessColumns = numProcesses/numProcessRows;
+	}
+	else{
+		TBTKAssert(
+			requestedProcessRows*requestedProcessColumns == numProcesses,
+			"DistributedDiagonalizationSolver::initProcessGrid()",
+			"The process grid " << requestedProcessRows << "x" << requestedProcessColumns << " does not match the number of processes " << numProcesses << ".",
+			""
+		);
+		numProcessRows = requestedProcessRows;
+		numProcessColumns = requestedProcessColumns;
+	}
+
+	int rows, columns;
+	Cblacs_get(-1, 0, &context);
+	Cblacs_gridinit(&context, "Row", numProcessRows, numProcessColumns);
+	Cblacs_gridinfo(
+		context,
+		&rows,
+		&columns,
+		&processRow,
+		&processColumn
+	);
+
+	//One-dimensional grid for the eigenvector panels, where the process
+	//column is the rank.
+	int panelRow, panelColumn;
+	Cblacs_get(-1, 0, &panelContext);
+	Cblacs_gridinit(&panelContext, "Row", 1, numProcesses);
+	Cblacs_gridinfo(panelContext, &rows, &columns, &panelRow, &panelColumn);
+	TBTKAssert(
+		panelColumn == rank,
+		"DistributedDiagonalizationSolver::initProcessGrid()",
+		"BLACS process numbering differs from MPI_COMM_WORLD.",
+		"This should never happen, contact the developer."
+	);
+}
+
+void DistributedDiagonalizationSolver::exitProcessGrid(){
+	Cblacs_gridexit(panelContext);
+	Cblacs_gridexit(context);
+}
+
+void DistributedDiagonalizationSolver::solve(){
+	//Setup ScaLAPACK to calculate...
+	char jobz = 'V';			//...eigenvalues and eigenvectors...
+	char uplo = 'U';			//...for an upper triangular...
+	int n = model->getBasisSize();		//...nxn-matrix.
+	int one = 1;
+	int info;
+
+	//Block cyclic distribution of the Hamiltonian and eigenvectors.
+	int descriptor[9] = {
+		1,
+		context,
+		n,
+		n,
+		blockSize,
+		blockSize,
+		0,
+		0,
+		max(1, numLocalRows)
+	};
+
+	//Complete columns, with blocks of blockSize columns distributed
+	//cyclically over the ranks.
+	int panelDescriptor[9] = {
+		1,
+		panelContext,
+		n,
+		n,
+		max(1, n),
+		blockSize,
+		0,
+		0,
+		max(1, n)
+	};
+
+	//Workspace query. The real workspace is raised to the documented
+	//minimum, since some ScaLAPACK versions underestimate it.
+	complex<double> workQuery;
+	double rworkQuery;
+	int iworkQuery;
+	int query = -1;
+	pzheevd_(&jobz, &uplo, &n, hamiltonian, &one, &one, descriptor, eigenValues, eigenVectors, &one, &one, descriptor, &workQuery, &query, &rworkQuery, &query, &iworkQuery, &query, &info);
+	TBTKAssert(
+		info == 0,
+		"DistributedDiagonalizationSolver::solve()",
+		"Workspace query for pzheevd exited with INFO=" << info << ".",
+		"See ScaLAPACK documentation for pzheevd for further information."
+	);
+
+	int lwork = (int)real(workQuery);
+	int lrwork = max(
+		(int)rworkQuery,
+		1 + 9*n + 3*numLocalRows*numLocalColumns
+	);
+	int liwork = max(iworkQuery, 7*n + 8*numProcessColumns + 2);
+	complex<double> *work = new complex<double>[lwork];
+	double *rwork = new double[lrwork];
+	int *iwork = new int[liwork];
+
+	pzheevd_(&jobz, &uplo, &n, hamiltonian, &one, &one, descriptor, eigenValues, eigenVectors, &one, &one, descriptor, work, &lwork, rwork, &lrwork, iwork, &liwork, &info);
+
+	delete [] work;
+	delete [] rwork;
+	delete [] iwork;
+
+	TBTKAssert(
+		info == 0,
+		"DistributedDiagonalizationSolver::solve()",
+		"Diagonalization routine pzheevd exited with INFO=" << info << ".",
+		"See ScaLAPACK documentation for pzheevd for further information."
+	);
+
+	pzgemr2d_(&n, &n, eigenVectors, &one, &one, descriptor, localEigenVectors, &one, &one, panelDescriptor, &panelContext);
+}
+
+void DistributedDiagonalizationSolver::sumOverProcesses(
+	double *data,
+	int size
+){
+	MPI_Allreduce(
+		MPI_IN_PLACE,
+		data,
+		size,
+		MPI_DOUBLE,
+		MPI_SUM,
+		MPI_COMM_WORLD
+	);
+}
+
+void DistributedDiagonalizationSolver::sumOverProcesses(
+	complex<double> *data,
+	int size
+){
+	//The real and imaginary parts are summed independently.
+	MPI_Allreduce(
+		MPI_IN_PLACE,
+		reinterpret_cast<double*>(data),
+		2*size,
+		MPI_DOUBLE,
+		MPI_SUM,
+		MPI_COMM_WORLD
+	);
+}
+
+};	//End of namespace TBTK
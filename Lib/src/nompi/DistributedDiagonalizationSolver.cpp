@@ -0,0 +1,125 @@
+/* Copyright 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file DistributedDiagonalizationSolver.cpp
+ *  @brief Single process backend of the DistributedDiagonalizationSolver, to
+ *  allow for compilation without MPI support
+ *
+ *  @author agent
+ */
+
+#include "DistributedDiagonalizationSolver.h"
+#include "TBTKMacros.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace TBTK{
+
+//Lapack function for divide and conquer diagonalization of full matrix.
+extern "C" void zheevd_(
+	char *jobz,		//'N' = Eigenvalues only, 'V' = Eigenvalues and eigenvectors.
+	char *uplo,		//'U' = Stored as upper triangular, 'L' = Stored as lower triangular.
+	int *n,			//n*n = Matrix size
+	complex<double> *a,	//Input matrix. Contains the eigenvectors on exit if jobz = 'V'
+	int *lda,		//Leading dimension of a
+	double *w,		//Eigenvalues, is in accending order if info = 0
+	complex<double> *work,	//Workspace
+	int *lwork,		//Size of work. -1 = workspace query
+	double *rwork,		//Workspace
+	int *lrwork,		//Size of rwork. -1 = workspace query
+	int *iwork,		//Workspace
+	int *liwork,		//Size of iwork. -1 = workspace query
+	int *info);		//0 = successful, <0 = -info value was illegal, >0 = failed to converge.
+
+void DistributedDiagonalizationSolver::initProcessGrid(){
+	TBTKAssert(
+		requestedProcessRows == -1
+		|| requestedProcessRows*requestedProcessColumns == 1,
+		"DistributedDiagonalizationSolver::initProcessGrid()",
+		"The process grid " << requestedProcessRows << "x" << requestedProcessColumns << " does not match the number of processes 1.",
+		"Build TBTK with MPI=1 to run on multiple processes."
+	);
+
+	rank = 0;
+	numProcesses = 1;
+	context = 0;
+	numProcessRows = 1;
+	numProcessColumns = 1;
+	processRow = 0;
+	processColumn = 0;
+	panelContext = 0;
+}
+
+void DistributedDiagonalizationSolver::exitProcessGrid(){
+}
+
+void DistributedDiagonalizationSolver::solve(){
+	//Setup LAPACK to calculate...
+	char jobz = 'V';			//...eigenvalues and eigenvectors...
+	char uplo = 'U';			//...for an upper triangular...
+	int n = model->getBasisSize();		//...nxn-matrix.
+	int lda = max(1, n);
+	int info;
+
+	complex<double> workQuery;
+	double rworkQuery;
+	int iworkQuery;
+	int query = -1;
+	zheevd_(&jobz, &uplo, &n, hamiltonian, &lda, eigenValues, &workQuery, &query, &rworkQuery, &query, &iworkQuery, &query, &info);
+
+	int lwork = (int)real(workQuery);
+	int lrwork = (int)rworkQuery;
+	int liwork = iworkQuery;
+	complex<double> *work = new complex<double>[lwork];
+	double *rwork = new double[lrwork];
+	int *iwork = new int[liwork];
+
+	zheevd_(&jobz, &uplo, &n, hamiltonian, &lda, eigenValues, work, &lwork, rwork, &lrwork, iwork, &liwork, &info);
+
+	delete [] work;
+	delete [] rwork;
+	delete [] iwork;
+
+	TBTKAssert(
+		info == 0,
+		"DistributedDiagonalizationSolver::solve()",
+		"Diagonalization routine zheevd exited with INFO=" << info << ".",
+		"See LAPACK documentation for zheevd for further information."
+	);
+
+	//With a single process, the whole Hamiltonian is local and zheevd
+	//returns all eigenvectors in place of it.
+	copy(
+		hamiltonian,
+		hamiltonian + (size_t)n*n,
+		localEigenVectors
+	);
+}
+
+void DistributedDiagonalizationSolver::sumOverProcesses(
+	double *data,
+	int size
+){
+}
+
+void DistributedDiagonalizationSolver::sumOverProcesses(
+	complex<double> *data,
+	int size
+){
+}
+
+};	//End of namespace TBTK
@@ -70,12 +70,15 @@ int main(int argc, char **argv){
 	//Chebyshev expansion parameters.
 	const int NUM_COEFFICIENTS = 5000;
 	const int ENERGY_RESOLUTION = 10000;
-	const double SCALE_FACTOR = 5.;
 
-	//Setup ChebyshevSolver
+	//Setup ChebyshevSolver. The energy shift and scale factor are
+	//estimated from the spectral bounds of the Hamiltonian, such that the
+	//expansion covers the interval [LOWER_BOUND, UPPER_BOUND].
 	ChebyshevSolver cSolver;
 	cSolver.setModel(&model);
-	cSolver.setScaleFactor(SCALE_FACTOR);
+	cSolver.estimateScaleFactor();
+	const double LOWER_BOUND = cSolver.getEnergyShift() - cSolver.getScaleFactor();
+	const double UPPER_BOUND = cSolver.getEnergyShift() + cSolver.getScaleFactor();
 
 	//Set filename and remove any file already in the folder
 	FileWriter::setFileName("TBTKResults.h5");
@@ -89,15 +92,15 @@ int main(int argc, char **argv){
 	//whether to use a lookup table for the Green's function or not
 	//(required if the Green's function is evaluated on a GPU), and the
 	//lower and upper bound between which the Green's function is evaluated
-	//(has to be inside the interval [-SCALE_FACTOR, SCALE_FACTOR]).
+	//(has to be inside the interval [LOWER_BOUND, UPPER_BOUND]).
 	CPropertyExtractor pe(&cSolver,
 				NUM_COEFFICIENTS,
 				ENERGY_RESOLUTION,
 				false,
 				false,
 				true,
-				-SCALE_FACTOR,
-				SCALE_FACTOR);
+				LOWER_BOUND,
+				UPPER_BOUND);
 
 	//Extract local density of states and write to file
 	Property::LDOS *ldos = pe.calculateLDOS({IDX_X, SIZE_Y/2, IDX_SUM_ALL},
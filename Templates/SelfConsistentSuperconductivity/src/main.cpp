@@ -28,6 +28,7 @@
 #include <complex>
 #include "Model.h"
 #include "FileWriter.h"
+#include "SelfConsistencyDriver.h"
 #include "DiagonalizationSolver.h"
 
 using namespace std;
@@ -39,12 +40,13 @@ const complex<double> i(0, 1);
 const int SIZE_X = 20;
 const int SIZE_Y = 20;
 
-//Order parameter. The two buffers are alternatively swaped by setting dCounter
-// = 0 or 1. One buffer contains the order parameter used in the previous
-//calculation, while the other is used to store the newly obtained order
-//parameter that will be used in the next calculation.
-complex<double> D[2][SIZE_X][SIZE_Y];
-int dCounter = 0;
+//Order parameter. D contains the order parameter used in the current
+//calculation, while DOut is used to store the newly obtained order parameter.
+//The SelfConsistencyDriver mixes the two to obtain the order parameter that
+//will be used in the next calculation.
+complex<double> D[SIZE_X][SIZE_Y];
+complex<double> DOut[SIZE_X][SIZE_Y];
+SelfConsistencyDriver scDriver;
 
 //Superconducting pair potential, convergence limit, max iterations, and initial guess
 const double V_sc = 2.;
@@ -58,7 +60,7 @@ bool scCallback(DiagonalizationSolver *dSolver){
 	//Clear the order parameter
 	for(int x = 0; x < SIZE_X; x++){
 		for(int y = 0; y < SIZE_Y; y++){
-			D[(dCounter+1)%2][x][y] = 0.;
+			DOut[x][y] = 0.;
 		}
 	}
 
@@ -70,34 +72,14 @@ bool scCallback(DiagonalizationSolver *dSolver){
 				complex<double> u_u = dSolver->getAmplitude(n, {x, y, 0});
 				complex<double> v_d = dSolver->getAmplitude(n, {x, y, 3});
 
-				D[(dCounter+1)%2][x][y] -= V_sc*conj(v_d)*u_u;
+				DOut[x][y] -= V_sc*conj(v_d)*u_u;
 			}
 		}
 	}
 
-	//Swap order parameter buffers
-	dCounter = (dCounter+1)%2;
-
-	//Calculate convergence parameter
-	double maxError = 0.;
-	for(int x = 0; x < SIZE_X; x++){
-		for(int y = 0; y < SIZE_Y; y++){
-			double error = 0.;
-			if(abs(D[dCounter][x][y]) == 0 && abs(D[(dCounter+1)%2][x][y]) == 0)
-				error = 0.;
-			else
-				error = abs(D[dCounter][x][y] - D[(dCounter+1)%2][x][y])/max(abs(D[dCounter][x][y]), abs(D[(dCounter+1)%2][x][y]));
-
-			if(error > maxError)
-				maxError = error;
-		}
-	}
-
-	//Return true or false depending on whether the result has converged or not
-	if(maxError < CONVERGENCE_LIMIT)
-		return true;
-	else
-		return false;
+	//Mix the old and new order parameter and return true or false
+	//depending on whether the result has converged or not
+	return scDriver.update(&DOut[0][0]);
 }
 
 //Callback function responsible for determining the value of the order
@@ -112,13 +94,13 @@ complex<double> fD(Index to, Index from){
 	//Return appropriate amplitude
 	switch(s){
 		case 0:
-			return conj(D[dCounter][x][y]);
+			return conj(D[x][y]);
 		case 1:
-			return -conj(D[dCounter][x][y]);
+			return -conj(D[x][y]);
 		case 2:
-			return -D[dCounter][x][y];
+			return -D[x][y];
 		case 3:
-			return D[dCounter][x][y];
+			return D[x][y];
 		default://Never happens
 			return 0;
 	}
@@ -128,7 +110,7 @@ complex<double> fD(Index to, Index from){
 void initD(){
 	for(int x = 0; x < SIZE_X; x++){
 		for(int y = 0; y < SIZE_Y; y++){
-			D[0][x][y] = D_INITIAL_GUESS;
+			D[x][y] = D_INITIAL_GUESS;
 		}
 	}
 }
@@ -164,8 +146,11 @@ int main(int argc, char **argv){
 	//Construct model
 	model.construct();
 
-	//Initialize D
+	//Initialize D and register it with the SelfConsistencyDriver, which
+	//uses Anderson mixing by default
 	initD();
+	scDriver.setOrderParameter(&D[0][0], SIZE_X*SIZE_Y);
+	scDriver.setConvergenceLimit(CONVERGENCE_LIMIT);
 
 	//Setup and run DiagonalizationSolver
 	DiagonalizationSolver dSolver;
@@ -183,8 +168,8 @@ int main(int argc, char **argv){
 	double D_arg[SIZE_X*SIZE_Y];
 	for(int x = 0; x < SIZE_X; x++){
 		for(int y = 0; y < SIZE_Y; y++){
-			D_abs[x*SIZE_Y + y] = abs(D[dCounter][x][y]);
-			D_arg[x*SIZE_Y + y] = arg(D[dCounter][x][y]);
+			D_abs[x*SIZE_Y + y] = abs(D[x][y]);
+			D_arg[x*SIZE_Y + y] = arg(D[x][y]);
 		}
 	}
 
@@ -28,6 +28,7 @@
 #include <complex>
 #include "Model.h"
 #include "FileWriter.h"
+#include "SelfConsistencyDriver.h"
 #include "ChebyshevSolver.h"
 #include "CPropertyExtractor.h"
 
@@ -40,12 +41,13 @@ const complex<double> i(0, 1);
 const int SIZE_X = 20;
 const int SIZE_Y = 20;
 
-//Order parameter. The two buffers are alternatively swaped by setting dCounter
-// = 0 or 1. One buffer contains the order parameter used in the previous
-//calculation, while the other is used to store the newly obtained order
-//parameter that will be used in the next calculation.
-complex<double> D[2][SIZE_X][SIZE_Y];
-int dCounter = 0;
+//Order parameter. D contains the order parameter used in the current
+//calculation, while DOut is used to store the newly obtained order parameter.
+//The SelfConsistencyDriver mixes the two to obtain the order parameter that
+//will be used in the next calculation.
+complex<double> D[SIZE_X][SIZE_Y];
+complex<double> DOut[SIZE_X][SIZE_Y];
+SelfConsistencyDriver scDriver;
 
 //ChebyshevSolver parameters, SCALE_FACTOR scales the energy spectrum to lie
 //within -1 < E < 1, while NUM_COEFFICIENTS and ENERGY resolution are the
@@ -57,14 +59,12 @@ const int NUM_COEFFICIENTS = 1000;
 const int ENERGY_RESOLUTION = 2000;
 
 //Superconducting pair potential, convergence limit, max iterations, initial
-//guess, weight factor with which the old order parameter is mixed with the
-//newly calculated one, and Deby frequency used to specify the integration
-//limits used to calculate the superconducting order parameter.
+//guess, and Deby frequency used to specify the integration limits used to
+//calculate the superconducting order parameter.
 const double V_sc = 2.;
 const double CONVERGENCE_LIMIT = 0.0001;
 const int MAX_ITERATIONS = 50;
 const complex<double> D_INITIAL_GUESS = 0.3;
-const double SC_WEIGHT_FACTOR = 0.5;
 const double DEBYE_FREQUENCY = 10.;
 
 //Self-consistency loop
@@ -81,7 +81,7 @@ bool scLoop(ChebyshevSolver *cSolver){
 		//Clear the order parameter
 		for(int x = 0; x < SIZE_X; x++){
 			for(int y = 0; y < SIZE_Y; y++){
-				D[(dCounter+1)%2][x][y] = 0.;
+				DOut[x][y] = 0.;
 			}
 		}
 
@@ -94,38 +94,18 @@ bool scLoop(ChebyshevSolver *cSolver){
 				//Calculate order parameter
 				for(int n = 0; n < ENERGY_RESOLUTION/2; n++){
 					const double dE = 2.*DEBYE_FREQUENCY/(double)ENERGY_RESOLUTION;
-					D[(dCounter+1)%2][x][y] -= V_sc*i*greensFunction[n]*dE/M_PI;
+					DOut[x][y] -= V_sc*i*greensFunction[n]*dE/M_PI;
 				}
 
 				//Free memory used for Green's function
 				delete [] greensFunction;
-
-				//Mix old and new order parameter
-				D[(dCounter+1)%2][x][y] = (1-SC_WEIGHT_FACTOR)*D[(dCounter+1)%2][x][y] + SC_WEIGHT_FACTOR*D[dCounter][x][y];
-			}
-		}
-
-		//Swap order parameter buffers
-		dCounter = (dCounter+1)%2;
-
-		//Calculate convergence parameter
-		double maxError = 0.;
-		for(int x = 0; x < SIZE_X; x++){
-			for(int y = 0; y < SIZE_Y; y++){
-				double error = 0.;
-				if(abs(D[dCounter][x][y]) == 0 && abs(D[(dCounter+1)%2][x][y]) == 0)
-					error = 0.;
-				else
-					error = abs(D[dCounter][x][y] - D[(dCounter+1)%2][x][y])/max(abs(D[dCounter][x][y]), abs(D[(dCounter+1)%2][x][y]));
-
-				if(error > maxError)
-					maxError = error;
 			}
 		}
 
-		//Exit the self-consistency loop depending on whether the
-		//result has converged or not
-		if(maxError < CONVERGENCE_LIMIT)
+		//Mix the old and new order parameter and exit the
+		//self-consistency loop depending on whether the result has
+		//converged or not
+		if(scDriver.update(&DOut[0][0]))
 			break;
 	}
 }
@@ -142,13 +122,13 @@ complex<double> fD(Index to, Index from){
 	//Return appropriate amplitude
 	switch(s){
 		case 0:
-			return conj(D[dCounter][x][y]);
+			return conj(D[x][y]);
 		case 1:
-			return -conj(D[dCounter][x][y]);
+			return -conj(D[x][y]);
 		case 2:
-			return -D[dCounter][x][y];
+			return -D[x][y];
 		case 3:
-			return D[dCounter][x][y];
+			return D[x][y];
 		default://Never happens
 			return 0;
 	}
@@ -158,7 +138,7 @@ complex<double> fD(Index to, Index from){
 void initD(){
 	for(int x = 0; x < SIZE_X; x++){
 		for(int y = 0; y < SIZE_Y; y++){
-			D[0][x][y] = D_INITIAL_GUESS;
+			D[x][y] = D_INITIAL_GUESS;
 		}
 	}
 }
@@ -197,8 +177,11 @@ int main(int argc, char **argv){
 	//Construct model
 	model.construct();
 
-	//Initialize D
+	//Initialize D and register it with the SelfConsistencyDriver, which
+	//uses Anderson mixing by default
 	initD();
+	scDriver.setOrderParameter(&D[0][0], SIZE_X*SIZE_Y);
+	scDriver.setConvergenceLimit(CONVERGENCE_LIMIT);
 
 	//Setup ChebyshevSolver
 	ChebyshevSolver cSolver;
@@ -217,8 +200,8 @@ int main(int argc, char **argv){
 	double D_arg[SIZE_X*SIZE_Y];
 	for(int x = 0; x < SIZE_X; x++){
 		for(int y = 0; y < SIZE_Y; y++){
-			D_abs[x*SIZE_Y + y] = abs(D[dCounter][x][y]);
-			D_arg[x*SIZE_Y + y] = arg(D[dCounter][x][y]);
+			D_abs[x*SIZE_Y + y] = abs(D[x][y]);
+			D_arg[x*SIZE_Y + y] = arg(D[x][y]);
 		}
 	}
 
@@ -118,9 +118,12 @@ int main(int argc, char **argv){
 
 	FileWriter::setFileName("TBTKResults.h5");
 
-	//Setup and run DiagonalizationSolver and corresponding PropertyExtractor
+	//Setup and run DiagonalizationSolver and corresponding PropertyExtractor.
+	//Only the eigenvalues are needed for the DOS.
 	DiagonalizationSolver dSolver;
 	dSolver.setModel(model);
+	dSolver.setAlgorithm(DiagonalizationSolver::Algorithm::DivideAndConquer);
+	dSolver.setCalculateEigenVectors(false);
 	dSolver.run();
 	DPropertyExtractor pe(&dSolver);
 
@@ -15,10 +15,13 @@
 
 /** @package TBTKTools
  *  @file main.cpp
- *  @brief Estimates the DOS using random sampling of LDOS.
+ *  @brief Estimates the DOS using random vectors.
  *
  *  Reads model from text file and estimates the DOS using the
- *  ChebyshevSolver.
+ *  ChebyshevSolver. The DOS is estimated from the expansions for random
+ *  vectors with random phases on every basis state matching the index
+ *  pattern, and is normalized to one state per basis state. The standard
+ *  error of the estimate is written as DOSError.
  *
  *  Takes filename of file to parse as first argument.
  *
@@ -38,7 +41,6 @@
 #include <complex>
 #include <fstream>
 #include <cstdlib>
-#include <ctime>
 #include <getopt.h>
 
 using namespace std;
@@ -54,7 +56,7 @@ int main(int argc, char **argv){
 	int forceGPU		= false;
 	int forceCPU		= false;
 	int numSamples		= 100;
-	int scaleFactor		= 20;
+	double scaleFactor	= -1;
 	int numCoefficients	= 5000;
 	int energyResolution	= 10000;
 	Index *pattern		= NULL;
@@ -153,7 +155,12 @@ int main(int argc, char **argv){
 	//Setup ChebyshevSolver and corresponding PropertyExtractor
 	ChebyshevSolver cSolver;
 	cSolver.setModel(model);
-	cSolver.setScaleFactor(scaleFactor);
+	if(scaleFactor > 0)
+		cSolver.setScaleFactor(scaleFactor);
+	else
+		cSolver.estimateScaleFactor();
+	double lowerBound = cSolver.getEnergyShift() - cSolver.getScaleFactor();
+	double upperBound = cSolver.getEnergyShift() + cSolver.getScaleFactor();
 
 	CPropertyExtractor pe(
 		&cSolver,
@@ -162,58 +169,51 @@ int main(int argc, char **argv){
 		useGPU,
 		false,
 		true,
-		-scaleFactor,
-		scaleFactor
+		lowerBound,
+		upperBound
 	);
 
-	//Initialize randomization and dos
-	srand(time(NULL));
-	double *dosData = new double[energyResolution];
-	for(int n = 0; n < energyResolution; n++)
-		dosData[n] = 0.;
-
-	//Main loop: Repeatedly calculate LDOS for random sites
-	for(int n = 0; n < numSamples; n++){
-		//Get new random index
-		int b = rand()%model->getBasisSize();
-		Index index = model->getAmplitudeSet()->tree.getPhysicalIndex(b);
-
-		//Ensure index conforms to index pattern
-		if(pattern != NULL){
-			if(!pattern->equals(index, true)){
-				n--;
-				continue;
-			}
-		}
-
-		//Calculate LDOS
-		Property::LDOS *ldos = pe.calculateLDOS(
-			index,
-			index.getUnitRange()
+	//Estimate DOS using one random vector per sample
+	Property::DOS *dos;
+	Property::DOS *dosError;
+	int numBasisStates = 0;
+	if(pattern != NULL){
+		for(int n = 0; n < model->getBasisSize(); n++)
+			if(pattern->equals(model->getPhysicalIndex(n), true))
+				numBasisStates++;
+		TBTKAssert(
+			numBasisStates > 0,
+			"EstimateDOS",
+			"No index matches the index pattern.",
+			""
 		);
+		dos = pe.calculateDOS(*pattern, numSamples, &dosError);
+	}
+	else{
+		dos = pe.calculateDOS(numSamples, &dosError);
+		numBasisStates = model->getBasisSize();
+	}
 
-		//Add calculated LDOS to total DOS
-		const double *data = ldos->getData();
-		for(int e = 0; e < energyResolution; e++)
-			dosData[e] += data[e]/(double)numSamples;
-
-		//Free memory
-		delete ldos;
-
-		//Print progress
-		cout << "." << flush;
-		if(n%10 == 9)
-			cout << " ";
-		if(n%50 == 49)
-			cout << "\n";
+	//Normalize to one state per basis state
+	const double *data = dos->getData();
+	const double *errorData = dosError->getData();
+	double *dosData = new double[energyResolution];
+	double *dosErrorData = new double[energyResolution];
+	for(int e = 0; e < energyResolution; e++){
+		dosData[e] = data[e]/numBasisStates;
+		dosErrorData[e] = errorData[e]/numBasisStates;
 	}
-	cout << "\n";
 
 	//Write DOS to file
-	Property::DOS dos(-scaleFactor, scaleFactor, energyResolution, dosData);
-	FileWriter::writeDOS(&dos);
+	Property::DOS normalizedDOS(lowerBound, upperBound, energyResolution, dosData);
+	Property::DOS normalizedDOSError(lowerBound, upperBound, energyResolution, dosErrorData);
+	FileWriter::writeDOS(&normalizedDOS);
+	FileWriter::writeDOS(&normalizedDOSError, "DOSError");
 
 	delete [] dosData;
+	delete [] dosErrorData;
+	delete dos;
+	delete dosError;
 	delete model;
 
 	Streams::closeLog();